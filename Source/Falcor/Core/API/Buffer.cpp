@@ -188,6 +188,7 @@ namespace Falcor
         else
         {
             gpDevice->releaseResource(mApiHandle);
+            if (mSubAllocation.isValid() && gpDevice->getBufferAllocator()) gpDevice->getBufferAllocator()->release(mSubAllocation);
         }
     }
 
@@ -28,6 +28,7 @@
 #pragma once
 #include "Resource.h"
 #include "GpuMemoryHeap.h"
+#include "BufferAllocator.h"
 
 namespace Falcor
 {
@@ -308,6 +309,7 @@ namespace Falcor
 
         CpuAccess mCpuAccess;
         GpuMemoryHeap::Allocation mDynamicData;
+        BufferAllocator::Allocation mSubAllocation; // For device-local buffers placed in a shared heap
         Buffer::SharedPtr mpStagingResource; // For buffers that have both CPU read flag and can be used by the GPU
         Resource::SharedPtr mpAliasedResource;
         uint32_t mElementCount = 0;
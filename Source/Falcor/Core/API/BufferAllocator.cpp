@@ -0,0 +1,146 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "BufferAllocator.h"
+
+namespace Falcor
+{
+    BufferAllocator::BufferAllocator(Backend::UniquePtr pBackend, const Desc& desc, const GpuFence::SharedPtr& pFence)
+        : mpBackend(std::move(pBackend))
+        , mDesc(desc)
+        , mpFence(pFence)
+    {
+        if (!mpBackend) throw std::exception("BufferAllocator::BufferAllocator() - backend is null");
+        if (mDesc.maxAllocationSize > mDesc.heapSize) throw std::exception("BufferAllocator::BufferAllocator() - maxAllocationSize is larger than heapSize");
+    }
+
+    BufferAllocator::SharedPtr BufferAllocator::create(Backend::UniquePtr pBackend, const Desc& desc, const GpuFence::SharedPtr& pFence)
+    {
+        return SharedPtr(new BufferAllocator(std::move(pBackend), desc, pFence));
+    }
+
+    BufferAllocator::Allocation BufferAllocator::allocate(uint64_t size, uint64_t alignment)
+    {
+        Allocation allocation;
+        if (size > mDesc.maxAllocationSize) return allocation;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto tryAllocate = [&](uint32_t heapIndex)
+        {
+            auto range = mHeaps[heapIndex].pAllocator->allocate(size, alignment);
+            if (!range.isValid()) return false;
+            allocation.pHeap = mHeaps[heapIndex].pHandle;
+            allocation.offset = range.offset;
+            allocation.size = range.size;
+            allocation.heapIndex = heapIndex;
+            allocation.range = range;
+            return true;
+        };
+
+        for (uint32_t i = 0; i < (uint32_t)mHeaps.size(); i++)
+        {
+            if (mHeaps[i].pAllocator && tryAllocate(i)) return allocation;
+        }
+
+        // Create a new heap, reusing the slot of a released one if possible.
+        uint32_t heapIndex = (uint32_t)mHeaps.size();
+        for (uint32_t i = 0; i < (uint32_t)mHeaps.size(); i++)
+        {
+            if (!mHeaps[i].pAllocator) { heapIndex = i; break; }
+        }
+        if (heapIndex == mHeaps.size()) mHeaps.emplace_back();
+
+        mHeaps[heapIndex].pHandle = mpBackend->createHeap(mDesc.heapSize);
+        mHeaps[heapIndex].pAllocator = std::make_unique<TlsfAllocator>(mDesc.heapSize, mDesc.granularity);
+        if (!tryAllocate(heapIndex))
+        {
+            throw std::exception("BufferAllocator::allocate() - allocation failed in a new heap");
+        }
+        return allocation;
+    }
+
+    void BufferAllocator::release(Allocation& allocation)
+    {
+        assert(mpFence);
+        release(allocation, mpFence->getCpuValue());
+    }
+
+    void BufferAllocator::release(Allocation& allocation, uint64_t fenceValue)
+    {
+        assert(allocation.isValid());
+        mDeferredReleases.push(fenceValue, allocation);
+        allocation = {};
+    }
+
+    void BufferAllocator::executeDeferredReleases()
+    {
+        assert(mpFence);
+        executeDeferredReleases(mpFence->getGpuValue());
+    }
+
+    void BufferAllocator::executeDeferredReleases(uint64_t completedValue)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDeferredReleases.release(completedValue, [this](const Allocation& allocation)
+        {
+            Heap& heap = mHeaps[allocation.heapIndex];
+            heap.pAllocator->free(allocation.range);
+
+            // Keep one heap around to avoid re-creating it when allocations come and go, release the other empty heaps.
+            if (heap.pAllocator->isEmpty())
+            {
+                uint32_t liveHeaps = 0;
+                for (const auto& h : mHeaps) liveHeaps += h.pAllocator ? 1 : 0;
+                if (liveHeaps > 1) heap = Heap();
+            }
+        });
+    }
+
+    BufferAllocator::Stats BufferAllocator::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Stats stats;
+        uint64_t freeSize = 0;
+        for (const auto& heap : mHeaps)
+        {
+            if (!heap.pAllocator) continue;
+            auto heapStats = heap.pAllocator->getStats();
+            stats.heapCount++;
+            stats.heapSize += heapStats.capacity;
+            stats.usedSize += heapStats.usedSize;
+            stats.allocationCount += heapStats.allocationCount;
+            stats.freeBlockCount += heapStats.freeBlockCount;
+            stats.largestFreeBlock = std::max(stats.largestFreeBlock, heapStats.largestFreeBlock);
+            freeSize += heapStats.freeSize;
+        }
+        stats.pendingReleaseCount = (uint32_t)mDeferredReleases.getPendingCount();
+        stats.fragmentation = freeSize > 0 ? 1.f - (float)((double)stats.largestFreeBlock / (double)freeSize) : 0.f;
+        return stats;
+    }
+}
@@ -0,0 +1,139 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/API/GpuFence.h"
+#include "Core/API/DeferredReleaseQueue.h"
+#include "Utils/Algorithm/TlsfAllocator.h"
+
+namespace Falcor
+{
+    /** Sub-allocator for device-local buffer memory.
+
+        Memory is reserved in large heaps created through a backend, and ranges within the heaps are handed out
+        by a TLSF allocator per heap. Releases are deferred until the GPU has passed the fence value current at
+        the time of release, like GpuMemoryHeap. All functions can be called from any thread.
+
+        The backend only creates the heap objects, so the allocator can be tested without a device.
+    */
+    class dlldecl BufferAllocator
+    {
+    public:
+        using SharedPtr = std::shared_ptr<BufferAllocator>;
+        static const uint32_t kInvalidIndex = (uint32_t)-1;
+
+        /** Interface for creating heap objects.
+        */
+        class Backend
+        {
+        public:
+            using UniquePtr = std::unique_ptr<Backend>;
+            virtual ~Backend() = default;
+
+            /** Create a heap of the given size. The heap is released when the last reference to the returned handle goes away.
+            */
+            virtual ApiObjectHandle createHeap(uint64_t size) = 0;
+        };
+
+        struct Desc
+        {
+            uint64_t heapSize = 64 * 1024 * 1024;           ///< Size of each heap.
+            uint64_t maxAllocationSize = 4 * 1024 * 1024;   ///< Larger requests are not sub-allocated.
+            uint64_t granularity = 64 * 1024;               ///< Minimum allocation size and alignment.
+        };
+
+        struct Allocation
+        {
+            ApiObjectHandle pHeap;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t heapIndex = kInvalidIndex;
+            TlsfAllocator::Allocation range;
+            bool isValid() const { return heapIndex != kInvalidIndex; }
+        };
+
+        struct Stats
+        {
+            uint32_t heapCount = 0;
+            uint64_t heapSize = 0;              ///< Total size of all heaps.
+            uint64_t usedSize = 0;
+            uint64_t largestFreeBlock = 0;
+            uint32_t allocationCount = 0;
+            uint32_t freeBlockCount = 0;
+            uint32_t pendingReleaseCount = 0;   ///< Releases waiting for the GPU.
+            float fragmentation = 0.f;          ///< Fraction of the free space that is not part of the largest free block.
+        };
+
+        /** Create a new allocator.
+            \param[in] pBackend Backend used to create the heaps.
+            \param[in] desc Allocator configuration.
+            \param[in] pFence Fence used for deferred releases. Can be nullptr if the explicit fence value overloads are used.
+            \return A new object, or throws an exception if creation failed.
+        */
+        static SharedPtr create(Backend::UniquePtr pBackend, const Desc& desc, const GpuFence::SharedPtr& pFence);
+
+        /** Allocate memory.
+            \return A valid allocation, or an invalid one if the size exceeds Desc::maxAllocationSize.
+        */
+        Allocation allocate(uint64_t size, uint64_t alignment = 1);
+
+        /** Release an allocation once the GPU reaches the fence's current CPU value.
+        */
+        void release(Allocation& allocation);
+
+        /** Release an allocation once the GPU reaches the given fence value.
+        */
+        void release(Allocation& allocation, uint64_t fenceValue);
+
+        /** Return the memory of releases the GPU is done with to the heaps, using the fence's current GPU value.
+        */
+        void executeDeferredReleases();
+
+        /** Return the memory of releases with fence values up to and including completedValue to the heaps.
+        */
+        void executeDeferredReleases(uint64_t completedValue);
+
+        const Desc& getDesc() const { return mDesc; }
+        Stats getStats() const;
+
+    private:
+        BufferAllocator(Backend::UniquePtr pBackend, const Desc& desc, const GpuFence::SharedPtr& pFence);
+
+        struct Heap
+        {
+            ApiObjectHandle pHandle;
+            std::unique_ptr<TlsfAllocator> pAllocator;
+        };
+
+        Backend::UniquePtr mpBackend;
+        Desc mDesc;
+        GpuFence::SharedPtr mpFence;
+        mutable std::mutex mMutex;  ///< Guards the heaps.
+        std::vector<Heap> mHeaps;
+        DeferredReleaseQueue<Allocation> mDeferredReleases;
+    };
+}
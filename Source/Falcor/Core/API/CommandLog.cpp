@@ -0,0 +1,63 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "CommandLog.h"
+
+namespace Falcor
+{
+    uint64_t CommandLog::Stats::getTotalCount() const
+    {
+        uint64_t count = 0;
+        for (auto c : commandCount) count += c;
+        return count;
+    }
+
+    uint64_t CommandLog::Stats::getDrawCount() const
+    {
+        return getCount(Type::Draw) + getCount(Type::DrawIndexed) + getCount(Type::DrawIndirect) + getCount(Type::DrawIndexedIndirect);
+    }
+
+    CommandLog::SharedPtr CommandLog::create(bool keepCommands)
+    {
+        return SharedPtr(new CommandLog(keepCommands));
+    }
+
+    void CommandLog::record(const Command& command)
+    {
+        assert(command.type < Type::Count);
+        mStats.commandCount[(size_t)command.type]++;
+        if (command.type == Type::UpdateBuffer || command.type == Type::UpdateTexture) mStats.uploadedBytes += command.size;
+        if (mKeepCommands) mCommands.push_back(command);
+    }
+
+    void CommandLog::clear()
+    {
+        mCommands.clear();
+        mStats = Stats();
+    }
+}
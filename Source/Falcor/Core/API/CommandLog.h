@@ -0,0 +1,152 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    class Resource;
+
+    /** Records the commands issued through a CopyContext, ComputeContext or RenderContext.
+        Use it to inspect the command stream of a frame, or to count the commands and uploaded bytes of CPU-side benchmarks.
+        Commands that are implemented with other context commands log those as well, e.g. updateBuffer() also logs a CopyBufferRegion and blit() a Draw.
+        A log is not thread-safe, attach one log per context.
+    */
+    class dlldecl CommandLog
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CommandLog>;
+
+        enum class Type : uint32_t
+        {
+            ResourceBarrier,
+            UavBarrier,
+            CopyResource,
+            CopySubresource,
+            CopyBufferRegion,
+            CopySubresourceRegion,
+            UpdateBuffer,
+            UpdateTexture,
+            ClearRtv,
+            ClearDsv,
+            ClearUav,
+            Dispatch,
+            DispatchIndirect,
+            Draw,
+            DrawIndexed,
+            DrawIndirect,
+            DrawIndexedIndirect,
+            Raytrace,
+            Resolve,
+            Submit,
+
+            Count
+        };
+
+        struct Command
+        {
+            Type type;
+            const Resource* pResource = nullptr;    ///< Resource written by the command, if any. Only use it for identification, the resource may have been released since
+            uint64_t size = 0;                      ///< Bytes uploaded by UpdateBuffer/UpdateTexture and copied by CopyBufferRegion
+            uint32_t count = 0;                     ///< Vertex or index count of draws, thread-group count of dispatches, max command count of indirect draws, subresource count of texture updates
+            uint32_t instanceCount = 0;             ///< Instance count of draws
+        };
+
+        struct Stats
+        {
+            std::array<uint64_t, (size_t)Type::Count> commandCount = {};   ///< Number of commands of each type
+            uint64_t uploadedBytes = 0;                                     ///< Bytes uploaded from the CPU
+
+            uint64_t getCount(Type type) const { return commandCount[(size_t)type]; }
+            uint64_t getTotalCount() const;
+
+            /** Number of draw commands, including indirect ones.
+            */
+            uint64_t getDrawCount() const;
+        };
+
+        /** Create a new log.
+            \param[in] keepCommands If false, only the statistics are kept. Use this for long-running benchmarks.
+        */
+        static SharedPtr create(bool keepCommands = true);
+
+        /** Record a command.
+        */
+        void record(const Command& command);
+
+        /** Get the commands recorded since the log was created or cleared. Empty if the log doesn't keep commands.
+        */
+        const std::vector<Command>& getCommands() const { return mCommands; }
+
+        /** Get the statistics of the commands recorded since the log was created or cleared.
+        */
+        const Stats& getStats() const { return mStats; }
+
+        /** Discard the recorded commands and reset the statistics.
+        */
+        void clear();
+
+    private:
+        CommandLog(bool keepCommands) : mKeepCommands(keepCommands) {}
+
+        bool mKeepCommands;
+        std::vector<Command> mCommands;
+        Stats mStats;
+    };
+
+    inline std::string to_string(CommandLog::Type type)
+    {
+#define t2s(t_) case CommandLog::Type::t_: return #t_;
+        switch (type)
+        {
+            t2s(ResourceBarrier);
+            t2s(UavBarrier);
+            t2s(CopyResource);
+            t2s(CopySubresource);
+            t2s(CopyBufferRegion);
+            t2s(CopySubresourceRegion);
+            t2s(UpdateBuffer);
+            t2s(UpdateTexture);
+            t2s(ClearRtv);
+            t2s(ClearDsv);
+            t2s(ClearUav);
+            t2s(Dispatch);
+            t2s(DispatchIndirect);
+            t2s(Draw);
+            t2s(DrawIndexed);
+            t2s(DrawIndirect);
+            t2s(DrawIndexedIndirect);
+            t2s(Raytrace);
+            t2s(Resolve);
+            t2s(Submit);
+        default:
+            should_not_get_here();
+            return "";
+        }
+#undef t2s
+    }
+}
@@ -51,6 +51,7 @@ namespace Falcor
     {
         if (mCommandsPending)
         {
+            logCommand(CommandLog::Type::Submit);
             mpLowLevelData->flush();
             mCommandsPending = false;
         }
@@ -68,9 +69,9 @@ namespace Falcor
         }
     }
 
-    CopyContext::ReadTextureTask::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    CopyContext::ReadTextureTask::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const Buffer::SharedPtr& pStagingBuffer)
     {
-        return CopyContext::ReadTextureTask::create(this, pTexture, subresourceIndex);
+        return CopyContext::ReadTextureTask::create(this, pTexture, subresourceIndex, pStagingBuffer);
     }
 
     std::vector<uint8_t> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
@@ -174,6 +175,7 @@ namespace Falcor
         }
 
         mCommandsPending = true;
+        logCommand(CommandLog::Type::UpdateBuffer, pBuffer, numBytes);
         // Allocate a buffer on the upload heap
         Buffer::SharedPtr pUploadBuffer = Buffer::create(numBytes, Buffer::BindFlags::None, Buffer::CpuAccess::Write, pData);
 
@@ -28,6 +28,7 @@
 #pragma once
 #include "Resource.h"
 #include "LowLevelContextData.h"
+#include "CommandLog.h"
 
 namespace Falcor
 {
@@ -43,8 +44,22 @@ namespace Falcor
         {
         public:
             using SharedPtr = std::shared_ptr<ReadTextureTask>;
-            static SharedPtr create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex);
+            /** Record a copy of a texture subresource into a readback buffer and submit it.
+                \param[in] pCtx Context to record the copy on.
+                \param[in] pTexture Texture to read from.
+                \param[in] subresourceIndex Subresource to read.
+                \param[in] pStagingBuffer Optional readback buffer (CpuAccess::Read) to reuse. A new buffer is created if it is nullptr or too small.
+            */
+            static SharedPtr create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex, const Buffer::SharedPtr& pStagingBuffer = nullptr);
+
+            /** Wait for the copy to finish and return the texel data with tightly packed rows.
+                This only waits on the task's own fence and may be called from a thread other than the one that created the task.
+            */
             std::vector<uint8_t> getData();
+
+            /** Get the readback buffer used by the task. Can be passed to a later task for reuse once getData() has returned.
+            */
+            const Buffer::SharedPtr& getStagingBuffer() const { return mpBuffer; }
         private:
             ReadTextureTask() = default;
             GpuFence::SharedPtr mpFence;
@@ -126,8 +141,9 @@ namespace Falcor
         std::vector<uint8_t> readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
 
         /** Read texture data Asynchronously
+            \param[in] pStagingBuffer Optional readback buffer to reuse, see ReadTextureTask::create().
         */
-        ReadTextureTask::SharedPtr asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
+        ReadTextureTask::SharedPtr asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const Buffer::SharedPtr& pStagingBuffer = nullptr);
 
         /** Get the low-level context data
         */
@@ -141,6 +157,15 @@ namespace Falcor
         */
         void bindDescriptorHeaps();
 
+        /** Attach a log that records the commands issued through the context.
+            \param[in] pLog The log, or nullptr to stop recording.
+        */
+        void setCommandLog(const CommandLog::SharedPtr& pLog) { mpCommandLog = pLog; }
+
+        /** Get the attached command log, or nullptr if none is attached.
+        */
+        const CommandLog::SharedPtr& getCommandLog() const { return mpCommandLog; }
+
     protected:
         CopyContext(LowLevelContextData::CommandQueueType type, CommandQueueHandle queue);
 
@@ -150,7 +175,13 @@ namespace Falcor
         void apiSubresourceBarrier(const Texture* pTexture, Resource::State newState, Resource::State oldState, uint32_t arraySlice, uint32_t mipLevel);
         void updateTextureSubresources(const Texture* pTexture, uint32_t firstSubresource, uint32_t subresourceCount, const void* pData, const uint3& offset = uint3(0), const uint3& size = uint3(-1));
 
+        void logCommand(CommandLog::Type type, const Resource* pResource = nullptr, uint64_t size = 0, uint32_t count = 0, uint32_t instanceCount = 0)
+        {
+            if (mpCommandLog) mpCommandLog->record({ type, pResource, size, count, instanceCount });
+        }
+
         bool mCommandsPending = false;
         LowLevelContextData::SharedPtr mpLowLevelData;
+        CommandLog::SharedPtr mpCommandLog;
     };
 }
@@ -32,25 +32,74 @@
 
 namespace Falcor
 {
+    namespace
+    {
+        D3D12_RESOURCE_DESC getBufferDesc(size_t size, Buffer::BindFlags bindFlags)
+        {
+            D3D12_RESOURCE_DESC bufDesc = {};
+            bufDesc.Alignment = 0;
+            bufDesc.DepthOrArraySize = 1;
+            bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+            bufDesc.Flags = getD3D12ResourceFlags(bindFlags);
+            bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+            bufDesc.Height = 1;
+            bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+            bufDesc.MipLevels = 1;
+            bufDesc.SampleDesc.Count = 1;
+            bufDesc.SampleDesc.Quality = 0;
+            bufDesc.Width = size;
+            assert(bufDesc.Width > 0);
+            return bufDesc;
+        }
+
+        class D3D12BufferHeapBackend : public BufferAllocator::Backend
+        {
+        public:
+            ApiObjectHandle createHeap(uint64_t size) override
+            {
+                D3D12_HEAP_DESC desc = {};
+                desc.SizeInBytes = size;
+                desc.Properties = kDefaultHeapProps;
+                desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+                desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+                ID3D12HeapPtr pHeap;
+                d3d_call(gpDevice->getApiHandle()->CreateHeap(&desc, IID_PPV_ARGS(&pHeap)));
+                return pHeap;
+            }
+        };
+
+        bool isSubAllocatable(Buffer::CpuAccess cpuAccess, Buffer::BindFlags bindFlags, size_t size)
+        {
+            const auto& pAllocator = gpDevice->getBufferAllocator();
+            return pAllocator && cpuAccess == Buffer::CpuAccess::None && !is_set(bindFlags, Buffer::BindFlags::Shared) && size <= pAllocator->getDesc().maxAllocationSize;
+        }
+
+        ID3D12ResourcePtr createPlacedBuffer(Buffer::State initState, size_t size, const BufferAllocator::Allocation& allocation, Buffer::BindFlags bindFlags)
+        {
+            D3D12_RESOURCE_DESC bufDesc = getBufferDesc(size, bindFlags);
+            ID3D12HeapPtr pHeap = allocation.pHeap;
+            ID3D12ResourcePtr pApiHandle;
+            d3d_call(gpDevice->getApiHandle()->CreatePlacedResource(pHeap, allocation.offset, &bufDesc, getD3D12ResourceState(initState), nullptr, IID_PPV_ARGS(&pApiHandle)));
+            assert(pApiHandle);
+            return pApiHandle;
+        }
+    }
+
+    BufferAllocator::SharedPtr createBufferAllocator(const GpuFence::SharedPtr& pFence)
+    {
+        BufferAllocator::Desc desc;
+        desc.granularity = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        return BufferAllocator::create(std::make_unique<D3D12BufferHeapBackend>(), desc, pFence);
+    }
+
     ID3D12ResourcePtr createBuffer(Buffer::State initState, size_t size, const D3D12_HEAP_PROPERTIES& heapProps, Buffer::BindFlags bindFlags)
     {
         assert(gpDevice);
         ID3D12Device* pDevice = gpDevice->getApiHandle();
 
         // Create the buffer
-        D3D12_RESOURCE_DESC bufDesc = {};
-        bufDesc.Alignment = 0;
-        bufDesc.DepthOrArraySize = 1;
-        bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        bufDesc.Flags = getD3D12ResourceFlags(bindFlags);
-        bufDesc.Format = DXGI_FORMAT_UNKNOWN;
-        bufDesc.Height = 1;
-        bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        bufDesc.MipLevels = 1;
-        bufDesc.SampleDesc.Count = 1;
-        bufDesc.SampleDesc.Quality = 0;
-        bufDesc.Width = size;
-        assert(bufDesc.Width > 0);
+        D3D12_RESOURCE_DESC bufDesc = getBufferDesc(size, bindFlags);
 
         D3D12_RESOURCE_STATES d3dState = getD3D12ResourceState(initState);
         ID3D12ResourcePtr pApiHandle;
@@ -111,7 +160,24 @@ namespace Falcor
         {
             mState.global = Resource::State::Common;
             if (is_set(mBindFlags, BindFlags::AccelerationStructure)) mState.global = Resource::State::AccelerationStructure;
-            mApiHandle = createBuffer(mState.global, mSize, kDefaultHeapProps, mBindFlags);
+
+            // Small device-local buffers are placed in shared heaps to reduce the number of allocations.
+            if (isSubAllocatable(mCpuAccess, mBindFlags, mSize))
+            {
+                mSubAllocation = gpDevice->getBufferAllocator()->allocate(mSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+                mApiHandle = createPlacedBuffer(mState.global, mSize, mSubAllocation, mBindFlags);
+
+                // Unlike committed resources, placed resources are not zero-initialized, and the range may have been used by an earlier buffer
+                if (hasInitData == false)
+                {
+                    std::vector<uint8_t> zeros(mSize, 0);
+                    gpDevice->getRenderContext()->updateBuffer(this, zeros.data());
+                }
+            }
+            else
+            {
+                mApiHandle = createBuffer(mState.global, mSize, kDefaultHeapProps, mBindFlags);
+            }
         }
     }
 
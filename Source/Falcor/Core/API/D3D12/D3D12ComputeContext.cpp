@@ -111,6 +111,7 @@ namespace Falcor
 
         if (prepareForDispatch(pState, pVars) == false) return;
         mpLowLevelData->getCommandList()->Dispatch(dispatchSize.x, dispatchSize.y, dispatchSize.z);
+        logCommand(CommandLog::Type::Dispatch, nullptr, 0, dispatchSize.x * dispatchSize.y * dispatchSize.z);
     }
 
 
@@ -136,12 +137,14 @@ namespace Falcor
     void ComputeContext::clearUAV(const UnorderedAccessView* pUav, const float4& value)
     {
         clearUavCommon(this, pUav, value, mpLowLevelData->getCommandList().GetInterfacePtr());
+        logCommand(CommandLog::Type::ClearUav, pUav->getResource());
         mCommandsPending = true;
     }
 
     void ComputeContext::clearUAV(const UnorderedAccessView* pUav, const uint4& value)
     {
         clearUavCommon(this, pUav, value, mpLowLevelData->getCommandList().GetInterfacePtr());
+        logCommand(CommandLog::Type::ClearUav, pUav->getResource());
         mCommandsPending = true;
     }
 
@@ -158,5 +161,6 @@ namespace Falcor
         if (prepareForDispatch(pState, pVars) == false) return;
         resourceBarrier(pArgBuffer, Resource::State::IndirectArg);
         mpLowLevelData->getCommandList()->ExecuteIndirect(sApiData.pDispatchCommandSig, 1, pArgBuffer->getApiHandle(), argBufferOffset, nullptr, 0);
+        logCommand(CommandLog::Type::DispatchIndirect, nullptr, 0, 1);
     }
 }
@@ -140,9 +140,10 @@ namespace Falcor
         }
 
         pBuffer->unmap();
+        logCommand(CommandLog::Type::UpdateTexture, pTexture, bufferSize, subresourceCount);
     }
 
-    CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex)
+    CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex, const Buffer::SharedPtr& pStagingBuffer)
     {
         SharedPtr pThis = SharedPtr(new ReadTextureTask);
         pThis->mpContext = pCtx;
@@ -154,8 +155,15 @@ namespace Falcor
         ID3D12Device* pDevice = gpDevice->getApiHandle();
         pDevice->GetCopyableFootprints(&texDesc, subresourceIndex, 1, 0, &footprint, &pThis->mRowCount, &rowSize, &size);
 
-        //Create buffer
-        pThis->mpBuffer = Buffer::create(size, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+        //Create buffer, unless the caller provided a large enough one
+        if (pStagingBuffer && pStagingBuffer->getCpuAccess() == Buffer::CpuAccess::Read && pStagingBuffer->getSize() >= size)
+        {
+            pThis->mpBuffer = pStagingBuffer;
+        }
+        else
+        {
+            pThis->mpBuffer = Buffer::create(size, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+        }
 
         //Copy from texture to buffer
         D3D12_TEXTURE_COPY_LOCATION srcLoc = { pTexture->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, subresourceIndex };
@@ -245,6 +253,7 @@ namespace Falcor
     bool CopyContext::textureBarrier(const Texture* pTexture, Resource::State newState)
     {
         bool recorded = d3d12GlobalResourceBarrier(pTexture, newState, mpLowLevelData->getCommandList());
+        if (recorded) logCommand(CommandLog::Type::ResourceBarrier, pTexture);
         pTexture->setGlobalState(newState);
         mCommandsPending = mCommandsPending || recorded;
         return recorded;
@@ -254,6 +263,7 @@ namespace Falcor
     {
         if (pBuffer && pBuffer->getCpuAccess() != Buffer::CpuAccess::None) return false;
         bool recorded = d3d12GlobalResourceBarrier(pBuffer, newState, mpLowLevelData->getCommandList());
+        if (recorded) logCommand(CommandLog::Type::ResourceBarrier, pBuffer);
         pBuffer->setGlobalState(newState);
         mCommandsPending = mCommandsPending || recorded;
         return recorded;
@@ -263,6 +273,7 @@ namespace Falcor
     {
         uint32_t subresourceIndex = pTexture->getSubresourceIndex(arraySlice, mipLevel);
         d3d12ResourceBarrier(pTexture, newState, oldState, subresourceIndex, mpLowLevelData->getCommandList());
+        logCommand(CommandLog::Type::ResourceBarrier, pTexture);
     }
 
     void CopyContext::uavBarrier(const Resource* pResource)
@@ -276,6 +287,7 @@ namespace Falcor
         static const Resource::BindFlags reqFlags = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::AccelerationStructure;
         assert(is_set(pResource->getBindFlags(), reqFlags));
         mpLowLevelData->getCommandList()->ResourceBarrier(1, &barrier);
+        logCommand(CommandLog::Type::UavBarrier, pResource);
         mCommandsPending = true;
     }
 
@@ -284,6 +296,7 @@ namespace Falcor
         resourceBarrier(pDst, Resource::State::CopyDest);
         resourceBarrier(pSrc, Resource::State::CopySource);
         mpLowLevelData->getCommandList()->CopyResource(pDst->getApiHandle(), pSrc->getApiHandle());
+        logCommand(CommandLog::Type::CopyResource, pDst);
         mCommandsPending = true;
     }
 
@@ -304,6 +317,7 @@ namespace Falcor
         pSrcCopyLoc.SubresourceIndex = srcSubresourceIdx;
 
         mpLowLevelData->getCommandList()->CopyTextureRegion(&pDstCopyLoc, 0, 0, 0, &pSrcCopyLoc, NULL);
+        logCommand(CommandLog::Type::CopySubresource, pDst);
         mCommandsPending = true;
     }
 
@@ -312,6 +326,7 @@ namespace Falcor
         resourceBarrier(pDst, Resource::State::CopyDest);
         resourceBarrier(pSrc, Resource::State::CopySource);
         mpLowLevelData->getCommandList()->CopyBufferRegion(pDst->getApiHandle(), dstOffset, pSrc->getApiHandle(), pSrc->getGpuAddressOffset() + srcOffset, numBytes);
+        logCommand(CommandLog::Type::CopyBufferRegion, pDst, numBytes);
         mCommandsPending = true;
     }
 
@@ -340,6 +355,7 @@ namespace Falcor
         box.back = (size.z == -1) ? pSrc->getDepth(mipLevel) - box.front : size.z;
 
         mpLowLevelData->getCommandList()->CopyTextureRegion(&dstLoc, dstOffset.x, dstOffset.y, dstOffset.z, &srcLoc, &box);
+        logCommand(CommandLog::Type::CopySubresourceRegion, pDst);
 
         mCommandsPending = true;
     }
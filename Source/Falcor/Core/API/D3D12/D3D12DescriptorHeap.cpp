@@ -80,6 +80,7 @@ namespace Falcor
 
     D3D12DescriptorHeap::Allocation::SharedPtr D3D12DescriptorHeap::allocateDescriptors(uint32_t count)
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         if (setupCurrentChunk(count) == false) return nullptr;
 
         if (mpCurrentChunk->chunkCount * kDescPerChunk - mpCurrentChunk->currentDesc < count)
@@ -147,6 +148,7 @@ namespace Falcor
     
     void D3D12DescriptorHeap::releaseChunk(Chunk::SharedPtr pChunk)
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         pChunk->allocCount--;
         if (pChunk->allocCount == 0 && (pChunk != mpCurrentChunk))
         {
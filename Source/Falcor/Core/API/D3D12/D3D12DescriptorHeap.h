@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include <queue>
+#include <mutex>
 
 namespace Falcor
 {
@@ -136,5 +137,6 @@ namespace Falcor
         Chunk::SharedPtr mpCurrentChunk;
         std::vector<Chunk::SharedPtr> mFreeChunks; // Free list for standard sized chunks (1 chunk * kDescPerChunk)
         std::multiset<Chunk::SharedPtr, ChunkComparator> mFreeLargeChunks; // Free list for large chunks with the capacity of multiple chunks (>1 chunk * kDescPerChunk)
+        std::mutex mMutex; // Guards the chunks. Descriptors are allocated by render passes recording on worker threads
     };
 }
@@ -127,7 +127,7 @@ namespace Falcor
         return pSwapChain3;
     }
 
-    DeviceHandle createDevice(IDXGIFactory4* pFactory, D3D_FEATURE_LEVEL requestedFeatureLevel, const std::vector<UUID>& experimentalFeatures)
+    DeviceHandle createDevice(IDXGIFactory4* pFactory, D3D_FEATURE_LEVEL requestedFeatureLevel, const std::vector<UUID>& experimentalFeatures, bool useSoftwareAdapter)
     {
         // Feature levels to try creating devices. Listed in descending order so the highest supported level is used.
         const static D3D_FEATURE_LEVEL kFeatureLevels[] =
@@ -178,6 +178,21 @@ namespace Falcor
             return false;
         };
 
+        if (useSoftwareAdapter)
+        {
+            // WARP executes on the CPU and allocates the resources in host memory, so it works on machines without a GPU
+            bool created = SUCCEEDED(pFactory->EnumWarpAdapter(IID_PPV_ARGS(&pAdapter)));
+            if (created) created = (requestedFeatureLevel == 0) ? createMaxFeatureLevel(kFeatureLevels, arraysize(kFeatureLevels)) : createMaxFeatureLevel(&requestedFeatureLevel, 1);
+            if (created)
+            {
+                logInfo("Successfully created device on the software adapter with feature level: " + to_string(selectedFeatureLevel));
+                return pDevice;
+            }
+
+            logFatal("Could not create a D3D12 device on the software adapter");
+            return nullptr;
+        }
+
         // Properties to search for
         const uint32_t vendorId = (preferredGpuVendorId != kUnspecified) ? preferredGpuVendorId : kDefaultVendorId;
         const uint32_t gpuIdx = (preferredGpuIndex != kUnspecified) ? preferredGpuIndex : 0;
@@ -352,7 +367,7 @@ namespace Falcor
         d3d_call(CreateDXGIFactory2(dxgiFlags, IID_PPV_ARGS(&mpApiData->pDxgiFactory)));
 
         // Create the device
-        mApiHandle = createDevice(mpApiData->pDxgiFactory, getD3DFeatureLevel(mDesc.apiMajorVersion, mDesc.apiMinorVersion), mDesc.experimentalFeatures);
+        mApiHandle = createDevice(mpApiData->pDxgiFactory, getD3DFeatureLevel(mDesc.apiMajorVersion, mDesc.apiMinorVersion), mDesc.experimentalFeatures, mDesc.useSoftwareAdapter);
         if (mApiHandle == nullptr) return false;
 
         mSupportedFeatures = getSupportedFeatures(mApiHandle);
@@ -141,6 +141,7 @@ namespace Falcor
     {
         resourceBarrier(pRtv->getResource(), Resource::State::RenderTarget);
         mpLowLevelData->getCommandList()->ClearRenderTargetView(pRtv->getApiHandle()->getCpuHandle(0), glm::value_ptr(color), 0, nullptr);
+        logCommand(CommandLog::Type::ClearRtv, pRtv->getResource());
         mCommandsPending = true;
     }
 
@@ -151,6 +152,7 @@ namespace Falcor
 
         resourceBarrier(pDsv->getResource(), Resource::State::DepthStencil);
         mpLowLevelData->getCommandList()->ClearDepthStencilView(pDsv->getApiHandle()->getCpuHandle(0), D3D12_CLEAR_FLAGS(flags), depth, stencil, 0, nullptr);
+        logCommand(CommandLog::Type::ClearDsv, pDsv->getResource());
         mCommandsPending = true;
     }
 
@@ -330,6 +332,7 @@ namespace Falcor
     {
         if (prepareForDraw(pState, pVars) == false) return;
         mpLowLevelData->getCommandList()->DrawInstanced(vertexCount, instanceCount, startVertexLocation, startInstanceLocation);
+        logCommand(CommandLog::Type::Draw, nullptr, 0, vertexCount, instanceCount);
     }
 
     void RenderContext::draw(GraphicsState* pState, GraphicsVars* pVars, uint32_t vertexCount, uint32_t startVertexLocation)
@@ -341,6 +344,7 @@ namespace Falcor
     {
         if (prepareForDraw(pState, pVars) == false) return;
         mpLowLevelData->getCommandList()->DrawIndexedInstanced(indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+        logCommand(CommandLog::Type::DrawIndexed, nullptr, 0, indexCount, instanceCount);
     }
 
     void RenderContext::drawIndexed(GraphicsState* pState, GraphicsVars* pVars, uint32_t indexCount, uint32_t startIndexLocation, int32_t baseVertexLocation)
@@ -359,12 +363,14 @@ namespace Falcor
     {
         if (prepareForDraw(pState, pVars) == false) return;
         drawIndirectCommon(this, mpLowLevelData->getCommandList(), sApiData.pDrawCommandSig, maxCommandCount, pArgBuffer, argBufferOffset, pCountBuffer, countBufferOffset);
+        logCommand(CommandLog::Type::DrawIndirect, nullptr, 0, maxCommandCount);
     }
 
     void RenderContext::drawIndexedIndirect(GraphicsState* pState, GraphicsVars* pVars, uint32_t maxCommandCount, const Buffer* pArgBuffer, uint64_t argBufferOffset, const Buffer* pCountBuffer, uint64_t countBufferOffset)
     {
         if (prepareForDraw(pState, pVars) == false) return;
         drawIndirectCommon(this, mpLowLevelData->getCommandList(), sApiData.pDrawIndexCommandSig, maxCommandCount, pArgBuffer, argBufferOffset, pCountBuffer, countBufferOffset);
+        logCommand(CommandLog::Type::DrawIndexedIndirect, nullptr, 0, maxCommandCount);
     }
 
     void RenderContext::raytrace(RtProgram* pProgram, RtProgramVars* pVars, uint32_t width, uint32_t height, uint32_t depth)
@@ -414,6 +420,7 @@ namespace Falcor
         GET_COM_INTERFACE(pCmdList, ID3D12GraphicsCommandList4, pList4);
         pList4->SetPipelineState1(pRtso->getApiHandle().GetInterfacePtr());
         pList4->DispatchRays(&raytraceDesc);
+        logCommand(CommandLog::Type::Raytrace, nullptr, 0, width * height * depth);
     }
 
     void RenderContext::blit(ShaderResourceView::SharedPtr pSrc, RenderTargetView::SharedPtr pDst, const uint4& srcRect, const uint4& dstRect, Sampler::Filter filter)
@@ -484,6 +491,7 @@ namespace Falcor
     {
         DXGI_FORMAT format = getDxgiFormat(pDst->getFormat());
         mpLowLevelData->getCommandList()->ResolveSubresource(pDst->getApiHandle(), dstSubresource, pSrc->getApiHandle(), srcSubresource, format);
+        logCommand(CommandLog::Type::Resolve, pDst.get());
         mCommandsPending = true;
     }
 
@@ -199,6 +199,7 @@ namespace Falcor
     MAKE_SMART_COM_PTR(ID3D12CommandAllocator);
     MAKE_SMART_COM_PTR(ID3D12DescriptorHeap);
     MAKE_SMART_COM_PTR(ID3D12Resource);
+    MAKE_SMART_COM_PTR(ID3D12Heap);
     MAKE_SMART_COM_PTR(ID3D12Fence);
     MAKE_SMART_COM_PTR(ID3D12PipelineState);
     MAKE_SMART_COM_PTR(ID3D12RootSignature);
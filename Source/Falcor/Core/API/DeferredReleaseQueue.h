@@ -0,0 +1,207 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <queue>
+
+namespace Falcor
+{
+    /** Thread-safe queue of objects waiting for a GPU fence value before they can be released or reused.
+
+        Any thread can push objects, tagged with the fence value after which the GPU no longer accesses them.
+        Pushing is lock-free and doesn't allocate: entries go into a fixed-size ring (a bounded multi-producer queue),
+        with a locked overflow list used only when the ring is full.
+
+        Objects are retired in batches by a single consumer at a time. The consumer drains the ring into a list ordered
+        by fence value and hands out all objects whose fence value was reached. A thread that finds another consumer
+        active returns immediately instead of waiting.
+    */
+    template<typename T>
+    class DeferredReleaseQueue
+    {
+    public:
+        /** Create a queue.
+            \param[in] capacity Number of entries in the ring. Rounded up to a power of two.
+        */
+        explicit DeferredReleaseQueue(uint32_t capacity = 1024)
+        {
+            uint32_t size = 1;
+            while (size < capacity) size <<= 1;
+            mCells = std::make_unique<Cell[]>(size);
+            mMask = size - 1;
+            for (uint32_t i = 0; i < size; i++) mCells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+        DeferredReleaseQueue& operator=(const DeferredReleaseQueue&) = delete;
+
+        /** Add an object. Can be called from any thread.
+            \param[in] fenceValue The object is retired once the GPU fence reaches this value.
+            \param[in] object The object.
+        */
+        void push(uint64_t fenceValue, T object)
+        {
+            mPendingCount.fetch_add(1, std::memory_order_relaxed);
+
+            size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell& cell = mCells[pos & mMask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0)
+                {
+                    if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        cell.entry.fenceValue = fenceValue;
+                        cell.entry.object = std::move(object);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // The ring is full.
+                    std::lock_guard<std::mutex> lock(mOverflowMutex);
+                    mOverflow.push_back({ fenceValue, std::move(object) });
+                    return;
+                }
+                else
+                {
+                    pos = mEnqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /** Retire all objects whose fence value is less than or equal to completedValue.
+            \param[in] completedValue The last fence value reached by the GPU.
+            \param[in] func Called with each retired object before it is destroyed.
+            \return The number of retired objects. Returns 0 without waiting if another thread is consuming.
+        */
+        template<typename Func>
+        uint32_t release(uint64_t completedValue, Func func)
+        {
+            std::unique_lock<std::mutex> lock(mConsumerMutex, std::try_to_lock);
+            if (!lock.owns_lock()) return 0;
+
+            drain();
+            uint32_t count = 0;
+            while (mPending.size() && mPending.top().fenceValue <= completedValue)
+            {
+                // The priority queue only gives const access to its top, which is safe to move from right before popping.
+                Entry& entry = const_cast<Entry&>(mPending.top());
+                func(entry.object);
+                mPending.pop();
+                count++;
+            }
+            mPendingCount.fetch_sub(count, std::memory_order_relaxed);
+            return count;
+        }
+
+        uint32_t release(uint64_t completedValue)
+        {
+            return release(completedValue, [](T&) {});
+        }
+
+        /** Take a single retired object for reuse.
+            \param[in] completedValue The last fence value reached by the GPU.
+            \param[out] object The object, if one was available.
+            \return True if an object was returned. Returns false without waiting if another thread is consuming.
+        */
+        bool tryPop(uint64_t completedValue, T& object)
+        {
+            std::unique_lock<std::mutex> lock(mConsumerMutex, std::try_to_lock);
+            if (!lock.owns_lock()) return false;
+
+            drain();
+            if (mPending.empty() || mPending.top().fenceValue > completedValue) return false;
+            object = std::move(const_cast<Entry&>(mPending.top()).object);
+            mPending.pop();
+            mPendingCount.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /** Get the number of objects waiting to be retired. The value is approximate while other threads are pushing.
+        */
+        size_t getPendingCount() const { return mPendingCount.load(std::memory_order_relaxed); }
+
+        /** Destroy all objects without waiting for the fence. Must not be called concurrently with other operations.
+        */
+        void clear()
+        {
+            release(std::numeric_limits<uint64_t>::max());
+        }
+
+    private:
+        struct Entry
+        {
+            uint64_t fenceValue = 0;
+            T object = {};
+            bool operator>(const Entry& other) const { return fenceValue > other.fenceValue; }
+        };
+
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            Entry entry;
+        };
+
+        /** Move all pushed entries into the pending list. Must be called by the consumer.
+        */
+        void drain()
+        {
+            for (;;)
+            {
+                Cell& cell = mCells[mDequeuePos & mMask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                if (sequence != mDequeuePos + 1) break;
+                mPending.push(std::move(cell.entry));
+                cell.entry = {};
+                cell.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+                mDequeuePos++;
+            }
+
+            std::lock_guard<std::mutex> lock(mOverflowMutex);
+            for (auto& entry : mOverflow) mPending.push(std::move(entry));
+            mOverflow.clear();
+        }
+
+        std::unique_ptr<Cell[]> mCells;
+        size_t mMask = 0;
+        std::atomic<size_t> mEnqueuePos{ 0 };
+        size_t mDequeuePos = 0;
+        std::atomic<size_t> mPendingCount{ 0 };
+
+        std::mutex mOverflowMutex;
+        std::vector<Entry> mOverflow;
+
+        std::mutex mConsumerMutex;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> mPending;
+    };
+}
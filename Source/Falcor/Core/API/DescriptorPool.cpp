@@ -46,18 +46,11 @@ namespace Falcor
 
     void DescriptorPool::executeDeferredReleases()
     {
-        uint64_t gpuVal = mpFence->getGpuValue();
-        while (mpDeferredReleases.size() && mpDeferredReleases.top().fenceValue <= gpuVal)
-        {
-            mpDeferredReleases.pop();
-        }
+        mDeferredReleases.release(mpFence->getGpuValue());
     }
 
     void DescriptorPool::releaseAllocation(std::shared_ptr<DescriptorSetApiData> pData)
     {
-        DeferredRelease d;
-        d.pData = pData;
-        d.fenceValue = mpFence->getCpuValue();
-        mpDeferredReleases.push(d);
+        mDeferredReleases.push(mpFence->getCpuValue(), std::move(pData));
     }
 }
@@ -26,7 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
-#include <queue>
+#include "Core/API/DeferredReleaseQueue.h"
 
 namespace Falcor
 {
@@ -109,13 +109,6 @@ namespace Falcor
         std::shared_ptr<ApiData> mpApiData;
         GpuFence::SharedPtr mpFence;
 
-        struct DeferredRelease
-        {
-            std::shared_ptr<DescriptorSetApiData> pData;
-            uint64_t fenceValue;
-            bool operator>(const DeferredRelease& other) const { return fenceValue > other.fenceValue; }
-        };
-
-        std::priority_queue<DeferredRelease, std::vector<DeferredRelease>, std::greater<DeferredRelease>> mpDeferredReleases;
+        DeferredReleaseQueue<std::shared_ptr<DescriptorSetApiData>> mDeferredReleases;
     };
 }
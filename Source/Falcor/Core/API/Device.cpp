@@ -32,6 +32,7 @@ namespace Falcor
 {
     void createNullViews();
     void releaseNullViews();
+    BufferAllocator::SharedPtr createBufferAllocator(const GpuFence::SharedPtr& pFence);
 
     Device::SharedPtr gpDevice;
 
@@ -80,6 +81,9 @@ namespace Falcor
         mpRenderContext->flush();  // This will bind the descriptor heaps.
         // TODO: Do we need to flush here or should RenderContext::create() bind the descriptor heaps automatically without flush? See #749.
 
+        // Sub-allocated buffers are cleared with the render context, so the allocator is created after it
+        mpBufferAllocator = createBufferAllocator(mpFrameFence);
+
         // Update the FBOs
         if (updateDefaultFBO(mpWindow->getClientAreaSize().x, mpWindow->getClientAreaSize().y, mDesc.colorFormat, mDesc.depthFormat) == false)
         {
@@ -99,7 +103,7 @@ namespace Falcor
         }
 
         // Now execute all deferred releases
-        decltype(mDeferredReleases)().swap(mDeferredReleases);
+        mDeferredReleases.clear();
     }
 
     bool Device::updateDefaultFBO(uint32_t width, uint32_t height, ResourceFormat colorFormat, ResourceFormat depthFormat)
@@ -145,7 +149,7 @@ namespace Falcor
             // Some static objects get here when the application exits
             if(this)
             {
-                mDeferredReleases.push({ mpFrameFence->getCpuValue(), pResource });
+                mDeferredReleases.push(mpFrameFence->getCpuValue(), pResource);
             }
         }
     }
@@ -158,11 +162,8 @@ namespace Falcor
     void Device::executeDeferredReleases()
     {
         mpUploadHeap->executeDeferredReleases();
-        uint64_t gpuVal = mpFrameFence->getGpuValue();
-        while (mDeferredReleases.size() && mDeferredReleases.front().frameID <= gpuVal)
-        {
-            mDeferredReleases.pop();
-        }
+        if (mpBufferAllocator) mpBufferAllocator->executeDeferredReleases();
+        mDeferredReleases.release(mpFrameFence->getGpuValue());
         mpCpuDescPool->executeDeferredReleases();
         mpGpuDescPool->executeDeferredReleases();
     }
@@ -179,10 +180,11 @@ namespace Falcor
         // Release all the bound resources. Need to do that before deleting the RenderContext
         for (uint32_t i = 0; i < arraysize(mCmdQueues); i++) mCmdQueues[i].clear();
         for (uint32_t i = 0; i < kSwapChainBuffersCount; i++) mpSwapChainFbos[i].reset();
-        mDeferredReleases = decltype(mDeferredReleases)();
+        mDeferredReleases.clear();
         releaseNullViews();
         mpRenderContext.reset();
         mpUploadHeap.reset();
+        mpBufferAllocator.reset();
         mpCpuDescPool.reset();
         mpGpuDescPool.reset();
         mpFrameFence.reset();
@@ -283,6 +285,7 @@ namespace Falcor
         deviceDesc.field(apiMinorVersion);
         deviceDesc.field(enableVsync);
         deviceDesc.field(enableDebugLayer);
+        deviceDesc.field(useSoftwareAdapter);
         deviceDesc.field(cmdQueues);
 #undef field
     }
@@ -32,6 +32,8 @@
 #include "Core/API/RenderContext.h"
 #include "Core/API/DescriptorPool.h"
 #include "Core/API/GpuMemoryHeap.h"
+#include "Core/API/BufferAllocator.h"
+#include "Core/API/DeferredReleaseQueue.h"
 #include "Core/API/QueryHeap.h"
 
 namespace Falcor
@@ -62,6 +64,7 @@ namespace Falcor
             uint32_t apiMinorVersion = 0;                                   ///< Requested API minor version. If specified, device creation will fail if not supported. Otherwise, the highest supported version will be automatically selected.
             bool enableVsync = false;                                       ///< Controls vertical-sync
             bool enableDebugLayer = DEFAULT_ENABLE_DEBUG_LAYER;             ///< Enable the debug layer. The default for release build is false, for debug build it's true.
+            bool useSoftwareAdapter = false;                                ///< Create the device on the software rasterizer (WARP on D3D12). Resources are allocated in host memory, so this works on machines without a GPU.
 
             static_assert((uint32_t)LowLevelContextData::CommandQueueType::Direct == 2, "Default initialization of cmdQueues assumes that Direct queue index is 2");
             std::array<uint32_t, kQueueTypeCount> cmdQueues = { 0, 0, 1 };  ///< Command queues to create. If no direct-queues are created, mpRenderContext will not be initialized
@@ -156,6 +159,10 @@ namespace Falcor
         const DescriptorPool::SharedPtr& getCpuDescriptorPool() const { return mpCpuDescPool; }
         const DescriptorPool::SharedPtr& getGpuDescriptorPool() const { return mpGpuDescPool; }
         const GpuMemoryHeap::SharedPtr& getUploadHeap() const { return mpUploadHeap; }
+
+        /** Get the allocator used for small device-local buffers. Returns nullptr if the API doesn't support sub-allocating buffers.
+        */
+        const BufferAllocator::SharedPtr& getBufferAllocator() const { return mpBufferAllocator; }
         void releaseResource(ApiObjectHandle pResource);
         double getGpuTimestampFrequency() const { return mGpuTimestampFrequency; } // ms/tick
 
@@ -169,12 +176,7 @@ namespace Falcor
 #endif
     private:
         static constexpr uint32_t kSwapChainBuffersCount = 3;
-        struct ResourceRelease
-        {
-            size_t frameID;
-            ApiObjectHandle pApiObject;
-        };
-        std::queue<ResourceRelease> mDeferredReleases;
+        DeferredReleaseQueue<ApiObjectHandle> mDeferredReleases;
 
         uint32_t mCurrentBackBufferIndex;
         Fbo::SharedPtr mpSwapChainFbos[kSwapChainBuffersCount];
@@ -188,6 +190,7 @@ namespace Falcor
         Desc mDesc;
         ApiHandle mApiHandle;
         GpuMemoryHeap::SharedPtr mpUploadHeap;
+        BufferAllocator::SharedPtr mpBufferAllocator;
         DescriptorPool::SharedPtr mpCpuDescPool;
         DescriptorPool::SharedPtr mpGpuDescPool;
         bool mIsWindowOccluded = false;
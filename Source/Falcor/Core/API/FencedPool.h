@@ -26,8 +26,8 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
-#include <queue>
 #include "GpuFence.h"
+#include "DeferredReleaseQueue.h"
 
 namespace Falcor
 {
@@ -56,23 +56,16 @@ namespace Falcor
         ObjectType newObject()
         {
             // Retire the active object
-            Data data;
-            data.alloc = mActiveObject;
-            data.timestamp = mpFence->getCpuValue();
-            mQueue.push(data);
+            mQueue.push(mpFence->getCpuValue(), mActiveObject);
 
-            // The queue is sorted based on time. Check if the first object is free
-            data = mQueue.front();
-            if (data.timestamp <= mpFence->getGpuValue())
+            // Reuse the oldest retired object if the GPU is done with it
+            ObjectType pObj;
+            if (!mQueue.tryPop(mpFence->getGpuValue(), pObj))
             {
-                mQueue.pop();
-            }
-            else
-            {
-                data.alloc = createObject();
+                pObj = createObject();
             }
 
-            mActiveObject = data.alloc;
+            mActiveObject = pObj;
             return mActiveObject;
         }
 
@@ -93,15 +86,9 @@ namespace Falcor
             return pObj;
         }
 
-        struct Data
-        {
-            ObjectType alloc;
-            uint64_t timestamp;
-        };
-
         ObjectType mActiveObject;
         NewObjectFuncType mNewObjFunc = nullptr;
-        std::queue<Data> mQueue;
+        DeferredReleaseQueue<ObjectType> mQueue;
         GpuFence::SharedConstPtr mpFence;
         void* mpUserData;
     };
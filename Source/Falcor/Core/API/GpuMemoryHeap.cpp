@@ -31,16 +31,27 @@
 
 namespace Falcor
 {
+    namespace
+    {
+        const uint64_t kOffsetBits = 40;
+        const uint64_t kOffsetMask = (1ull << kOffsetBits) - 1;
+        const uint64_t kCountOne = 1ull << kOffsetBits;
+        const uint64_t kCountMask = ((1ull << 23) - 1) << kOffsetBits;
+        const uint64_t kRetiredBit = 1ull << 63;
+    }
+
     GpuMemoryHeap::~GpuMemoryHeap()
     {
-        mDeferredReleases = decltype(mDeferredReleases)();
+        mDeferredReleases.clear();
     }
 
     GpuMemoryHeap::GpuMemoryHeap(Type type, size_t pageSize, const GpuFence::SharedPtr& pFence)
         : mType(type)
         , mPageSize(pageSize)
         , mpFence(pFence)
+        , mDeferredReleases(4096)
     {
+        assert(pageSize <= kOffsetMask);
         allocateNewPage();
     }
 
@@ -51,26 +62,58 @@ namespace Falcor
 
     void GpuMemoryHeap::allocateNewPage()
     {
-        if (mpActivePage)
+        // Retire the active page. If it has no live allocations it can be recycled right away, otherwise the last release does it.
+        PageData* pActivePage = mpActivePage.load();
+        if (pActivePage)
         {
-            mUsedPages[mCurrentPageId] = std::move(mpActivePage);
+            uint64_t state = pActivePage->state.fetch_or(kRetiredBit);
+            if ((state & kCountMask) == 0)
+            {
+                mAvailablePages.push(std::move(mUsedPages[pActivePage->id]));
+                mUsedPages.erase(pActivePage->id);
+            }
         }
 
+        PageData::UniquePtr pPage;
         if (mAvailablePages.size())
         {
-            mpActivePage = std::move(mAvailablePages.front());
+            pPage = std::move(mAvailablePages.front());
             mAvailablePages.pop();
-            mpActivePage->allocationsCount = 0;
-            mpActivePage->currentOffset = 0;
         }
         else
         {
-            mpActivePage = std::make_unique<PageData>();
-            initBasePageData((*mpActivePage), mPageSize);
+            pPage = std::make_unique<PageData>();
+            initBasePageData((*pPage), mPageSize);
         }
 
-        mpActivePage->currentOffset = 0;
         mCurrentPageId++;
+        pPage->id = mCurrentPageId;
+        pPage->state.store(0);
+        mpActivePage.store(pPage.get());
+        mUsedPages[mCurrentPageId] = std::move(pPage);
+    }
+
+    bool GpuMemoryHeap::allocateFromPage(PageData* pPage, size_t size, size_t alignment, Allocation& data)
+    {
+        uint64_t state = pPage->state.load();
+        for (;;)
+        {
+            if (state & kRetiredBit) return false;
+            size_t currentOffset = align_to(alignment, (size_t)(state & kOffsetMask));
+            if (currentOffset + size > mPageSize) return false;
+            assert((state & kCountMask) != kCountMask);
+
+            uint64_t newState = ((state & ~kOffsetMask) + kCountOne) | (currentOffset + size);
+            if (pPage->state.compare_exchange_weak(state, newState))
+            {
+                // The page holds a live allocation now, so it can't be recycled under us.
+                data.pageID = pPage->id;
+                data.offset = currentOffset;
+                data.pData = pPage->pData + currentOffset;
+                data.pResourceHandle = pPage->pResourceHandle;
+                return true;
+            }
+        }
     }
 
     GpuMemoryHeap::Allocation GpuMemoryHeap::allocate(size_t size, size_t alignment)
@@ -83,20 +126,15 @@ namespace Falcor
         }
         else
         {
-            // Calculate the start
-            size_t currentOffset = align_to(alignment, mpActivePage->currentOffset);
-            if (currentOffset + size > mPageSize)
+            for (;;)
             {
-                currentOffset = 0;
-                allocateNewPage();
-            }
+                PageData* pPage = mpActivePage.load();
+                if (allocateFromPage(pPage, size, alignment, data)) break;
 
-            data.pageID = mCurrentPageId;
-            data.offset = currentOffset;
-            data.pData = mpActivePage->pData + currentOffset;
-            data.pResourceHandle = mpActivePage->pResourceHandle;
-            mpActivePage->currentOffset = currentOffset + size;
-            mpActivePage->allocationsCount++;
+                // The page is full. Switch to a new one unless another thread already did.
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mpActivePage.load() == pPage) allocateNewPage();
+            }
         }
 
         data.fenceValue = mpFence->getCpuValue();
@@ -106,38 +144,36 @@ namespace Falcor
     void GpuMemoryHeap::release(Allocation& data)
     {
         assert(data.pResourceHandle);
-        mDeferredReleases.push(data);
+        mDeferredReleases.push(mpFence->getCpuValue(), data);
     }
 
-    void GpuMemoryHeap::executeDeferredReleases()
+    void GpuMemoryHeap::releaseFromPage(const Allocation& data)
     {
-        uint64_t gpuVal = mpFence->getGpuValue();
-        while (mDeferredReleases.size() && mDeferredReleases.top().fenceValue <= gpuVal)
+        // Mega-pages are released with the resource handle.
+        if (data.pageID == Allocation::kMegaPageId) return;
+
+        auto it = mUsedPages.find(data.pageID);
+        assert(it != mUsedPages.end());
+        PageData* pPage = it->second.get();
+        uint64_t state = pPage->state.fetch_sub(kCountOne) - kCountOne;
+        if ((state & kCountMask) != 0) return;
+
+        if (state & kRetiredBit)
         {
-            const Allocation& data = mDeferredReleases.top();
-            if (data.pageID == mCurrentPageId)
-            {
-                mpActivePage->allocationsCount--;
-                if (mpActivePage->allocationsCount == 0)
-                {
-                    mpActivePage->currentOffset = 0;
-                }
-            }
-            else
-            {
-                if (data.pageID != Allocation::kMegaPageId)
-                {
-                    auto& pData = mUsedPages[data.pageID];
-                    pData->allocationsCount--;
-                    if (pData->allocationsCount == 0)
-                    {
-                        mAvailablePages.push(std::move(pData));
-                        mUsedPages.erase(data.pageID);
-                    }
-                }
-                // else it's a mega-page. Popping it will release the resource
-            }
-            mDeferredReleases.pop();
+            mAvailablePages.push(std::move(it->second));
+            mUsedPages.erase(it);
         }
+        else
+        {
+            // The active page is empty, start over from the beginning. Fails harmlessly if another thread allocated in the meantime.
+            pPage->state.compare_exchange_strong(state, 0);
+        }
+    }
+
+    void GpuMemoryHeap::executeDeferredReleases()
+    {
+        uint64_t gpuVal = mpFence->getGpuValue();
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDeferredReleases.release(gpuVal, [this](Allocation& data) { releaseFromPage(data); });
     }
 }
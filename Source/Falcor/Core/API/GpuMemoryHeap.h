@@ -28,9 +28,15 @@
 #pragma once
 #include <queue>
 #include "Core/API/GpuFence.h"
+#include "Core/API/DeferredReleaseQueue.h"
 
 namespace Falcor
 {   
+    /** Heap of CPU-accessible GPU memory, sub-allocated linearly in pages.
+
+        allocate() and release() can be called from any thread. Allocations from the active page are lock-free; switching pages takes a lock.
+        Released allocations are returned to their page by executeDeferredReleases() once the GPU passed the fence value current at release time.
+    */
     class dlldecl GpuMemoryHeap
     {
     public:
@@ -57,7 +63,6 @@ namespace Falcor
             uint64_t fenceValue = 0;
 
             static const uint64_t kMegaPageId = -1;
-            bool operator<(const Allocation& other)  const { return fenceValue > other.fenceValue; }
         };
 
         ~GpuMemoryHeap();
@@ -80,8 +85,11 @@ namespace Falcor
 
         struct PageData : public BaseData
         {
-            uint32_t allocationsCount = 0;
-            size_t currentOffset = 0;
+            /** Packed page state, updated atomically so that allocations don't need a lock.
+                Bits 0-39 hold the current offset, bits 40-62 the number of live allocations, and bit 63 is set once the page is no longer active.
+            */
+            std::atomic<uint64_t> state{ 0 };
+            uint64_t id = 0;
 
             using UniquePtr = std::unique_ptr<PageData>;
         };
@@ -90,13 +98,16 @@ namespace Falcor
         GpuFence::SharedPtr mpFence;
         size_t mPageSize = 0;
         size_t mCurrentPageId = 0;
-        PageData::UniquePtr mpActivePage;
+        std::atomic<PageData*> mpActivePage{ nullptr };
 
-        std::priority_queue<Allocation> mDeferredReleases;
-        std::unordered_map<size_t, PageData::UniquePtr> mUsedPages;
+        std::mutex mMutex;  ///< Guards the page containers and page switching.
+        DeferredReleaseQueue<Allocation> mDeferredReleases;
+        std::unordered_map<size_t, PageData::UniquePtr> mUsedPages; ///< All pages in use, including the active page.
         std::queue<PageData::UniquePtr> mAvailablePages;
 
+        bool allocateFromPage(PageData* pPage, size_t size, size_t alignment, Allocation& data);
         void allocateNewPage();
+        void releaseFromPage(const Allocation& data);
         void initBasePageData(BaseData& data, size_t size);
     };
 }
@@ -29,7 +29,7 @@
 #include "Texture.h"
 #include "Device.h"
 #include "RenderContext.h"
-#include "Utils/Threading.h"
+#include "Utils/Image/AsyncTextureWriter.h"
 
 #include <mutex>
 
@@ -272,30 +272,19 @@ namespace Falcor
         // Handle the special case where we have an HDR texture with less then 3 channels
         FormatType type = getFormatType(mFormat);
         uint32_t channels = getFormatChannelCount(mFormat);
-        std::vector<uint8_t> textureData;
-        ResourceFormat resourceFormat = mFormat;
 
+        // The readback is submitted here, but waiting for it and encoding the image happens on the writer's worker threads.
         if (type == FormatType::Float && channels < 3)
         {
             Texture::SharedPtr pOther = Texture::create2D(getWidth(mipLevel), getHeight(mipLevel), ResourceFormat::RGBA32Float, 1, 1, nullptr, ResourceBindFlags::RenderTarget | ResourceBindFlags::ShaderResource);
             pContext->blit(getSRV(mipLevel, 1, arraySlice, 1), pOther->getRTV(0, 0, 1));
-            textureData = pContext->readTextureSubresource(pOther.get(), 0);
-            resourceFormat = ResourceFormat::RGBA32Float;
+            AsyncTextureWriter::instance().capture(pContext, pOther.get(), 0, filename, format, exportFlags);
         }
         else
         {
             uint32_t subresource = getSubresourceIndex(arraySlice, mipLevel);
-            textureData = pContext->readTextureSubresource(this, subresource);
+            AsyncTextureWriter::instance().capture(pContext, this, subresource, filename, format, exportFlags);
         }
-
-        uint32_t width = getWidth(mipLevel);
-        uint32_t height = getHeight(mipLevel);
-        auto func = [=]()
-        {
-            Bitmap::saveImage(filename, width, height, format, exportFlags, resourceFormat, true, (void*)textureData.data());
-        };
-
-        Threading::dispatchTask(func);
     }
 
     void Texture::uploadInitData(const void* pData, bool autoGenMips)
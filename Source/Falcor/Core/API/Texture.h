@@ -165,7 +165,7 @@ namespace Falcor
 
         /** Create a new texture object from a file.
             \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory.
-            \param[in] generateMipLevels Whether the mip-chain should be generated.
+            \param[in] generateMipLevels Whether the mip-chain should be generated. The mips are generated on the CPU (see MipGenerator), or on the GPU if the format is not supported.
             \param[in] loadAsSrgb Load the texture using sRGB format. Only valid for 3 or 4 component textures.
             \param[in] bindFlags The bind flags to create the texture with.
             \return A new texture, or nullptr if the texture failed to load.
@@ -223,6 +223,7 @@ namespace Falcor
         UnorderedAccessView::SharedPtr getUAV(uint32_t mipLevel, uint32_t firstArraySlice = 0, uint32_t arraySize = kMaxPossible);
 
         /** Capture the texture to an image file.
+            The file is written asynchronously by AsyncTextureWriter. Call AsyncTextureWriter::instance().waitForCompletion() to wait for it.
             \param[in] mipLevel Requested mip-level
             \param[in] arraySlice Requested array-slice
             \param[in] filename Name of the file to save.
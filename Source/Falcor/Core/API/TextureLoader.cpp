@@ -31,6 +31,7 @@
 #include "Utils/StringUtils.h"
 #include <cstring>
 #include "Utils/Image/ImageIO.h"
+#include "Utils/Image/MipGenerator.h"
 
 static const bool kTopDown = true;
 
@@ -50,6 +51,10 @@ namespace Falcor
         {
             pTex = ImageIO::loadTextureFromDDS(filename, loadAsSrgb);
         }
+        else if (generateMipLevels)
+        {
+            pTex = MipGenerator::createTextureFromFile(fullpath, loadAsSrgb, false, MipGenerator::kTextureLoadFilter, bindFlags);
+        }
         else
         {
             Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(fullpath, kTopDown);
@@ -61,7 +66,7 @@ namespace Falcor
                     texFormat = linearToSrgbFormat(texFormat);
                 }
 
-                pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
+                pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, 1, pBitmap->getData(), bindFlags);
             }
         }
 
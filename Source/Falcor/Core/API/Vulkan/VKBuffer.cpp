@@ -46,6 +46,12 @@ namespace Falcor
         return deviceMem;
     }
 
+    BufferAllocator::SharedPtr createBufferAllocator(const GpuFence::SharedPtr& pFence)
+    {
+        // Buffers are not sub-allocated on Vulkan.
+        return nullptr;
+    }
+
     void* mapBufferApi(const Buffer::ApiHandle& apiHandle, size_t size)
     {
         void* pData;
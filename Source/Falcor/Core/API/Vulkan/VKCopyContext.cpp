@@ -184,8 +184,11 @@ namespace Falcor
 
         dataSize = getMipLevelPackedDataSize(pTexture, vkCopy.imageExtent.width, vkCopy.imageExtent.height, vkCopy.imageExtent.depth, pTexture->getFormat());
 
-        // Upload the data to a staging buffer
-        pStaging = Buffer::create(dataSize, Buffer::BindFlags::None, pSrcData ? Buffer::CpuAccess::Write : Buffer::CpuAccess::Read, pSrcData);
+        // Upload the data to a staging buffer. Readback buffers passed in by the caller are reused if large enough.
+        if (pSrcData || !pStaging || pStaging->getSize() < dataSize)
+        {
+            pStaging = Buffer::create(dataSize, Buffer::BindFlags::None, pSrcData ? Buffer::CpuAccess::Write : Buffer::CpuAccess::Read, pSrcData);
+        }
         vkCopy.bufferOffset = pStaging->getGpuAddressOffset();
     }
 
@@ -219,10 +222,11 @@ namespace Falcor
         }
     }
 
-    CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex)
+    CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex, const Buffer::SharedPtr& pStagingBuffer)
     {
         SharedPtr pThis = SharedPtr(new ReadTextureTask);
         pThis->mpContext = pCtx;
+        if (pStagingBuffer && pStagingBuffer->getCpuAccess() == Buffer::CpuAccess::Read) pThis->mpBuffer = pStagingBuffer;
 
         VkBufferImageCopy vkCopy;
         initTexAccessParams(pTexture, subresourceIndex, vkCopy, pThis->mpBuffer, nullptr, {}, uint3(-1, -1, -1), pThis->mDataSize);
@@ -247,6 +251,7 @@ namespace Falcor
         std::vector<uint8> result(mDataSize);
         uint8* pData = reinterpret_cast<uint8*>(mpBuffer->map(Buffer::MapType::Read));
         std::memcpy(result.data(), pData, mDataSize);
+        mpBuffer->unmap();
         return result;
     }
 
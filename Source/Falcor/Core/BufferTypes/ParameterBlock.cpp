@@ -285,6 +285,7 @@ namespace Falcor
         : mpReflector(pReflection)
         , mpProgramVersion(pProgramVersion)
         , mData(pReflection->getElementType()->getByteSize(), 0)
+        , mDirtyUniformRange(0, mData.size())
     {
         ReflectionStructType::BuildState state;
         auto pElementType = getElementType();
@@ -567,6 +568,38 @@ namespace Falcor
     }
 
     void ParameterBlock::markUniformDataDirty() const
+    {
+        mDirtyUniformRange = { 0, mData.size() };
+        bumpUniformDataEpoch();
+    }
+
+    void ParameterBlock::markUniformDataDirty(size_t offset, size_t size) const
+    {
+        if (mDirtyUniformRange.first >= mDirtyUniformRange.second) mDirtyUniformRange = { offset, offset + size };
+        else mDirtyUniformRange = { std::min(mDirtyUniformRange.first, offset), std::max(mDirtyUniformRange.second, offset + size) };
+        bumpUniformDataEpoch();
+    }
+
+    bool ParameterBlock::updateUniformData(const UniformUpdate* pUpdates, size_t count)
+    {
+        size_t first = mData.size(), last = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto& u = pUpdates[i];
+            assert(u.offset + u.size <= mData.size());
+            uint8_t* pDst = mData.data() + u.offset;
+            if (std::memcmp(pDst, u.pSrc, u.size) == 0) continue;
+            std::memcpy(pDst, u.pSrc, u.size);
+            first = std::min(first, u.offset);
+            last = std::max(last, u.offset + u.size);
+        }
+
+        if (first >= last) return false;
+        markUniformDataDirty(first, last - first);
+        return true;
+    }
+
+    void ParameterBlock::bumpUniformDataEpoch() const
     {
         auto epoch = mEpochOfLastChange++;
         mEpochOfLastUniformDataChange = epoch;
@@ -1127,6 +1160,7 @@ namespace Falcor
         // to avoid redundantly filling in the buffer yet again.
         //
         mUnderlyingConstantBuffer.epochOfLastObservedChange = epochOfLastUniformDataChange;
+        mDirtyUniformRange = { 0, 0 };
 
         // Finally, we need to clobber the constant buffer view object,
         // because it is created on demand, and the old view will still
@@ -1217,13 +1251,28 @@ namespace Falcor
         {
             const uint8_t* pVar = mData.data() + offset.getByteOffset();
             *(VarType*)pVar = value;
-            markUniformDataDirty();
+            markUniformDataDirty(offset.getByteOffset(), sizeof(VarType));
             return true;
         }
         return false;
     }
 
-#define set_constant_by_offset(_t) template dlldecl bool ParameterBlock::setVariable(UniformShaderVarOffset offset, const _t& value)
+    template<typename VarType>
+    bool ParameterBlock::checkVariableType(const TypedShaderVarOffset& offset) const
+    {
+        auto pType = offset.getType();
+        const ReflectionBasicType* pBasicType = pType ? pType->asBasicType() : nullptr;
+        if (!pBasicType || pBasicType->getType() != getReflectionTypeFromCType<VarType>())
+        {
+            logError("ParameterBlock::checkVariableType() - Type mismatch. The variable at byte offset " + std::to_string(offset.getUniform().getByteOffset()) +
+                " was declared with type " + to_string(pBasicType ? pBasicType->getType() : ReflectionBasicType::Type::Unknown) + ", but accessed as " + to_string(getReflectionTypeFromCType<VarType>()) + ".");
+            return false;
+        }
+        return true;
+    }
+
+#define set_constant_by_offset(_t) template dlldecl bool ParameterBlock::setVariable(UniformShaderVarOffset offset, const _t& value); \
+    template dlldecl bool ParameterBlock::checkVariableType<_t>(const TypedShaderVarOffset& offset) const
 
     set_constant_by_offset(bool);
     set_constant_by_offset(bool2);
@@ -1270,7 +1319,7 @@ namespace Falcor
             return false;
         }
         std::memcpy(mData.data() + offset, pSrc, size);
-        markUniformDataDirty();
+        markUniformDataDirty(offset, size);
         return true;
     }
 
@@ -153,6 +153,44 @@ namespace Falcor
         bool setBlob(const void* pSrc, UniformShaderVarOffset offset, size_t size);
         bool setBlob(const void* pSrc, size_t offset, size_t size);
 
+        /** Check that a variable has the basic type matching T. Logs an error on a mismatch.
+        */
+        template<typename T>
+        bool checkVariableType(const TypedShaderVarOffset& offset) const;
+
+        /** Write uniform data without validation. The block is only marked dirty if the data differs from the current contents.
+            This is the fast path used by UniformVarHandle. The caller is responsible for passing an offset and size inside the block's uniform data.
+            \return True if the data changed.
+        */
+        bool updateUniformData(size_t offset, const void* pSrc, size_t size)
+        {
+            assert(offset + size <= mData.size());
+            uint8_t* pDst = mData.data() + offset;
+            if (std::memcmp(pDst, pSrc, size) == 0) return false;
+            std::memcpy(pDst, pSrc, size);
+            markUniformDataDirty(offset, size);
+            return true;
+        }
+
+        /** A uniform data write, see updateUniformData().
+        */
+        struct UniformUpdate
+        {
+            size_t offset;
+            const void* pSrc;
+            size_t size;
+        };
+
+        /** Apply a batch of uniform data writes without validation. The block is marked dirty at most once, covering the range of the writes that changed data.
+            \return True if any data changed.
+        */
+        bool updateUniformData(const UniformUpdate* pUpdates, size_t count);
+
+        /** Get the byte range [first, second) of the uniform data that changed since the underlying constant buffer was last written.
+            The range is empty (first >= second) if nothing changed.
+        */
+        std::pair<size_t, size_t> getDirtyUniformRange() const { return mDirtyUniformRange; }
+
         /** Bind a buffer by name.
             If the name doesn't exists, the bind flags don't match the shader requirements or the size doesn't match the required size, the call will fail.
             \param[in] name The name of the buffer in the program
@@ -329,6 +367,7 @@ namespace Falcor
         void collectSpecializationArgs(SpecializationArgs& ioArgs) const;
 
         void markUniformDataDirty() const;
+        void markUniformDataDirty(size_t offset, size_t size) const;
 
         void const* getRawData() { return mData.data(); }
 
@@ -391,6 +430,7 @@ namespace Falcor
         ParameterBlockReflection::SharedConstPtr mpReflector;
         mutable ParameterBlockReflection::SharedConstPtr mpSpecializedReflector;
         std::vector<uint8_t> mData;
+        mutable std::pair<size_t, size_t> mDirtyUniformRange;     ///< Range of mData changed since the underlying constant buffer was written
 
         virtual bool updateSpecializationImpl() const;
         void createConstantBuffers(const ShaderVar& var);
@@ -482,6 +522,7 @@ namespace Falcor
         uint32_t getDescriptorSetIndex(const BindLocation& bindLocation);
         void markDescriptorSetDirty(uint32_t index) const;
         void markDescriptorSetDirty(const BindLocation& bindLocation);
+        void bumpUniformDataEpoch() const;
 
         struct UnderlyingConstantBuffer
         {
@@ -551,4 +592,16 @@ namespace Falcor
     {
         return mpBlock->setVariable(mOffset, val);
     }
+
+    template<typename T> UniformVarHandle<T> ShaderVar::getUniformHandle() const
+    {
+        if (!isValid() || !mpBlock->checkVariableType<T>(mOffset)) return UniformVarHandle<T>();
+        return UniformVarHandle<T>(mpBlock, getByteOffset());
+    }
+
+    template<typename T> bool UniformVarHandle<T>::set(const T& value) const
+    {
+        assert(isValid());
+        return mpBlock->updateUniformData(mByteOffset, &value, sizeof(T));
+    }
 }
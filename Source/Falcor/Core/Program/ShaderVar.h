@@ -37,6 +37,38 @@ namespace Falcor
     template<typename T>
     class ParameterBlockSharedPtr;
 
+    /** A pre-resolved handle to a uniform variable of type T in a parameter block.
+
+        A handle is created once using `ShaderVar::getUniformHandle<T>()`, which performs the name lookup and type check.
+        Setting the value through the handle afterwards is a plain memcpy into the block's uniform data, skipping
+        the string lookup and reflection checks done by `ShaderVar`. The block is only marked dirty if the value changed.
+
+        Like `ShaderVar`, a handle doesn't own the parameter block it points into. The handle must not outlive the block,
+        and becomes stale if the block is re-created (e.g., after a program recompile).
+    */
+    template<typename T>
+    class UniformVarHandle
+    {
+    public:
+        UniformVarHandle() = default;
+
+        bool isValid() const { return mpBlock != nullptr; }
+
+        /** Set the value. Returns true if the value changed.
+        */
+        bool set(const T& value) const;
+
+        ParameterBlock* getBlock() const { return mpBlock; }
+        size_t getByteOffset() const { return mByteOffset; }
+
+    private:
+        friend struct ShaderVar;
+        UniformVarHandle(ParameterBlock* pBlock, size_t byteOffset) : mpBlock(pBlock), mByteOffset(byteOffset) {}
+
+        ParameterBlock* mpBlock = nullptr;
+        size_t mByteOffset = 0;
+    };
+
     /** A "pointer" to a shader variable stored in some parameter block.
 
     A `ShaderVar` works like a pointer to the data "inside" a `ParameterBlock`.
@@ -163,6 +195,11 @@ namespace Falcor
             return setImpl<T>(val);
         }
 
+        /** Resolve this variable into a handle for fast repeated updates of its uniform data.
+            Logs an error and returns an invalid handle if the variable doesn't have a basic type matching T.
+        */
+        template<typename T> UniformVarHandle<T> getUniformHandle() const;
+
         /** Assign raw binary data to the pointed-to value.
 
             This operation will only assign to the ordinary/"uniform" data pointed to by this shader variable, and will not affect any
@@ -177,6 +177,7 @@ namespace Falcor
         if (mVideoCapture.pVideoCapture) endVideoCapture();
 
         Clock::shutdown();
+        AsyncTextureWriter::shutdown();
         Threading::shutdown();
         Scripting::shutdown();
         RenderPassLibrary::instance().shutdown();
@@ -29,6 +29,11 @@
 #include "LightCollection.h"
 #include "LightCollectionShared.slang"
 #include "Scene/Scene.h"
+#include "Scene/CPU/CPUTexture.h"
+#include "Utils/Color/ColorHelpers.slang"
+#include "Utils/NumericRange.h"
+#include "Utils/StringUtils.h"
+#include <execution>
 #include <sstream>
 
 namespace Falcor
@@ -43,11 +48,69 @@ namespace Falcor
         const char kBuildTriangleListFile[] = "Experimental/Scene/Lights/BuildTriangleList.cs.slang";
         const char kUpdateTriangleVerticesFile[] = "Experimental/Scene/Lights/UpdateTriangleVertices.cs.slang";
         const char kFinalizeIntegrationFile[] = "Experimental/Scene/Lights/FinalizeIntegration.cs.slang";
+
+        const int kIntegratorViewportDim = 16384;   ///< Viewport size used by the GPU integrator. The CPU integrator clips to the same region to produce identical results.
+
+        /** Texture addressing of the material sampler.
+        */
+        struct TextureAddressing
+        {
+            Sampler::AddressMode modeU = Sampler::AddressMode::Wrap;
+            Sampler::AddressMode modeV = Sampler::AddressMode::Wrap;
+            float3 borderColor = float3(0.f);
+        };
+
+        /** Sum up the texels covered by a triangle in texture space.
+            This approximates the GPU integrator, which rasterizes the triangle scaled to the texture resolution and point samples the texture once per covered texel center.
+            Coverage of texels on triangle edges can differ from the hardware rasterization rules, so the flux matches the GPU within a small tolerance, not exactly.
+            \param[in] texture The emissive texture.
+            \param[in] texCoords The triangle's texture coordinates.
+            \param[in] addressing Texture addressing of the material sampler.
+            \return Sum over texels (RGB) and number of texels (A).
+        */
+        float4 integrateTexels(const CPUTexture& texture, const float2 texCoords[3], const TextureAddressing& addressing)
+        {
+            const float2 dims((float)texture.getWidth(), (float)texture.getHeight());
+            const float2 uvMin = glm::min(glm::min(texCoords[0], texCoords[1]), texCoords[2]);
+            const float2 offset = glm::floor(uvMin);
+
+            // Vertex positions in texels, offset so that they are positive.
+            float2 p[3];
+            for (uint32_t i = 0; i < 3; i++) p[i] = (texCoords[i] - offset) * dims;
+
+            const float2 pMin = glm::min(glm::min(p[0], p[1]), p[2]);
+            const float2 pMax = glm::max(glm::max(p[0], p[1]), p[2]);
+            const int x0 = std::max((int)std::ceil(pMin.x - 0.5f), 0);
+            const int y0 = std::max((int)std::ceil(pMin.y - 0.5f), 0);
+            const int x1 = std::min((int)std::floor(pMax.x - 0.5f), kIntegratorViewportDim - 1);
+            const int y1 = std::min((int)std::floor(pMax.y - 0.5f), kIntegratorViewportDim - 1);
+
+            // Edge functions, oriented so that the interior is positive regardless of winding.
+            auto edge = [] (const float2& a, const float2& b, const float2& c) { return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x); };
+            const float orientation = edge(p[0], p[1], p[2]) < 0.f ? -1.f : 1.f;
+
+            const int2 texelOffset = int2(offset * dims);
+            float4 sum(0.f);
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    const float2 c(x + 0.5f, y + 0.5f);
+                    if (orientation * edge(p[0], p[1], c) < 0.f || orientation * edge(p[1], p[2], c) < 0.f || orientation * edge(p[2], p[0], c) < 0.f) continue;
+
+                    int tx = CPUTexture::applyAddressMode(x + texelOffset.x, (int)texture.getWidth(), addressing.modeU);
+                    int ty = CPUTexture::applyAddressMode(y + texelOffset.y, (int)texture.getHeight(), addressing.modeV);
+                    float3 color = (tx < 0 || ty < 0) ? addressing.borderColor : float3(texture.getTexel(tx, ty));
+                    sum += float4(color, 1.f);
+                }
+            }
+            return sum;
+        }
     }
 
-    LightCollection::SharedPtr LightCollection::create(RenderContext* pRenderContext, const std::shared_ptr<Scene>& pScene)
+    LightCollection::SharedPtr LightCollection::create(RenderContext* pRenderContext, const std::shared_ptr<Scene>& pScene, const Options& options)
     {
-        SharedPtr ptr = SharedPtr(new LightCollection());
+        SharedPtr ptr = SharedPtr(new LightCollection(options));
         return ptr->init(pRenderContext, pScene) ? ptr : nullptr;
     }
 
@@ -100,9 +163,10 @@ namespace Falcor
         // Setup the lights.
         if (!setupMeshLights(*pScene)) return false;
 
-        // Create program for integrating emissive textures.
+        // Create program for integrating emissive textures on the GPU.
         // This should be done after lights are setup, so that we know which sampler state etc. to use.
-        if (!initIntegrator(*pScene)) return false;
+        // If the lights are built on the CPU, the program is created on demand as a fallback in build().
+        if (!mOptions.buildOnCPU && !initIntegrator(*pScene)) return false;
 
         // Create programs for building/updating the mesh lights.
         Shader::DefineList defines = pScene->getSceneDefines();
@@ -113,9 +177,7 @@ namespace Falcor
         mpStagingFence = GpuFence::create();
 
         // Now build the mesh light data.
-        build(pRenderContext, *pScene);
-
-        return true;
+        return build(pRenderContext, *pScene);
     }
 
     bool LightCollection::initIntegrator(const Scene& scene)
@@ -215,7 +277,7 @@ namespace Falcor
         return true;
     }
 
-    void LightCollection::build(RenderContext* pRenderContext, const Scene& scene)
+    bool LightCollection::build(RenderContext* pRenderContext, const Scene& scene)
     {
         prepareMeshData(scene);
 
@@ -234,19 +296,39 @@ namespace Falcor
             // Prepare GPU buffers.
             prepareTriangleData(pRenderContext, scene);
 
-            // Pre-integrate emissive triangles.
-            // TODO: We might want to redo this in update() for animated meshes or after scale changes as that affects the flux.
-            integrateEmissive(pRenderContext, scene);
+            // Extract and pre-integrate emissive triangles on the CPU if possible.
+            // The results are uploaded to the GPU buffers, so no readback is needed.
+            mBuiltOnCPU = mOptions.buildOnCPU && buildTriangleListCPU(scene);
 
-            mCPUInvalidData = CPUOutOfDateFlags::All;
-            mStagingBufferValid = false;
-            mStatsValid = false;
+            if (mBuiltOnCPU)
+            {
+                mCPUInvalidData = CPUOutOfDateFlags::None;
+                mStagingBufferValid = true;
+            }
+            else
+            {
+                if (!mIntegrator.pProgram && !initIntegrator(scene)) return false;
+
+                // Compute triangle data (vertices, uv-coordinates, materialID) for all mesh lights.
+                buildTriangleList(pRenderContext, scene);
 
-            prepareSyncCPUData(pRenderContext);
+                // Pre-integrate emissive triangles.
+                // TODO: We might want to redo this in update() for animated meshes or after scale changes as that affects the flux.
+                integrateEmissive(pRenderContext, scene);
+
+                mCPUInvalidData = CPUOutOfDateFlags::All;
+                mStagingBufferValid = false;
+
+                prepareSyncCPUData(pRenderContext);
+            }
+
+            mStatsValid = false;
 
             // Build list of active triangles.
             updateActiveTriangleList();
         }
+
+        return true;
     }
 
     void LightCollection::prepareTriangleData(RenderContext* pRenderContext, const Scene& scene)
@@ -261,9 +343,6 @@ namespace Falcor
         mpFluxData = Buffer::createStructured(mpFinalizeIntegration["gFluxData"], mTriangleCount, ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess, Buffer::CpuAccess::None, nullptr, false);
         mpFluxData->setName("LightCollection::mpFluxData");
         if (mpFluxData->getStructSize() != sizeof(EmissiveFlux)) throw std::exception("Struct EmissiveFlux size mismatch between CPU/GPU");
-
-        // Compute triangle data (vertices, uv-coordinates, materialID) for all mesh lights.
-        buildTriangleList(pRenderContext, scene);
     }
 
     void LightCollection::prepareMeshData(const Scene& scene)
@@ -436,6 +515,147 @@ namespace Falcor
         }
     }
 
+    bool LightCollection::buildTriangleListCPU(const Scene& scene)
+    {
+        assert(mMeshLights.size() > 0);
+
+        const auto& indexData = scene.getMeshIndexData();
+        const auto& vertexData = scene.getMeshStaticData();
+        if (vertexData.empty()) return false;
+
+        // Skinned meshes are only available in their animated state on the GPU.
+        for (const auto& meshLight : mMeshLights)
+        {
+            if (scene.getMeshInstance(meshLight.meshInstanceID).hasDynamicData()) return false;
+        }
+
+        // Load the emissive textures. Each texture is loaded once, even if shared between materials.
+        std::vector<const Texture*> textures;
+        std::vector<int32_t> materialTexture(scene.getMaterialCount(), -1);
+        for (const auto& meshLight : mMeshLights)
+        {
+            const Texture* pTexture = scene.getMaterial(meshLight.materialID)->getEmissiveTexture().get();
+            if (!pTexture) continue;
+            auto it = std::find(textures.begin(), textures.end(), pTexture);
+            materialTexture[meshLight.materialID] = (int32_t)std::distance(textures.begin(), it);
+            if (it == textures.end()) textures.push_back(pTexture);
+        }
+
+        std::vector<CPUTexture::SharedPtr> cpuTextures(textures.size());
+        std::atomic<bool> texturesLoaded{ true };
+        NumericRange<uint32_t> textureRange(0, (uint32_t)textures.size());
+        std::for_each(std::execution::par, textureRange.begin(), textureRange.end(), [&] (uint32_t i)
+        {
+            cpuTextures[i] = CPUTexture::createFromTexture(*textures[i]);
+            if (!cpuTextures[i]) texturesLoaded = false;
+        });
+        if (!texturesLoaded)
+        {
+            logInfo("LightCollection: Emissive textures are not available on the CPU. Building the light collection on the GPU.");
+            return false;
+        }
+
+        TextureAddressing addressing;
+        if (mpSamplerState)
+        {
+            addressing.modeU = mpSamplerState->getAddressModeU();
+            addressing.modeV = mpSamplerState->getAddressModeV();
+            addressing.borderColor = mpSamplerState->getBorderColor().rgb;
+        }
+        const auto& globalMatrices = scene.getAnimationController()->getGlobalMatrices();
+
+        std::vector<PackedEmissiveTriangle> triangleData(mTriangleCount);
+        std::vector<EmissiveFlux> fluxData(mTriangleCount);
+        mMeshLightTriangles.resize(mTriangleCount);
+
+        // Process all emissive triangles in parallel.
+        NumericRange<uint32_t> triangleRange(0, mTriangleCount);
+        std::for_each(std::execution::par, triangleRange.begin(), triangleRange.end(), [&] (uint32_t triIdx)
+        {
+            // Find the mesh light. The lights are sorted by triangle offset.
+            auto it = std::upper_bound(mMeshLights.begin(), mMeshLights.end(), triIdx, [] (uint32_t idx, const MeshLightData& meshLight) { return idx < meshLight.triangleOffset; });
+            const uint32_t lightIdx = (uint32_t)std::distance(mMeshLights.begin(), it) - 1;
+            const MeshLightData& meshLight = mMeshLights[lightIdx];
+            const uint32_t triangleIndex = triIdx - meshLight.triangleOffset;
+
+            const MeshInstanceData& instance = scene.getMeshInstance(meshLight.meshInstanceID);
+            const MeshDesc& mesh = scene.getMesh(instance.meshID);
+            const glm::mat4& worldMat = globalMatrices[instance.globalMatrixID];
+
+            // Fetch vertex data, same as Scene::getIndices() and Scene::getVertexPositionsW() on the GPU.
+            uint3 vtxIndices = uint3(triangleIndex * 3) + uint3(0, 1, 2);
+            if (mesh.indexCount > 0)
+            {
+                if (instance.flags & (uint32_t)MeshInstanceFlags::Use16BitIndices)
+                {
+                    const uint16_t* pIndices = reinterpret_cast<const uint16_t*>(indexData.data() + instance.ibOffset) + triangleIndex * 3;
+                    vtxIndices = uint3(pIndices[0], pIndices[1], pIndices[2]);
+                }
+                else
+                {
+                    const uint32_t* pIndices = indexData.data() + instance.ibOffset + triangleIndex * 3;
+                    vtxIndices = uint3(pIndices[0], pIndices[1], pIndices[2]);
+                }
+            }
+            vtxIndices += instance.vbOffset;
+
+            EmissiveTriangle tri;
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                const PackedStaticVertexData& v = vertexData[vtxIndices[j]];
+                tri.posW[j] = (worldMat * float4(v.position, 1.f)).xyz;
+                tri.texCoords[j] = v.texCrd;
+            }
+
+            // Compute face normal and area, same as Scene::computeFaceNormalAndAreaW() on the GPU.
+            float3 N = glm::cross(tri.posW[1] - tri.posW[0], tri.posW[2] - tri.posW[0]);
+            tri.area = 0.5f * glm::length(N);
+            if (instance.flags & (uint32_t)MeshInstanceFlags::IsWorldFrontFaceCW) N = -N;
+            tri.normal = tri.area > 0.f ? glm::normalize(N) : float3(0.f, 0.f, 1.f);
+            tri.materialID = meshLight.materialID;
+            tri.lightIdx = lightIdx;
+
+            // Pack the triangle and continue with the unpacked data, so that the flux is computed from the same quantized data as on the GPU.
+            triangleData[triIdx].pack(tri);
+            tri = triangleData[triIdx].unpack();
+
+            // Compute the triangle's average emitted radiance (RGB), same as the GPU integrator.
+            const Material::SharedPtr& pMaterial = scene.getMaterial(meshLight.materialID);
+            float3 averageEmissiveColor = pMaterial->getEmissiveColor();
+            if (materialTexture[meshLight.materialID] >= 0)
+            {
+                // If the triangle doesn't cover any texel centers, assign a default value (1.0) to avoid bias.
+                float4 texelSum = integrateTexels(*cpuTextures[materialTexture[meshLight.materialID]], tri.texCoords, addressing);
+                averageEmissiveColor = texelSum.a > 0.f ? texelSum.rgb / texelSum.a : float3(1.f);
+            }
+            float3 averageRadiance = averageEmissiveColor * pMaterial->getEmissiveFactor();
+
+            // Pre-compute the luminous flux emitted assuming diffuse single-sided emitters.
+            float flux = luminance(averageRadiance) * tri.area * (float)M_PI;
+
+            fluxData[triIdx].flux = flux;
+            fluxData[triIdx].averageRadiance = averageRadiance;
+
+            auto& meshLightTri = mMeshLightTriangles[triIdx];
+            meshLightTri.lightIdx = tri.lightIdx;
+            meshLightTri.normal = tri.normal;
+            meshLightTri.area = tri.area;
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                meshLightTri.vtx[j].pos = tri.posW[j];
+                meshLightTri.vtx[j].uv = tri.texCoords[j];
+            }
+            meshLightTri.flux = flux;
+            meshLightTri.averageRadiance = averageRadiance;
+        });
+
+        // Upload the results.
+        mpTriangleData->setBlob(triangleData.data(), 0, triangleData.size() * sizeof(PackedEmissiveTriangle));
+        mpFluxData->setBlob(fluxData.data(), 0, fluxData.size() * sizeof(EmissiveFlux));
+
+        return true;
+    }
+
     void LightCollection::updateActiveTriangleList()
     {
         // This function updates the list of active (non-culled) triangles based on the pre-integrated flux.
@@ -52,6 +52,14 @@ namespace Falcor
             MatrixChanged       = 1u,   ///< Mesh instance transform changed.
         };
 
+        /** Light collection configuration options.
+        */
+        struct Options
+        {
+            bool buildOnCPU = true;     ///< Extract the emissive triangles and pre-integrate their flux on the CPU. This avoids reading back the results from the GPU.
+                                        ///< The GPU path is used as fallback if the mesh data or emissive textures are not available on the CPU (e.g., skinned meshes or DDS textures).
+        };
+
         struct UpdateStatus
         {
             std::vector<UpdateFlags> lightsUpdateInfo;
@@ -109,9 +117,10 @@ namespace Falcor
             Note that update() must be called before the collection is ready to use.
             \param[in] pRenderContext The render context.
             \param[in] pScene The scene.
+            \param[in] options Configuration options.
             \return Ptr to the created object, or nullptr if an error occured.
         */
-        static SharedPtr create(RenderContext* pRenderContext, const std::shared_ptr<Scene>& pScene);
+        static SharedPtr create(RenderContext* pRenderContext, const std::shared_ptr<Scene>& pScene, const Options& options = Options());
 
         /** Updates the light collection to the current state of the scene.
             \param[in] pRenderContext The render context.
@@ -134,6 +143,10 @@ namespace Falcor
         */
         uint32_t getTotalLightCount() const { return mTriangleCount; }
 
+        /** Returns true if the emissive triangles were extracted and pre-integrated on the CPU.
+        */
+        bool isBuiltOnCPU() const { return mBuiltOnCPU; }
+
         /** Returns stats.
         */
         const MeshLightStats& getStats() const { computeStats(); return mMeshLightStats; }
@@ -171,17 +184,18 @@ namespace Falcor
         };
 
     protected:
-        LightCollection() = default;
+        LightCollection(const Options& options) : mOptions(options) {}
 
         bool init(RenderContext* pRenderContext, const std::shared_ptr<Scene>& pScene);
         bool initIntegrator(const Scene& scene);
         bool setupMeshLights(const Scene& scene);
-        void build(RenderContext* pRenderContext, const Scene& scene);
+        bool build(RenderContext* pRenderContext, const Scene& scene);
         void prepareTriangleData(RenderContext* pRenderContext, const Scene& scene);
         void prepareMeshData(const Scene& scene);
         void integrateEmissive(RenderContext* pRenderContext, const Scene& scene);
         void computeStats() const;
         void buildTriangleList(RenderContext* pRenderContext, const Scene& scene);
+        bool buildTriangleListCPU(const Scene& scene);
         void updateActiveTriangleList();
         void updateTrianglePositions(RenderContext* pRenderContext, const Scene& scene, const std::vector<uint32_t>& updatedLights);
 
@@ -190,6 +204,8 @@ namespace Falcor
 
         // Internal state
         std::weak_ptr<Scene>                    mpScene;                ///< Weak pointer to scene (scene owns LightCollection).
+        Options                                 mOptions;               ///< Configuration options.
+        bool                                    mBuiltOnCPU = false;    ///< True if the emissive triangles were built on the CPU.
 
         std::vector<MeshLightData>              mMeshLights;            ///< List of all mesh lights.
         uint32_t                                mTriangleCount = 0;     ///< Total number of triangles in all mesh lights (= mMeshLightTriangles.size()). This may include culled triangles.
@@ -48,6 +48,8 @@ namespace Falcor
     {
         Program::DefineList defines;
         defines.add("VOLUME_SAMPLER_TRANSMITTANCE_ESTIMATOR", std::to_string((uint32_t)mOptions.transmittanceEstimator));
+        defines.add("VOLUME_SAMPLER_USE_MAJORANT_GRID", mOptions.useMajorantGrid ? "1" : "0");
+        defines.add("VOLUME_SAMPLER_MAJORANT_GRID_LEVEL", std::to_string(mOptions.majorantGridLevel));
         return defines;
     }
 
@@ -65,6 +67,13 @@ namespace Falcor
             dirty = true;
         }
 
+        dirty |= widget.checkbox("Use majorant grid", mOptions.useMajorantGrid);
+        widget.tooltip("Use per-brick maximum densities for tracking, which reduces the number of null collisions in sparse volumes.", true);
+        if (mOptions.useMajorantGrid)
+        {
+            dirty |= widget.var("Majorant grid level", mOptions.majorantGridLevel, 0u, 8u);
+        }
+
         return dirty;
     }
 
@@ -85,6 +94,8 @@ namespace Falcor
         ScriptBindings::SerializableStruct<VolumeSampler::Options> options(m, "VolumeSamplerOptions");
 #define field(f_) field(#f_, &VolumeSampler::Options::f_)
         options.field(transmittanceEstimator);
+        options.field(useMajorantGrid);
+        options.field(majorantGridLevel);
 #undef field
     }
 }
@@ -44,6 +44,8 @@ namespace Falcor
         struct Options
         {
             TransmittanceEstimator transmittanceEstimator = TransmittanceEstimator::RatioTracking;
+            bool useMajorantGrid = false;       ///< Use the majorant grid of the density grid for tracking instead of the global maximum density. Disabled by default.
+            uint32_t majorantGridLevel = 0;     ///< Majorant grid level to traverse. Coarser levels have fewer cells but looser majorants.
         };
 
         virtual ~VolumeSampler() = default;
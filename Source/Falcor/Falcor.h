@@ -43,9 +43,12 @@
 // Core/API
 #include "Core/API/BlendState.h"
 #include "Core/API/Buffer.h"
+#include "Core/API/BufferAllocator.h"
+#include "Core/API/CommandLog.h"
 #include "Core/API/ComputeContext.h"
 #include "Core/API/ComputeStateObject.h"
 #include "Core/API/CopyContext.h"
+#include "Core/API/DeferredReleaseQueue.h"
 #include "Core/API/DepthStencilState.h"
 #include "Core/API/DescriptorPool.h"
 #include "Core/API/DescriptorSet.h"
@@ -127,8 +130,11 @@
 #include "Utils/Algorithm/DirectedGraph.h"
 #include "Utils/Algorithm/DirectedGraphTraversal.h"
 #include "Utils/Algorithm/ParallelReduction.h"
+#include "Utils/Algorithm/TlsfAllocator.h"
+#include "Utils/Image/AsyncTextureWriter.h"
 #include "Utils/Image/Bitmap.h"
 #include "Utils/Image/ImageIO.h"
+#include "Utils/Image/MipGenerator.h"
 #include "Utils/Math/CubicSpline.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Scripting/Dictionary.h"
@@ -138,6 +144,8 @@
 #include "Utils/SampleGenerators/HaltonSamplePattern.h"
 #include "Utils/SampleGenerators/StratifiedSamplePattern.h"
 #include "Utils/SampleGenerators/CPUSampleGenerator.h"
+#include "Utils/SampleGenerators/PMJ02Sequence.h"
+#include "Utils/SampleGenerators/SobolSequence.h"
 #include "Utils/Scripting/Scripting.h"
 #include "Utils/Scripting/Console.h"
 #include "Utils/Timing/CpuTimer.h"
@@ -30,9 +30,68 @@
 #include "RenderPassLibrary.h"
 #include "Utils/Algorithm/DirectedGraphTraversal.h"
 #include "RenderGraphCompiler.h"
+#include "rapidjson/ostreamwrapper.h"
+#include "rapidjson/prettywriter.h"
+#include <fstream>
 
 namespace Falcor
 {
+    namespace
+    {
+        using JsonWriter = rapidjson::PrettyWriter<rapidjson::OStreamWrapper>;
+
+        void writeStringArray(JsonWriter& writer, const char* key, const std::vector<std::string>& strings)
+        {
+            writer.Key(key);
+            writer.StartArray();
+            for (const auto& s : strings) writer.String(s.c_str());
+            writer.EndArray();
+        }
+
+        void writeCompilationReport(JsonWriter& writer, const RenderGraphExe::CompilationReport& report)
+        {
+            writer.StartObject();
+
+            writer.Key("passes");
+            writer.StartArray();
+            for (const auto& pass : report.passes)
+            {
+                writer.StartObject();
+                writer.Key("name"); writer.String(pass.name.c_str());
+                writeStringArray(writer, "reads", pass.reads);
+                writeStringArray(writer, "writes", pass.writes);
+                writer.Key("transientBytes"); writer.Uint64(pass.transientSize);
+                writer.EndObject();
+            }
+            writer.EndArray();
+
+            // Time points are indices into the pass list. Resources that live until the end of the graph are flagged as graph outputs.
+            const auto& memory = report.memory;
+            writer.Key("memory");
+            writer.StartObject();
+            writer.Key("totalBytes"); writer.Uint64(memory.totalSize);
+            writer.Key("peakLiveBytes"); writer.Uint64(memory.peakLiveSize);
+            writer.Key("peakPass"); writer.String(memory.peakTimePoint < report.passes.size() ? report.passes[memory.peakTimePoint].name.c_str() : "");
+            writer.Key("resources");
+            writer.StartArray();
+            for (const auto& r : memory.resources)
+            {
+                bool graphOutput = r.lastUse == uint32_t(-1);
+                writer.StartObject();
+                writer.Key("name"); writer.String(r.name.c_str());
+                writer.Key("bytes"); writer.Uint64(r.size);
+                writer.Key("firstUse"); writer.Uint(r.firstUse);
+                writer.Key("lastUse"); writer.Uint(graphOutput ? uint32_t(report.passes.size() - 1) : r.lastUse);
+                writer.Key("graphOutput"); writer.Bool(graphOutput);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+
+            writer.EndObject();
+        }
+    }
+
     std::vector<RenderGraph*> gRenderGraphs;
     const FileDialogFilterVec RenderGraph::kFileExtensionFilters = { { "py", "Render Graph Files"} };
 
@@ -73,6 +132,7 @@ namespace Falcor
         {
             it.second.pPass->setScene(gpDevice->getRenderContext(), pScene);
         }
+        mCompilerState.passes.clear();
         mRecompile = true;
     }
 
@@ -91,7 +151,7 @@ namespace Falcor
             mNameToIndex[passName] = passIndex;
         }
 
-        pPass->mPassChangedCB = [this]() { mRecompile = true; };
+        pPass->mPassChangedCB = [this, passIndex]() { mCompilerState.dirtyPasses.insert(passIndex); mRecompile = true; };
         pPass->mName = passName;
 
         if (mpScene) pPass->setScene(gpDevice->getRenderContext(), mpScene);
@@ -143,7 +203,8 @@ namespace Falcor
         std::string passTypeName = getClassTypeName(pOldPass.get());
         auto pPass = RenderPassLibrary::instance().createPass(pRenderContext, passTypeName.c_str(), dict);
         pPassIt->second.pPass = pPass;
-        pPass->mPassChangedCB = [this]() { mRecompile = true; };
+        mCompilerState.dirtyPasses.insert(index);
+        pPass->mPassChangedCB = [this, index]() { mCompilerState.dirtyPasses.insert(index); mRecompile = true; };
         pPass->mName = pOldPass->getName();
 
         if (mpScene) pPass->setScene(gpDevice->getRenderContext(), mpScene);
@@ -389,8 +450,15 @@ namespace Falcor
 
         try
         {
-            mpExe = RenderGraphCompiler::compile(*this, pContext, mCompilerDeps);
+            mpExe = RenderGraphCompiler::compile(*this, pContext, mCompilerDeps, &mCompilerState, &mCompilationStats);
             mRecompile = false;
+
+            const auto& stats = mCompilationStats;
+            std::string compiledPasses;
+            for (const auto& name : stats.compiledPasses) compiledPasses += (compiledPasses.empty() ? "" : ", ") + name;
+            logInfo("RenderGraph '" + mName + "' compiled in " + std::to_string(stats.compileTime) + " ms (" + (stats.incremental ? "incremental" : "full") + "). " +
+                "Reflected " + std::to_string(stats.reflectedPasses.size()) + "/" + std::to_string(stats.passCount) + " passes, compiled " + std::to_string(stats.compiledPasses.size()) + " passes" +
+                (compiledPasses.empty() ? "" : " (" + compiledPasses + ")") + ", reused " + std::to_string(stats.reusedResourceCount) + " resources, allocated " + std::to_string(stats.allocatedResourceCount) + ".");
             return true;
         }
         catch (const std::exception& e)
@@ -415,9 +483,71 @@ namespace Falcor
         c.pRenderContext = pContext;
         c.defaultTexDims = mCompilerDeps.defaultResourceProps.dims;
         c.defaultTexFormat = mCompilerDeps.defaultResourceProps.format;
+        if (mInstrumentationEnabled) c.pFrameRecord = &mFrameRecords.emplace_back();
+        c.parallelRecording = mParallelRecordingEnabled;
         mpExe->execute(c);
     }
 
+    bool RenderGraph::exportInstrumentation(const std::string& filename) const
+    {
+        // Frames refer to the compilation they executed, which is written only once
+        std::vector<std::shared_ptr<const RenderGraphExe::CompilationReport>> compilations;
+        std::vector<size_t> frameCompilations;
+        for (const auto& frame : mFrameRecords)
+        {
+            auto it = std::find(compilations.begin(), compilations.end(), frame.pCompilation);
+            frameCompilations.push_back(it - compilations.begin());
+            if (it == compilations.end()) compilations.push_back(frame.pCompilation);
+        }
+        if (compilations.empty())
+        {
+            auto pReport = getCompilationReport();
+            if (pReport) compilations.push_back(pReport);
+        }
+
+        std::ofstream ofs(filename);
+        if (!ofs.good())
+        {
+            logError("RenderGraph::exportInstrumentation() - Can't open file '" + filename + "' for writing");
+            return false;
+        }
+
+        rapidjson::OStreamWrapper osw(ofs);
+        JsonWriter writer(osw);
+        writer.StartObject();
+        writer.Key("graph"); writer.String(mName.c_str());
+
+        writer.Key("compilations");
+        writer.StartArray();
+        for (const auto& pReport : compilations) writeCompilationReport(writer, *pReport);
+        writer.EndArray();
+
+        writer.Key("frames");
+        writer.StartArray();
+        for (size_t i = 0; i < mFrameRecords.size(); i++)
+        {
+            const auto& frame = mFrameRecords[i];
+            writer.StartObject();
+            writer.Key("compilation"); writer.Uint((uint32_t)frameCompilations[i]);
+            writer.Key("cpuTimeMs"); writer.Double(frame.cpuTime);
+            writer.Key("passes");
+            writer.StartArray();
+            for (size_t p = 0; p < frame.passCpuTimes.size(); p++)
+            {
+                writer.StartObject();
+                writer.Key("name"); writer.String(frame.pCompilation->passes[p].name.c_str());
+                writer.Key("cpuTimeMs"); writer.Double(frame.passCpuTimes[p]);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        writer.EndArray();
+
+        writer.EndObject();
+        return true;
+    }
+
     void RenderGraph::update(const SharedPtr& pGraph)
     {
         // fill in missing passes from referenced graph
@@ -601,6 +731,7 @@ namespace Falcor
         mCompilerDeps.defaultResourceProps.dims = { pTargetFbo->getWidth(), pTargetFbo->getHeight() };
 
         // Invalidate the graph. Render-passes might change their reflection based on the resize information
+        mCompilerState.passes.clear();
         mRecompile = true;
     }
 
@@ -772,6 +903,10 @@ namespace Falcor
         renderGraph.def(RenderGraphIR::kAutoGenEdges, &RenderGraph::autoGenEdges, "executionOrder"_a);
         renderGraph.def("getPass", &RenderGraph::getPass, "name"_a);
         renderGraph.def("getOutput", pybind11::overload_cast<const std::string&>(&RenderGraph::getOutput), "name"_a);
+        renderGraph.def_property("instrumentation", &RenderGraph::isInstrumentationEnabled, &RenderGraph::setInstrumentationEnabled);
+        renderGraph.def_property("parallelRecording", &RenderGraph::isParallelRecordingEnabled, &RenderGraph::setParallelRecordingEnabled);
+        renderGraph.def("clearFrameRecords", &RenderGraph::clearFrameRecords);
+        renderGraph.def("exportInstrumentation", &RenderGraph::exportInstrumentation, "filename"_a);
         auto printGraph = [](RenderGraph::SharedPtr pGraph) { pybind11::print(RenderGraphExporter::getIR(pGraph)); };
         renderGraph.def("print", printGraph);
 
@@ -205,6 +205,46 @@ namespace Falcor
         bool compile(RenderContext* pContext, std::string& log);
         bool compile(RenderContext* pContext) { std::string s; return compile(pContext, s); }
 
+        /** Get a report of the last successful compilation, including which passes were reflected and compiled again.
+        */
+        const RenderGraphCompiler::Stats& getCompilationStats() const { return mCompilationStats; }
+
+        /** Enable/disable recording of per-frame execution data. Recorded frames are kept until clearFrameRecords() is called.
+        */
+        void setInstrumentationEnabled(bool enabled) { mInstrumentationEnabled = enabled; }
+
+        /** Check if per-frame execution data is recorded.
+        */
+        bool isInstrumentationEnabled() const { return mInstrumentationEnabled; }
+
+        /** Get the frames recorded while instrumentation was enabled.
+        */
+        const std::vector<RenderGraphExe::FrameRecord>& getFrameRecords() const { return mFrameRecords; }
+
+        /** Discard the recorded frames.
+        */
+        void clearFrameRecords() { mFrameRecords.clear(); }
+
+        /** Get the per-pass resource usage and memory report of the current compilation, or nullptr if the graph is not compiled.
+        */
+        std::shared_ptr<const RenderGraphExe::CompilationReport> getCompilationReport() const { return mpExe ? mpExe->getCompilationReport() : nullptr; }
+
+        /** Export the recorded frames and the compilation reports they refer to as JSON.
+            If no frames were recorded, the report of the current compilation is exported.
+            \param[in] filename Output file.
+            \return True if the file was written.
+        */
+        bool exportInstrumentation(const std::string& filename) const;
+
+        /** Enable/disable recording of independent passes on worker threads. Only passes that support it are recorded concurrently, see RenderPass::supportsParallelRecording().
+            The recorded command lists are submitted in graph order.
+        */
+        void setParallelRecordingEnabled(bool enabled) { mParallelRecordingEnabled = enabled; }
+
+        /** Check if independent passes are recorded on worker threads.
+        */
+        bool isParallelRecordingEnabled() const { return mParallelRecordingEnabled; }
+
     private:
         friend class RenderGraphUI;
         friend class RenderGraphExporter;
@@ -259,5 +299,10 @@ namespace Falcor
         RenderGraphExe::SharedPtr mpExe;
         bool mRecompile = false;
         RenderGraphCompiler::Dependencies mCompilerDeps;
+        RenderGraphCompiler::IncrementalState mCompilerState;
+        RenderGraphCompiler::Stats mCompilationStats;
+        bool mInstrumentationEnabled = false;
+        bool mParallelRecordingEnabled = false;
+        std::vector<RenderGraphExe::FrameRecord> mFrameRecords;
     };
 }
@@ -38,16 +38,45 @@ namespace Falcor
         {
             return src.getSampleCount() > 1 && dst.getSampleCount() == 1;
         }
+
+        bool isSameCompileData(const RenderPass::CompileData& a, const RenderPass::CompileData& b)
+        {
+            return a.defaultTexDims == b.defaultTexDims && a.defaultTexFormat == b.defaultTexFormat && a.connectedResources == b.connectedResources;
+        }
+
+        /** Get the state a field's resource is in while the pass executes, based on the field's visibility and the bind flags it requested.
+            Fields without bind flags use the flags of the resource. Returns Undefined if there is no state to transition to.
+        */
+        Resource::State getFieldState(const RenderPassReflection::Field& field, const Resource* pResource)
+        {
+            ResourceBindFlags flags = field.getBindFlags();
+            if (pResource) flags = (flags == ResourceBindFlags::None) ? pResource->getBindFlags() : (flags & pResource->getBindFlags());
+
+            auto visibility = field.getVisibility();
+            if (is_set(visibility, RenderPassReflection::Field::Visibility::Output) || is_set(visibility, RenderPassReflection::Field::Visibility::Internal))
+            {
+                if (is_set(flags, ResourceBindFlags::DepthStencil)) return Resource::State::DepthStencil;
+                if (is_set(flags, ResourceBindFlags::RenderTarget)) return Resource::State::RenderTarget;
+                if (is_set(flags, ResourceBindFlags::UnorderedAccess)) return Resource::State::UnorderedAccess;
+            }
+            else if (is_set(flags, ResourceBindFlags::ShaderResource)) return Resource::State::ShaderResource;
+            return Resource::State::Undefined;
+        }
     }
 
-    RenderGraphCompiler::RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies) : mGraph(graph), mDependencies(dependencies) {}
+    RenderGraphCompiler::RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies, const IncrementalState* pState) : mGraph(graph), mDependencies(dependencies), mpState(pState) {}
 
-    RenderGraphExe::SharedPtr RenderGraphCompiler::compile(RenderGraph& graph, RenderContext* pContext, const Dependencies& dependencies)
+    RenderGraphExe::SharedPtr RenderGraphCompiler::compile(RenderGraph& graph, RenderContext* pContext, const Dependencies& dependencies, IncrementalState* pState, Stats* pStats)
     {
-        RenderGraphCompiler c = RenderGraphCompiler(graph, dependencies);
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        RenderGraphCompiler c = RenderGraphCompiler(graph, dependencies, pState);
+        c.mStats.incremental = pState && !pState->passes.empty();
 
-        // Register the external resources
+        // Passes that are not compiled again keep the handles they got from the previous cache, so the handles must resolve to the same names
         auto pResourcesCache = ResourceCache::create();
+        if (pState && pState->pResourceCache) pResourcesCache->inheritHandles(*pState->pResourceCache);
+
+        // Register the external resources
         for (const auto&[name, pRes] : dependencies.externalResources) pResourcesCache->registerExternalResource(name, pRes);
 
         c.resolveExecutionOrder();
@@ -55,16 +84,45 @@ namespace Falcor
         if (c.insertAutoPasses()) c.resolveExecutionOrder();
         c.validateGraph();
         c.allocateResources(pResourcesCache.get());
+        c.mStats.passCount = (uint32_t)c.mExecutionList.size();
 
         auto pExe = RenderGraphExe::create();
         pExe->mExecutionList.reserve(c.mExecutionList.size());
 
-        for (auto e : c.mExecutionList)
+        for (const auto& e : c.mExecutionList)
         {
-            pExe->insertPass(e.name, e.pPass);
+            // Resolve the resource handles of the pass' fields, so that RenderData lookups don't need to build and hash the full names.
+            // The states of the resources are resolved here too, so passes that record in parallel don't have to transition shared resources.
+            RenderData::FieldHandles fieldHandles;
+            RenderGraphExe::ResourceStates resourceStates;
+            fieldHandles.reserve(e.reflector.getFieldCount());
+            for (size_t f = 0; f < e.reflector.getFieldCount(); f++)
+            {
+                const auto& field = *e.reflector.getField(f);
+                auto handle = pResourcesCache->getHandle(e.name + '.' + field.getName());
+                fieldHandles.emplace_back(field.getName(), handle);
+
+                auto state = getFieldState(field, pResourcesCache->getResource(handle).get());
+                if (state != Resource::State::Undefined) resourceStates.emplace_back(handle, state);
+            }
+            pExe->insertPass(e.name, e.pPass, std::move(fieldHandles), std::move(resourceStates));
         }
+        pExe->mDependencyLevels = c.getDependencyLevels();
         c.restoreCompilationChanges();
         pExe->mpResourceCache = pResourcesCache;
+
+        std::vector<RenderPassReflection> reflectors;
+        for (const auto& e : c.mExecutionList) reflectors.push_back(e.reflector);
+        pExe->createCompilationReport(reflectors);
+
+        if (pState)
+        {
+            c.updateState(*pState);
+            pState->pResourceCache = pResourcesCache;
+        }
+
+        c.mStats.compileTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+        if (pStats) *pStats = c.mStats;
         return pExe;
     }
 
@@ -102,9 +160,58 @@ namespace Falcor
         if (err.size()) throw std::exception(err.c_str());
     }
 
+    std::unordered_set<uint32_t> RenderGraphCompiler::findDirtyPasses() const
+    {
+        // Passes that changed, or have no cached state, need to be reflected again
+        std::vector<uint32_t> changedPasses;
+        for (const auto& [index, nodeData] : mGraph.mNodeData)
+        {
+            bool changed = mpState == nullptr || mpState->dirtyPasses.count(index) || getCachedState(index, nodeData.pPass.get()) == nullptr;
+            if (changed) changedPasses.push_back(index);
+        }
+
+        // Their downstream consumers might depend on the changes, so they are treated as dirty as well
+        std::unordered_set<uint32_t> dirtyPasses;
+        for (uint32_t index : changedPasses)
+        {
+            if (dirtyPasses.count(index)) continue;
+            auto dfs = DirectedGraphDfsTraversal(mGraph.mpGraph, index, DirectedGraphDfsTraversal::Flags::IgnoreVisited);
+            uint32_t nodeId = dfs.traverse();
+            while (nodeId != DirectedGraph::kInvalidID)
+            {
+                dirtyPasses.insert(nodeId);
+                nodeId = dfs.traverse();
+            }
+        }
+        return dirtyPasses;
+    }
+
+    const RenderGraphCompiler::IncrementalState::PassState* RenderGraphCompiler::getCachedState(uint32_t index, const RenderPass* pPass) const
+    {
+        if (mpState == nullptr) return nullptr;
+        auto it = mpState->passes.find(index);
+        if (it == mpState->passes.end() || it->second.pPass.get() != pPass) return nullptr;
+        return &it->second;
+    }
+
+    void RenderGraphCompiler::updateState(IncrementalState& state) const
+    {
+        // Only passes which were compiled (or skipped because nothing changed) are cached. Auto-generated passes are recreated on every compilation.
+        std::unordered_map<uint32_t, IncrementalState::PassState> passes;
+        for (const auto& p : mExecutionList)
+        {
+            auto it = mCompileData.find(p.index);
+            if (it == mCompileData.end()) continue;
+            passes[p.index] = { p.pPass, p.reflector, it->second };
+        }
+        state.passes = std::move(passes);
+        state.dirtyPasses.clear();
+    }
+
     void RenderGraphCompiler::resolveExecutionOrder()
     {
         mExecutionList.clear();
+        mStats.reflectedPasses.clear();
 
         // Find out which passes are mandatory
         std::unordered_set<uint32_t> mandatoryPasses;
@@ -137,13 +244,17 @@ namespace Falcor
         // Run topological sort
         auto topologicalSort = DirectedGraphTopologicalSort::sort(mGraph.mpGraph.get());
 
-        // For each object in the vector, if it's being used in the execution, put it in the list
+        // For each object in the vector, if it's being used in the execution, put it in the list. Only dirty passes are reflected again.
+        auto dirtyPasses = findDirtyPasses();
         for (auto& node : topologicalSort)
         {
             if (participatingPasses.find(node) != participatingPasses.end())
             {
                 const auto pData = mGraph.mNodeData[node];
-                mExecutionList.push_back({ node, pData.pPass, pData.name, pData.pPass->reflect({}) });
+                bool dirty = dirtyPasses.count(node) != 0;
+                if (dirty) mStats.reflectedPasses.push_back(pData.name);
+                const auto& reflector = dirty ? pData.pPass->reflect({}) : getCachedState(node, pData.pPass.get())->reflector;
+                mExecutionList.push_back({ node, pData.pPass, pData.name, reflector, dirty });
             }
         }
     }
@@ -235,13 +346,6 @@ namespace Falcor
 
     void RenderGraphCompiler::allocateResources(ResourceCache* pResourceCache)
     {
-        // Build list to look up execution order index from the pass
-        std::unordered_map<RenderPass*, uint32_t> passToIndex;
-        for (size_t i = 0; i < mExecutionList.size(); i++)
-        {
-            passToIndex.emplace(mExecutionList[i].pPass.get(), uint32_t(i));
-        }
-
         for (size_t i = 0; i < mExecutionList.size(); i++)
         {
             uint32_t nodeIndex = mExecutionList[i].index;
@@ -276,9 +380,9 @@ namespace Falcor
 
                     // Resource lifetime for graph outputs must extend to end of graph execution
                     bool graphOutput = mGraph.isGraphOutput({ nodeIndex, field.getName() });
-                    uint32_t lifetime = graphOutput ? uint32_t(-1) : uint32_t(i);
                     if (graphOutput && field.getBindFlags() != ResourceBindFlags::None) field.bindFlags(field.getBindFlags() | ResourceBindFlags::ShaderResource); // Adding ShaderResource for graph outputs
-                    pResourceCache->registerField(fullFieldName, field, lifetime);
+                    pResourceCache->registerField(fullFieldName, field, uint32_t(i));
+                    if (graphOutput) pResourceCache->extendLifetime(fullFieldName, uint32_t(-1));
                 }
             }
 
@@ -303,13 +407,16 @@ namespace Falcor
                 std::string srcFieldName = mGraph.mNodeData[pEdge->getSourceNode()].name + '.' + edgeData.srcField;
                 std::string dstFieldName = mGraph.mNodeData[nodeIndex].name + '.' + dstField.getName();
 
-                const auto& pSrcPass = mGraph.mNodeData[pEdge->getSourceNode()].pPass.get();
-                const auto& srcReflection = mExecutionList[passToIndex.at(pSrcPass)].reflector;
-                pResourceCache->registerField(dstFieldName, dstField, passToIndex[pSrcPass], srcFieldName);
+                // The resource's lifetime extends to the pass reading it
+                pResourceCache->registerField(dstFieldName, dstField, uint32_t(i), srcFieldName);
             }
         }
 
-        pResourceCache->allocateResources(mDependencies.defaultResourceProps);
+        // Resources of the previous compilation are reused if their properties didn't change
+        const ResourceCache* pPrevious = mpState ? mpState->pResourceCache.get() : nullptr;
+        auto allocationStats = pResourceCache->allocateResources(mDependencies.defaultResourceProps, pPrevious);
+        mStats.allocatedResourceCount = allocationStats.allocatedCount;
+        mStats.reusedResourceCount = allocationStats.reusedCount;
     }
 
 
@@ -396,22 +503,67 @@ namespace Falcor
         return compileData;
     }
 
+    std::vector<std::vector<size_t>> RenderGraphCompiler::getDependencyLevels() const
+    {
+        // The execution list is topologically sorted, so the sources of a pass' incoming edges were already assigned a level
+        std::unordered_map<uint32_t, size_t> nodeToLevel;
+        std::vector<std::vector<size_t>> levels;
+        for (size_t i = 0; i < mExecutionList.size(); i++)
+        {
+            size_t level = 0;
+            const DirectedGraph::Node* pNode = mGraph.mpGraph->getNode(mExecutionList[i].index);
+            for (uint32_t e = 0; e < pNode->getIncomingEdgeCount(); e++)
+            {
+                auto it = nodeToLevel.find(mGraph.mpGraph->getEdge(pNode->getIncomingEdge(e))->getSourceNode());
+                if (it != nodeToLevel.end()) level = std::max(level, it->second + 1);
+            }
+            nodeToLevel[mExecutionList[i].index] = level;
+            if (levels.size() <= level) levels.resize(level + 1);
+            levels[level].push_back(i);
+        }
+        return levels;
+    }
+
     void RenderGraphCompiler::compilePasses(RenderContext* pContext)
     {
+        // Compile-data of the last successful compile() call of the passes compiled so far, indexed by graph node. A compilation can take several
+        // attempts, and a pass compiled in an earlier attempt is only up to date if its data didn't change since then.
+        std::unordered_map<uint32_t, RenderPass::CompileData> compiledData;
+        std::unordered_set<uint32_t> failedPasses;
+
         while(1)
         {
             std::string log;
             bool success = true;
             for (auto& p : mExecutionList)
             {
+                // Passes that didn't change and whose connected resources are the same as in the last compilation don't need to be compiled again
+                auto compileData = prepPassCompilationData(p);
+                const RenderPass::CompileData* pLastData = nullptr;
+                auto compiledIt = compiledData.find(p.index);
+                if (compiledIt != compiledData.end()) pLastData = &compiledIt->second;
+                else if (failedPasses.count(p.index) == 0)
+                {
+                    if (auto pCached = getCachedState(p.index, p.pPass.get())) pLastData = &pCached->compileData;
+                }
+
+                mCompileData[p.index] = compileData;
+                if (!p.dirty && pLastData && isSameCompileData(*pLastData, compileData)) continue;
+
                 try
                 {
-                    p.pPass->compile(pContext, prepPassCompilationData(p));
+                    if (std::find(mStats.compiledPasses.begin(), mStats.compiledPasses.end(), p.name) == mStats.compiledPasses.end()) mStats.compiledPasses.push_back(p.name);
+                    p.pPass->compile(pContext, compileData);
+                    failedPasses.erase(p.index);
+                    compiledData[p.index] = std::move(compileData);
                 }
                 catch (const std::exception& e)
                 {
+                    // Passes that failed are compiled again in the next attempt
                     log += std::string(e.what()) + "\n";
                     success = false;
+                    compiledData.erase(p.index);
+                    failedPasses.insert(p.index);
                 }
             }
 
@@ -425,6 +577,7 @@ namespace Falcor
                 if (newR != p.reflector)
                 {
                     p.reflector = newR;
+                    p.dirty = true;
                     changed = true;
                 }
             }
@@ -432,6 +585,7 @@ namespace Falcor
             if (!changed)
             {
                 logError("Graph compilation failed.\n" + log);
+                mCompileData.clear(); // Don't cache the state of a failed compilation
                 return;
             }
         }
@@ -41,12 +41,52 @@ namespace Falcor
             ResourceCache::DefaultProperties defaultResourceProps;
             ResourceCache::ResourcesMap externalResources;
         };
-        static RenderGraphExe::SharedPtr compile(RenderGraph& graph, RenderContext* pContext, const Dependencies& dependencies);
+
+        /** State carried over between compilations of the same graph, used for incremental compilation.
+            Passes that are not dirty reuse their cached reflection, and are only compiled again if their compile-data changed.
+        */
+        struct IncrementalState
+        {
+            struct PassState
+            {
+                RenderPass::SharedPtr pPass;            ///< The pass the state belongs to. A different pass at the same node invalidates the state
+                RenderPassReflection reflector;         ///< Reflection after the last successful compilation
+                RenderPass::CompileData compileData;    ///< Compile-data passed to the last compile() call
+            };
+            std::unordered_map<uint32_t, PassState> passes;     ///< Cached pass state, indexed by graph node
+            std::unordered_set<uint32_t> dirtyPasses;           ///< Nodes whose pass changed since the last compilation
+            ResourceCache::SharedPtr pResourceCache;            ///< Resources of the last compilation. Compatible resources are reused
+        };
+
+        /** Report of what the last compilation did
+        */
+        struct Stats
+        {
+            bool incremental = false;                   ///< True if cached state from a previous compilation was available
+            std::vector<std::string> reflectedPasses;   ///< Passes that were reflected again
+            std::vector<std::string> compiledPasses;    ///< Passes whose compile() was called
+            uint32_t passCount = 0;                     ///< Number of passes in the execution list
+            uint32_t allocatedResourceCount = 0;        ///< Number of newly created resources
+            uint32_t reusedResourceCount = 0;           ///< Number of resources reused from the previous compilation
+            double compileTime = 0;                     ///< Compilation time in ms
+        };
+
+        /** Compile a graph
+            \param[in] graph The graph to compile
+            \param[in] pContext Render context passed to the passes
+            \param[in] dependencies Default resource properties and external resources
+            \param[in,out] pState Optional. State of the previous compilation. If provided, only dirty passes and their downstream consumers are re-reflected,
+                passes are only compiled when needed and compatible resources are reused. The state is updated on success.
+            \param[out] pStats Optional. Receives a report of what was recompiled.
+        */
+        static RenderGraphExe::SharedPtr compile(RenderGraph& graph, RenderContext* pContext, const Dependencies& dependencies, IncrementalState* pState = nullptr, Stats* pStats = nullptr);
 
     private:
-        RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies);
+        RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies, const IncrementalState* pState);
         RenderGraph& mGraph;
         const Dependencies& mDependencies;
+        const IncrementalState* mpState;
+        Stats mStats;
 
         struct PassData
         {
@@ -54,8 +94,10 @@ namespace Falcor
             RenderPass::SharedPtr pPass;
             std::string name;
             RenderPassReflection reflector;
+            bool dirty;
         };
         std::vector<PassData> mExecutionList;
+        std::unordered_map<uint32_t, RenderPass::CompileData> mCompileData; // Compile-data passed to compile(), indexed by graph node
 
         // TODO Better way to track history, or avoid changing the original graph altogether?
         struct
@@ -71,5 +113,9 @@ namespace Falcor
         void validateGraph() const;
         void restoreCompilationChanges();
         RenderPass::CompileData prepPassCompilationData(const PassData& passData);
+        std::unordered_set<uint32_t> findDirtyPasses() const;
+        const IncrementalState::PassState* getCachedState(uint32_t index, const RenderPass* pPass) const;
+        void updateState(IncrementalState& state) const;
+        std::vector<std::vector<size_t>> getDependencyLevels() const;
     };
 }
@@ -27,6 +27,8 @@
  **************************************************************************/
 #include "stdafx.h"
 #include "RenderGraphExe.h"
+#include "Utils/NumericRange.h"
+#include <execution>
 
 namespace Falcor
 {
@@ -34,12 +36,108 @@ namespace Falcor
     {
         PROFILE("RenderGraphExe::execute()");
 
-        for (const auto& pass : mExecutionList)
+        FrameRecord* pRecord = ctx.pFrameRecord;
+        CpuTimer::TimePoint frameStart;
+        if (pRecord)
         {
-            PROFILE(pass.name);
+            pRecord->pCompilation = mpCompilationReport;
+            pRecord->passCpuTimes.assign(mExecutionList.size(), 0.0);
+            frameStart = CpuTimer::getCurrentTimePoint();
+        }
 
-            RenderData renderData(pass.name, mpResourceCache, ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
-            pass.pPass->execute(ctx.pRenderContext, renderData);
+        if (ctx.parallelRecording) executeParallel(ctx);
+        else
+        {
+            for (size_t i = 0; i < mExecutionList.size(); i++)
+            {
+                PROFILE(mExecutionList[i].name);
+                executePass(ctx, ctx.pRenderContext, i);
+            }
+        }
+
+        if (pRecord) pRecord->cpuTime = CpuTimer::calcDuration(frameStart, CpuTimer::getCurrentTimePoint());
+    }
+
+    void RenderGraphExe::executePass(const Context& ctx, RenderContext* pRenderContext, size_t index)
+    {
+        const auto& pass = mExecutionList[index];
+
+        CpuTimer::TimePoint passStart;
+        if (ctx.pFrameRecord) passStart = CpuTimer::getCurrentTimePoint();
+
+        RenderData renderData(pass.name, mpResourceCache, ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat, &pass.fieldHandles);
+        pass.pPass->execute(pRenderContext, renderData);
+
+        if (ctx.pFrameRecord) ctx.pFrameRecord->passCpuTimes[index] = CpuTimer::calcDuration(passStart, CpuTimer::getCurrentTimePoint());
+    }
+
+    void RenderGraphExe::executeParallel(const Context& ctx)
+    {
+        RenderContext* pRenderContext = ctx.pRenderContext;
+
+        for (const auto& level : mDependencyLevels)
+        {
+            // Passes that don't support parallel recording run first, on the calling thread and context
+            std::vector<size_t> parallelPasses;
+            for (size_t i : level)
+            {
+                if (mExecutionList[i].pPass->supportsParallelRecording()) parallelPasses.push_back(i);
+                else
+                {
+                    PROFILE(mExecutionList[i].name);
+                    executePass(ctx, pRenderContext, i);
+                }
+            }
+
+            if (parallelPasses.size() < 2)
+            {
+                for (size_t i : parallelPasses)
+                {
+                    PROFILE(mExecutionList[i].name);
+                    executePass(ctx, pRenderContext, i);
+                }
+                continue;
+            }
+
+            // Record the barriers resolved at compile time, so the recording threads only read the state of shared resources.
+            // Creating the default views here keeps the threads from inserting into the views cache of shared resources.
+            for (size_t i : parallelPasses)
+            {
+                for (const auto& [handle, state] : mExecutionList[i].resourceStates)
+                {
+                    const auto& pResource = mpResourceCache->getResource(handle);
+                    if (!pResource) continue;
+                    pRenderContext->resourceBarrier(pResource.get(), state);
+                    if (state == Resource::State::ShaderResource) pResource->getSRV();
+                }
+            }
+
+            while (mpWorkerContexts.size() < parallelPasses.size())
+            {
+                auto pContext = RenderContext::create(pRenderContext->getLowLevelData()->getCommandQueue());
+                pContext->flush(); // This will bind the descriptor heaps
+                mpWorkerContexts.push_back(pContext);
+            }
+
+            // Exceptions can't leave a parallel algorithm, so they are captured and the first one in execution order is rethrown after submission
+            std::vector<std::exception_ptr> exceptions(parallelPasses.size());
+            NumericRange<size_t> range(0, parallelPasses.size());
+            std::for_each(std::execution::par, range.begin(), range.end(), [&](size_t j)
+            {
+                try
+                {
+                    executePass(ctx, mpWorkerContexts[j].get(), parallelPasses[j]);
+                }
+                catch (...)
+                {
+                    exceptions[j] = std::current_exception();
+                }
+            });
+
+            // Submit in graph order. Everything recorded on the calling context, including the barriers, executes before the recorded passes.
+            pRenderContext->flush();
+            for (size_t j = 0; j < parallelPasses.size(); j++) mpWorkerContexts[j]->flush();
+            for (const auto& e : exceptions) if (e) std::rethrow_exception(e);
         }
     }
 
@@ -90,9 +188,43 @@ namespace Falcor
         }
     }
 
-    void RenderGraphExe::insertPass(const std::string& name, const RenderPass::SharedPtr& pPass)
+    void RenderGraphExe::insertPass(const std::string& name, const RenderPass::SharedPtr& pPass, RenderData::FieldHandles fieldHandles, ResourceStates resourceStates)
+    {
+        mExecutionList.push_back(Pass(name, pPass, std::move(fieldHandles), std::move(resourceStates)));
+    }
+
+    void RenderGraphExe::createCompilationReport(const std::vector<RenderPassReflection>& reflectors)
     {
-        mExecutionList.push_back(Pass(name, pPass));
+        assert(reflectors.size() == mExecutionList.size());
+        auto pReport = std::make_shared<CompilationReport>();
+        pReport->memory = mpResourceCache->getMemoryReport();
+
+        for (size_t i = 0; i < mExecutionList.size(); i++)
+        {
+            CompilationReport::Pass pass;
+            pass.name = mExecutionList[i].name;
+
+            for (size_t f = 0; f < reflectors[i].getFieldCount(); f++)
+            {
+                const auto& field = *reflectors[i].getField(f);
+                std::string fullName = pass.name + '.' + field.getName();
+                if (!mpResourceCache->getResource(fullName)) continue; // Unconnected optional field
+
+                // Inputs are reported by the name of the resource they alias
+                const std::string& resourceName = mpResourceCache->getResourceName(fullName);
+                auto visibility = field.getVisibility();
+                if (is_set(visibility, RenderPassReflection::Field::Visibility::Input)) pass.reads.push_back(resourceName);
+                if (is_set(visibility, RenderPassReflection::Field::Visibility::Output) || is_set(visibility, RenderPassReflection::Field::Visibility::Internal)) pass.writes.push_back(resourceName);
+            }
+
+            for (const auto& r : pReport->memory.resources)
+            {
+                if (r.firstUse == i && r.lastUse != uint32_t(-1)) pass.transientSize += r.size;
+            }
+            pReport->passes.push_back(std::move(pass));
+        }
+
+        mpCompilationReport = pReport;
     }
 
     Resource::SharedPtr RenderGraphExe::getResource(const std::string& name) const
@@ -38,12 +38,39 @@ namespace Falcor
     {
     public:
         using SharedPtr = std::shared_ptr<RenderGraphExe>;
+
+        /** Static information about the compiled graph, used for instrumentation
+        */
+        struct CompilationReport
+        {
+            struct Pass
+            {
+                std::string name;
+                std::vector<std::string> reads;     ///< Resources read by the pass
+                std::vector<std::string> writes;    ///< Resources written by the pass
+                uint64_t transientSize = 0;         ///< Size in bytes of the intermediate resources whose lifetime starts at this pass
+            };
+            std::vector<Pass> passes;               ///< Passes in execution order
+            ResourceCache::MemoryReport memory;     ///< Memory of the graph-owned resources. Time points are indices into 'passes'
+        };
+
+        /** Timing of one executed frame
+        */
+        struct FrameRecord
+        {
+            std::shared_ptr<const CompilationReport> pCompilation;  ///< Report of the compilation that was executed
+            double cpuTime = 0;                                     ///< CPU time of the frame in ms
+            std::vector<double> passCpuTimes;                       ///< CPU time of each pass' execute() in ms, in the order of pCompilation->passes
+        };
+
         struct Context
         {
             RenderContext* pRenderContext;
             InternalDictionary::SharedPtr pGraphDictionary;
             uint2 defaultTexDims;
             ResourceFormat defaultTexFormat;
+            FrameRecord* pFrameRecord = nullptr;    ///< Optional. Receives the timing of the frame
+            bool parallelRecording = false;         ///< Record independent passes that support it on worker threads. See RenderPass::supportsParallelRecording()
         };
 
         /** Execute the graph
@@ -79,23 +106,38 @@ namespace Falcor
         */
         void setInput(const std::string& name, const Resource::SharedPtr& pResource);
 
+        /** Get the resource usage and memory report of the compiled graph
+        */
+        const std::shared_ptr<const CompilationReport>& getCompilationReport() const { return mpCompilationReport; }
+
     private:
         friend class RenderGraphCompiler;
         static SharedPtr create() { return SharedPtr(new RenderGraphExe); }
         RenderGraphExe() = default;
 
-        void insertPass(const std::string& name, const RenderPass::SharedPtr& pPass);
+        using ResourceStates = std::vector<std::pair<ResourceCache::Handle, Resource::State>>;
+
+        void insertPass(const std::string& name, const RenderPass::SharedPtr& pPass, RenderData::FieldHandles fieldHandles, ResourceStates resourceStates);
+        void createCompilationReport(const std::vector<RenderPassReflection>& reflectors);
+        void executePass(const Context& ctx, RenderContext* pRenderContext, size_t index);
+        void executeParallel(const Context& ctx);
 
         struct Pass
         {
             std::string name;
             RenderPass::SharedPtr pPass;
+            RenderData::FieldHandles fieldHandles;  ///< Resource handles of the pass' reflected fields.
+            ResourceStates resourceStates;          ///< States the pass' resources are transitioned to before the pass records on a worker thread
         private:
             friend class RenderGraphExe; // Force RenderGraphCompiler to use insertPass() by hiding this Ctor from it
-            Pass(const std::string& name_, const RenderPass::SharedPtr& pPass_) : name(name_), pPass(pPass_) {}
+            Pass(const std::string& name_, const RenderPass::SharedPtr& pPass_, RenderData::FieldHandles fieldHandles_, ResourceStates resourceStates_)
+                : name(name_), pPass(pPass_), fieldHandles(std::move(fieldHandles_)), resourceStates(std::move(resourceStates_)) {}
         };
 
         std::vector<Pass> mExecutionList;
+        std::vector<std::vector<size_t>> mDependencyLevels;         ///< Indices into mExecutionList. Passes of a level don't depend on each other
+        std::vector<RenderContext::SharedPtr> mpWorkerContexts;     ///< Contexts used for parallel recording, created on demand
         ResourceCache::SharedPtr mpResourceCache;
+        std::shared_ptr<const CompilationReport> mpCompilationReport;
     };
 }
@@ -30,9 +30,10 @@
 
 namespace Falcor
 {
-    RenderData::RenderData(const std::string& passName, const ResourceCache::SharedPtr& pResourceCache, const InternalDictionary::SharedPtr& pDict, const uint2& defaultTexDims, ResourceFormat defaultTexFormat)
+    RenderData::RenderData(const std::string& passName, const ResourceCache::SharedPtr& pResourceCache, const InternalDictionary::SharedPtr& pDict, const uint2& defaultTexDims, ResourceFormat defaultTexFormat, const FieldHandles* pFieldHandles)
         : mName(passName)
         , mpResources(pResourceCache)
+        , mpFieldHandles(pFieldHandles)
         , mpDictionary(pDict)
         , mDefaultTexDims(defaultTexDims)
         , mDefaultTexFormat(defaultTexFormat)
@@ -42,6 +43,29 @@ namespace Falcor
 
     const Resource::SharedPtr& RenderData::getResource(const std::string& name) const
     {
+        ResourceCache::Handle handle = findHandle(name);
+        if (handle != ResourceCache::kInvalidHandle) return mpResources->getResource(handle);
+
+        // Fall back to looking up the full name for fields the pass did not reflect.
         return mpResources->getResource(mName + '.' + name);
     }
+
+    ResourceCache::Handle RenderData::getHandle(const std::string& name) const
+    {
+        ResourceCache::Handle handle = findHandle(name);
+        return handle != ResourceCache::kInvalidHandle ? handle : mpResources->getHandle(mName + '.' + name);
+    }
+
+    ResourceCache::Handle RenderData::findHandle(const std::string& name) const
+    {
+        // Passes have few fields, so a linear search beats hashing the name.
+        if (mpFieldHandles)
+        {
+            for (const auto& [fieldName, handle] : *mpFieldHandles)
+            {
+                if (fieldName == name) return handle;
+            }
+        }
+        return ResourceCache::kInvalidHandle;
+    }
 }
@@ -43,6 +43,10 @@ namespace Falcor
     class dlldecl RenderData
     {
     public:
+        /** List of a pass' field names and the handles of their resources. Resolved when the graph is compiled.
+        */
+        using FieldHandles = std::vector<std::pair<std::string, ResourceCache::Handle>>;
+
         /** Get a resource
             \param[in] name The name of the pass' resource (i.e. "outputColor"). No need to specify the pass' name
             \return If the name exists, a pointer to the resource. Otherwise, nullptr
@@ -55,6 +59,21 @@ namespace Falcor
         */
         const Resource::SharedPtr& getResource(const std::string& name) const;
 
+        /** Get a handle to a resource. Looking up a resource by handle skips the name lookup.
+            Handles stay valid when the graph is recompiled, also if `RenderPass::compile()` is skipped because the pass and its
+            connected resources did not change. A handle keeps referring to the same field name across compilations, and resolves
+            to nullptr once the field no longer exists. Passes can therefore get the handles once in `execute()` and reset them in `compile()`.
+            \param[in] name The name of the pass' resource (i.e. "outputColor"). No need to specify the pass' name
+            \return The handle. Getting a resource with a handle to an unknown name returns nullptr.
+        */
+        ResourceCache::Handle getHandle(const std::string& name) const;
+
+        /** Get a resource by handle
+            \param[in] handle Handle returned by getHandle()
+            \return If the handle refers to a resource, a pointer to the resource. Otherwise, nullptr
+        */
+        const Resource::SharedPtr& operator[](ResourceCache::Handle handle) const { return mpResources->getResource(handle); }
+
         /** Get the global dictionary. You can use it to pass data between different passes
         */
         InternalDictionary& getDictionary() const { return (*mpDictionary); }
@@ -72,9 +91,11 @@ namespace Falcor
         ResourceFormat getDefaultTextureFormat() const { return mDefaultTexFormat; }
     protected:
         friend class RenderGraphExe;
-        RenderData(const std::string& passName, const ResourceCache::SharedPtr& pResourceCache, const InternalDictionary::SharedPtr& pDict, const uint2& defaultTexDims, ResourceFormat defaultTexFormat);
+        RenderData(const std::string& passName, const ResourceCache::SharedPtr& pResourceCache, const InternalDictionary::SharedPtr& pDict, const uint2& defaultTexDims, ResourceFormat defaultTexFormat, const FieldHandles* pFieldHandles = nullptr);
+        ResourceCache::Handle findHandle(const std::string& name) const;
         const std::string& mName;
         ResourceCache::SharedPtr mpResources;
+        const FieldHandles* mpFieldHandles;
         InternalDictionary::SharedPtr mpDictionary;
         uint2 mDefaultTexDims;
         ResourceFormat mDefaultTexFormat;
@@ -117,6 +138,12 @@ namespace Falcor
         */
         virtual void execute(RenderContext* pRenderContext, const RenderData& renderData) = 0;
 
+        /** Whether execute() may record on a worker thread, concurrently with other passes of the graph that don't depend on this one.
+            The graph transitions the pass' resources before recording, based on the fields' visibility and bind flags. Resources shared with other passes
+            must only be accessed in those states and through their default views, and the pass must not use the profiler or modify state shared with other passes.
+        */
+        virtual bool supportsParallelRecording() const { return false; }
+
         /** Get a dictionary that can be used to reconstruct the object
         */
         virtual Dictionary getScriptingDictionary() { return {}; }
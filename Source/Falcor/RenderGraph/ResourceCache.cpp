@@ -40,6 +40,7 @@ namespace Falcor
     {
         mNameToIndex.clear();
         mResourceData.clear();
+        for (auto& data : mHandles) data.resourceIndex = uint32_t(-1);
     }
 
     const Resource::SharedPtr& ResourceCache::getResource(const std::string& name) const
@@ -58,6 +59,43 @@ namespace Falcor
         return extIt->second;
     }
 
+    ResourceCache::Handle ResourceCache::getHandle(const std::string& name)
+    {
+        auto it = mNameToHandle.find(name);
+        if (it != mNameToHandle.end()) return it->second;
+
+        Handle handle = (Handle)mHandles.size();
+        HandleData data;
+        auto indexIt = mNameToIndex.find(name);
+        if (indexIt != mNameToIndex.end()) data.resourceIndex = indexIt->second;
+        auto extIt = mExternalResources.find(name);
+        if (extIt != mExternalResources.end()) data.pExternal = extIt->second;
+
+        mNameToHandle[name] = handle;
+        mHandles.push_back(data);
+        return handle;
+    }
+
+    void ResourceCache::inheritHandles(const ResourceCache& previous)
+    {
+        assert(mHandles.empty());
+        mNameToHandle = previous.mNameToHandle;
+        mHandles.resize(previous.mHandles.size());
+        for (const auto& [name, handle] : mNameToHandle)
+        {
+            auto indexIt = mNameToIndex.find(name);
+            if (indexIt != mNameToIndex.end()) mHandles[handle].resourceIndex = indexIt->second;
+            auto extIt = mExternalResources.find(name);
+            if (extIt != mExternalResources.end()) mHandles[handle].pExternal = extIt->second;
+        }
+    }
+
+    void ResourceCache::updateHandle(const std::string& name, uint32_t resourceIndex)
+    {
+        auto it = mNameToHandle.find(name);
+        if (it != mNameToHandle.end()) mHandles[it->second].resourceIndex = resourceIndex;
+    }
+
     const RenderPassReflection::Field& ResourceCache::getResourceReflection(const std::string& name) const
     {
         uint32_t i = mNameToIndex.at(name);
@@ -78,6 +116,9 @@ namespace Falcor
 
             mExternalResources.erase(it);
         }
+
+        auto handleIt = mNameToHandle.find(name);
+        if (handleIt != mNameToHandle.end()) mHandles[handleIt->second].pExternal = pResource;
     }
 
     void mergeTimePoint(std::pair<uint32_t, uint32_t>& range, uint32_t newTime)
@@ -86,6 +127,60 @@ namespace Falcor
         range.second = std::max(range.second, newTime);
     }
 
+    void ResourceCache::extendLifetime(const std::string& name, uint32_t timePoint)
+    {
+        auto it = mNameToIndex.find(name);
+        if (it == mNameToIndex.end()) throw std::exception(("ResourceCache::extendLifetime() - Field named " + name + " not found.").c_str());
+        mergeTimePoint(mResourceData[it->second].lifetime, timePoint);
+    }
+
+    const std::string& ResourceCache::getResourceName(const std::string& name) const
+    {
+        if (mExternalResources.count(name)) return name;
+        auto it = mNameToIndex.find(name);
+        return it == mNameToIndex.end() ? name : mResourceData[it->second].name;
+    }
+
+    ResourceCache::MemoryReport ResourceCache::getMemoryReport() const
+    {
+        MemoryReport report;
+        uint32_t endTime = 0;
+        for (const auto& data : mResourceData)
+        {
+            if (!data.pResource) continue;
+
+            auto pTexture = dynamic_cast<const Texture*>(data.pResource.get());
+            uint64_t size = pTexture ? pTexture->getTextureSizeInBytes() : data.pResource->getSize();
+            uint32_t firstUse = data.lifetime.first == uint32_t(-1) ? 0 : data.lifetime.first; // Only registered at the end of the graph
+            report.resources.push_back({ data.name, size, firstUse, data.lifetime.second });
+            report.totalSize += size;
+
+            // Resources that live until the end of the graph don't define the number of time points
+            endTime = std::max(endTime, firstUse + 1);
+            if (data.lifetime.second != uint32_t(-1)) endTime = std::max(endTime, data.lifetime.second + 1);
+        }
+
+        // Sweep over the time points, adding resources at their first and removing them after their last use
+        std::vector<int64_t> delta(endTime + 1, 0);
+        for (const auto& r : report.resources)
+        {
+            delta[r.firstUse] += (int64_t)r.size;
+            delta[r.lastUse == uint32_t(-1) ? endTime : r.lastUse + 1] -= (int64_t)r.size;
+        }
+
+        int64_t liveSize = 0;
+        for (uint32_t t = 0; t < endTime; t++)
+        {
+            liveSize += delta[t];
+            if ((uint64_t)liveSize > report.peakLiveSize)
+            {
+                report.peakLiveSize = (uint64_t)liveSize;
+                report.peakTimePoint = t;
+            }
+        }
+        return report;
+    }
+
     void ResourceCache::registerField(const std::string& name, const RenderPassReflection::Field& field, uint32_t timePoint, const std::string& alias)
     {
         assert(mNameToIndex.find(name) == mNameToIndex.end());
@@ -101,6 +196,7 @@ namespace Falcor
         {
             assert(mNameToIndex.count(name) == 0);
             mNameToIndex[name] = (uint32_t)mResourceData.size();
+            updateHandle(name, (uint32_t)mResourceData.size());
             bool resolveBindFlags = (field.getBindFlags() == ResourceBindFlags::None);
             mResourceData.push_back({ field, {timePoint, timePoint}, nullptr, resolveBindFlags, name });
         }
@@ -108,6 +204,7 @@ namespace Falcor
         {
             uint32_t index = mNameToIndex[alias];
             mNameToIndex[name] = index;
+            updateHandle(name, index);
             mResourceData[index].field.merge(field);
             mergeTimePoint(mResourceData[index].lifetime, timePoint);
             mResourceData[index].pResource = nullptr;
@@ -179,14 +276,48 @@ namespace Falcor
         return pResource;
     }
 
-    void ResourceCache::allocateResources(const DefaultProperties& params)
+    namespace
+    {
+        bool canReuseResource(const RenderPassReflection::Field& field, const ResourceCache::DefaultProperties& params, const RenderPassReflection::Field& prevField, const ResourceCache::DefaultProperties& prevParams)
+        {
+            if (field != prevField) return false;
+
+            // Fields that don't specify their size or format are resolved using the default properties
+            if (field.getWidth() == 0 && params.dims.x != prevParams.dims.x) return false;
+            if (field.getHeight() == 0 && params.dims.y != prevParams.dims.y) return false;
+            if (field.getType() != RenderPassReflection::Field::Type::RawBuffer && field.getFormat() == ResourceFormat::Unknown && params.format != prevParams.format) return false;
+            return true;
+        }
+    }
+
+    ResourceCache::AllocationStats ResourceCache::allocateResources(const DefaultProperties& params, const ResourceCache* pPrevious)
     {
+        AllocationStats stats;
         for (auto& data : mResourceData)
         {
             if ((data.pResource == nullptr) && (data.field.isValid()))
             {
+                if (pPrevious)
+                {
+                    auto it = pPrevious->mNameToIndex.find(data.name);
+                    if (it != pPrevious->mNameToIndex.end())
+                    {
+                        const auto& prevData = pPrevious->mResourceData[it->second];
+                        if (prevData.pResource && prevData.name == data.name && prevData.resolveBindFlags == data.resolveBindFlags &&
+                            canReuseResource(data.field, params, prevData.field, pPrevious->mAllocationParams))
+                        {
+                            data.pResource = prevData.pResource;
+                            stats.reusedCount++;
+                            continue;
+                        }
+                    }
+                }
+
                 data.pResource = createResourceForPass(params, data.field, data.resolveBindFlags, data.name);
+                stats.allocatedCount++;
             }
         }
+        mAllocationParams = params;
+        return stats;
     }
 }
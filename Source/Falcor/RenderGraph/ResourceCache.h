@@ -37,6 +37,11 @@ namespace Falcor
         using SharedPtr = std::shared_ptr<ResourceCache>;
         using ResourcesMap = std::unordered_map<std::string, Resource::SharedPtr>;
 
+        /** Dense integer handle to a named resource. See getHandle().
+        */
+        using Handle = uint32_t;
+        static const Handle kInvalidHandle = uint32_t(-1);
+
         /** Create a new object
         */
         static SharedPtr create();
@@ -68,22 +73,94 @@ namespace Falcor
         */
         const Resource::SharedPtr& getResource(const std::string& name) const;
 
+        /** Get a handle to a resource by name. Includes external resources known by the cache.
+            Looking up a resource by handle avoids hashing its name. Handles stay valid for the lifetime of the cache,
+            and resolve to the resource currently registered under the name (or nullptr), including external resources
+            registered after the handle was created.
+            \param[in] name String in the format of PassName.FieldName
+            \return The handle. A handle is created if the name is not known yet.
+        */
+        Handle getHandle(const std::string& name);
+
+        /** Assign the handles of a previous cache to the same names in this cache. Must be called before any handle is created.
+            Handles a pass got from the previous cache then stay valid in this one, even if the handle of a name would otherwise
+            be different because the names are requested in a different order. Names that are not registered anymore resolve to nullptr.
+            \param[in] previous A cache from a previous compilation of the same graph.
+        */
+        void inheritHandles(const ResourceCache& previous);
+
+        /** Get a resource by handle.
+            \return If the handle refers to a registered resource, a pointer to the resource. Otherwise, nullptr.
+        */
+        const Resource::SharedPtr& getResource(Handle handle) const
+        {
+            static const Resource::SharedPtr pNull;
+            if (handle >= mHandles.size()) return pNull;
+            const auto& data = mHandles[handle];
+            if (data.pExternal) return data.pExternal;
+            return data.resourceIndex < mResourceData.size() ? mResourceData[data.resourceIndex].pResource : pNull;
+        }
+
         /** Get the field-reflection of a resource
         */
         const RenderPassReflection::Field& getResourceReflection(const std::string& name) const;
 
+        /** Statistics returned by allocateResources()
+        */
+        struct AllocationStats
+        {
+            uint32_t allocatedCount = 0;    ///< Number of newly created resources
+            uint32_t reusedCount = 0;       ///< Number of resources taken over from the previous cache
+        };
+
         /** Allocate all resources that need to be created/updated.
             This includes new resources, resources whose properties have been updated since last allocation call.
+            \param[in] params Properties to use for unspecified field properties.
+            \param[in] pPrevious Optional. A cache from a previous compilation of the same graph. Resources registered there under the same name
+                and with identical resolved properties are reused instead of being recreated.
         */
-        void allocateResources(const DefaultProperties& params);
+        AllocationStats allocateResources(const DefaultProperties& params, const ResourceCache* pPrevious = nullptr);
 
         /** Clears all registered field/resource properties and allocated resources.
         */
         void reset();
 
+        /** Extend the lifetime of a registered field's resource to include a time point.
+            Use uint32_t(-1) for resources that must stay alive until the end of the graph execution.
+        */
+        void extendLifetime(const std::string& name, uint32_t timePoint);
+
+        /** Get the name of the resource a field is registered as. For aliased fields, this is the name of the field that was registered first.
+            External resources and unknown names are returned unchanged.
+        */
+        const std::string& getResourceName(const std::string& name) const;
+
+        /** Memory used by the resources owned by the cache
+        */
+        struct MemoryReport
+        {
+            struct ResourceInfo
+            {
+                std::string name;       ///< Name of the resource
+                uint64_t size = 0;      ///< Size in bytes
+                uint32_t firstUse = 0;  ///< First time point the resource is used at
+                uint32_t lastUse = 0;   ///< Last time point the resource is used at, or uint32_t(-1) if it lives until the end of the graph execution
+            };
+            std::vector<ResourceInfo> resources;
+            uint64_t totalSize = 0;     ///< Sum of the sizes of all resources
+            uint64_t peakLiveSize = 0;  ///< Largest sum of the sizes of resources that are alive at the same time point
+            uint32_t peakTimePoint = 0; ///< Time point at which the peak is reached
+        };
+
+        /** Get the memory used by the allocated resources, computed from their sizes and lifetimes.
+        */
+        MemoryReport getMemoryReport() const;
+
     private:
         ResourceCache() = default;
 
+        void updateHandle(const std::string& name, uint32_t resourceIndex);
+
         struct ResourceData
         {
             RenderPassReflection::Field field;      // Holds merged properties for aliased resources
@@ -99,6 +176,18 @@ namespace Falcor
 
         // References to output resources not to be allocated by the render graph
         ResourcesMap mExternalResources;
+
+        // Properties used in the last allocateResources() call
+        DefaultProperties mAllocationParams;
+
+        // Handles resolve names to the external resource or the index into mResourceData
+        struct HandleData
+        {
+            uint32_t resourceIndex = uint32_t(-1);  // Index into mResourceData or -1 if not registered
+            Resource::SharedPtr pExternal;          // External resource, takes precedence like in getResource(name)
+        };
+        std::unordered_map<std::string, Handle> mNameToHandle;
+        std::vector<HandleData> mHandles;
     };
 
 }
@@ -60,6 +60,7 @@ namespace Falcor
         mpInvTransposeWorldMatricesBuffer->setName("AnimationController::mpInvTransposeWorldMatricesBuffer");
 
         createSkinningPass(staticVertexData, dynamicVertexData);
+        createSkinnedBoneBounds(staticVertexData, dynamicVertexData);
 
         // Determine length of global animation loop.
         for (const auto& animation : mAnimations)
@@ -256,6 +257,30 @@ namespace Falcor
         }
     }
 
+    void AnimationController::createSkinnedBoneBounds(const std::vector<PackedStaticVertexData>& staticVertexData, const std::vector<DynamicVertexData>& dynamicVertexData)
+    {
+        if (dynamicVertexData.empty()) return;
+
+        for (uint32_t meshID = 0; meshID < (uint32_t)mpScene->mMeshDesc.size(); meshID++)
+        {
+            const auto& mesh = mpScene->mMeshDesc[meshID];
+            if ((mesh.flags & (uint32_t)MeshFlags::HasDynamicData) == 0) continue;
+
+            std::map<uint32_t, AABB> boneBounds;
+            for (uint32_t i = 0; i < mesh.vertexCount; i++)
+            {
+                const auto& d = dynamicVertexData[mesh.dynamicVbOffset + i];
+                const float3 position = staticVertexData[d.staticIndex].position;
+                for (uint32_t j = 0; j < 4; j++)
+                {
+                    if (d.boneWeight[j] > 0.f) boneBounds[d.boneID[j]].include(position);
+                }
+            }
+
+            for (const auto& [boneID, bounds] : boneBounds) mSkinnedBoneBounds.push_back({ meshID, boneID, bounds });
+        }
+    }
+
     void AnimationController::executeSkinningPass(RenderContext* pContext)
     {
         if (!mpSkinningPass) return;
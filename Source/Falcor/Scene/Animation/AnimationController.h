@@ -105,6 +105,25 @@ namespace Falcor
         */
         const std::vector<glm::mat4>& getGlobalMatrices() const { return mGlobalMatrices; }
 
+        /** Get the skinning matrices. These transform bind-pose vertices to world space.
+            The vector is empty if the scene has no skinned meshes.
+        */
+        const std::vector<glm::mat4>& getSkinningMatrices() const { return mSkinningMatrices; }
+
+        /** Bounds of the bind-pose vertices of a skinned mesh that are influenced by a bone.
+        */
+        struct SkinnedBoneBounds
+        {
+            uint32_t meshID;        ///< Skinned mesh ID.
+            uint32_t boneID;        ///< Bone matrix ID.
+            AABB bounds;            ///< Bounds of the vertices with non-zero weight for the bone, in bind space.
+        };
+
+        /** Get the bone bounds of all skinned meshes, sorted by mesh ID.
+            Transforming the bounds by the skinning matrices conservatively bounds the skinned meshes.
+        */
+        const std::vector<SkinnedBoneBounds>& getSkinnedBoneBounds() const { return mSkinnedBoneBounds; }
+
         /** Render the UI.
         */
         void renderUI(Gui::Widgets& widget);
@@ -128,6 +147,7 @@ namespace Falcor
         void updateMatrices();
 
         void createSkinningPass(const std::vector<PackedStaticVertexData>& staticVertexData, const std::vector<DynamicVertexData>& dynamicVertexData);
+        void createSkinnedBoneBounds(const std::vector<PackedStaticVertexData>& staticVertexData, const std::vector<DynamicVertexData>& dynamicVertexData);
         void executeSkinningPass(RenderContext* pContext);
         void initLocalMatrices();
 
@@ -155,6 +175,7 @@ namespace Falcor
         std::vector<glm::mat4> mSkinningMatrices;
         std::vector<glm::mat4> mInvTransposeSkinningMatrices;
         uint32_t mSkinningDispatchSize = 0;
+        std::vector<SkinnedBoneBounds> mSkinnedBoneBounds;
 
         Buffer::SharedPtr mpSkinningMatricesBuffer;
         Buffer::SharedPtr mpInvTransposeSkinningMatricesBuffer;
@@ -0,0 +1,159 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "BVHQualityTracker.h"
+#include "Scene/Scene.h"
+#include <iomanip>
+#include <sstream>
+
+namespace Falcor
+{
+    BVHQualityTracker::SharedPtr BVHQualityTracker::create(const Scene* pScene, const Options& options)
+    {
+        return SharedPtr(new BVHQualityTracker(pScene, options));
+    }
+
+    BVHQualityTracker::BVHQualityTracker(const Scene* pScene, const Options& options)
+        : mpScene(pScene)
+        , mOptions(options)
+    {
+        assert(pScene);
+        const auto& boneBounds = pScene->getAnimationController()->getSkinnedBoneBounds();
+
+        mGroups.resize(pScene->mMeshGroups.size());
+        for (size_t groupID = 0; groupID < mGroups.size(); groupID++)
+        {
+            for (uint32_t meshID : pScene->mMeshGroups[groupID].meshList)
+            {
+                if (!pScene->mMeshHasDynamicData[meshID]) continue;
+
+                // Skinned meshes are not instanced, so the first instance defines the object space of the BLAS.
+                assert(pScene->mMeshIdToInstanceIds[meshID].size() == 1);
+                uint32_t worldMatrixID = pScene->mMeshInstanceData[pScene->mMeshIdToInstanceIds[meshID][0]].globalMatrixID;
+
+                auto it = std::partition_point(boneBounds.begin(), boneBounds.end(), [meshID] (const auto& b) { return b.meshID < meshID; });
+                for (; it != boneBounds.end() && it->meshID == meshID; it++) mGroups[groupID].primitives.push_back({ it->bounds, it->boneID, worldMatrixID });
+            }
+        }
+
+        reset();
+    }
+
+    void BVHQualityTracker::update()
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        const AnimationController* pAnimationController = mpScene->getAnimationController();
+
+        for (auto& group : mGroups)
+        {
+            for (uint32_t i = 0; i < (uint32_t)group.primitives.size(); i++)
+            {
+                const auto& primitive = group.primitives[i];
+                if (pAnimationController->isMatrixChanged(primitive.boneID) || pAnimationController->isMatrixChanged(primitive.worldMatrixID))
+                {
+                    group.bvh.setPrimitiveBounds(i, computeBounds(primitive));
+                }
+            }
+
+            if (!group.bvh.refit()) continue;
+
+            if (group.bvh.getSAHRatio() > mOptions.rebuildThreshold) group.rebuildRecommended = true;
+            if (group.rebuildRecommended) mStats.rebuildCount++;
+            else mStats.refitCount++;
+        }
+
+        mStats.updateTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+    }
+
+    void BVHQualityTracker::reset()
+    {
+        mStats.trackedGroupCount = 0;
+        for (auto& group : mGroups)
+        {
+            if (group.primitives.empty()) continue;
+
+            std::vector<AABB> bounds;
+            bounds.reserve(group.primitives.size());
+            for (const auto& primitive : group.primitives) bounds.push_back(computeBounds(primitive));
+
+            group.bvh.build(bounds);
+            group.rebuildRecommended = false;
+            mStats.trackedGroupCount++;
+        }
+    }
+
+    bool BVHQualityTracker::isTracked(uint32_t meshGroupID) const
+    {
+        return meshGroupID < mGroups.size() && !mGroups[meshGroupID].primitives.empty();
+    }
+
+    bool BVHQualityTracker::isRebuildRecommended(uint32_t meshGroupID) const
+    {
+        return isTracked(meshGroupID) && mGroups[meshGroupID].rebuildRecommended;
+    }
+
+    void BVHQualityTracker::notifyRebuilt(uint32_t meshGroupID)
+    {
+        if (!isTracked(meshGroupID)) return;
+
+        auto& group = mGroups[meshGroupID];
+        group.bvh.rebuild();
+        group.rebuildRecommended = false;
+    }
+
+    float BVHQualityTracker::getSAHRatio(uint32_t meshGroupID) const
+    {
+        return isTracked(meshGroupID) ? mGroups[meshGroupID].bvh.getSAHRatio() : 1.f;
+    }
+
+    void BVHQualityTracker::renderUI(Gui::Widgets& widget)
+    {
+        widget.var("Rebuild threshold", mOptions.rebuildThreshold, 1.f, std::numeric_limits<float>::max(), 0.05f);
+        widget.tooltip("A BLAS is rebuilt instead of refitted once its estimated SAH cost grows by this factor over the cost at its last rebuild.", true);
+
+        std::ostringstream oss;
+        oss << "Tracked BLASes: " << mStats.trackedGroupCount << std::endl
+            << "Refits: " << mStats.refitCount << std::endl
+            << "Rebuilds: " << mStats.rebuildCount << std::endl
+            << "Update time: " << std::fixed << std::setprecision(3) << mStats.updateTime << " ms" << std::endl;
+        for (uint32_t groupID = 0; groupID < (uint32_t)mGroups.size(); groupID++)
+        {
+            if (!isTracked(groupID)) continue;
+            oss << "Mesh group " << groupID << ": SAH ratio " << std::setprecision(2) << getSAHRatio(groupID) << std::endl;
+        }
+        widget.text(oss.str());
+    }
+
+    AABB BVHQualityTracker::computeBounds(const Primitive& primitive) const
+    {
+        const AnimationController* pAnimationController = mpScene->getAnimationController();
+        const glm::mat4& worldMatrix = pAnimationController->getGlobalMatrices()[primitive.worldMatrixID];
+        const glm::mat4& skinningMatrix = pAnimationController->getSkinningMatrices()[primitive.boneID];
+        return primitive.bindBounds.transform(glm::inverse(worldMatrix) * skinningMatrix);
+    }
+}
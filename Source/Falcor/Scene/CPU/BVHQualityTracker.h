@@ -0,0 +1,132 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "RefitBVH.h"
+
+namespace Falcor
+{
+    class Scene;
+
+    /** Tracks on the CPU how the quality of the scene's ray tracing BLASes degrades under animation.
+
+        BLASes containing skinned meshes are updated every frame the scene graph changes. Refitting is
+        fast, but the quality of a refitted BVH degrades as the geometry deforms away from the pose it
+        was built in. For each such mesh group, the tracker keeps a RefitBVH over the bind-pose bone
+        bounds of its skinned meshes, transformed by the current skinning matrices into the object space
+        of the BLAS. Only the primitives whose matrices changed are updated and refitted.
+
+        A rebuild is recommended for a mesh group once the SAH cost of its refitted hierarchy exceeds
+        the cost at its last rebuild by the configured ratio. This way only the degraded BLASes are
+        rebuilt, and the others keep being refitted. The decision is made per BLAS rather than per
+        subtree, as a DXR acceleration structure is opaque and can only be rebuilt or refitted as a whole.
+    */
+    class dlldecl BVHQualityTracker
+    {
+    public:
+        using SharedPtr = std::shared_ptr<BVHQualityTracker>;
+
+        struct Options
+        {
+            float rebuildThreshold = 1.5f;      ///< Recommend a rebuild when the SAH cost grows by this factor over the cost at the last rebuild.
+        };
+
+        struct Stats
+        {
+            uint32_t trackedGroupCount = 0;     ///< Number of tracked mesh groups.
+            uint64_t refitCount = 0;            ///< Number of mesh group updates where refitting was sufficient.
+            uint64_t rebuildCount = 0;          ///< Number of mesh group updates where a rebuild was recommended.
+            double updateTime = 0.0;            ///< Time spent in the last update in ms.
+        };
+
+        /** Create a tracker for a scene.
+            \param[in] pScene Scene to track. The tracker must not outlive it.
+            \param[in] options Tracker options.
+        */
+        static SharedPtr create(const Scene* pScene, const Options& options = Options());
+
+        /** Update the tracked hierarchies with the matrices changed by the last animation step.
+        */
+        void update();
+
+        /** Rebuild all tracked hierarchies from the current pose. Call when all BLASes were rebuilt.
+        */
+        void reset();
+
+        /** Check if a mesh group is tracked, i.e., if its BLAS contains skinned meshes.
+        */
+        bool isTracked(uint32_t meshGroupID) const;
+
+        /** Check if the BLAS of a mesh group has degraded enough that it should be rebuilt instead of refitted.
+            The recommendation persists until notifyRebuilt() is called for the mesh group.
+        */
+        bool isRebuildRecommended(uint32_t meshGroupID) const;
+
+        /** Notify the tracker that the BLAS of a mesh group was rebuilt.
+        */
+        void notifyRebuilt(uint32_t meshGroupID);
+
+        /** Get the ratio of the current SAH cost of a mesh group to the cost at its last rebuild.
+            Returns 1 for mesh groups that are not tracked.
+        */
+        float getSAHRatio(uint32_t meshGroupID) const;
+
+        void setOptions(const Options& options) { mOptions = options; }
+        const Options& getOptions() const { return mOptions; }
+        const Stats& getStats() const { return mStats; }
+
+        /** Render the UI.
+        */
+        void renderUI(Gui::Widgets& widget);
+
+    private:
+        BVHQualityTracker(const Scene* pScene, const Options& options);
+
+        /** Bone bounds of a skinned mesh in a mesh group.
+        */
+        struct Primitive
+        {
+            AABB bindBounds;            ///< Bounds in bind space.
+            uint32_t boneID;            ///< Bone matrix ID.
+            uint32_t worldMatrixID;     ///< Global matrix ID of the mesh instance, which defines the object space of the BLAS.
+        };
+
+        struct Group
+        {
+            std::vector<Primitive> primitives;
+            RefitBVH bvh;
+            bool rebuildRecommended = false;
+        };
+
+        AABB computeBounds(const Primitive& primitive) const;
+
+        const Scene* mpScene = nullptr;
+        Options mOptions;
+        Stats mStats;
+        std::vector<Group> mGroups;     ///< Per mesh group. Untracked groups have no primitives.
+    };
+}
@@ -0,0 +1,1047 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "CPUBVH.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <xmmintrin.h>
+#include <atomic>
+#include <execution>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kMaxDepth = 64;                      ///< Maximum depth of the binary hierarchy.
+        const uint32_t kMaxSAHDepth = 32;                   ///< Depth after which nodes are split at the object median, which bounds the depth to kMaxDepth.
+        const uint32_t kMaxBinCount = 256;
+        const uint32_t kParallelBinningThreshold = 1 << 16; ///< Minimum number of references to bin in parallel.
+        const uint32_t kBinningChunkSize = 1 << 14;         ///< Number of references per parallel binning task.
+        const uint32_t kMinTaskSize = 1 << 10;              ///< Minimum number of references per parallel subtree build.
+
+        /** Traversal stack size. Each level pushes at most N - 1 more entries than it pops.
+        */
+        template<uint32_t N>
+        constexpr uint32_t getStackSize() { return kMaxDepth * (N - 1) + 1; }
+
+        /** Reference to a triangle. With spatial splits the bounds cover only part of the triangle.
+        */
+        struct Reference
+        {
+            AABB bounds;
+            uint32_t index;
+        };
+
+        /** Node of the intermediate binary hierarchy.
+        */
+        struct BuildNode
+        {
+            AABB bounds;
+            uint32_t children[2] = { CPUBVH::kInvalidIndex, CPUBVH::kInvalidIndex };
+            uint32_t first = 0;     ///< First triangle of a leaf.
+            uint32_t count = 0;     ///< Triangle count of a leaf.
+
+            bool isLeaf() const { return children[0] == CPUBVH::kInvalidIndex; }
+        };
+
+        struct ObjectBin
+        {
+            AABB bounds;
+            uint32_t count = 0;
+
+            uint32_t getEntryCount() const { return count; }
+            uint32_t getExitCount() const { return count; }
+            void include(const ObjectBin& other) { bounds.include(other.bounds); count += other.count; }
+        };
+
+        /** Bin for spatial splits. References are counted in the bins where they start and end.
+        */
+        struct SpatialBin
+        {
+            AABB bounds;
+            uint32_t entryCount = 0;
+            uint32_t exitCount = 0;
+
+            uint32_t getEntryCount() const { return entryCount; }
+            uint32_t getExitCount() const { return exitCount; }
+            void include(const SpatialBin& other) { bounds.include(other.bounds); entryCount += other.entryCount; exitCount += other.exitCount; }
+        };
+
+        struct Split
+        {
+            float cost = std::numeric_limits<float>::infinity();
+            uint32_t axis = 0;
+            uint32_t bin = 0;           ///< Index of the first bin on the right side.
+            uint32_t leftCount = 0;
+            uint32_t rightCount = 0;
+            AABB leftBounds;
+            AABB rightBounds;
+
+            bool isValid() const { return cost < std::numeric_limits<float>::infinity(); }
+        };
+
+        /** Surface area that is zero for empty boxes.
+        */
+        inline float area(const AABB& bounds)
+        {
+            return bounds.valid() ? bounds.area() : 0.f;
+        }
+
+        /** Split a triangle reference at an axis-aligned plane.
+            The bounds of both halves are computed from the clipped triangle and are limited to the bounds of the reference.
+        */
+        void splitReference(const Reference& ref, const float3* vertices, uint32_t axis, float position, Reference& left, Reference& right)
+        {
+            left.index = right.index = ref.index;
+            left.bounds.invalidate();
+            right.bounds.invalidate();
+
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const float3& v0 = vertices[i];
+                const float3& v1 = vertices[(i + 1) % 3];
+                const float p0 = v0[axis];
+                const float p1 = v1[axis];
+
+                if (p0 <= position) left.bounds.include(v0);
+                if (p0 >= position) right.bounds.include(v0);
+
+                // Add the intersection of the edge with the plane to both sides.
+                if ((p0 < position && p1 > position) || (p0 > position && p1 < position))
+                {
+                    float3 p = glm::mix(v0, v1, glm::clamp((position - p0) / (p1 - p0), 0.f, 1.f));
+                    p[axis] = position;
+                    left.bounds.include(p);
+                    right.bounds.include(p);
+                }
+            }
+
+            left.bounds.intersection(ref.bounds);
+            right.bounds.intersection(ref.bounds);
+        }
+
+        /** Bin references, in parallel chunks for large nodes.
+            \param[in] refCount Number of references.
+            \param[in] binCount Size of the bin array.
+            \param[in] parallel Bin in parallel.
+            \param[in] binRange Function binning the references in a range [begin, end) into a bin array.
+            \return The bins.
+        */
+        template<typename BinT, typename F>
+        std::vector<BinT> computeBins(uint32_t refCount, uint32_t binCount, bool parallel, const F& binRange)
+        {
+            if (!parallel)
+            {
+                std::vector<BinT> bins(binCount);
+                binRange(0, refCount, bins);
+                return bins;
+            }
+
+            const uint32_t chunkCount = (refCount + kBinningChunkSize - 1) / kBinningChunkSize;
+            std::vector<std::vector<BinT>> chunkBins(chunkCount, std::vector<BinT>(binCount));
+            NumericRange<uint32_t> chunkRange(0, chunkCount);
+            std::for_each(std::execution::par, chunkRange.begin(), chunkRange.end(), [&] (uint32_t chunk)
+            {
+                binRange(chunk * kBinningChunkSize, std::min(refCount, (chunk + 1) * kBinningChunkSize), chunkBins[chunk]);
+            });
+
+            for (uint32_t chunk = 1; chunk < chunkCount; chunk++)
+            {
+                for (uint32_t b = 0; b < binCount; b++) chunkBins[0][b].include(chunkBins[chunk][b]);
+            }
+            return std::move(chunkBins[0]);
+        }
+
+        /** Evaluate the SAH cost at all bin boundaries along an axis and update the best split.
+            The cost is the sum of the child areas weighted by their reference counts.
+        */
+        template<typename BinT>
+        void findBestSplit(const BinT* bins, uint32_t binCount, uint32_t axis, Split& best)
+        {
+            float rightAreas[kMaxBinCount];
+            uint32_t rightCounts[kMaxBinCount];
+
+            // Sweep from the right, then from the left to evaluate all bin boundaries.
+            AABB bounds;
+            uint32_t count = 0;
+            for (uint32_t b = binCount - 1; b > 0; b--)
+            {
+                bounds.include(bins[b].bounds);
+                count += bins[b].getExitCount();
+                rightAreas[b] = area(bounds);
+                rightCounts[b] = count;
+            }
+
+            bounds.invalidate();
+            count = 0;
+            bool improved = false;
+            for (uint32_t b = 1; b < binCount; b++)
+            {
+                bounds.include(bins[b - 1].bounds);
+                count += bins[b - 1].getEntryCount();
+                if (count == 0 || rightCounts[b] == 0) continue;
+
+                float cost = area(bounds) * count + rightAreas[b] * rightCounts[b];
+                if (cost < best.cost)
+                {
+                    best.cost = cost;
+                    best.axis = axis;
+                    best.bin = b;
+                    best.leftCount = count;
+                    best.rightCount = rightCounts[b];
+                    best.leftBounds = bounds;
+                    improved = true;
+                }
+            }
+
+            if (improved)
+            {
+                best.rightBounds.invalidate();
+                for (uint32_t b = best.bin; b < binCount; b++) best.rightBounds.include(bins[b].bounds);
+            }
+        }
+
+        /** Binary hierarchy.
+        */
+        struct BinaryTree
+        {
+            std::vector<BuildNode> nodes;       ///< Nodes. The root is node 0.
+            std::vector<uint32_t> triangles;    ///< Triangle indices of the leaves.
+        };
+
+        /** Top-down builder of the binary hierarchy.
+        */
+        class TreeBuilder
+        {
+        public:
+            TreeBuilder(const std::vector<float3>& vertices, const CPUBVH::BuildOptions& options)
+                : mVertices(vertices)
+                , mOptions(options)
+            {
+                mOptions.binCount = glm::clamp(mOptions.binCount, 2u, kMaxBinCount);
+                mOptions.maxLeafSize = glm::clamp(mOptions.maxLeafSize, 1u, CPUBVH::kMaxLeafSize);
+            }
+
+            void build(std::vector<Reference> refs, BinaryTree& tree)
+            {
+                const uint32_t triangleCount = (uint32_t)refs.size();
+                mDuplicationBudget = mOptions.builder == CPUBVH::Builder::SBVH ? (int64_t)(std::max(mOptions.maxDuplication, 0.f) * triangleCount) : 0;
+                AABB rootBounds;
+                for (const auto& ref : refs) rootBounds.include(ref.bounds);
+                mRootArea = area(rootBounds);
+
+                // Split the upper levels on this thread and collect the remaining subtrees as tasks.
+                std::vector<Task> tasks;
+                const size_t taskSize = mOptions.parallel ? std::max<size_t>(refs.size() / (8 * std::max(std::thread::hardware_concurrency(), 1u)), kMinTaskSize) : std::numeric_limits<size_t>::max();
+                buildTopLevel(tree, tasks, refs, 0, taskSize);
+
+                // Build the subtrees in parallel.
+                std::vector<BinaryTree> subtrees(tasks.size());
+                NumericRange<uint32_t> taskRange(0, (uint32_t)tasks.size());
+                auto buildTask = [&] (uint32_t i)
+                {
+                    buildSubtree(subtrees[i], tasks[i].refs, tasks[i].depth);
+                };
+                if (mOptions.parallel) std::for_each(std::execution::par, taskRange.begin(), taskRange.end(), buildTask);
+                else std::for_each(taskRange.begin(), taskRange.end(), buildTask);
+
+                // Append the subtrees. The subtree root replaces the placeholder node of its task.
+                for (size_t i = 0; i < tasks.size(); i++)
+                {
+                    const uint32_t nodeOffset = (uint32_t)tree.nodes.size();
+                    const uint32_t triangleOffset = (uint32_t)tree.triangles.size();
+                    for (BuildNode node : subtrees[i].nodes)
+                    {
+                        if (node.isLeaf()) node.first += triangleOffset;
+                        else for (auto& child : node.children) child += nodeOffset;
+                        tree.nodes.push_back(node);
+                    }
+                    tree.triangles.insert(tree.triangles.end(), subtrees[i].triangles.begin(), subtrees[i].triangles.end());
+                    tree.nodes[tasks[i].nodeIndex] = tree.nodes[nodeOffset];
+                    subtrees[i] = BinaryTree();
+                }
+            }
+
+        private:
+            struct Task
+            {
+                std::vector<Reference> refs;
+                uint32_t nodeIndex;
+                uint32_t depth;
+            };
+
+            uint32_t buildTopLevel(BinaryTree& tree, std::vector<Task>& tasks, std::vector<Reference>& refs, uint32_t depth, size_t taskSize)
+            {
+                const uint32_t nodeIndex = (uint32_t)tree.nodes.size();
+                tree.nodes.emplace_back();
+
+                if (refs.size() <= taskSize)
+                {
+                    tasks.push_back({ std::move(refs), nodeIndex, depth });
+                    return nodeIndex;
+                }
+
+                std::vector<Reference> left, right;
+                if (!splitNode(refs, depth, tree.nodes[nodeIndex].bounds, left, right))
+                {
+                    makeLeaf(tree, nodeIndex, refs);
+                    return nodeIndex;
+                }
+                std::vector<Reference>().swap(refs);
+
+                uint32_t leftIndex = buildTopLevel(tree, tasks, left, depth + 1, taskSize);
+                uint32_t rightIndex = buildTopLevel(tree, tasks, right, depth + 1, taskSize);
+                tree.nodes[nodeIndex].children[0] = leftIndex;
+                tree.nodes[nodeIndex].children[1] = rightIndex;
+                return nodeIndex;
+            }
+
+            uint32_t buildSubtree(BinaryTree& tree, std::vector<Reference>& refs, uint32_t depth)
+            {
+                const uint32_t nodeIndex = (uint32_t)tree.nodes.size();
+                tree.nodes.emplace_back();
+
+                std::vector<Reference> left, right;
+                if (!splitNode(refs, depth, tree.nodes[nodeIndex].bounds, left, right))
+                {
+                    makeLeaf(tree, nodeIndex, refs);
+                    return nodeIndex;
+                }
+                std::vector<Reference>().swap(refs);
+
+                uint32_t leftIndex = buildSubtree(tree, left, depth + 1);
+                uint32_t rightIndex = buildSubtree(tree, right, depth + 1);
+                tree.nodes[nodeIndex].children[0] = leftIndex;
+                tree.nodes[nodeIndex].children[1] = rightIndex;
+                return nodeIndex;
+            }
+
+            void makeLeaf(BinaryTree& tree, uint32_t nodeIndex, const std::vector<Reference>& refs)
+            {
+                tree.nodes[nodeIndex].first = (uint32_t)tree.triangles.size();
+                tree.nodes[nodeIndex].count = (uint32_t)refs.size();
+                for (const auto& ref : refs) tree.triangles.push_back(ref.index);
+            }
+
+            /** Find the best split of a node and partition its references.
+                \param[in] refs References of the node.
+                \param[in] depth Depth of the node.
+                \param[out] bounds Bounds of the node.
+                \param[out] left References of the left child.
+                \param[out] right References of the right child.
+                \return False if a leaf should be created.
+            */
+            bool splitNode(std::vector<Reference>& refs, uint32_t depth, AABB& bounds, std::vector<Reference>& left, std::vector<Reference>& right)
+            {
+                const uint32_t count = (uint32_t)refs.size();
+                const bool parallel = mOptions.parallel && count >= kParallelBinningThreshold;
+
+                AABB centroidBounds;
+                for (const auto& ref : refs)
+                {
+                    bounds.include(ref.bounds);
+                    centroidBounds.include(ref.bounds.center());
+                }
+
+                if (count <= 1) return false;
+                if (depth >= kMaxSAHDepth)
+                {
+                    if (count <= mOptions.maxLeafSize) return false;
+                    splitMedian(refs, centroidBounds, left, right);
+                    return true;
+                }
+
+                // Object splits.
+                const uint32_t binCount = mOptions.binCount;
+                const float3 centroidExtent = centroidBounds.extent();
+                auto getObjectBin = [&] (const Reference& ref, uint32_t axis)
+                {
+                    const float scale = binCount / centroidExtent[axis];
+                    return std::min(binCount - 1, (uint32_t)((ref.bounds.center()[axis] - centroidBounds.minPoint[axis]) * scale));
+                };
+
+                Split objectSplit;
+                auto objectBins = computeBins<ObjectBin>(count, 3 * binCount, parallel, [&] (uint32_t begin, uint32_t end, std::vector<ObjectBin>& bins)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        for (uint32_t axis = 0; axis < 3; axis++)
+                        {
+                            if (centroidExtent[axis] <= 0.f) continue;
+                            auto& bin = bins[axis * binCount + getObjectBin(refs[i], axis)];
+                            bin.bounds.include(refs[i].bounds);
+                            bin.count++;
+                        }
+                    }
+                });
+                for (uint32_t axis = 0; axis < 3; axis++)
+                {
+                    if (centroidExtent[axis] > 0.f) findBestSplit(&objectBins[axis * binCount], binCount, axis, objectSplit);
+                }
+
+                // Spatial splits, if the children of the best object split overlap significantly.
+                Split spatialSplit;
+                const float3 extent = bounds.extent();
+                if (mOptions.builder == CPUBVH::Builder::SBVH && objectSplit.isValid() && mDuplicationBudget.load() > 0 &&
+                    area(AABB(objectSplit.leftBounds).intersection(objectSplit.rightBounds)) > mOptions.splitAlpha * mRootArea)
+                {
+                    const float3 binSize = extent / (float)binCount;
+                    auto getSpatialBin = [&] (float p, uint32_t axis)
+                    {
+                        return std::min(binCount - 1, (uint32_t)std::max(0.f, (p - bounds.minPoint[axis]) / binSize[axis]));
+                    };
+
+                    auto spatialBins = computeBins<SpatialBin>(count, 3 * binCount, parallel, [&] (uint32_t begin, uint32_t end, std::vector<SpatialBin>& bins)
+                    {
+                        for (uint32_t i = begin; i < end; i++)
+                        {
+                            for (uint32_t axis = 0; axis < 3; axis++)
+                            {
+                                if (extent[axis] <= 0.f) continue;
+                                SpatialBin* axisBins = &bins[axis * binCount];
+
+                                // Clip the reference to the bins it overlaps.
+                                Reference ref = refs[i];
+                                const uint32_t firstBin = getSpatialBin(ref.bounds.minPoint[axis], axis);
+                                const uint32_t lastBin = std::max(firstBin, getSpatialBin(ref.bounds.maxPoint[axis], axis));
+                                for (uint32_t b = firstBin; b < lastBin; b++)
+                                {
+                                    Reference leftRef, rightRef;
+                                    splitReference(ref, &mVertices[3 * (size_t)ref.index], axis, bounds.minPoint[axis] + binSize[axis] * (b + 1), leftRef, rightRef);
+                                    axisBins[b].bounds.include(leftRef.bounds);
+                                    ref = rightRef;
+                                }
+                                axisBins[lastBin].bounds.include(ref.bounds);
+                                axisBins[firstBin].entryCount++;
+                                axisBins[lastBin].exitCount++;
+                            }
+                        }
+                    });
+                    for (uint32_t axis = 0; axis < 3; axis++)
+                    {
+                        if (extent[axis] > 0.f) findBestSplit(&spatialBins[axis * binCount], binCount, axis, spatialSplit);
+                    }
+
+                    // Discard spatial splits that exceed the duplication budget.
+                    if (spatialSplit.isValid() && (int64_t)(spatialSplit.leftCount + spatialSplit.rightCount - count) > mDuplicationBudget.load())
+                    {
+                        spatialSplit = Split();
+                    }
+                }
+
+                const bool useSpatialSplit = spatialSplit.cost < objectSplit.cost;
+                const float bestCost = std::min(objectSplit.cost, spatialSplit.cost);
+                if (bestCost == std::numeric_limits<float>::infinity())
+                {
+                    // All centroids coincide. Split in the middle if the leaf would be too large.
+                    if (count <= mOptions.maxLeafSize) return false;
+                    splitMedian(refs, centroidBounds, left, right);
+                    return true;
+                }
+
+                const float nodeArea = area(bounds);
+                const float leafCost = (float)count;
+                const float splitCost = mOptions.traversalCost + (nodeArea > 0.f ? bestCost / nodeArea : (float)count);
+                if (count <= mOptions.maxLeafSize && splitCost >= leafCost) return false;
+
+                if (useSpatialSplit)
+                {
+                    const float position = bounds.minPoint[spatialSplit.axis] + extent[spatialSplit.axis] / (float)binCount * spatialSplit.bin;
+                    if (partitionSpatial(refs, spatialSplit.axis, position, left, right)) return true;
+                    left.clear();
+                    right.clear();
+                }
+
+                for (const auto& ref : refs)
+                {
+                    (getObjectBin(ref, objectSplit.axis) < objectSplit.bin ? left : right).push_back(ref);
+                }
+                return true;
+            }
+
+            /** Partition references at a spatial split plane.
+                References straddling the plane are split, unless moving them to one side has a lower SAH cost (reference unsplitting).
+                \return False if one side is empty.
+            */
+            bool partitionSpatial(const std::vector<Reference>& refs, uint32_t axis, float position, std::vector<Reference>& left, std::vector<Reference>& right)
+            {
+                std::vector<Reference> straddling;
+                AABB leftBounds, rightBounds;
+                for (const auto& ref : refs)
+                {
+                    if (ref.bounds.maxPoint[axis] <= position)
+                    {
+                        left.push_back(ref);
+                        leftBounds.include(ref.bounds);
+                    }
+                    else if (ref.bounds.minPoint[axis] >= position)
+                    {
+                        right.push_back(ref);
+                        rightBounds.include(ref.bounds);
+                    }
+                    else
+                    {
+                        straddling.push_back(ref);
+                    }
+                }
+
+                uint32_t leftCount = (uint32_t)(left.size() + straddling.size());
+                uint32_t rightCount = (uint32_t)(right.size() + straddling.size());
+                for (const auto& ref : straddling)
+                {
+                    Reference leftRef, rightRef;
+                    splitReference(ref, &mVertices[3 * (size_t)ref.index], axis, position, leftRef, rightRef);
+
+                    float splitCost = std::numeric_limits<float>::infinity();
+                    if (leftRef.bounds.valid() && rightRef.bounds.valid())
+                    {
+                        splitCost = area(AABB(leftBounds).include(leftRef.bounds)) * leftCount + area(AABB(rightBounds).include(rightRef.bounds)) * rightCount;
+                    }
+                    const float leftCost = area(AABB(leftBounds).include(ref.bounds)) * leftCount + area(rightBounds) * (rightCount - 1);
+                    const float rightCost = area(leftBounds) * (leftCount - 1) + area(AABB(rightBounds).include(ref.bounds)) * rightCount;
+
+                    if (splitCost <= leftCost && splitCost <= rightCost)
+                    {
+                        left.push_back(leftRef);
+                        leftBounds.include(leftRef.bounds);
+                        right.push_back(rightRef);
+                        rightBounds.include(rightRef.bounds);
+                    }
+                    else if (leftCost <= rightCost)
+                    {
+                        left.push_back(ref);
+                        leftBounds.include(ref.bounds);
+                        rightCount--;
+                    }
+                    else
+                    {
+                        right.push_back(ref);
+                        rightBounds.include(ref.bounds);
+                        leftCount--;
+                    }
+                }
+
+                if (left.empty() || right.empty()) return false;
+                mDuplicationBudget -= (int64_t)(left.size() + right.size() - refs.size());
+                return true;
+            }
+
+            /** Split references at the median centroid along the axis of largest centroid extent.
+            */
+            void splitMedian(std::vector<Reference>& refs, const AABB& centroidBounds, std::vector<Reference>& left, std::vector<Reference>& right)
+            {
+                const float3 extent = centroidBounds.extent();
+                const uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+                auto median = refs.begin() + refs.size() / 2;
+                std::nth_element(refs.begin(), median, refs.end(), [axis] (const Reference& a, const Reference& b)
+                {
+                    return a.bounds.center()[axis] < b.bounds.center()[axis];
+                });
+                left.assign(refs.begin(), median);
+                right.assign(median, refs.end());
+            }
+
+            const std::vector<float3>& mVertices;
+            CPUBVH::BuildOptions mOptions;
+            float mRootArea = 0.f;
+            std::atomic<int64_t> mDuplicationBudget{ 0 };    ///< Number of additional references that spatial splits may still create.
+        };
+
+        inline float3 safeInverse(const float3& d)
+        {
+            const float kHuge = 1e30f;
+            return float3(d.x != 0.f ? 1.f / d.x : kHuge, d.y != 0.f ? 1.f / d.y : kHuge, d.z != 0.f ? 1.f / d.z : kHuge);
+        }
+
+        inline float horizontalMax(__m128 v)
+        {
+            alignas(16) float values[4];
+            _mm_store_ps(values, v);
+            return std::max(std::max(values[0], values[1]), std::max(values[2], values[3]));
+        }
+    }
+
+    struct CPUBVH::BuildTree : BinaryTree {};
+
+    template<> std::vector<CPUBVH::Node<4>>& CPUBVH::getNodes<4>() { return mNodes4; }
+    template<> std::vector<CPUBVH::Node<8>>& CPUBVH::getNodes<8>() { return mNodes8; }
+    template<> const std::vector<CPUBVH::Node<4>>& CPUBVH::getNodes<4>() const { return mNodes4; }
+    template<> const std::vector<CPUBVH::Node<8>>& CPUBVH::getNodes<8>() const { return mNodes8; }
+
+    CPUBVH::SharedPtr CPUBVH::create(const std::vector<float3>& vertices, const BuildOptions& options)
+    {
+        if (options.width != 4 && options.width != 8) throw std::exception("CPUBVH::create() - Width must be 4 or 8");
+        return SharedPtr(new CPUBVH(vertices, options));
+    }
+
+    CPUBVH::CPUBVH(const std::vector<float3>& vertices, const BuildOptions& options)
+        : mWidth(options.width)
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        mTriangleCount = (uint32_t)(vertices.size() / 3);
+
+        std::vector<Reference> refs(mTriangleCount);
+        for (uint32_t i = 0; i < mTriangleCount; i++)
+        {
+            auto& ref = refs[i];
+            ref.bounds = AABB(vertices[3 * i]);
+            ref.bounds.include(vertices[3 * i + 1]).include(vertices[3 * i + 2]);
+            ref.index = i;
+            mBounds.include(ref.bounds);
+        }
+
+        BuildTree tree;
+        TreeBuilder(vertices, options).build(std::move(refs), tree);
+        if (mWidth == 8) collapse<8>(tree, vertices);
+        else collapse<4>(tree, vertices);
+
+        mBuildTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+    }
+
+    template<uint32_t N>
+    void CPUBVH::collapse(const BuildTree& tree, const std::vector<float3>& vertices)
+    {
+        const auto& buildNodes = tree.nodes;
+        auto& nodes = getNodes<N>();
+
+        // Collapse the binary hierarchy into N-wide nodes.
+        // Each node opens the child with the largest surface area until it has N children.
+        mTriangles.reserve(tree.triangles.size());
+        auto emitLeaf = [&] (const BuildNode& node)
+        {
+            uint32_t first = (uint32_t)mTriangles.size();
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                uint32_t index = tree.triangles[i];
+                const float3& v0 = vertices[3 * index];
+                mTriangles.push_back({ v0, vertices[3 * index + 1] - v0, vertices[3 * index + 2] - v0, index });
+            }
+            return makeLeaf(first, node.count);
+        };
+
+        auto initNode = [] (Node<N>& node)
+        {
+            for (uint32_t i = 0; i < N; i++)
+            {
+                for (uint32_t j = 0; j < 6; j++) node.bounds[j][i] = std::numeric_limits<float>::quiet_NaN();
+                node.child[i] = kInvalidIndex;
+            }
+        };
+
+        std::function<uint32_t(uint32_t)> collapseNode = [&] (uint32_t buildIndex)
+        {
+            uint32_t children[N] = { buildNodes[buildIndex].children[0], buildNodes[buildIndex].children[1] };
+            uint32_t childCount = 2;
+            while (childCount < N)
+            {
+                int largest = -1;
+                float largestArea = -1.f;
+                for (uint32_t i = 0; i < childCount; i++)
+                {
+                    const BuildNode& child = buildNodes[children[i]];
+                    if (!child.isLeaf() && child.bounds.area() > largestArea)
+                    {
+                        largest = (int)i;
+                        largestArea = child.bounds.area();
+                    }
+                }
+                if (largest < 0) break;
+
+                const BuildNode& child = buildNodes[children[largest]];
+                children[largest] = child.children[0];
+                children[childCount++] = child.children[1];
+            }
+
+            const uint32_t nodeIndex = (uint32_t)nodes.size();
+            nodes.emplace_back();
+
+            Node<N> node;
+            initNode(node);
+            for (uint32_t i = 0; i < childCount; i++)
+            {
+                const BuildNode& child = buildNodes[children[i]];
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    node.bounds[j][i] = child.bounds.minPoint[j];
+                    node.bounds[3 + j][i] = child.bounds.maxPoint[j];
+                }
+                node.child[i] = child.isLeaf() ? emitLeaf(child) : collapseNode(children[i]);
+            }
+            nodes[nodeIndex] = node;
+            return nodeIndex;
+        };
+
+        if (buildNodes[0].isLeaf())
+        {
+            // Wrap a single leaf into a root node.
+            Node<N> root;
+            initNode(root);
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                root.bounds[j][0] = mBounds.minPoint[j];
+                root.bounds[3 + j][0] = mBounds.maxPoint[j];
+            }
+            if (buildNodes[0].count > 0) root.child[0] = emitLeaf(buildNodes[0]);
+            nodes.push_back(root);
+        }
+        else
+        {
+            collapseNode(0);
+        }
+    }
+
+    bool CPUBVH::intersect(const Ray& ray, Hit& hit) const
+    {
+        hit = Hit();
+        return mWidth == 8 ? traverse<8, false>(ray, hit) : traverse<4, false>(ray, hit);
+    }
+
+    bool CPUBVH::isOccluded(const Ray& ray) const
+    {
+        Hit hit;
+        return mWidth == 8 ? traverse<8, true>(ray, hit) : traverse<4, true>(ray, hit);
+    }
+
+    uint32_t CPUBVH::intersectPacket(const Ray* rays, Hit* hits, uint32_t rayCount) const
+    {
+        assert(rayCount <= kPacketSize);
+        for (uint32_t i = 0; i < rayCount; i++) hits[i] = Hit();
+        return mWidth == 8 ? traversePacket<8, false>(rays, hits, rayCount) : traversePacket<4, false>(rays, hits, rayCount);
+    }
+
+    uint32_t CPUBVH::isOccludedPacket(const Ray* rays, uint32_t rayCount) const
+    {
+        assert(rayCount <= kPacketSize);
+        return mWidth == 8 ? traversePacket<8, true>(rays, nullptr, rayCount) : traversePacket<4, true>(rays, nullptr, rayCount);
+    }
+
+    template<uint32_t N, bool kAnyHit>
+    bool CPUBVH::traverse(const Ray& ray, Hit& hit) const
+    {
+        struct StackEntry
+        {
+            uint32_t ref;
+            float t;
+        };
+        StackEntry stack[getStackSize<N>()];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = { 0, ray.tMin };
+
+        const auto& nodes = getNodes<N>();
+        const float3 invDir = safeInverse(ray.dir);
+        const __m128 origin[3] = { _mm_set1_ps(ray.origin.x), _mm_set1_ps(ray.origin.y), _mm_set1_ps(ray.origin.z) };
+        const __m128 inv[3] = { _mm_set1_ps(invDir.x), _mm_set1_ps(invDir.y), _mm_set1_ps(invDir.z) };
+        const __m128 tMin = _mm_set1_ps(ray.tMin);
+        float tMax = ray.tMax;
+
+        while (stackSize > 0)
+        {
+            const StackEntry entry = stack[--stackSize];
+            if (entry.t > tMax) continue;
+
+            if (isLeaf(entry.ref))
+            {
+                const uint32_t first = getLeafFirst(entry.ref);
+                const uint32_t last = first + getLeafCount(entry.ref);
+                for (uint32_t i = first; i < last; i++)
+                {
+                    // Moeller-Trumbore ray/triangle intersection.
+                    const Triangle& tri = mTriangles[i];
+                    const float3 p = cross(ray.dir, tri.e2);
+                    const float det = dot(tri.e1, p);
+                    if (det == 0.f) continue;
+                    const float invDet = 1.f / det;
+                    const float3 s = ray.origin - tri.v0;
+                    const float u = dot(s, p) * invDet;
+                    if (u < 0.f || u > 1.f) continue;
+                    const float3 q = cross(s, tri.e1);
+                    const float v = dot(ray.dir, q) * invDet;
+                    if (v < 0.f || u + v > 1.f) continue;
+                    const float t = dot(tri.e2, q) * invDet;
+                    if (t < ray.tMin || t > tMax) continue;
+
+                    hit.triangleIndex = tri.index;
+                    hit.t = t;
+                    hit.barycentrics = float2(u, v);
+                    if (kAnyHit) return true;
+                    tMax = t;
+                }
+                continue;
+            }
+
+            // Intersect the ray with the child boxes, four at a time.
+            const Node<N>& node = nodes[entry.ref];
+            alignas(16) float tNearValues[N];
+            int mask = 0;
+            for (uint32_t k = 0; k < N; k += 4)
+            {
+                __m128 tNear = tMin;
+                __m128 tFar = _mm_set1_ps(tMax);
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&node.bounds[j][k]), origin[j]), inv[j]);
+                    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&node.bounds[3 + j][k]), origin[j]), inv[j]);
+                    tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+                    tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+                }
+                mask |= _mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) << k;
+                _mm_store_ps(&tNearValues[k], tNear);
+            }
+            if (mask == 0) continue;
+
+            // Push the hit children with the closest one on top of the stack.
+            StackEntry children[N];
+            uint32_t childCount = 0;
+            for (uint32_t i = 0; i < N; i++)
+            {
+                if ((mask & (1 << i)) == 0 || node.child[i] == kInvalidIndex) continue;
+                StackEntry child = { node.child[i], tNearValues[i] };
+                uint32_t k = childCount++;
+                while (k > 0 && children[k - 1].t < child.t)
+                {
+                    children[k] = children[k - 1];
+                    k--;
+                }
+                children[k] = child;
+            }
+            for (uint32_t i = 0; i < childCount; i++) stack[stackSize++] = children[i];
+        }
+
+        return hit.isValid();
+    }
+
+    template<uint32_t N, bool kAnyHit>
+    uint32_t CPUBVH::traversePacket(const Ray* rays, Hit* hits, uint32_t rayCount) const
+    {
+        struct StackEntry
+        {
+            uint32_t ref;
+            float t;
+        };
+        StackEntry stack[getStackSize<N>()];
+        uint32_t stackSize = 0;
+
+        // Load the rays in SoA layout. Unused lanes get an empty interval.
+        alignas(16) float values[10][kPacketSize];
+        for (uint32_t i = 0; i < kPacketSize; i++)
+        {
+            const Ray ray = i < rayCount ? rays[i] : Ray{ float3(0.f), 1.f, float3(1.f), 0.f };
+            const float3 invDir = safeInverse(ray.dir);
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                values[j][i] = ray.origin[j];
+                values[3 + j][i] = ray.dir[j];
+                values[6 + j][i] = invDir[j];
+            }
+            values[9][i] = ray.tMin;
+        }
+        __m128 origin[3], dir[3], inv[3];
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            origin[j] = _mm_load_ps(values[j]);
+            dir[j] = _mm_load_ps(values[3 + j]);
+            inv[j] = _mm_load_ps(values[6 + j]);
+        }
+        const __m128 tMin = _mm_load_ps(values[9]);
+
+        alignas(16) float tMaxValues[kPacketSize];
+        for (uint32_t i = 0; i < kPacketSize; i++) tMaxValues[i] = i < rayCount ? rays[i].tMax : -std::numeric_limits<float>::infinity();
+        __m128 tMax = _mm_load_ps(tMaxValues);
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 negInf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+        const uint32_t activeMask = (1 << rayCount) - 1;
+        uint32_t hitMask = 0;
+
+        const auto& nodes = getNodes<N>();
+        stack[stackSize++] = { 0, -std::numeric_limits<float>::infinity() };
+        float tMaxPacket = horizontalMax(tMax);
+
+        while (stackSize > 0)
+        {
+            const StackEntry entry = stack[--stackSize];
+            if (entry.t > tMaxPacket) continue;
+
+            if (isLeaf(entry.ref))
+            {
+                const uint32_t first = getLeafFirst(entry.ref);
+                const uint32_t last = first + getLeafCount(entry.ref);
+                for (uint32_t i = first; i < last; i++)
+                {
+                    // Moeller-Trumbore ray/triangle intersection for all rays in the packet.
+                    const Triangle& tri = mTriangles[i];
+                    const __m128 v0[3] = { _mm_set1_ps(tri.v0.x), _mm_set1_ps(tri.v0.y), _mm_set1_ps(tri.v0.z) };
+                    const __m128 e1[3] = { _mm_set1_ps(tri.e1.x), _mm_set1_ps(tri.e1.y), _mm_set1_ps(tri.e1.z) };
+                    const __m128 e2[3] = { _mm_set1_ps(tri.e2.x), _mm_set1_ps(tri.e2.y), _mm_set1_ps(tri.e2.z) };
+
+                    const __m128 p[3] =
+                    {
+                        _mm_sub_ps(_mm_mul_ps(dir[1], e2[2]), _mm_mul_ps(e2[1], dir[2])),
+                        _mm_sub_ps(_mm_mul_ps(dir[2], e2[0]), _mm_mul_ps(e2[2], dir[0])),
+                        _mm_sub_ps(_mm_mul_ps(dir[0], e2[1]), _mm_mul_ps(e2[0], dir[1])),
+                    };
+                    const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1[0], p[0]), _mm_mul_ps(e1[1], p[1])), _mm_mul_ps(e1[2], p[2]));
+                    const __m128 invDet = _mm_div_ps(one, det);
+                    const __m128 s[3] = { _mm_sub_ps(origin[0], v0[0]), _mm_sub_ps(origin[1], v0[1]), _mm_sub_ps(origin[2], v0[2]) };
+                    const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(s[0], p[0]), _mm_mul_ps(s[1], p[1])), _mm_mul_ps(s[2], p[2])), invDet);
+                    const __m128 q[3] =
+                    {
+                        _mm_sub_ps(_mm_mul_ps(s[1], e1[2]), _mm_mul_ps(e1[1], s[2])),
+                        _mm_sub_ps(_mm_mul_ps(s[2], e1[0]), _mm_mul_ps(e1[2], s[0])),
+                        _mm_sub_ps(_mm_mul_ps(s[0], e1[1]), _mm_mul_ps(e1[0], s[1])),
+                    };
+                    const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dir[0], q[0]), _mm_mul_ps(dir[1], q[1])), _mm_mul_ps(dir[2], q[2])), invDet);
+                    const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2[0], q[0]), _mm_mul_ps(e2[1], q[1])), _mm_mul_ps(e2[2], q[2])), invDet);
+
+                    __m128 valid = _mm_cmpneq_ps(det, zero);
+                    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+                    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+                    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(t, tMin), _mm_cmple_ps(t, tMax)));
+                    const uint32_t mask = (uint32_t)_mm_movemask_ps(valid) & activeMask;
+                    if (mask == 0) continue;
+
+                    hitMask |= mask;
+                    if (kAnyHit)
+                    {
+                        // Deactivate the occluded rays.
+                        tMax = _mm_or_ps(_mm_and_ps(valid, negInf), _mm_andnot_ps(valid, tMax));
+                        if (hitMask == activeMask) return hitMask;
+                        continue;
+                    }
+
+                    tMax = _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, tMax));
+                    alignas(16) float tValues[kPacketSize], uValues[kPacketSize], vValues[kPacketSize];
+                    _mm_store_ps(tValues, t);
+                    _mm_store_ps(uValues, u);
+                    _mm_store_ps(vValues, v);
+                    for (uint32_t k = 0; k < rayCount; k++)
+                    {
+                        if ((mask & (1 << k)) == 0) continue;
+                        hits[k].triangleIndex = tri.index;
+                        hits[k].t = tValues[k];
+                        hits[k].barycentrics = float2(uValues[k], vValues[k]);
+                    }
+                }
+                tMaxPacket = horizontalMax(tMax);
+                continue;
+            }
+
+            // Intersect all rays with each child box.
+            const Node<N>& node = nodes[entry.ref];
+            StackEntry children[N];
+            uint32_t childCount = 0;
+            for (uint32_t i = 0; i < N; i++)
+            {
+                if (node.child[i] == kInvalidIndex) continue;
+                __m128 tNear = tMin;
+                __m128 tFar = tMax;
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds[j][i]), origin[j]), inv[j]);
+                    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds[3 + j][i]), origin[j]), inv[j]);
+                    tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+                    tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+                }
+                const int mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+                if (mask == 0) continue;
+
+                // Order the children by the closest entry distance of any ray.
+                alignas(16) float tNearValues[kPacketSize];
+                _mm_store_ps(tNearValues, tNear);
+                float tChild = std::numeric_limits<float>::infinity();
+                for (uint32_t k = 0; k < kPacketSize; k++) if (mask & (1 << k)) tChild = std::min(tChild, tNearValues[k]);
+
+                StackEntry child = { node.child[i], tChild };
+                uint32_t k = childCount++;
+                while (k > 0 && children[k - 1].t < child.t)
+                {
+                    children[k] = children[k - 1];
+                    k--;
+                }
+                children[k] = child;
+            }
+            for (uint32_t i = 0; i < childCount; i++) stack[stackSize++] = children[i];
+        }
+
+        return hitMask;
+    }
+
+    float CPUBVH::getSAHCost() const
+    {
+        return mWidth == 8 ? computeSAHCost<8>() : computeSAHCost<4>();
+    }
+
+    template<uint32_t N>
+    float CPUBVH::computeSAHCost() const
+    {
+        const float rootArea = mBounds.area();
+        if (rootArea <= 0.f) return 0.f;
+
+        // The root traversal is counted with unit probability.
+        float cost = 1.f;
+        for (const auto& node : getNodes<N>())
+        {
+            for (uint32_t i = 0; i < N; i++)
+            {
+                if (node.child[i] == kInvalidIndex) continue;
+                AABB bounds(float3(node.bounds[0][i], node.bounds[1][i], node.bounds[2][i]), float3(node.bounds[3][i], node.bounds[4][i], node.bounds[5][i]));
+                cost += bounds.area() / rootArea * (isLeaf(node.child[i]) ? (float)getLeafCount(node.child[i]) : 1.f);
+            }
+        }
+        return cost;
+    }
+
+    SCRIPT_BINDING(CPUBVH)
+    {
+        pybind11::class_<CPUBVH, CPUBVH::SharedPtr> bvh(m, "CPUBVH");
+        bvh.def_property_readonly("triangleCount", &CPUBVH::getTriangleCount);
+        bvh.def_property_readonly("referenceCount", &CPUBVH::getReferenceCount);
+        bvh.def_property_readonly("nodeCount", &CPUBVH::getNodeCount);
+        bvh.def_property_readonly("width", &CPUBVH::getWidth);
+        bvh.def_property_readonly("buildTime", &CPUBVH::getBuildTime);
+        bvh.def_property_readonly("sahCost", &CPUBVH::getSAHCost);
+
+        pybind11::enum_<CPUBVH::Builder> builder(m, "CPUBVHBuilder");
+        builder.value("BinnedSAH", CPUBVH::Builder::BinnedSAH);
+        builder.value("SBVH", CPUBVH::Builder::SBVH);
+
+        // TODO use a nested class in the bindings when supported.
+        ScriptBindings::SerializableStruct<CPUBVH::BuildOptions> options(m, "CPUBVHBuildOptions");
+#define field(f_) field(#f_, &CPUBVH::BuildOptions::f_)
+        options.field(builder);
+        options.field(width);
+        options.field(binCount);
+        options.field(maxLeafSize);
+        options.field(traversalCost);
+        options.field(splitAlpha);
+        options.field(maxDuplication);
+        options.field(parallel);
+#undef field
+    }
+}
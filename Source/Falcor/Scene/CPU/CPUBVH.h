@@ -0,0 +1,198 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Utils/Math/AABB.h"
+
+namespace Falcor
+{
+    /** Bounding volume hierarchy over triangles for ray queries on the CPU.
+
+        The hierarchy is built top-down, either with binned SAH or as a spatial split BVH (SBVH),
+        and then collapsed into 4- or 8-wide nodes. The child bounds of a node are stored in SoA
+        layout so that single-ray traversal tests a ray against four children at a time using SSE.
+        Packet traversal instead tests a packet of four rays against one child at a time.
+
+        Large builds are parallelized. The upper levels of the hierarchy are split on the calling
+        thread using parallel binning, and the remaining subtrees are built in parallel.
+    */
+    class dlldecl CPUBVH
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CPUBVH>;
+
+        static const uint32_t kInvalidIndex = 0xffffffff;
+        static const uint32_t kMaxLeafSize = 15;
+        static const uint32_t kPacketSize = 4;      ///< Number of rays in a packet query.
+
+        enum class Builder
+        {
+            BinnedSAH,      ///< Object splits using binned SAH.
+            SBVH,           ///< Object and spatial splits (Stich et al. 2009). Triangles may be referenced by multiple leaves.
+        };
+
+        struct BuildOptions
+        {
+            Builder builder = Builder::BinnedSAH;   ///< Builder type.
+            uint32_t width = 4;                 ///< Branching factor of the nodes (4 or 8).
+            uint32_t binCount = 16;             ///< Number of bins per axis for the SAH evaluation.
+            uint32_t maxLeafSize = 4;           ///< Maximum number of triangles per leaf (at most kMaxLeafSize).
+            float traversalCost = 1.f;          ///< SAH cost of traversing a node relative to intersecting a triangle.
+            float splitAlpha = 1e-5f;           ///< SBVH: Spatial splits are only evaluated if the children of the best object split overlap by more than this fraction of the root surface area.
+            float maxDuplication = 0.5f;        ///< SBVH: Maximum number of additional triangle references, relative to the triangle count.
+            bool parallel = true;               ///< Build in parallel.
+        };
+
+        struct Ray
+        {
+            float3 origin;
+            float tMin = 0.f;
+            float3 dir;
+            float tMax = std::numeric_limits<float>::max();
+        };
+
+        struct Hit
+        {
+            uint32_t triangleIndex = kInvalidIndex;     ///< Index of the hit triangle in the input triangle list.
+            float t = std::numeric_limits<float>::max(); ///< Hit distance along the ray.
+            float2 barycentrics = float2(0.f);          ///< Barycentrics of vertices 1 and 2.
+
+            bool isValid() const { return triangleIndex != kInvalidIndex; }
+        };
+
+        /** Build a BVH over a list of triangles.
+            \param[in] vertices Triangle vertices, three per triangle.
+            \param[in] options Build options.
+            \return New object.
+        */
+        static SharedPtr create(const std::vector<float3>& vertices, const BuildOptions& options = BuildOptions());
+
+        /** Find the closest hit along a ray.
+            \param[in] ray Ray, the hit distance is limited to [tMin, tMax].
+            \param[out] hit The closest hit, if any.
+            \return True if a triangle was hit.
+        */
+        bool intersect(const Ray& ray, Hit& hit) const;
+
+        /** Test if any triangle is hit along a ray.
+            \param[in] ray Ray, the hit distance is limited to [tMin, tMax].
+            \return True if a triangle was hit.
+        */
+        bool isOccluded(const Ray& ray) const;
+
+        /** Find the closest hits for a packet of rays.
+            Packet traversal visits the union of the nodes visited by the individual rays, so the rays should be coherent.
+            \param[in] rays Array of rayCount rays.
+            \param[out] hits Array of rayCount hits, receiving the closest hit per ray.
+            \param[in] rayCount Number of rays (at most kPacketSize).
+            \return Bit mask of the rays that hit a triangle.
+        */
+        uint32_t intersectPacket(const Ray* rays, Hit* hits, uint32_t rayCount = kPacketSize) const;
+
+        /** Test a packet of rays for occlusion.
+            \param[in] rays Array of rayCount rays.
+            \param[in] rayCount Number of rays (at most kPacketSize).
+            \return Bit mask of the rays that hit a triangle.
+        */
+        uint32_t isOccludedPacket(const Ray* rays, uint32_t rayCount = kPacketSize) const;
+
+        uint32_t getTriangleCount() const { return mTriangleCount; }
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getNodeCount() const { return mWidth == 8 ? (uint32_t)mNodes8.size() : (uint32_t)mNodes4.size(); }
+        const AABB& getBounds() const { return mBounds; }
+
+        /** Get the number of triangle references in the leaves. This is larger than the triangle count if spatial splits were used.
+        */
+        uint32_t getReferenceCount() const { return (uint32_t)mTriangles.size(); }
+
+        /** Get the build time in ms.
+        */
+        double getBuildTime() const { return mBuildTime; }
+
+        /** Compute the SAH cost of the hierarchy, relative to intersecting a single triangle.
+        */
+        float getSAHCost() const;
+
+    private:
+        CPUBVH(const std::vector<float3>& vertices, const BuildOptions& options);
+
+        /** N-wide node. Child bounds are stored in SoA layout for SIMD traversal.
+            Child references are either a node index, a leaf or kInvalidIndex for empty slots.
+        */
+        template<uint32_t N>
+        struct alignas(16) Node
+        {
+            float bounds[6][N];     ///< Child bounds: min x/y/z, max x/y/z.
+            uint32_t child[N];
+        };
+
+        /** Triangle stored in the layout used by the intersection test.
+        */
+        struct Triangle
+        {
+            float3 v0;
+            float3 e1;
+            float3 e2;
+            uint32_t index;         ///< Index in the input triangle list.
+        };
+
+        /** Binary hierarchy produced by the builder.
+        */
+        struct BuildTree;
+
+        static const uint32_t kLeafFlag = 0x80000000;
+        static const uint32_t kLeafCountBits = 4;
+
+        static bool isLeaf(uint32_t ref) { return ref != kInvalidIndex && (ref & kLeafFlag); }
+        static uint32_t makeLeaf(uint32_t first, uint32_t count) { return kLeafFlag | (first << kLeafCountBits) | count; }
+        static uint32_t getLeafFirst(uint32_t ref) { return (ref & ~kLeafFlag) >> kLeafCountBits; }
+        static uint32_t getLeafCount(uint32_t ref) { return ref & ((1 << kLeafCountBits) - 1); }
+
+        template<uint32_t N> std::vector<Node<N>>& getNodes();
+        template<uint32_t N> const std::vector<Node<N>>& getNodes() const;
+
+        template<uint32_t N>
+        void collapse(const BuildTree& tree, const std::vector<float3>& vertices);
+
+        template<uint32_t N, bool kAnyHit>
+        bool traverse(const Ray& ray, Hit& hit) const;
+
+        template<uint32_t N, bool kAnyHit>
+        uint32_t traversePacket(const Ray* rays, Hit* hits, uint32_t rayCount) const;
+
+        template<uint32_t N>
+        float computeSAHCost() const;
+
+        uint32_t mWidth = 4;
+        std::vector<Node<4>> mNodes4;       ///< Nodes if the width is 4. The root is node 0.
+        std::vector<Node<8>> mNodes8;       ///< Nodes if the width is 8. The root is node 0.
+        std::vector<Triangle> mTriangles;   ///< Triangle references in leaf order.
+        uint32_t mTriangleCount = 0;
+        AABB mBounds;
+        double mBuildTime = 0.0;
+    };
+}
@@ -0,0 +1,583 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "CPUPathTracer.h"
+#include "Utils/Color/ColorHelpers.slang"
+#include "Utils/NumericRange.h"
+#include "Utils/SampleGenerators/SobolSequence.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <execution>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Constants matching the GPU shading code.
+        const float kMinCosTheta = 1e-6f;
+        const float kMinGGXAlpha = 0.0064f;
+        const float kMinLightDistSqr = 1e-9f;
+        const float kMaxLightDistance = std::numeric_limits<float>::max();
+
+        // Sample dimensions. Each path vertex uses a fixed range of dimensions, so that the dimensions
+        // of all paths line up and the stratification of the Sobol sequence is preserved.
+        const uint32_t kPixelDimensions = 2;        ///< Sub-pixel position.
+        const uint32_t kVertexDimensions = 5;       ///< Light selection (1D), light sample (2D), scatter direction (2D).
+        const uint32_t kLightSelectionDimension = 0;
+        const uint32_t kScatterDimension = 3;
+
+        /** Sample generator drawing from an Owen-scrambled Sobol sequence, seeded per pixel.
+        */
+        struct SampleGenerator
+        {
+            uint32_t index;
+            uint32_t seed;
+            uint32_t dimension = 0;
+            uint32_t vertexDimension = 0;   ///< First dimension of the current path vertex.
+
+            void startVertex(uint32_t vertexIndex) { vertexDimension = dimension = kPixelDimensions + vertexIndex * kVertexDimensions; }
+            void setVertexDimension(uint32_t offset) { dimension = vertexDimension + offset; }
+            float next1D() { return SobolSequence::toFloat(SobolSequence::sampleOwen(index, dimension++, seed)); }
+            float2 next2D() { float x = next1D(); return float2(x, next1D()); }
+        };
+
+        // Host versions of the sampling functions in MathHelpers.slang.
+
+        float2 sample_disk(float2 u)
+        {
+            float r = std::sqrt(u.x);
+            float phi = 2.f * (float)M_PI * u.y;
+            return float2(r * std::cos(phi), r * std::sin(phi));
+        }
+
+        float3 sample_cone(float2 u, float cosTheta)
+        {
+            float z = u.x * (1.f - cosTheta) + cosTheta;
+            float r = std::sqrt(1.f - z * z);
+            float phi = 2.f * (float)M_PI * u.y;
+            return float3(r * std::cos(phi), r * std::sin(phi), z);
+        }
+
+        float3 sample_sphere(float2 u)
+        {
+            float phi = 2.f * (float)M_PI * u.y;
+            float cosTheta = 1.f - 2.f * u.x;
+            float sinTheta = std::sqrt(std::max(0.f, 1.f - cosTheta * cosTheta));
+            return float3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+        }
+
+        float2 sample_disk_concentric(float2 u)
+        {
+            u = 2.f * u - 1.f;
+            if (u.x == 0.f && u.y == 0.f) return u;
+            float phi, r;
+            if (std::abs(u.x) > std::abs(u.y))
+            {
+                r = u.x;
+                phi = (u.y / u.x) * (float)M_PI_4;
+            }
+            else
+            {
+                r = u.y;
+                phi = (float)M_PI_2 - (u.x / u.y) * (float)M_PI_4;
+            }
+            return r * float2(std::cos(phi), std::sin(phi));
+        }
+
+        float3 sample_cosine_hemisphere_concentric(float2 u, float& pdf)
+        {
+            float2 d = sample_disk_concentric(u);
+            float z = std::sqrt(std::max(0.f, 1.f - glm::dot(d, d)));
+            pdf = z * (float)M_1_PI;
+            return float3(d, z);
+        }
+
+        float3 perp_stark(const float3& u)
+        {
+            float3 a = glm::abs(u);
+            uint32_t uyx = (a.x - a.y) < 0 ? 1 : 0;
+            uint32_t uzx = (a.x - a.z) < 0 ? 1 : 0;
+            uint32_t uzy = (a.y - a.z) < 0 ? 1 : 0;
+            uint32_t xm = uyx & uzx;
+            uint32_t ym = (1 ^ xm) & uzy;
+            uint32_t zm = 1 ^ (xm | ym);
+            return glm::cross(u, float3(xm, ym, zm));
+        }
+
+        /** Offset a ray origin along the normal to avoid self-intersection. Same as computeRayOrigin() in Helpers.slang.
+        */
+        float3 computeRayOrigin(const float3& pos, const float3& normal)
+        {
+            const float origin = 1.f / 32.f;
+            const float fScale = 1.f / 65536.f;
+            const float iScale = 256.f;
+
+            float3 result;
+            for (int i = 0; i < 3; i++)
+            {
+                int iOff = (int)(normal[i] * iScale);
+                float iPos = asfloat(asint(pos[i]) + (pos[i] < 0.f ? -iOff : iOff));
+                result[i] = std::abs(pos[i]) < origin ? pos[i] + normal[i] * fScale : iPos;
+            }
+            return result;
+        }
+
+        /** Same as getMetallic() in Helpers.slang.
+        */
+        float getMetallic(const float3& diffuse, const float3& spec)
+        {
+            float d = luminance(diffuse);
+            float s = luminance(spec);
+            if (s == 0.f) return 0.f;
+            float b = s + d - 0.08f;
+            float c = 0.04f - s;
+            float root = std::sqrt(b * b - 0.16f * c);
+            return (root - b) * 12.5f;
+        }
+
+        float4 sampleTexture(const CPUTexture::SharedPtr& pTexture, const CPUScene::Material& material, const float2& uv, const float4& factor, uint32_t mode)
+        {
+            if (mode == ChannelTypeUnused) return float4(0.f);
+            if (mode == ChannelTypeConst || !pTexture) return factor;
+            return pTexture->sample(uv, material.addressModeU, material.addressModeV, material.borderColor);
+        }
+
+        /** Shading data at a hit point. This is the subset of ShadingData used by the path tracer.
+        */
+        struct ShadingData
+        {
+            float3 posW;
+            float3 V;
+            float3 N;
+            float3 T;
+            float3 B;
+            float3 faceN;
+            bool frontFacing;
+
+            float3 diffuse;
+            float3 specular;
+            float linearRoughness;
+            float metallic;
+            float specularTransmission;
+            float3 emissive = float3(0.f);
+
+            float3 toLocal(const float3& v) const { return float3(glm::dot(v, T), glm::dot(v, B), glm::dot(v, N)); }
+            float3 fromLocal(const float3& v) const { return T * v.x + B * v.y + N * v.z; }
+            float3 computeNewRayOrigin() const { return computeRayOrigin(posW, frontFacing ? faceN : -faceN); }
+        };
+
+        /** Evaluate the material at a hit point. Same as prepareShadingData() in Shading.slang, without normal mapping and alpha testing.
+        */
+        ShadingData prepareShadingData(const CPUScene& scene, const CPUScene::HitData& hit, const float3& viewDir)
+        {
+            const CPUScene::Material& material = scene.getMaterial(hit.materialID);
+            const MaterialData& md = material.data;
+
+            ShadingData sd;
+            sd.posW = hit.posW;
+            sd.V = viewDir;
+            sd.N = hit.normalW;
+            sd.faceN = hit.faceNormalW;
+            sd.frontFacing = glm::dot(sd.V, sd.faceN) >= 0.f;
+            sd.specularTransmission = md.specularTransmission;
+            sd.T = perp_stark(sd.N);
+            sd.B = glm::cross(sd.N, sd.T);
+
+            float4 baseColor = sampleTexture(material.pBaseColor, material, hit.texC, md.baseColor, EXTRACT_DIFFUSE_TYPE(md.flags));
+            float4 spec = sampleTexture(material.pSpecular, material, hit.texC, md.specular, EXTRACT_SPECULAR_TYPE(md.flags));
+
+            if (EXTRACT_SHADING_MODEL(md.flags) == ShadingModelMetalRough)
+            {
+                // R - Occlusion; G - Roughness; B - Metallic
+                sd.diffuse = glm::mix(float3(baseColor), float3(0.f), spec.b);
+                float f = (md.IoR - 1.f) / (md.IoR + 1.f);
+                sd.specular = glm::mix(float3(f * f), float3(baseColor), spec.b);
+                sd.linearRoughness = spec.g;
+                sd.metallic = spec.b;
+            }
+            else
+            {
+                sd.diffuse = float3(baseColor);
+                sd.specular = float3(spec);
+                sd.linearRoughness = 1.f - spec.a;
+                sd.metallic = getMetallic(sd.diffuse, sd.specular);
+            }
+
+            // Triangles are emissive only on the front-facing side.
+            if (sd.frontFacing)
+            {
+                sd.emissive = float3(sampleTexture(material.pEmissive, material, hit.texC, float4(md.emissive, 1.f), EXTRACT_EMISSIVE_TYPE(md.flags))) * md.emissiveFactor;
+            }
+
+            // Flip the shading frame for back-facing hits on double-sided materials.
+            if (!sd.frontFacing && EXTRACT_DOUBLE_SIDED(md.flags))
+            {
+                sd.N = -sd.N;
+                sd.B = -sd.B;
+            }
+
+            return sd;
+        }
+
+        float evalFresnelSchlick(float f0, float f90, float cosTheta)
+        {
+            return f0 + (f90 - f0) * std::pow(std::max(1.f - cosTheta, 0.f), 5.f);
+        }
+
+        float3 evalFresnelSchlick(const float3& f0, const float3& f90, float cosTheta)
+        {
+            return f0 + (f90 - f0) * std::pow(std::max(1.f - cosTheta, 0.f), 5.f);
+        }
+
+        float evalLambdaGGX(float alphaSqr, float cosTheta)
+        {
+            if (cosTheta <= 0.f) return 0.f;
+            float cosThetaSqr = cosTheta * cosTheta;
+            float tanThetaSqr = std::max(1.f - cosThetaSqr, 0.f) / cosThetaSqr;
+            return 0.5f * (-1.f + std::sqrt(1.f + alphaSqr * tanThetaSqr));
+        }
+
+        /** Evaluate the BSDF multiplied by the cosine term. Same as the diffuse and specular reflection lobes of FalcorBSDF with the default configuration
+            (Frostbite diffuse, GGX with height-correlated Smith masking, delta reflection for small roughness).
+        */
+        float3 evalBSDFCosine(const ShadingData& sd, const float3& L)
+        {
+            const float3 wo = sd.toLocal(sd.V);
+            const float3 wi = sd.toLocal(L);
+            if (std::min(wo.z, wi.z) < kMinCosTheta) return float3(0.f);
+
+            // Lobe selection weights, as in FalcorBSDF::setup().
+            const float dielectricBRDF = (1.f - sd.metallic) * (1.f - sd.specularTransmission);
+            const float specularBRDF = sd.metallic + dielectricBRDF;
+            const bool hasDiffuse = luminance(sd.diffuse) * dielectricBRDF > 0.f;
+            const bool hasSpecular = luminance(evalFresnelSchlick(sd.specular, float3(1.f), glm::dot(sd.V, sd.N))) * specularBRDF > 0.f;
+
+            const float3 h = glm::normalize(wo + wi);
+            const float woDotH = glm::dot(wo, h);
+            float3 result(0.f);
+
+            if (hasDiffuse)
+            {
+                const float wiDotH = glm::dot(wi, h);
+                const float energyBias = glm::mix(0.f, 0.5f, sd.linearRoughness);
+                const float energyFactor = glm::mix(1.f, 1.f / 1.51f, sd.linearRoughness);
+                const float fd90 = energyBias + 2.f * wiDotH * wiDotH * sd.linearRoughness;
+                const float wiScatter = evalFresnelSchlick(1.f, fd90, wi.z);
+                const float woScatter = evalFresnelSchlick(1.f, fd90, wo.z);
+                result += sd.diffuse * (wiScatter * woScatter * energyFactor * (float)M_1_PI * wi.z);
+            }
+
+            const float alpha = sd.linearRoughness * sd.linearRoughness;
+            if (hasSpecular && alpha >= kMinGGXAlpha)
+            {
+                const float alphaSqr = alpha * alpha;
+                const float d = (h.z * alphaSqr - h.z) * h.z + 1.f;
+                const float D = alphaSqr / (d * d * (float)M_PI);
+                const float G = 1.f / (1.f + evalLambdaGGX(alphaSqr, wi.z) + evalLambdaGGX(alphaSqr, wo.z));
+                const float3 F = evalFresnelSchlick(sd.specular, float3(1.f), woDotH);
+                result += F * (D * G * 0.25f / wo.z);
+            }
+
+            return result * (1.f - sd.specularTransmission);
+        }
+
+        /** Light sample. Same as AnalyticLightSample in LightHelpers.slang.
+        */
+        struct AnalyticLightSample
+        {
+            float3 posW;
+            float3 normalW;
+            float3 dir;
+            float distance;
+            float3 Li;
+        };
+
+        bool finalizeAreaLightSample(const float3& shadingPosW, const LightData& light, AnalyticLightSample& ls)
+        {
+            float3 toLight = ls.posW - shadingPosW;
+            float distSqr = std::max(glm::dot(toLight, toLight), kMinLightDistSqr);
+            ls.distance = std::sqrt(distSqr);
+            ls.dir = toLight / ls.distance;
+
+            // The area lights are single-sided.
+            float cosTheta = glm::dot(ls.normalW, -ls.dir);
+            if (cosTheta <= 0.f) return false;
+            ls.Li = light.intensity * (light.surfaceArea * cosTheta / distSqr);
+            return true;
+        }
+
+        /** Sample an analytic light. Same as sampleLight() in LightHelpers.slang.
+        */
+        bool sampleLight(const float3& shadingPosW, const LightData& light, SampleGenerator& sg, AnalyticLightSample& ls)
+        {
+            switch ((LightType)light.type)
+            {
+            case LightType::Point:
+            {
+                ls.posW = light.posW;
+                ls.normalW = light.dirW;
+                float3 toLight = ls.posW - shadingPosW;
+                float distSqr = std::max(glm::dot(toLight, toLight), kMinLightDistSqr);
+                ls.distance = std::sqrt(distSqr);
+                ls.dir = toLight / ls.distance;
+                ls.Li = light.intensity / distSqr;
+                return true;
+            }
+            case LightType::Directional:
+                ls.posW = float3(0.f);
+                ls.normalW = light.dirW;
+                ls.distance = kMaxLightDistance;
+                ls.dir = -light.dirW;
+                ls.Li = light.intensity;
+                return true;
+            case LightType::Rect:
+            {
+                float2 u = sg.next2D();
+                ls.posW = float3(light.transMat * float4(u.x * 2.f - 1.f, u.y * 2.f - 1.f, 0.f, 1.f));
+                ls.normalW = glm::normalize(float3(light.transMatIT * float4(0.f, 0.f, 1.f, 0.f)));
+                return finalizeAreaLightSample(shadingPosW, light, ls);
+            }
+            case LightType::Sphere:
+            {
+                float3 pos = sample_sphere(sg.next2D());
+                ls.posW = float3(light.transMat * float4(pos, 1.f));
+                ls.normalW = glm::normalize(float3(light.transMatIT * float4(pos, 0.f)));
+                return finalizeAreaLightSample(shadingPosW, light, ls);
+            }
+            case LightType::Disc:
+            {
+                float3 pos = float3(sample_disk(sg.next2D()), 0.f);
+                ls.posW = float3(light.transMat * float4(pos, 1.f));
+                ls.normalW = glm::normalize(float3(light.transMatIT * float4(0.f, 0.f, 1.f, 0.f)));
+                return finalizeAreaLightSample(shadingPosW, light, ls);
+            }
+            case LightType::Distant:
+            {
+                float3 dir = sample_cone(sg.next2D(), light.cosSubtendedAngle);
+                ls.posW = float3(0.f);
+                ls.dir = glm::normalize(glm::mat3(light.transMat) * dir);
+                ls.normalW = -ls.dir;
+                ls.distance = kMaxLightDistance;
+                ls.Li = light.intensity;
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        /** Traces the paths of one tile.
+        */
+        class PathTracer
+        {
+        public:
+            PathTracer(const CPUScene& scene, const CPUPathTracer::Options& options) : mScene(scene), mOptions(options) {}
+
+            float3 tracePath(const uint2& pixel, SampleGenerator& sg);
+
+            uint64_t getRayCount() const { return mRayCount; }
+
+        private:
+            bool intersect(const float3& origin, const float3& dir, float tMin, float tMax, CPUBVH::Hit& hit)
+            {
+                CPUBVH::Ray ray;
+                ray.origin = origin;
+                ray.dir = dir;
+                ray.tMin = tMin;
+                ray.tMax = tMax;
+                mRayCount++;
+                return mScene.getBVH()->intersect(ray, hit);
+            }
+
+            bool isVisible(const float3& origin, const float3& dir, float distance)
+            {
+                CPUBVH::Ray ray;
+                ray.origin = origin;
+                ray.dir = dir;
+                ray.tMax = distance;
+                mRayCount++;
+                return !mScene.getBVH()->isOccluded(ray);
+            }
+
+            float3 evalDirectAnalytic(const ShadingData& sd, const float3& rayOrigin, SampleGenerator& sg);
+            bool generateScatterRay(const ShadingData& sd, SampleGenerator& sg, float3& dir, float3& thp);
+
+            const CPUScene& mScene;
+            const CPUPathTracer::Options& mOptions;
+            uint64_t mRayCount = 0;
+        };
+
+        float3 PathTracer::evalDirectAnalytic(const ShadingData& sd, const float3& rayOrigin, SampleGenerator& sg)
+        {
+            const auto& lights = mScene.getLights();
+            const uint32_t lightCount = (uint32_t)lights.size();
+            if (lightCount == 0) return float3(0.f);
+
+            // Pick one of the analytic light sources randomly with equal probability.
+            sg.setVertexDimension(kLightSelectionDimension);
+            const uint32_t lightIndex = std::min((uint32_t)(sg.next1D() * lightCount), lightCount - 1);
+            const float invPdf = (float)lightCount;
+
+            AnalyticLightSample ls;
+            bool valid = sampleLight(rayOrigin, lights[lightIndex], sg, ls);
+
+            // Reject sample if lower hemisphere.
+            if (!valid || glm::dot(ls.dir, sd.N) <= kMinCosTheta) return float3(0.f);
+
+            return isVisible(rayOrigin, ls.dir, ls.distance) ? evalBSDFCosine(sd, ls.dir) * ls.Li * invPdf : float3(0.f);
+        }
+
+        bool PathTracer::generateScatterRay(const ShadingData& sd, SampleGenerator& sg, float3& dir, float3& thp)
+        {
+            // Generate scatter ray as cosine-weighted direction over the hemisphere.
+            float pdf = 0.f;
+            sg.setVertexDimension(kScatterDimension);
+            float3 wi = sample_cosine_hemisphere_concentric(sg.next2D(), pdf);
+            dir = sd.fromLocal(wi);
+            thp *= pdf > 0.f ? evalBSDFCosine(sd, dir) / pdf : float3(0.f);
+            return thp != float3(0.f);
+        }
+
+        float3 PathTracer::tracePath(const uint2& pixel, SampleGenerator& sg)
+        {
+            // Generate the primary ray through a random position in the pixel, assuming a pinhole camera.
+            const CameraData& camera = mScene.getCamera();
+            float2 p = (float2(pixel) + sg.next2D()) / float2(mOptions.frameDim);
+            float2 ndc = float2(2.f, -2.f) * p + float2(-1.f, 1.f);
+            float3 rayDir = glm::normalize(ndc.x * camera.cameraU + ndc.y * camera.cameraV + camera.cameraW);
+            float invCos = 1.f / glm::dot(glm::normalize(camera.cameraW), rayDir);
+
+            CPUBVH::Hit hit;
+            if (!intersect(camera.posW, rayDir, camera.nearZ * invCos, camera.farZ * invCos, hit)) return mOptions.backgroundColor;
+
+            sg.startVertex(0);
+            ShadingData sd = prepareShadingData(mScene, mScene.getHitData(hit), -rayDir);
+            float3 rayOrigin = sd.computeNewRayOrigin();
+            float3 radiance(0.f);
+
+            if (mOptions.computeDirect)
+            {
+                // Always output directly emitted light, independent of whether emissive materials are treated as light sources or not.
+                radiance += sd.emissive;
+                if (mOptions.useAnalyticLights) radiance += evalDirectAnalytic(sd, rayOrigin, sg);
+            }
+
+            float3 thp(1.f);
+            if (!generateScatterRay(sd, sg, rayDir, thp)) return radiance;
+
+            // Follow the path into the scene. The path length is the number of path segments after the primary hit.
+            for (uint32_t pathLength = 0; pathLength <= mOptions.maxBounces; pathLength++)
+            {
+                if (!intersect(rayOrigin, rayDir, 0.f, std::numeric_limits<float>::max(), hit)) break;
+
+                sg.startVertex(pathLength + 1);
+                sd = prepareShadingData(mScene, mScene.getHitData(hit), -rayDir);
+
+                if (mOptions.useEmissiveLights && (mOptions.computeDirect || pathLength > 0))
+                {
+                    radiance += thp * sd.emissive;
+                }
+
+                if (pathLength >= mOptions.maxBounces) break;
+
+                rayOrigin = sd.computeNewRayOrigin();
+                if (mOptions.useAnalyticLights) radiance += thp * evalDirectAnalytic(sd, rayOrigin, sg);
+
+                if (!generateScatterRay(sd, sg, rayDir, thp)) break;
+            }
+
+            return radiance;
+        }
+    }
+
+    CPUPathTracer::SharedPtr CPUPathTracer::create(const CPUScene::SharedPtr& pScene, const Options& options)
+    {
+        if (!pScene) throw std::exception("CPUPathTracer::create() - Scene is missing");
+        if (options.frameDim.x == 0 || options.frameDim.y == 0) throw std::exception("CPUPathTracer::create() - Frame dimensions must be non-zero");
+        if (options.tileSize == 0) throw std::exception("CPUPathTracer::create() - Tile size must be non-zero");
+        return SharedPtr(new CPUPathTracer(pScene, options));
+    }
+
+    CPUPathTracer::CPUPathTracer(const CPUScene::SharedPtr& pScene, const Options& options)
+        : mpScene(pScene)
+        , mOptions(options)
+    {
+        reset();
+    }
+
+    void CPUPathTracer::reset()
+    {
+        mAccumulation.assign((size_t)mOptions.frameDim.x * mOptions.frameDim.y, float3(0.f));
+        mFrameCount = 0;
+        mStats = {};
+    }
+
+    void CPUPathTracer::renderFrame()
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+
+        const uint2 tileCount = (mOptions.frameDim + mOptions.tileSize - 1u) / mOptions.tileSize;
+        std::atomic<uint64_t> rayCount{ 0 };
+
+        NumericRange<uint32_t> tileRange(0, tileCount.x * tileCount.y);
+        std::for_each(std::execution::par, tileRange.begin(), tileRange.end(), [&] (uint32_t tileIndex)
+        {
+            const uint2 tileOrigin = uint2(tileIndex % tileCount.x, tileIndex / tileCount.x) * mOptions.tileSize;
+            const uint2 tileEnd = glm::min(tileOrigin + mOptions.tileSize, mOptions.frameDim);
+
+            PathTracer pathTracer(*mpScene, mOptions);
+            for (uint32_t y = tileOrigin.y; y < tileEnd.y; y++)
+            {
+                for (uint32_t x = tileOrigin.x; x < tileEnd.x; x++)
+                {
+                    const uint32_t pixelIndex = y * mOptions.frameDim.x + x;
+                    SampleGenerator sg = { mFrameCount, SobolSequence::hashCombine(mOptions.seed, pixelIndex) };
+                    mAccumulation[pixelIndex] += pathTracer.tracePath(uint2(x, y), sg);
+                }
+            }
+            rayCount += pathTracer.getRayCount();
+        });
+
+        mFrameCount++;
+        mStats.rayCount += rayCount;
+        mStats.renderTimeMs += CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+    }
+
+    std::vector<float4> CPUPathTracer::getImage() const
+    {
+        std::vector<float4> image(mAccumulation.size());
+        const float invFrameCount = mFrameCount > 0 ? 1.f / mFrameCount : 0.f;
+        for (size_t i = 0; i < image.size(); i++) image[i] = float4(mAccumulation[i] * invFrameCount, 1.f);
+        return image;
+    }
+
+    void CPUPathTracer::saveImage(const std::string& filename) const
+    {
+        std::vector<float4> image = getImage();
+        Bitmap::saveImage(filename, mOptions.frameDim.x, mOptions.frameDim.y, Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA32Float, true, image.data());
+    }
+}
@@ -0,0 +1,111 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "CPUScene.h"
+
+namespace Falcor
+{
+    /** Reference path tracer running on the CPU.
+
+        This mirrors the MinimalPathTracer render pass, so that reference images can be produced on machines without a GPU:
+        Analytic lights are sampled with one shadow ray per path vertex, emissive surfaces are added when hit,
+        and scatter rays are sampled with cosine-weighted hemisphere sampling of Falcor's default BSDF.
+        Environment maps are not supported, rays that miss the scene return a constant background color.
+
+        The image is split into tiles that are rendered in parallel. Each call to renderFrame() adds one sample
+        per pixel to the accumulated image. Samples are drawn from an Owen-scrambled Sobol sequence.
+    */
+    class dlldecl CPUPathTracer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CPUPathTracer>;
+
+        struct Options
+        {
+            uint2 frameDim = uint2(512, 512);       ///< Image dimensions in pixels.
+            uint32_t maxBounces = 3;                ///< Max number of indirect bounces (0 = none).
+            bool computeDirect = true;              ///< Compute direct illumination (otherwise indirect only).
+            bool useAnalyticLights = true;          ///< Sample the analytic lights.
+            bool useEmissiveLights = true;          ///< Add the emitted light of hit emissive surfaces.
+            float3 backgroundColor = float3(0.f);   ///< Radiance of rays that miss the scene.
+            uint32_t tileSize = 16;                 ///< Tile size in pixels.
+            uint32_t seed = 0;                      ///< Seed of the sample sequence.
+        };
+
+        /** Rendering statistics, accumulated over all frames since the last reset.
+        */
+        struct Stats
+        {
+            uint64_t rayCount = 0;          ///< Number of traced rays, including shadow rays.
+            double renderTimeMs = 0.0;      ///< Total render time in milliseconds.
+
+            double getRaysPerSecond() const { return renderTimeMs > 0.0 ? rayCount / (renderTimeMs * 1e-3) : 0.0; }
+        };
+
+        /** Create a path tracer.
+            \param[in] pScene The scene to render.
+            \param[in] options Options.
+            \return New object.
+        */
+        static SharedPtr create(const CPUScene::SharedPtr& pScene, const Options& options = Options());
+
+        /** Render one sample per pixel and add it to the accumulated image.
+        */
+        void renderFrame();
+
+        /** Clear the accumulated image and the statistics.
+        */
+        void reset();
+
+        /** Get the number of accumulated frames.
+        */
+        uint32_t getFrameCount() const { return mFrameCount; }
+
+        /** Get the accumulated image, averaged over all frames.
+            \return RGBA pixels in row-major order with the origin at the top-left.
+        */
+        std::vector<float4> getImage() const;
+
+        /** Save the accumulated image as an OpenEXR file.
+            \param[in] filename Output file.
+        */
+        void saveImage(const std::string& filename) const;
+
+        const Options& getOptions() const { return mOptions; }
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        CPUPathTracer(const CPUScene::SharedPtr& pScene, const Options& options);
+
+        CPUScene::SharedPtr mpScene;
+        Options mOptions;
+        std::vector<float3> mAccumulation;  ///< Sum of the samples per pixel.
+        uint32_t mFrameCount = 0;
+        Stats mStats;
+    };
+}
@@ -0,0 +1,232 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "CPUScene.h"
+#include "Utils/NumericRange.h"
+#include <execution>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Load the CPU copies of the textures of all materials. Textures shared between materials are loaded once.
+        */
+        std::vector<CPUScene::Material> loadMaterials(const Scene& scene)
+        {
+            const uint32_t slotCount = 3;
+            auto getTexture = [&] (uint32_t materialID, uint32_t slot)
+            {
+                const auto& pMaterial = scene.getMaterial(materialID);
+                switch (slot)
+                {
+                case 0: return pMaterial->getBaseColorTexture().get();
+                case 1: return pMaterial->getSpecularTexture().get();
+                default: return pMaterial->getEmissiveTexture().get();
+                }
+            };
+
+            std::vector<const Texture*> textures;
+            for (uint32_t materialID = 0; materialID < scene.getMaterialCount(); materialID++)
+            {
+                for (uint32_t slot = 0; slot < slotCount; slot++)
+                {
+                    const Texture* pTexture = getTexture(materialID, slot);
+                    if (pTexture && std::find(textures.begin(), textures.end(), pTexture) == textures.end()) textures.push_back(pTexture);
+                }
+            }
+
+            std::vector<CPUTexture::SharedPtr> cpuTextures(textures.size());
+            NumericRange<uint32_t> textureRange(0, (uint32_t)textures.size());
+            std::for_each(std::execution::par, textureRange.begin(), textureRange.end(), [&] (uint32_t i)
+            {
+                cpuTextures[i] = CPUTexture::createFromTexture(*textures[i]);
+            });
+
+            std::vector<CPUScene::Material> materials(scene.getMaterialCount());
+            for (uint32_t materialID = 0; materialID < scene.getMaterialCount(); materialID++)
+            {
+                const auto& pMaterial = scene.getMaterial(materialID);
+                auto& material = materials[materialID];
+                material.data = pMaterial->getData();
+
+                for (uint32_t slot = 0; slot < slotCount; slot++)
+                {
+                    const Texture* pTexture = getTexture(materialID, slot);
+                    if (!pTexture) continue;
+                    const auto& pCPUTexture = cpuTextures[std::distance(textures.begin(), std::find(textures.begin(), textures.end(), pTexture))];
+                    if (!pCPUTexture) logWarning("CPUScene: Texture '" + pTexture->getSourceFilename() + "' of material '" + pMaterial->getName() + "' is not available on the CPU. Using the constant material value instead.");
+                    (slot == 0 ? material.pBaseColor : slot == 1 ? material.pSpecular : material.pEmissive) = pCPUTexture;
+                }
+
+                if (const auto& pSampler = pMaterial->getResources().samplerState)
+                {
+                    material.addressModeU = pSampler->getAddressModeU();
+                    material.addressModeV = pSampler->getAddressModeV();
+                    material.borderColor = pSampler->getBorderColor();
+                }
+            }
+            return materials;
+        }
+    }
+
+    CPUScene::SharedPtr CPUScene::create(const Scene::SharedPtr& pScene, const CPUBVH::BuildOptions& options)
+    {
+        assert(pScene);
+        const Scene& scene = *pScene;
+
+        const auto& vertexData = scene.getMeshStaticData();
+        if (vertexData.empty()) throw std::exception("CPUScene::create() - The scene has no CPU geometry. Build the scene with SceneBuilder::Flags::KeepCPUGeometry.");
+
+        const auto& globalMatrices = scene.getAnimationController()->getGlobalMatrices();
+
+        // Compute the triangle offset of each mesh instance.
+        std::vector<uint32_t> triangleOffsets(scene.getMeshInstanceCount() + 1, 0);
+        uint32_t skippedInstances = 0;
+        for (uint32_t instanceID = 0; instanceID < scene.getMeshInstanceCount(); instanceID++)
+        {
+            const MeshInstanceData& instance = scene.getMeshInstance(instanceID);
+            uint32_t triangleCount = scene.getMesh(instance.meshID).getTriangleCount();
+
+            // Skinned meshes are only available in their animated state on the GPU.
+            if (instance.hasDynamicData())
+            {
+                triangleCount = 0;
+                skippedInstances++;
+            }
+            triangleOffsets[instanceID + 1] = triangleOffsets[instanceID] + triangleCount;
+        }
+        if (skippedInstances > 0) logWarning("CPUScene: Ignoring " + std::to_string(skippedInstances) + " skinned mesh instances.");
+
+        const uint32_t triangleCount = triangleOffsets.back();
+        Desc desc;
+        desc.positions.resize((size_t)triangleCount * 3);
+        desc.normals.resize((size_t)triangleCount * 3);
+        desc.texCrds.resize((size_t)triangleCount * 3);
+        desc.materialIDs.resize(triangleCount);
+
+        // Transform the triangles of all mesh instances to world space in parallel.
+        NumericRange<uint32_t> instanceRange(0, scene.getMeshInstanceCount());
+        std::for_each(std::execution::par, instanceRange.begin(), instanceRange.end(), [&] (uint32_t instanceID)
+        {
+            const MeshInstanceData& instance = scene.getMeshInstance(instanceID);
+            const glm::mat4& worldMat = globalMatrices[instance.globalMatrixID];
+            const glm::mat3 normalMat = glm::transpose(glm::inverse(glm::mat3(worldMat)));
+            const bool isFrontFaceCW = (instance.flags & (uint32_t)MeshInstanceFlags::IsWorldFrontFaceCW) != 0;
+
+            for (uint32_t triangleIndex = 0; triangleIndex < triangleOffsets[instanceID + 1] - triangleOffsets[instanceID]; triangleIndex++)
+            {
+                uint3 vtxIndices = scene.getMeshTriangleIndices(instanceID, triangleIndex);
+
+                // Flip the winding so that triangles are counter-clockwise as seen from the front-facing side.
+                if (isFrontFaceCW) std::swap(vtxIndices.y, vtxIndices.z);
+
+                const uint32_t triIdx = triangleOffsets[instanceID] + triangleIndex;
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    const StaticVertexData v = vertexData[vtxIndices[j]].unpack();
+                    desc.positions[(size_t)triIdx * 3 + j] = (worldMat * float4(v.position, 1.f)).xyz;
+                    desc.normals[(size_t)triIdx * 3 + j] = glm::normalize(normalMat * v.normal);
+                    desc.texCrds[(size_t)triIdx * 3 + j] = v.texCrd;
+                }
+                desc.materialIDs[triIdx] = instance.materialID;
+            }
+        });
+
+        desc.materials = loadMaterials(scene);
+
+        for (uint32_t lightID = 0; lightID < scene.getLightCount(); lightID++)
+        {
+            const auto& pLight = scene.getLight(lightID);
+            if (pLight->isActive()) desc.lights.push_back(pLight->getData());
+        }
+
+        desc.camera = pScene->getCamera()->getData();
+
+        return create(std::move(desc), options);
+    }
+
+    CPUScene::SharedPtr CPUScene::create(Desc desc, const CPUBVH::BuildOptions& options)
+    {
+        const size_t triangleCount = desc.materialIDs.size();
+        if (desc.positions.size() != triangleCount * 3) throw std::exception("CPUScene::create() - Expected three positions per triangle");
+        if (!desc.normals.empty() && desc.normals.size() != triangleCount * 3) throw std::exception("CPUScene::create() - Expected three normals per triangle");
+        if (!desc.texCrds.empty() && desc.texCrds.size() != triangleCount * 3) throw std::exception("CPUScene::create() - Expected three texture coordinates per triangle");
+        for (uint32_t materialID : desc.materialIDs)
+        {
+            if (materialID >= desc.materials.size()) throw std::exception("CPUScene::create() - Material ID out of range");
+        }
+
+        return SharedPtr(new CPUScene(std::move(desc), options));
+    }
+
+    CPUScene::CPUScene(Desc desc, const CPUBVH::BuildOptions& options)
+        : mDesc(std::move(desc))
+    {
+        mpBVH = CPUBVH::create(mDesc.positions, options);
+    }
+
+    CPUScene::HitData CPUScene::getHitData(const CPUBVH::Hit& hit) const
+    {
+        assert(hit.isValid());
+        const size_t i = (size_t)hit.triangleIndex * 3;
+        const float3 barycentrics(1.f - hit.barycentrics.x - hit.barycentrics.y, hit.barycentrics.x, hit.barycentrics.y);
+
+        HitData data;
+        const float3* p = &mDesc.positions[i];
+        data.posW = barycentrics.x * p[0] + barycentrics.y * p[1] + barycentrics.z * p[2];
+
+        float3 N = glm::cross(p[1] - p[0], p[2] - p[0]);
+        float lenSqr = glm::dot(N, N);
+        data.faceNormalW = lenSqr > 0.f ? N / std::sqrt(lenSqr) : float3(0.f, 0.f, 1.f);
+
+        if (!mDesc.normals.empty())
+        {
+            const float3* n = &mDesc.normals[i];
+            N = barycentrics.x * n[0] + barycentrics.y * n[1] + barycentrics.z * n[2];
+            lenSqr = glm::dot(N, N);
+            data.normalW = lenSqr > 0.f ? N / std::sqrt(lenSqr) : data.faceNormalW;
+        }
+        else
+        {
+            data.normalW = data.faceNormalW;
+        }
+
+        if (!mDesc.texCrds.empty())
+        {
+            const float2* t = &mDesc.texCrds[i];
+            data.texC = barycentrics.x * t[0] + barycentrics.y * t[1] + barycentrics.z * t[2];
+        }
+        else
+        {
+            data.texC = float2(0.f);
+        }
+
+        data.materialID = mDesc.materialIDs[hit.triangleIndex];
+        return data;
+    }
+}
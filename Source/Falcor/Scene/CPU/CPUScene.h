@@ -0,0 +1,120 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "CPUBVH.h"
+#include "CPUTexture.h"
+#include "Scene/Scene.h"
+
+namespace Falcor
+{
+    /** Scene representation for rendering on the CPU.
+
+        The geometry is flattened into a list of world-space triangles with a BVH for ray queries.
+        Triangles are stored with counter-clockwise winding as seen from the front-facing side.
+        Materials keep their MaterialData together with CPU copies of the base color, specular and emissive textures.
+
+        A CPUScene can be created from a Scene that was built with SceneBuilder::Flags::KeepCPUGeometry,
+        or directly from a description, which does not require a GPU device.
+    */
+    class dlldecl CPUScene
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CPUScene>;
+
+        /** Material with CPU textures.
+            A texture that is not available on the CPU is replaced by the constant value in the material data.
+        */
+        struct Material
+        {
+            MaterialData data;
+            CPUTexture::SharedPtr pBaseColor;
+            CPUTexture::SharedPtr pSpecular;
+            CPUTexture::SharedPtr pEmissive;
+            Sampler::AddressMode addressModeU = Sampler::AddressMode::Wrap;
+            Sampler::AddressMode addressModeV = Sampler::AddressMode::Wrap;
+            float4 borderColor = float4(0.f);
+        };
+
+        /** Scene description.
+        */
+        struct Desc
+        {
+            std::vector<float3> positions;      ///< World-space vertex positions, three per triangle.
+            std::vector<float3> normals;        ///< World-space shading normals, three per triangle. Optional, the face normals are used if empty.
+            std::vector<float2> texCrds;        ///< Texture coordinates, three per triangle. Optional.
+            std::vector<uint32_t> materialIDs;  ///< Material ID per triangle.
+            std::vector<Material> materials;
+            std::vector<LightData> lights;      ///< Analytic lights.
+            CameraData camera;
+        };
+
+        /** Interpolated surface attributes at a hit point.
+        */
+        struct HitData
+        {
+            float3 posW;
+            float3 normalW;         ///< Interpolated shading normal (normalized).
+            float3 faceNormalW;     ///< Face normal of the front-facing side (normalized).
+            float2 texC;
+            uint32_t materialID;
+        };
+
+        /** Create a CPU scene from a scene.
+            The scene needs to be built with SceneBuilder::Flags::KeepCPUGeometry. Skinned meshes, curves and procedural geometry are ignored.
+            \param[in] pScene The scene.
+            \param[in] options BVH build options.
+            \return New object.
+        */
+        static SharedPtr create(const Scene::SharedPtr& pScene, const CPUBVH::BuildOptions& options = CPUBVH::BuildOptions());
+
+        /** Create a CPU scene from a description.
+            \param[in] desc Scene description.
+            \param[in] options BVH build options.
+            \return New object.
+        */
+        static SharedPtr create(Desc desc, const CPUBVH::BuildOptions& options = CPUBVH::BuildOptions());
+
+        /** Get the attributes of a hit point.
+            \param[in] hit A valid hit returned by the BVH.
+        */
+        HitData getHitData(const CPUBVH::Hit& hit) const;
+
+        uint32_t getTriangleCount() const { return (uint32_t)mDesc.materialIDs.size(); }
+        const CPUBVH::SharedPtr& getBVH() const { return mpBVH; }
+        const Material& getMaterial(uint32_t materialID) const { return mDesc.materials[materialID]; }
+        uint32_t getMaterialCount() const { return (uint32_t)mDesc.materials.size(); }
+        const std::vector<LightData>& getLights() const { return mDesc.lights; }
+        const CameraData& getCamera() const { return mDesc.camera; }
+
+    private:
+        CPUScene(Desc desc, const CPUBVH::BuildOptions& options);
+
+        Desc mDesc;
+        CPUBVH::SharedPtr mpBVH;
+    };
+}
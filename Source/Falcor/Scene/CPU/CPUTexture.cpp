@@ -0,0 +1,153 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "CPUTexture.h"
+#include "Utils/Color/ColorHelpers.slang"
+#include "Utils/StringUtils.h"
+
+namespace Falcor
+{
+    CPUTexture::SharedPtr CPUTexture::createFromTexture(const Texture& texture)
+    {
+        const std::string& filename = texture.getSourceFilename();
+        if (filename.empty() || hasSuffix(filename, ".dds", false)) return nullptr;
+
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, true);
+        if (!pBitmap || pBitmap->getWidth() != texture.getWidth() || pBitmap->getHeight() != texture.getHeight()) return nullptr;
+
+        const uint32_t width = pBitmap->getWidth();
+        const uint32_t height = pBitmap->getHeight();
+        std::vector<float4> texels((size_t)width * height);
+
+        const ResourceFormat format = pBitmap->getFormat();
+        const bool isSrgb = isSrgbFormat(texture.getFormat());
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* pRow = pBitmap->getData() + (size_t)y * pBitmap->getRowPitch();
+            const uint16_t* pRow16 = reinterpret_cast<const uint16_t*>(pRow);
+            const float* pRow32 = reinterpret_cast<const float*>(pRow);
+            float4* pDst = texels.data() + (size_t)y * width;
+
+            for (uint32_t x = 0; x < width; x++)
+            {
+                float4 c;
+                switch (format)
+                {
+                case ResourceFormat::BGRA8Unorm:
+                    c = float4(pRow[4 * x + 2], pRow[4 * x + 1], pRow[4 * x + 0], pRow[4 * x + 3]) / 255.f;
+                    break;
+                case ResourceFormat::BGRX8Unorm:
+                    c = float4(float3(pRow[4 * x + 2], pRow[4 * x + 1], pRow[4 * x + 0]) / 255.f, 1.f);
+                    break;
+                case ResourceFormat::RG8Unorm:
+                    c = float4(pRow[2 * x + 0] / 255.f, pRow[2 * x + 1] / 255.f, 0.f, 1.f);
+                    break;
+                case ResourceFormat::R8Unorm:
+                    c = float4(pRow[x] / 255.f, 0.f, 0.f, 1.f);
+                    break;
+                case ResourceFormat::RGBA16Float:
+                    c = f16tof32(uint4(pRow16[4 * x + 0], pRow16[4 * x + 1], pRow16[4 * x + 2], pRow16[4 * x + 3]));
+                    break;
+                case ResourceFormat::RGB16Float:
+                    c = float4(f16tof32(uint3(pRow16[3 * x + 0], pRow16[3 * x + 1], pRow16[3 * x + 2])), 1.f);
+                    break;
+                case ResourceFormat::RGBA32Float:
+                    c = float4(pRow32[4 * x + 0], pRow32[4 * x + 1], pRow32[4 * x + 2], pRow32[4 * x + 3]);
+                    break;
+                case ResourceFormat::RGB32Float:
+                    c = float4(pRow32[3 * x + 0], pRow32[3 * x + 1], pRow32[3 * x + 2], 1.f);
+                    break;
+                default:
+                    return nullptr;
+                }
+                pDst[x] = isSrgb ? float4(sRGBToLinear(float3(c)), c.a) : c;
+            }
+        }
+
+        return SharedPtr(new CPUTexture(width, height, std::move(texels)));
+    }
+
+    CPUTexture::SharedPtr CPUTexture::create(uint32_t width, uint32_t height, std::vector<float4> texels)
+    {
+        if (width == 0 || height == 0 || texels.size() != (size_t)width * height) throw std::exception("CPUTexture::create() - Texel count does not match the texture dimensions");
+        return SharedPtr(new CPUTexture(width, height, std::move(texels)));
+    }
+
+    CPUTexture::CPUTexture(uint32_t width, uint32_t height, std::vector<float4> texels)
+        : mWidth(width)
+        , mHeight(height)
+        , mTexels(std::move(texels))
+    {
+    }
+
+    float4 CPUTexture::sample(const float2& uv, Sampler::AddressMode modeU, Sampler::AddressMode modeV, const float4& borderColor) const
+    {
+        // Texel centers are at half-integer coordinates.
+        const float2 p = uv * float2(mWidth, mHeight) - 0.5f;
+        const float2 p0 = glm::floor(p);
+        const float2 w = p - p0;
+        const int x0 = (int)p0.x;
+        const int y0 = (int)p0.y;
+
+        auto fetch = [&] (int x, int y)
+        {
+            int tx = applyAddressMode(x, (int)mWidth, modeU);
+            int ty = applyAddressMode(y, (int)mHeight, modeV);
+            return (tx < 0 || ty < 0) ? borderColor : getTexel((uint32_t)tx, (uint32_t)ty);
+        };
+
+        float4 c0 = glm::mix(fetch(x0, y0), fetch(x0 + 1, y0), w.x);
+        float4 c1 = glm::mix(fetch(x0, y0 + 1), fetch(x0 + 1, y0 + 1), w.x);
+        return glm::mix(c0, c1, w.y);
+    }
+
+    int CPUTexture::applyAddressMode(int i, int size, Sampler::AddressMode mode)
+    {
+        switch (mode)
+        {
+        case Sampler::AddressMode::Wrap:
+            i %= size;
+            return i < 0 ? i + size : i;
+        case Sampler::AddressMode::Mirror:
+        {
+            int period = 2 * size;
+            i %= period;
+            if (i < 0) i += period;
+            return i < size ? i : period - 1 - i;
+        }
+        case Sampler::AddressMode::MirrorOnce:
+            return std::min(i < 0 ? -1 - i : i, size - 1);
+        case Sampler::AddressMode::Border:
+            return i >= 0 && i < size ? i : -1;
+        case Sampler::AddressMode::Clamp:
+        default:
+            return glm::clamp(i, 0, size - 1);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    /** Texture decoded into linear RGBA floats for access on the CPU.
+        Only the top mip level is stored. The texels are loaded from the texture's source file,
+        since reading back GPU textures is not possible on machines without a GPU device.
+    */
+    class dlldecl CPUTexture
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CPUTexture>;
+
+        /** Create a CPU copy of a texture by decoding its source file.
+            \param[in] texture The texture.
+            \return New object, or nullptr if the texture is not available on the CPU. DDS files and textures not created from a file are not supported.
+        */
+        static SharedPtr createFromTexture(const Texture& texture);
+
+        /** Create a CPU texture from linear RGBA texels.
+            \param[in] width Width in texels.
+            \param[in] height Height in texels.
+            \param[in] texels Texels in row-major order.
+            \return New object.
+        */
+        static SharedPtr create(uint32_t width, uint32_t height, std::vector<float4> texels);
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+
+        /** Get a texel.
+        */
+        const float4& getTexel(uint32_t x, uint32_t y) const { return mTexels[(size_t)y * mWidth + x]; }
+
+        /** Sample the texture with bilinear filtering.
+            \param[in] uv Texture coordinate.
+            \param[in] modeU Address mode in U.
+            \param[in] modeV Address mode in V.
+            \param[in] borderColor Color returned for texels outside the texture when using the border address mode.
+        */
+        float4 sample(const float2& uv, Sampler::AddressMode modeU = Sampler::AddressMode::Wrap, Sampler::AddressMode modeV = Sampler::AddressMode::Wrap, const float4& borderColor = float4(0.f)) const;
+
+        /** Apply a sampler address mode to an integer texel coordinate.
+            \return The texel coordinate in [0, size), or -1 if it maps to the border color.
+        */
+        static int applyAddressMode(int i, int size, Sampler::AddressMode mode);
+
+    private:
+        CPUTexture(uint32_t width, uint32_t height, std::vector<float4> texels);
+
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        std::vector<float4> mTexels;    ///< Linear RGBA texels.
+    };
+}
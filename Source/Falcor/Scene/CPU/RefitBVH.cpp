@@ -0,0 +1,259 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "RefitBVH.h"
+#include <numeric>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kBinCount = 16;
+        const float kTraversalCost = 1.f;   ///< SAH cost of traversing a node relative to intersecting a primitive.
+
+        float area(const AABB& b)
+        {
+            return b.valid() ? b.area() : 0.f;
+        }
+
+        float3 centroid(const AABB& b)
+        {
+            return b.valid() ? b.center() : float3(0.f);
+        }
+
+        struct Bin
+        {
+            AABB bounds;
+            uint32_t count = 0;
+        };
+
+        /** Partition the primitive range using binned SAH over the centroids.
+            Falls back to a median split along the largest axis if no SAH split separates the primitives.
+            \return Index of the first primitive in the right partition.
+        */
+        uint32_t partition(std::vector<uint32_t>& prims, uint32_t begin, uint32_t end, const std::vector<AABB>& bounds)
+        {
+            AABB centroidBounds;
+            for (uint32_t i = begin; i < end; i++) centroidBounds.include(centroid(bounds[prims[i]]));
+            const float3 extent = centroidBounds.extent();
+
+            float bestCost = std::numeric_limits<float>::infinity();
+            uint32_t bestAxis = 0;
+            uint32_t bestBin = 0;
+
+            auto binIndex = [&](const AABB& b, uint32_t axis)
+            {
+                float t = (centroid(b)[axis] - centroidBounds.minPoint[axis]) / extent[axis];
+                return std::min(kBinCount - 1, (uint32_t)(t * kBinCount));
+            };
+
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                if (!(extent[axis] > 0.f)) continue;
+
+                Bin bins[kBinCount];
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    const AABB& b = bounds[prims[i]];
+                    Bin& bin = bins[binIndex(b, axis)];
+                    bin.bounds.include(b);
+                    bin.count++;
+                }
+
+                // Sweep from the right to accumulate the right-hand areas, then evaluate the splits from the left.
+                float rightArea[kBinCount];
+                uint32_t rightCount[kBinCount];
+                AABB acc;
+                uint32_t count = 0;
+                for (uint32_t i = kBinCount - 1; i > 0; i--)
+                {
+                    acc.include(bins[i].bounds);
+                    count += bins[i].count;
+                    rightArea[i] = area(acc);
+                    rightCount[i] = count;
+                }
+
+                acc = AABB();
+                count = 0;
+                for (uint32_t i = 0; i < kBinCount - 1; i++)
+                {
+                    acc.include(bins[i].bounds);
+                    count += bins[i].count;
+                    if (count == 0 || rightCount[i + 1] == 0) continue;
+
+                    float cost = area(acc) * count + rightArea[i + 1] * rightCount[i + 1];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestBin = i;
+                    }
+                }
+            }
+
+            if (bestCost < std::numeric_limits<float>::infinity())
+            {
+                auto it = std::partition(prims.begin() + begin, prims.begin() + end, [&](uint32_t p) { return binIndex(bounds[p], bestAxis) <= bestBin; });
+                uint32_t mid = (uint32_t)(it - prims.begin());
+                if (mid > begin && mid < end) return mid;
+            }
+
+            // Median split along the largest centroid axis.
+            uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+            uint32_t mid = (begin + end) / 2;
+            std::nth_element(prims.begin() + begin, prims.begin() + mid, prims.begin() + end, [&](uint32_t a, uint32_t b) { return centroid(bounds[a])[axis] < centroid(bounds[b])[axis]; });
+            return mid;
+        }
+    }
+
+    void RefitBVH::build(const std::vector<AABB>& primitiveBounds)
+    {
+        mPrimitiveBounds = primitiveBounds;
+        rebuild();
+    }
+
+    void RefitBVH::rebuild()
+    {
+        const uint32_t primitiveCount = getPrimitiveCount();
+
+        mNodes.clear();
+        mLeafNodes.assign(primitiveCount, kInvalidIndex);
+        mModifiedPrimitives.clear();
+        mBuildSAHCost = 0.f;
+        if (primitiveCount == 0) return;
+
+        mNodes.reserve(2 * primitiveCount - 1);
+        mNodes.emplace_back();
+
+        std::vector<uint32_t> prims(primitiveCount);
+        std::iota(prims.begin(), prims.end(), 0);
+
+        struct Task
+        {
+            uint32_t nodeIndex;
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        std::vector<Task> stack = { { 0, 0, primitiveCount } };
+        while (!stack.empty())
+        {
+            Task task = stack.back();
+            stack.pop_back();
+
+            if (task.end - task.begin == 1)
+            {
+                uint32_t primitive = prims[task.begin];
+                mNodes[task.nodeIndex].primitive = primitive;
+                mLeafNodes[primitive] = task.nodeIndex;
+                continue;
+            }
+
+            uint32_t mid = partition(prims, task.begin, task.end, mPrimitiveBounds);
+            uint32_t leftChild = (uint32_t)mNodes.size();
+            mNodes.resize(mNodes.size() + 2);
+            mNodes[task.nodeIndex].leftChild = leftChild;
+            mNodes[leftChild].parent = task.nodeIndex;
+            mNodes[leftChild + 1].parent = task.nodeIndex;
+
+            stack.push_back({ leftChild + 1, mid, task.end });
+            stack.push_back({ leftChild, task.begin, mid });
+        }
+        assert(mNodes.size() == 2 * primitiveCount - 1);
+
+        // Children are stored after their parents, so a reverse sweep computes the bounds bottom-up.
+        for (uint32_t i = (uint32_t)mNodes.size(); i-- > 0;) updateNode(i);
+
+        mNodeDirty.assign(mNodes.size(), false);
+        mBuildSAHCost = getSAHCost();
+    }
+
+    void RefitBVH::setPrimitiveBounds(uint32_t primitiveIndex, const AABB& bounds)
+    {
+        assert(primitiveIndex < getPrimitiveCount());
+        if (mPrimitiveBounds[primitiveIndex] == bounds) return;
+        mPrimitiveBounds[primitiveIndex] = bounds;
+        mModifiedPrimitives.push_back(primitiveIndex);
+    }
+
+    bool RefitBVH::refit()
+    {
+        if (mModifiedPrimitives.empty()) return false;
+
+        // Collect the union of the paths from the modified leaves to the root.
+        std::vector<uint32_t> dirtyNodes;
+        for (uint32_t primitive : mModifiedPrimitives)
+        {
+            for (uint32_t nodeIndex = mLeafNodes[primitive]; nodeIndex != kInvalidIndex && !mNodeDirty[nodeIndex]; nodeIndex = mNodes[nodeIndex].parent)
+            {
+                mNodeDirty[nodeIndex] = true;
+                dirtyNodes.push_back(nodeIndex);
+            }
+        }
+        mModifiedPrimitives.clear();
+
+        // Update children before their parents.
+        std::sort(dirtyNodes.begin(), dirtyNodes.end(), std::greater<uint32_t>());
+        for (uint32_t nodeIndex : dirtyNodes)
+        {
+            updateNode(nodeIndex);
+            mNodeDirty[nodeIndex] = false;
+        }
+
+        return true;
+    }
+
+    float RefitBVH::getSAHCost() const
+    {
+        if (mNodes.empty()) return 0.f;
+        float rootArea = area(mNodes[0].bounds);
+        return rootArea > 0.f ? mNodes[0].cost / rootArea : 0.f;
+    }
+
+    float RefitBVH::getSAHRatio() const
+    {
+        return mBuildSAHCost > 0.f ? getSAHCost() / mBuildSAHCost : 1.f;
+    }
+
+    void RefitBVH::updateNode(uint32_t nodeIndex)
+    {
+        Node& node = mNodes[nodeIndex];
+        if (node.isLeaf())
+        {
+            node.bounds = mPrimitiveBounds[node.primitive];
+            node.cost = area(node.bounds);
+        }
+        else
+        {
+            const Node& left = mNodes[node.leftChild];
+            const Node& right = mNodes[node.leftChild + 1];
+            node.bounds = left.bounds | right.bounds;
+            node.cost = kTraversalCost * area(node.bounds) + left.cost + right.cost;
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Utils/Math/AABB.h"
+
+namespace Falcor
+{
+    /** Binary bounding volume hierarchy over a set of AABBs that supports incremental refitting.
+
+        The hierarchy is built top-down using binned SAH with one primitive per leaf. When the
+        primitive bounds change, only the nodes on the paths from the modified leaves to the root
+        are refitted. The SAH cost of the hierarchy is maintained during refitting, which makes it
+        cheap to compare the quality of the refitted hierarchy against the one it was built with.
+    */
+    class dlldecl RefitBVH
+    {
+    public:
+        static const uint32_t kInvalidIndex = 0xffffffff;
+
+        struct Node
+        {
+            AABB bounds;                            ///< Bounds of the subtree.
+            float cost = 0.f;                       ///< SAH cost of the subtree scaled by the node surface area.
+            uint32_t parent = kInvalidIndex;        ///< Parent node index or kInvalidIndex for the root.
+            uint32_t leftChild = kInvalidIndex;     ///< Left child index. The right child follows directly after it. kInvalidIndex for leaves.
+            uint32_t primitive = kInvalidIndex;     ///< Primitive index for leaves, kInvalidIndex for interior nodes.
+
+            bool isLeaf() const { return primitive != kInvalidIndex; }
+        };
+
+        RefitBVH() = default;
+
+        /** Build the hierarchy from scratch.
+            \param[in] primitiveBounds Bounds of all primitives.
+        */
+        void build(const std::vector<AABB>& primitiveBounds);
+
+        /** Rebuild the whole hierarchy from the current primitive bounds.
+            This mirrors a rebuild of the BLAS the hierarchy stands in for, which can't be rebuilt partially.
+        */
+        void rebuild();
+
+        /** Update the bounds of a primitive. The hierarchy is updated on the next call to refit().
+        */
+        void setPrimitiveBounds(uint32_t primitiveIndex, const AABB& bounds);
+
+        /** Refit the nodes above all primitives modified since the last refit.
+            \return Returns true if any node was refitted.
+        */
+        bool refit();
+
+        /** Get the SAH cost of the hierarchy, normalized by the surface area of the root.
+        */
+        float getSAHCost() const;
+
+        /** Get the normalized SAH cost the hierarchy had when it was last built.
+        */
+        float getBuildSAHCost() const { return mBuildSAHCost; }
+
+        /** Get the ratio of the current SAH cost to the cost at build time.
+            This is 1 for a freshly built hierarchy and grows as refitting degrades it.
+        */
+        float getSAHRatio() const;
+
+        uint32_t getPrimitiveCount() const { return (uint32_t)mPrimitiveBounds.size(); }
+        const AABB& getPrimitiveBounds(uint32_t primitiveIndex) const { return mPrimitiveBounds[primitiveIndex]; }
+        const std::vector<Node>& getNodes() const { return mNodes; }
+
+        /** Get the bounds of the whole hierarchy.
+        */
+        AABB getBounds() const { return mNodes.empty() ? AABB() : mNodes[0].bounds; }
+
+    private:
+        void updateNode(uint32_t nodeIndex);
+
+        std::vector<Node> mNodes;                   ///< Nodes in depth-first order. Children always have larger indices than their parent.
+        std::vector<AABB> mPrimitiveBounds;         ///< Current bounds of all primitives.
+        std::vector<uint32_t> mLeafNodes;           ///< Leaf node index for each primitive.
+        std::vector<uint32_t> mModifiedPrimitives;  ///< Primitives modified since the last refit.
+        std::vector<bool> mNodeDirty;               ///< Scratch flags used during refitting.
+        float mBuildSAHCost = 0.f;
+    };
+}
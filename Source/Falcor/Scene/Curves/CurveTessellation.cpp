@@ -28,13 +28,19 @@
 #include "stdafx.h"
 #include "CurveTessellation.h"
 #include "Utils/Math/MathHelpers.h"
+#include "Utils/NumericRange.h"
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <execution>
+#include <numeric>
 
 namespace Falcor
 {
     namespace
     {
+        const uint32_t kAdaptiveSampleCount = 8;    ///< Number of samples per cubic segment used to estimate curvature and length.
+        const float kMinPixelSize = 1e-8f;          ///< Lower bound on the world-space pixel size (to avoid division by zero at the camera position).
+
         float4 transformSphere(const glm::mat4& xform, const float4& sphere)
         {
             // Spheres are represented as (center.x, center.y, center.z, radius).
@@ -45,9 +51,149 @@ namespace Falcor
             float xr = glm::length(xq - xp);
             return float4(xp.xyz, xr);
         }
+
+        template<typename F>
+        void forEachStrand(size_t strandCount, F func)
+        {
+            NumericRange<uint32_t> range(0, (uint32_t)strandCount);
+            std::for_each(std::execution::par, range.begin(), range.end(), func);
+        }
+
+        /** Compute the number of sub-segments for a single cubic segment using the adaptive targets.
+        */
+        uint32_t computeAdaptiveSubdiv(const CubicSpline<float3>& spline, uint32_t segment, const CurveTessellation::SubdivisionDesc& desc, const glm::mat4& xform)
+        {
+            const uint32_t minSubdiv = std::max(desc.minSubdivPerSegment, 1u);
+            const uint32_t maxSubdiv = std::max(desc.subdivPerSegment, minSubdiv);
+            const bool useCurvature = desc.maxAngle > 0.f;
+            const bool useScreenSize = desc.screenLength > 0.f && desc.pixelAngle > 0.f;
+            if (!useCurvature && !useScreenSize) return maxSubdiv;
+
+            // Estimate the total turning angle, arc length and closest distance to the camera from a few samples.
+            const glm::mat3 dirXform(xform);
+            float angle = 0.f;
+            float length = 0.f;
+            float minDistance = std::numeric_limits<float>::max();
+            float3 prevPos, prevDir;
+            for (uint32_t s = 0; s < kAdaptiveSampleCount; s++)
+            {
+                float t = (float)s / (float)(kAdaptiveSampleCount - 1);
+                float3 pos = (xform * float4(spline.interpolate(segment, t), 1.f)).xyz;
+                float3 dir = dirXform * spline.derivative(segment, t);
+                if (s > 0)
+                {
+                    length += glm::length(pos - prevPos);
+                    float denom = glm::length(dir) * glm::length(prevDir);
+                    if (denom > 0.f) angle += std::acos(glm::clamp(glm::dot(dir, prevDir) / denom, -1.f, 1.f));
+                }
+                minDistance = std::min(minDistance, glm::length(pos - desc.cameraPosition));
+                prevPos = pos;
+                prevDir = dir;
+            }
+
+            auto toCount = [maxSubdiv] (float x) { return (uint32_t)std::min(std::ceil(x), (float)maxSubdiv); };
+
+            uint32_t subdiv = maxSubdiv;
+            if (useCurvature) subdiv = toCount(angle / desc.maxAngle);
+            if (useScreenSize)
+            {
+                float pixelSize = std::max(minDistance * desc.pixelAngle, kMinPixelSize);
+                uint32_t screenSubdiv = toCount(length / (pixelSize * desc.screenLength));
+                subdiv = useCurvature ? std::min(subdiv, screenSubdiv) : screenSubdiv;
+            }
+            return glm::clamp(subdiv, minSubdiv, maxSubdiv);
+        }
+
+        /** Output layout of a tessellation, computed in a parallel counting pass followed by a prefix sum.
+            Each strand i produces the tessellated points [pointOffsets[i], pointOffsets[i + 1]) and one segment less than points.
+        */
+        struct StrandLayout
+        {
+            std::vector<uint32_t> controlPointOffsets;  ///< Offset of the first control point per strand (strandCount + 1 entries).
+            std::vector<uint32_t> pointOffsets;         ///< Offset of the first tessellated point per strand (strandCount + 1 entries).
+            std::vector<uint32_t> segmentSubdivs;       ///< Number of sub-segments per cubic segment. Empty if not adaptive.
+            uint32_t subdivPerSegment = 0;              ///< Number of sub-segments per cubic segment if not adaptive.
+
+            uint32_t getSubdiv(uint32_t strand, uint32_t segment) const
+            {
+                // Strand i has (controlPointCount - 1) cubic segments, so its first segment is at controlPointOffset - i.
+                return segmentSubdivs.empty() ? subdivPerSegment : segmentSubdivs[controlPointOffsets[strand] - strand + segment];
+            }
+
+            uint32_t getPointCount() const { return pointOffsets.back(); }
+        };
+
+        StrandLayout computeLayout(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const CurveTessellation::SubdivisionDesc& desc, const glm::mat4& xform)
+        {
+            StrandLayout layout;
+            layout.subdivPerSegment = std::max(desc.subdivPerSegment, 1u);
+
+            layout.controlPointOffsets.resize(strandCount + 1);
+            layout.controlPointOffsets[0] = 0;
+            std::inclusive_scan(vertexCountsPerStrand, vertexCountsPerStrand + strandCount, layout.controlPointOffsets.begin() + 1, std::plus<uint32_t>(), 0u);
+
+            // Count pass: number of tessellated points per strand.
+            // The counts are stored shifted by one so that an in-place scan turns them into offsets.
+            layout.pointOffsets.resize(strandCount + 1);
+            layout.pointOffsets[0] = 0;
+            if (desc.adaptive)
+            {
+                layout.segmentSubdivs.resize(layout.controlPointOffsets.back() - strandCount);
+                forEachStrand(strandCount, [&] (uint32_t i)
+                {
+                    thread_local CubicSpline<float3> strandPoints;
+                    uint32_t controlPointCount = (uint32_t)vertexCountsPerStrand[i];
+                    assert(controlPointCount >= 2);
+                    strandPoints.setControlPoints(controlPoints + layout.controlPointOffsets[i], controlPointCount);
+
+                    uint32_t* pSubdivs = layout.segmentSubdivs.data() + layout.controlPointOffsets[i] - i;
+                    uint32_t pointCount = 1;
+                    for (uint32_t j = 0; j < controlPointCount - 1; j++)
+                    {
+                        pSubdivs[j] = computeAdaptiveSubdiv(strandPoints, j, desc, xform);
+                        pointCount += pSubdivs[j];
+                    }
+                    layout.pointOffsets[i + 1] = pointCount;
+                });
+            }
+            else
+            {
+                forEachStrand(strandCount, [&] (uint32_t i)
+                {
+                    assert(vertexCountsPerStrand[i] >= 2);
+                    layout.pointOffsets[i + 1] = layout.subdivPerSegment * (vertexCountsPerStrand[i] - 1) + 1;
+                });
+            }
+
+            // Prefix sum: offsets into the output arrays.
+            std::inclusive_scan(std::execution::par, layout.pointOffsets.begin() + 1, layout.pointOffsets.end(), layout.pointOffsets.begin() + 1);
+
+            return layout;
+        }
+
+        /** Call a function for each tessellated point of a strand, passing the cubic segment index and the segment parameter.
+        */
+        template<typename F>
+        void forEachStrandPoint(const StrandLayout& layout, uint32_t strand, uint32_t controlPointCount, F func)
+        {
+            for (uint32_t j = 0; j < controlPointCount - 1; j++)
+            {
+                uint32_t subdiv = layout.getSubdiv(strand, j);
+                for (uint32_t k = 0; k < subdiv; k++)
+                {
+                    func(j, (float)k / (float)subdiv);
+                }
+            }
+            func(controlPointCount - 2, 1.f);
+        }
     }
 
     CurveTessellation::SweptSphereResult CurveTessellation::convertToLinearSweptSphere(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t degree, uint32_t subdivPerSegment, const glm::mat4& xform)
+    {
+        return convertToLinearSweptSphere(strandCount, vertexCountsPerStrand, controlPoints, widths, UVs, degree, SubdivisionDesc(subdivPerSegment), xform);
+    }
+
+    CurveTessellation::SweptSphereResult CurveTessellation::convertToLinearSweptSphere(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t degree, const SubdivisionDesc& subdiv, const glm::mat4& xform)
     {
         SweptSphereResult result;
 
@@ -56,50 +202,52 @@ namespace Falcor
         assert(degree == 1);
         result.degree = degree;
 
-        uint32_t pointCounts = 0;
-        uint32_t segCounts = 0;
-        for (uint32_t i = 0; i < strandCount; i++)
-        {
-            pointCounts += subdivPerSegment * (vertexCountsPerStrand[i] - 1) + 1;
-            segCounts += pointCounts - 1;
-        }
-        result.indices.reserve(segCounts);
-        result.points.reserve(pointCounts);
-        result.radius.reserve(pointCounts);
-        result.tangents.reserve(pointCounts);
-        result.normals.reserve(pointCounts);
-        result.texCrds.reserve(pointCounts);
-
-        uint32_t pointOffset = 0;
-        for (uint32_t i = 0; i < strandCount; i++)
+        const StrandLayout layout = computeLayout(strandCount, vertexCountsPerStrand, controlPoints, subdiv, xform);
+        const uint32_t pointCount = layout.getPointCount();
+
+        result.indices.resize(pointCount - strandCount);
+        result.points.resize(pointCount);
+        result.radius.resize(pointCount);
+        result.tangents.resize(pointCount);
+        result.normals.resize(pointCount);
+        if (UVs) result.texCrds.resize(pointCount);
+
+        // Fill pass: each strand writes its own range of the output arrays.
+        forEachStrand(strandCount, [&] (uint32_t i)
         {
-            CubicSpline strandPoints(controlPoints + pointOffset, vertexCountsPerStrand[i]);
-            CubicSpline strandWidths(widths + pointOffset, vertexCountsPerStrand[i]);
+            thread_local CubicSpline<float3> strandPoints;
+            thread_local CubicSpline<float> strandWidths;
+            thread_local CubicSpline<float2> strandUVs;
 
-            uint32_t resOffset = (uint32_t)result.points.size();
-            for (uint32_t j = 0; j < (uint32_t)vertexCountsPerStrand[i] - 1; j++)
-            {
-                for (uint32_t k = 0; k < subdivPerSegment; k++)
-                {
-                    float t = (float)k / (float)subdivPerSegment;
-                    result.indices.push_back((uint32_t)result.points.size());
+            const uint32_t controlPointOffset = layout.controlPointOffsets[i];
+            const uint32_t controlPointCount = (uint32_t)vertexCountsPerStrand[i];
+            strandPoints.setControlPoints(controlPoints + controlPointOffset, controlPointCount);
+            strandWidths.setControlPoints(widths + controlPointOffset, controlPointCount);
+            if (UVs) strandUVs.setControlPoints(UVs + controlPointOffset, controlPointCount);
 
-                    // Pre-transform curve points.
-                    float4 sph = transformSphere(xform, float4(strandPoints.interpolate(j, t), strandWidths.interpolate(j, t) * 0.5f));
-                    result.points.push_back(sph.xyz);
-                    result.radius.push_back(sph.w);
-                }
-            }
+            const uint32_t pointBegin = layout.pointOffsets[i];
+            const uint32_t pointEnd = layout.pointOffsets[i + 1];
+
+            // Segment indices; the last point of each strand does not start a segment.
+            for (uint32_t j = pointBegin; j < pointEnd - 1; j++) result.indices[j - i] = j;
 
-            float4 sph = transformSphere(xform, float4(strandPoints.interpolate(vertexCountsPerStrand[i] - 2, 1.f), strandWidths.interpolate(vertexCountsPerStrand[i] - 2, 1.f) * 0.5f));
-            result.points.push_back(sph.xyz);
-            result.radius.push_back(sph.w);
+            uint32_t pointIndex = pointBegin;
+            forEachStrandPoint(layout, i, controlPointCount, [&] (uint32_t j, float t)
+            {
+                // Pre-transform curve points.
+                float4 sph = transformSphere(xform, float4(strandPoints.interpolate(j, t), strandWidths.interpolate(j, t) * 0.5f));
+                result.points[pointIndex] = sph.xyz;
+                result.radius[pointIndex] = sph.w;
+                if (UVs) result.texCrds[pointIndex] = strandUVs.interpolate(j, t);
+                pointIndex++;
+            });
+            assert(pointIndex == pointEnd);
 
             // Compute tangents and normals.
-            for (uint32_t j = resOffset; j < result.points.size(); j++)
+            for (uint32_t j = pointBegin; j < pointEnd; j++)
             {
                 float3 fwd, s, t;
-                if (j < result.points.size() - 1)
+                if (j < pointEnd - 1)
                 {
                     fwd = normalize(result.points[j + 1] - result.points[j]);
                 }
@@ -109,94 +257,72 @@ namespace Falcor
                 }
                 buildFrame(fwd, s, t);
 
-                result.tangents.push_back(fwd);
-                result.normals.push_back(s);
+                result.tangents[j] = fwd;
+                result.normals[j] = s;
             }
-
-            // Texture coordinates.
-            if (UVs)
-            {
-                CubicSpline strandUVs(UVs + pointOffset, vertexCountsPerStrand[i]);
-                for (uint32_t j = 0; j < (uint32_t)vertexCountsPerStrand[i] - 1; j++)
-                {
-                    for (uint32_t k = 0; k < subdivPerSegment; k++)
-                    {
-                        float t = (float)k / (float)subdivPerSegment;
-                        result.texCrds.push_back(strandUVs.interpolate(j, t));
-                    }
-                }
-                result.texCrds.push_back(strandUVs.interpolate(vertexCountsPerStrand[i] - 2, 1.f));
-            }
-
-            pointOffset += vertexCountsPerStrand[i];
-        }
+        });
 
         return result;
     }
 
     CurveTessellation::MeshResult CurveTessellation::convertToMesh(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t subdivPerSegment, uint32_t pointCountPerCrossSection)
+    {
+        return convertToMesh(strandCount, vertexCountsPerStrand, controlPoints, widths, UVs, SubdivisionDesc(subdivPerSegment), pointCountPerCrossSection);
+    }
+
+    CurveTessellation::MeshResult CurveTessellation::convertToMesh(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, const SubdivisionDesc& subdiv, uint32_t pointCountPerCrossSection)
     {
         MeshResult result;
-        uint32_t vertexCounts = 0;
-        uint32_t faceCounts = 0;
-        for (uint32_t i = 0; i < strandCount; i++)
-        {
-            vertexCounts += pointCountPerCrossSection * subdivPerSegment * (vertexCountsPerStrand[i] - 1) + 1;
-            faceCounts += 2 * pointCountPerCrossSection * subdivPerSegment * (vertexCountsPerStrand[i] - 1);
-        }
-        result.vertices.reserve(vertexCounts);
-        result.normals.reserve(vertexCounts);
-        result.tangents.reserve(vertexCounts);
-        result.faceVertexCounts.reserve(faceCounts);
-        result.faceVertexIndices.reserve(faceCounts * 3);
-        result.texCrds.reserve(vertexCounts);
-
-        uint32_t pointOffset = 0;
-        uint32_t meshVertexOffset = 0;
-        for (uint32_t i = 0; i < strandCount; i++)
-        {
-            CubicSpline strandPoints(controlPoints + pointOffset, vertexCountsPerStrand[i]);
-            CubicSpline strandWidths(widths + pointOffset, vertexCountsPerStrand[i]);
 
-            std::vector<float3> curvePoints;
-            std::vector<float> curveRadius;
-            std::vector<float2> curveUVs;
+        const StrandLayout layout = computeLayout(strandCount, vertexCountsPerStrand, controlPoints, subdiv, glm::mat4(1.f));
+        const uint32_t pointCount = layout.getPointCount();
 
-            curvePoints.push_back(strandPoints.interpolate(0, 0.f));
-            curveRadius.push_back(strandWidths.interpolate(0, 0.f) * 0.5f);
+        // Each curve point produces a ring of vertices, and each curve segment two triangles per ring vertex.
+        const uint32_t vertexCount = pointCount * pointCountPerCrossSection;
+        const uint32_t faceCount = (pointCount - (uint32_t)strandCount) * 2 * pointCountPerCrossSection;
 
-            for (uint32_t j = 0; j < (uint32_t)vertexCountsPerStrand[i] - 1; j++)
-            {
-                for (uint32_t k = 1; k <= subdivPerSegment; k++)
-                {
-                    float t = (float)k / (float)subdivPerSegment;
-                    curvePoints.push_back(strandPoints.interpolate(j, t));
-                    curveRadius.push_back(strandWidths.interpolate(j, t) * 0.5f);
-                }
-            }
+        result.vertices.resize(vertexCount);
+        result.normals.resize(vertexCount);
+        result.tangents.resize(vertexCount);
+        result.faceVertexCounts.assign(faceCount, 3);
+        result.faceVertexIndices.resize(faceCount * 3);
+        if (UVs) result.texCrds.resize(vertexCount);
 
-            // Texture coordinates.
-            if (UVs)
+        // Fill pass: each strand writes its own range of the output arrays.
+        forEachStrand(strandCount, [&] (uint32_t i)
+        {
+            thread_local CubicSpline<float3> strandPoints;
+            thread_local CubicSpline<float> strandWidths;
+            thread_local CubicSpline<float2> strandUVs;
+            thread_local std::vector<float3> curvePoints;
+            thread_local std::vector<float> curveRadius;
+            thread_local std::vector<float2> curveUVs;
+
+            const uint32_t controlPointOffset = layout.controlPointOffsets[i];
+            const uint32_t controlPointCount = (uint32_t)vertexCountsPerStrand[i];
+            strandPoints.setControlPoints(controlPoints + controlPointOffset, controlPointCount);
+            strandWidths.setControlPoints(widths + controlPointOffset, controlPointCount);
+            if (UVs) strandUVs.setControlPoints(UVs + controlPointOffset, controlPointCount);
+
+            curvePoints.clear();
+            curveRadius.clear();
+            curveUVs.clear();
+            forEachStrandPoint(layout, i, controlPointCount, [&] (uint32_t j, float t)
             {
-                CubicSpline strandUVs(UVs + pointOffset, vertexCountsPerStrand[i]);
-                curveUVs.push_back(strandUVs.interpolate(0, 0.f));
-                for (uint32_t j = 0; j < (uint32_t)vertexCountsPerStrand[i] - 1; j++)
-                {
-                    for (uint32_t k = 1; k <= subdivPerSegment; k++)
-                    {
-                        float t = (float)k / (float)subdivPerSegment;
-                        curveUVs.push_back(strandUVs.interpolate(j, t));
-                    }
-                }
-            }
+                curvePoints.push_back(strandPoints.interpolate(j, t));
+                curveRadius.push_back(strandWidths.interpolate(j, t) * 0.5f);
+                if (UVs) curveUVs.push_back(strandUVs.interpolate(j, t));
+            });
 
-            pointOffset += vertexCountsPerStrand[i];
+            const uint32_t curvePointCount = (uint32_t)curvePoints.size();
+            const uint32_t meshVertexOffset = layout.pointOffsets[i] * pointCountPerCrossSection;
+            uint32_t* pFaceVertexIndices = result.faceVertexIndices.data() + (size_t)(layout.pointOffsets[i] - i) * 6 * pointCountPerCrossSection;
 
             // Create mesh.
-            for (uint32_t j = 0; j < curvePoints.size(); j++)
+            for (uint32_t j = 0; j < curvePointCount; j++)
             {
                 float3 fwd, s, t;
-                if (j < curvePoints.size() - 1)
+                if (j < curvePointCount - 1)
                 {
                     fwd = normalize(curvePoints[j + 1] - curvePoints[j]);
                 }
@@ -212,36 +338,34 @@ namespace Falcor
                     float phi = (float)k / (float)pointCountPerCrossSection * (float)M_PI * 2.f;
                     float3 vNormal = std::cos(phi) * s + std::sin(phi) * t;
 
-                    result.vertices.push_back(curvePoints[j] + curveRadius[j] * vNormal);
-                    result.normals.push_back(vNormal);
-                    result.tangents.push_back(float4(fwd.x, fwd.y, fwd.z, 1));
+                    uint32_t v = meshVertexOffset + j * pointCountPerCrossSection + k;
+                    result.vertices[v] = curvePoints[j] + curveRadius[j] * vNormal;
+                    result.normals[v] = vNormal;
+                    result.tangents[v] = float4(fwd.x, fwd.y, fwd.z, 1);
 
                     if (UVs)
                     {
-                        result.texCrds.push_back(curveUVs[j]);
+                        result.texCrds[v] = curveUVs[j];
                     }
                 }
 
                 // Mesh faces.
-                if (j < curvePoints.size() - 1)
+                if (j < curvePointCount - 1)
                 {
                     for (uint32_t k = 0; k < pointCountPerCrossSection; k++)
                     {
-                        result.faceVertexCounts.push_back(3);
-                        result.faceVertexIndices.push_back(meshVertexOffset + j * pointCountPerCrossSection + k);
-                        result.faceVertexIndices.push_back(meshVertexOffset + j * pointCountPerCrossSection + (k + 1) % pointCountPerCrossSection);
-                        result.faceVertexIndices.push_back(meshVertexOffset + (j + 1) * pointCountPerCrossSection + (k + 1) % pointCountPerCrossSection);
-
-                        result.faceVertexCounts.push_back(3);
-                        result.faceVertexIndices.push_back(meshVertexOffset + j * pointCountPerCrossSection + k);
-                        result.faceVertexIndices.push_back(meshVertexOffset + (j + 1) * pointCountPerCrossSection + (k + 1) % pointCountPerCrossSection);
-                        result.faceVertexIndices.push_back(meshVertexOffset + (j + 1) * pointCountPerCrossSection + k);
+                        *pFaceVertexIndices++ = meshVertexOffset + j * pointCountPerCrossSection + k;
+                        *pFaceVertexIndices++ = meshVertexOffset + j * pointCountPerCrossSection + (k + 1) % pointCountPerCrossSection;
+                        *pFaceVertexIndices++ = meshVertexOffset + (j + 1) * pointCountPerCrossSection + (k + 1) % pointCountPerCrossSection;
+
+                        *pFaceVertexIndices++ = meshVertexOffset + j * pointCountPerCrossSection + k;
+                        *pFaceVertexIndices++ = meshVertexOffset + (j + 1) * pointCountPerCrossSection + (k + 1) % pointCountPerCrossSection;
+                        *pFaceVertexIndices++ = meshVertexOffset + (j + 1) * pointCountPerCrossSection + k;
                     }
                 }
             }
+        });
 
-            meshVertexOffset += pointCountPerCrossSection * (uint32_t)curvePoints.size();
-        }
         return result;
     }
 }
@@ -33,6 +33,28 @@ namespace Falcor
     class dlldecl CurveTessellation
     {
     public:
+        /** Describes how many linear sub-segments each cubic segment (defined by 4 control points) is split into.
+            If adaptive subdivision is disabled, all segments use subdivPerSegment sub-segments.
+            Otherwise, the count is chosen per segment from the enabled targets:
+            - The curvature target asks for enough sub-segments to keep the change of tangent direction per sub-segment below maxAngle.
+            - The screen-size target asks for enough sub-segments to make each sub-segment about screenLength pixels long on screen.
+            If both targets are enabled, curvature-driven refinement stops once sub-segments would be shorter than the screen-size target,
+            so strands that are small on screen are tessellated coarsely. The result is clamped to [minSubdivPerSegment, subdivPerSegment].
+        */
+        struct SubdivisionDesc
+        {
+            uint32_t subdivPerSegment = 4;          ///< Number of sub-segments per segment, or the maximum number if adaptive.
+            bool adaptive = false;                  ///< Choose the number of sub-segments per segment adaptively.
+            uint32_t minSubdivPerSegment = 1;       ///< Minimum number of sub-segments per segment if adaptive.
+            float maxAngle = 0.1f;                  ///< Curvature target: maximum change of tangent direction per sub-segment in radians. Zero disables the target.
+            float screenLength = 0.f;               ///< Screen-size target: desired projected sub-segment length in pixels. Zero disables the target.
+            float3 cameraPosition = float3(0.f);    ///< Camera position in the space of the tessellated output.
+            float pixelAngle = 0.f;                 ///< Angle subtended by a single pixel in radians, e.g., vertical field of view divided by vertical resolution.
+
+            SubdivisionDesc() = default;
+            explicit SubdivisionDesc(uint32_t subdivPerSegment) : subdivPerSegment(subdivPerSegment) {}
+        };
+
         // Swept spheres
 
         struct SweptSphereResult
@@ -59,6 +81,20 @@ namespace Falcor
         */
         static SweptSphereResult convertToLinearSweptSphere(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t degree, uint32_t subdivPerSegment, const glm::mat4& xform);
 
+        /** Convert cubic B-splines to a couple of linear swept sphere segments.
+            Strands are tessellated in parallel. The output arrays are sized up front and written in place.
+            \param[in] strandCount Number of curve strands.
+            \param[in] vertexCountsPerStrand Number of control points per strand.
+            \param[in] controlPoints Array of control points.
+            \param[in] widths Array of curve widths, i.e., diameters of swept spheres.
+            \param[in] UVs Array of texture coordinates.
+            \param[in] degree Polynomial degree of strand (linear -- cubic).
+            \param[in] subdiv Subdivision settings. Screen-size targets are evaluated after pre-transformation.
+            \param[in] xform Row-major 4x4 transformation matrix. We apply pre-transformation to curve geometry.
+            \return Linear swept sphere segments.
+        */
+        static SweptSphereResult convertToLinearSweptSphere(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t degree, const SubdivisionDesc& subdiv, const glm::mat4& xform);
+
         // Tessellated mesh
 
         struct MeshResult
@@ -82,7 +118,20 @@ namespace Falcor
             \return Tessellated mesh.
         */
         static MeshResult convertToMesh(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t subdivPerSegment, uint32_t pointCountPerCrossSection);
-        
+
+        /** Tessellate cubic B-splines to a triangular mesh.
+            Strands are tessellated in parallel. The output arrays are sized up front and written in place.
+            \param[in] strandCount Number of curve strands.
+            \param[in] vertexCountsPerStrand Number of control points per strand.
+            \param[in] controlPoints Array of control points.
+            \param[in] widths Array of curve widths, i.e., diameters of swept spheres.
+            \param[in] UVs Array of texture coordinates.
+            \param[in] subdiv Subdivision settings.
+            \param[in] pointCountPerCrossSection Number of points sampled at each cross-section.
+            \return Tessellated mesh.
+        */
+        static MeshResult convertToMesh(size_t strandCount, const int* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, const SubdivisionDesc& subdiv, uint32_t pointCountPerCrossSection);
+
     private:
         CurveTessellation() = default;
         CurveTessellation(const CurveTessellation&) = delete;
@@ -0,0 +1,164 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "DrawListBuilder.h"
+#include <array>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Get the number of bits needed to represent all values up to and including maxValue.
+        */
+        uint32_t getBitCount(uint32_t maxValue)
+        {
+            uint32_t bits = 0;
+            while (bits < 32 && (maxValue >> bits) != 0) bits++;
+            return bits;
+        }
+
+        /** Stable LSD radix sort of key/value pairs on the lowest keyBits bits of the keys, 8 bits per pass.
+            Passes where all keys have the same digit are skipped. The temporary arrays are used as scratch space.
+        */
+        void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, std::vector<uint64_t>& tmpKeys, std::vector<uint32_t>& tmpValues, uint32_t keyBits)
+        {
+            assert(keys.size() == values.size());
+            const size_t count = keys.size();
+            tmpKeys.resize(count);
+            tmpValues.resize(count);
+
+            for (uint32_t shift = 0; shift < keyBits; shift += 8)
+            {
+                std::array<size_t, 256> offsets = {};
+                for (uint64_t key : keys) offsets[(key >> shift) & 0xff]++;
+                if (std::find(offsets.begin(), offsets.end(), count) != offsets.end()) continue;
+
+                size_t sum = 0;
+                for (auto& offset : offsets)
+                {
+                    size_t digitCount = offset;
+                    offset = sum;
+                    sum += digitCount;
+                }
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    size_t dst = offsets[(keys[i] >> shift) & 0xff]++;
+                    tmpKeys[dst] = keys[i];
+                    tmpValues[dst] = values[i];
+                }
+                keys.swap(tmpKeys);
+                values.swap(tmpValues);
+            }
+        }
+    }
+
+    const std::vector<DrawListBuilder::Draw>& DrawListBuilder::build(const std::vector<Item>& items)
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+
+        if (items.size() > std::numeric_limits<uint32_t>::max()) throw std::exception("DrawListBuilder::build() - Too many items");
+        const uint32_t itemCount = (uint32_t)items.size();
+
+        // Allocate the key bits. The depth gets the bits left over by the IDs, up to 32.
+        uint32_t maxBucket = 0, maxMaterialID = 0, maxMeshID = 0;
+        float minDepth = std::numeric_limits<float>::max(), maxDepth = std::numeric_limits<float>::lowest();
+        for (const auto& item : items)
+        {
+            maxBucket = std::max(maxBucket, item.bucket);
+            maxMaterialID = std::max(maxMaterialID, item.materialID);
+            maxMeshID = std::max(maxMeshID, item.meshID);
+            if (std::isfinite(item.depth))
+            {
+                minDepth = std::min(minDepth, item.depth);
+                maxDepth = std::max(maxDepth, item.depth);
+            }
+        }
+
+        const uint32_t meshBits = getBitCount(maxMeshID);
+        const uint32_t materialBits = getBitCount(maxMaterialID);
+        const uint32_t bucketBits = getBitCount(maxBucket);
+        const uint32_t idBits = bucketBits + materialBits + meshBits;
+        if (idBits > 64) throw std::exception("DrawListBuilder::build() - Bucket, material and mesh IDs don't fit in the sort key");
+
+        const uint32_t depthBits = mDepthSortEnabled && maxDepth > minDepth ? std::min(32u, 64 - idBits) : 0;
+        const uint32_t meshShift = depthBits;
+        const uint32_t materialShift = meshShift + meshBits;
+        const uint32_t bucketShift = materialShift + materialBits;
+
+        // Quantize the depth relative to the range of the items. Non-finite depths are sorted last.
+        const uint64_t maxDepthKey = depthBits > 0 ? (~0ull >> (64 - depthBits)) : 0;
+        const double depthScale = depthBits > 0 ? (double)maxDepthKey / ((double)maxDepth - minDepth) : 0.0;
+
+        auto shiftField = [](uint64_t value, uint32_t shift) { return shift < 64 ? value << shift : 0; };
+
+        mKeys.resize(itemCount);
+        mOrder.resize(itemCount);
+        for (uint32_t i = 0; i < itemCount; i++)
+        {
+            const auto& item = items[i];
+            uint64_t depthKey = 0;
+            if (depthBits > 0)
+            {
+                depthKey = std::isfinite(item.depth) ? std::min((uint64_t)(((double)item.depth - minDepth) * depthScale), maxDepthKey) : maxDepthKey;
+            }
+
+            mKeys[i] = shiftField(item.bucket, bucketShift) | shiftField(item.materialID, materialShift) | shiftField(item.meshID, meshShift) | depthKey;
+            mOrder[i] = i;
+        }
+
+        radixSort(mKeys, mOrder, mTmpKeys, mTmpOrder, idBits + depthBits);
+
+        // Merge consecutive instances of the same mesh.
+        mDraws.clear();
+        for (uint32_t slot = 0; slot < itemCount; slot++)
+        {
+            const auto& item = items[mOrder[slot]];
+            if (!mDraws.empty() && mDraws.back().bucket == item.bucket && mDraws.back().meshID == item.meshID)
+            {
+                mDraws.back().instanceCount++;
+            }
+            else
+            {
+                Draw draw;
+                draw.bucket = item.bucket;
+                draw.meshID = item.meshID;
+                draw.firstInstance = slot;
+                draw.instanceCount = 1;
+                mDraws.push_back(draw);
+            }
+        }
+
+        mStats.itemCount = itemCount;
+        mStats.drawCount = (uint32_t)mDraws.size();
+        mStats.depthBits = depthBits;
+        mStats.sortTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+
+        return mDraws;
+    }
+}
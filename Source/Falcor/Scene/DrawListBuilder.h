@@ -0,0 +1,102 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    /** Builds an ordered list of instanced draws for rasterizing the scene.
+
+        Every item is one mesh instance. The items are sorted by a packed 64-bit key made of
+        (bucket, material, mesh, depth), from the most to the least significant bits, using an
+        LSD radix sort. Buckets separate draws that need different pipeline state (e.g., triangle
+        winding and index format), so each bucket maps to one contiguous range of draws. Within a
+        bucket, the items are grouped by material and mesh and ordered front-to-back.
+
+        Consecutive items of the same mesh in the same bucket are merged into a single draw with
+        an instance count larger than one. The instance slots of a draw index into getOrder(), which
+        maps them back to the items. The scene uploads this mapping as the per-instance draw ID buffer.
+    */
+    class dlldecl DrawListBuilder
+    {
+    public:
+        struct Item
+        {
+            uint32_t bucket = 0;        ///< Draws in different buckets are never merged. Buckets are sorted first.
+            uint32_t materialID = 0;    ///< Material ID.
+            uint32_t meshID = 0;        ///< Mesh ID. Consecutive items of the same mesh are merged.
+            float depth = 0.f;          ///< View depth, sorted front-to-back. Ignored if depth sorting is disabled.
+        };
+
+        struct Draw
+        {
+            uint32_t bucket = 0;        ///< Bucket of the draw.
+            uint32_t meshID = 0;        ///< Mesh ID.
+            uint32_t firstInstance = 0; ///< First instance slot, i.e., index into getOrder().
+            uint32_t instanceCount = 0; ///< Number of instances.
+        };
+
+        struct Stats
+        {
+            uint32_t itemCount = 0;     ///< Number of items in the last build.
+            uint32_t drawCount = 0;     ///< Number of draws after merging instances in the last build.
+            uint32_t depthBits = 0;     ///< Number of key bits used for the depth in the last build.
+            double sortTime = 0.0;      ///< Time spent sorting and merging in the last build in ms.
+        };
+
+        /** Sort the items and merge them into instanced draws.
+            Throws an exception if the bucket, material and mesh IDs don't fit in the 64-bit key.
+            \param[in] items Items to draw.
+            \return The draws, ordered by bucket.
+        */
+        const std::vector<Draw>& build(const std::vector<Item>& items);
+
+        /** Get the item index of each instance slot of the last build.
+        */
+        const std::vector<uint32_t>& getOrder() const { return mOrder; }
+
+        /** Get the draws of the last build.
+        */
+        const std::vector<Draw>& getDraws() const { return mDraws; }
+
+        /** Enable/disable sorting by depth. When disabled, items with equal keys keep their input order.
+        */
+        void setDepthSortEnabled(bool enabled) { mDepthSortEnabled = enabled; }
+        bool isDepthSortEnabled() const { return mDepthSortEnabled; }
+
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        bool mDepthSortEnabled = true;
+        Stats mStats;
+        std::vector<uint64_t> mKeys;        ///< Sort keys, and scratch space for the radix sort.
+        std::vector<uint64_t> mTmpKeys;
+        std::vector<uint32_t> mOrder;       ///< Item index per instance slot.
+        std::vector<uint32_t> mTmpOrder;
+        std::vector<Draw> mDraws;
+    };
+}
@@ -36,7 +36,9 @@
 #include "Core/API/Device.h"
 #include "Scene/SceneBuilder.h"
 
+#include <atomic>
 #include <execution>
+#include <numeric>
 
 namespace Falcor
 {
@@ -403,21 +405,44 @@ namespace Falcor
             return true;
         }
 
+        /** Number of elements above which the attributes of a mesh are converted in parallel blocks.
+            Smaller meshes are converted serially, as meshes are already converted in parallel.
+        */
+        const uint32_t kParallelElementThreshold = 1 << 16;
+        const uint32_t kElementsPerTask = 1 << 14;
+
+        /** Calls func(i) for all elements, in parallel blocks if the count is large.
+        */
+        template<typename Func>
+        void forEachElement(uint32_t count, Func func)
+        {
+            if (count < kParallelElementThreshold)
+            {
+                for (uint32_t i = 0; i < count; i++) func(i);
+                return;
+            }
+
+            uint32_t blockCount = (count + kElementsPerTask - 1) / kElementsPerTask;
+            auto range = NumericRange<uint32_t>(0, blockCount);
+            std::for_each(std::execution::par, range.begin(), range.end(), [&] (uint32_t block) {
+                uint32_t end = std::min(count, (block + 1) * kElementsPerTask);
+                for (uint32_t i = block * kElementsPerTask; i < end; i++) func(i);
+            });
+        }
+
         void createTexCrdList(const aiVector3D* pAiTexCrd, uint32_t count, std::vector<float2>& texCrds)
         {
             texCrds.resize(count);
-            for (uint32_t i = 0; i < count; i++)
-            {
+            forEachElement(count, [&] (uint32_t i) {
                 assert(pAiTexCrd[i].z == 0);
                 texCrds[i] = float2(pAiTexCrd[i].x, pAiTexCrd[i].y);
-            }
+            });
         }
 
         void createTangentList(const aiVector3D* pAiTangent, const aiVector3D* pAiBitangent, const aiVector3D* pAiNormal, uint32_t count, std::vector<float4>& tangents)
         {
             tangents.resize(count);
-            for (uint32_t i = 0; i < count; i++)
-            {
+            forEachElement(count, [&] (uint32_t i) {
                 // We compute the bitangent at runtime as defined by MikkTSpace: cross(N, tangent.xyz) * tangent.w.
                 // Compute the orientation of the loaded bitangent here to set the sign (w) correctly.
                 float3 T = float3(pAiTangent[i].x, pAiTangent[i].y, pAiTangent[i].z);
@@ -425,7 +450,7 @@ namespace Falcor
                 float3 N = float3(pAiNormal[i].x, pAiNormal[i].y, pAiNormal[i].z);
                 float sign = dot(cross(N, T), B) >= 0.f ? 1.f : -1.f;
                 tangents[i] = float4(glm::normalize(T), sign);
-            }
+            });
         }
 
         void createIndexList(const aiMesh* pAiMesh, std::vector<uint32_t>& indices)
@@ -434,163 +459,186 @@ namespace Falcor
             const uint32_t indexCount = pAiMesh->mNumFaces * perFaceIndexCount;
 
             indices.resize(indexCount);
-            for (uint32_t i = 0; i < pAiMesh->mNumFaces; i++)
-            {
+            forEachElement(pAiMesh->mNumFaces, [&] (uint32_t i) {
                 assert(pAiMesh->mFaces[i].mNumIndices == perFaceIndexCount); // Mesh contains mixed primitive types, can be solved using aiProcess_SortByPType
                 for (uint32_t j = 0; j < perFaceIndexCount; j++)
                 {
                     indices[i * perFaceIndexCount + j] = (uint32_t)(pAiMesh->mFaces[i].mIndices[j]);
                 }
-            }
+            });
         }
 
         void loadBones(const aiMesh* pAiMesh, const ImporterData& data, std::vector<float4>& weights, std::vector<uint4>& ids)
         {
             const uint32_t vertexCount = pAiMesh->mNumVertices;
 
-            weights.resize(vertexCount);
-            ids.resize(vertexCount);
+            weights.assign(vertexCount, float4(0.f));
+            ids.assign(vertexCount, uint4(Scene::kInvalidBone));
 
-            std::fill(weights.begin(), weights.end(), float4(0.f));
-            std::fill(ids.begin(), ids.end(), uint4(Scene::kInvalidBone));
+            // The way Assimp works, each bone holds the IDs of the vertices it affects and their weights.
+            // Counting pass: count the non-zero weights per vertex and convert the counts to offsets.
+            std::vector<uint32_t> offsets(vertexCount + 1, 0);
+            for (uint32_t bone = 0; bone < pAiMesh->mNumBones; bone++)
+            {
+                const aiBone* pAiBone = pAiMesh->mBones[bone];
+                for (uint32_t weightID = 0; weightID < pAiBone->mNumWeights; weightID++)
+                {
+                    const aiVertexWeight& aiWeight = pAiBone->mWeights[weightID];
+                    if (aiWeight.mWeight != 0.f) offsets[aiWeight.mVertexId + 1]++;
+                }
+            }
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
 
+            // Gather the influences of each vertex into a contiguous range, in bone order.
+            std::vector<std::pair<uint32_t, float>> influences(offsets.back());
+            std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
             for (uint32_t bone = 0; bone < pAiMesh->mNumBones; bone++)
             {
                 const aiBone* pAiBone = pAiMesh->mBones[bone];
                 assert(data.getNodeInstanceCount(pAiBone->mName.C_Str()) == 1);
                 uint32_t aiBoneID = data.getFalcorNodeID(pAiBone->mName.C_Str(), 0);
 
-                // The way Assimp works, the weights holds the IDs of the vertices it affects.
-                // We loop over all the weights, initializing the vertices data along the way
                 for (uint32_t weightID = 0; weightID < pAiBone->mNumWeights; weightID++)
                 {
-                    // Get the vertex the current weight affects
                     const aiVertexWeight& aiWeight = pAiBone->mWeights[weightID];
+                    if (aiWeight.mWeight != 0.f) influences[cursors[aiWeight.mVertexId]++] = { aiBoneID, aiWeight.mWeight };
+                }
+            }
 
-                    // Skip zero weights
-                    if (aiWeight.mWeight == 0.f) continue;
+            // Assign the bone slots of each vertex and normalize the weights, since in some models the sum is larger than 1.
+            std::atomic<uint32_t> overflowCount = 0;
+            forEachElement(vertexCount, [&] (uint32_t i) {
+                auto begin = influences.begin() + offsets[i];
+                auto end = influences.begin() + offsets[i + 1];
+                if ((size_t)(end - begin) > Scene::kMaxBonesPerVertex)
+                {
+                    // Keep the strongest influences.
+                    std::stable_sort(begin, end, [] (const auto& a, const auto& b) { return a.second > b.second; });
+                    end = begin + Scene::kMaxBonesPerVertex;
+                    overflowCount++;
+                }
 
-                    // Get the address of the Bone ID and weight for the current vertex
-                    uint4& vertexIds = ids[aiWeight.mVertexId];
-                    float4& vertexWeights = weights[aiWeight.mVertexId];
+                float sum = 0.f;
+                uint32_t slot = 0;
+                for (auto it = begin; it != end; ++it, ++slot)
+                {
+                    ids[i][slot] = it->first;
+                    weights[i][slot] = it->second;
+                    sum += it->second;
+                }
+                if (sum > 0.f) weights[i] /= sum;
+            });
 
-                    // Find the next unused slot in the bone array of the vertex, and initialize it with the current value
-                    bool emptySlotFound = false;
-                    for (uint32_t j = 0; j < Scene::kMaxBonesPerVertex; j++)
-                    {
-                        if (vertexIds[j] == Scene::kInvalidBone)
-                        {
-                            vertexIds[j] = aiBoneID;
-                            vertexWeights[j] = aiWeight.mWeight;
-                            emptySlotFound = true;
-                            break;
-                        }
-                    }
+            if (overflowCount > 0)
+            {
+                logError("Mesh '" + std::string(pAiMesh->mName.C_Str()) + "' has " + std::to_string(overflowCount.load()) + " vertices with more than " + std::to_string(Scene::kMaxBonesPerVertex) +
+                    " bones attached. Only the strongest bones are kept and the animation might not look correct");
+            }
+        }
 
-                    if (emptySlotFound == false) logError("One of the vertices has too many bones attached to it. If you'll continue, this bone will be ignored and the animation might not look correct");
-                }
+        /** Mesh description converted from an Assimp mesh, along with the converted vertex and index data it references.
+        */
+        struct ConvertedMesh
+        {
+            SceneBuilder::Mesh mesh;
+            std::vector<uint32_t> indexList;
+            std::vector<float2> texCrds;
+            std::vector<float4> tangents;
+            std::vector<uint4> boneIds;
+            std::vector<float4> boneWeights;
+        };
+
+        void convertMesh(const aiMesh* pAiMesh, const ImporterData& data, bool loadTangents, ConvertedMesh& converted)
+        {
+            const uint32_t perFaceIndexCount = pAiMesh->mFaces[0].mNumIndices;
+
+            SceneBuilder::Mesh& mesh = converted.mesh;
+            mesh.name = pAiMesh->mName.C_Str();
+            mesh.faceCount = pAiMesh->mNumFaces;
+
+            // Indices
+            createIndexList(pAiMesh, converted.indexList);
+            assert(converted.indexList.size() <= std::numeric_limits<uint32_t>::max());
+            mesh.indexCount = (uint32_t)converted.indexList.size();
+            mesh.pIndices = converted.indexList.data();
+
+            // Vertices
+            assert(pAiMesh->mVertices);
+            mesh.vertexCount = pAiMesh->mNumVertices;
+            static_assert(sizeof(pAiMesh->mVertices[0]) == sizeof(mesh.positions.pData[0]));
+            static_assert(sizeof(pAiMesh->mNormals[0]) == sizeof(mesh.normals.pData[0]));
+            mesh.positions.pData = reinterpret_cast<float3*>(pAiMesh->mVertices);
+            mesh.positions.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+            mesh.normals.pData = reinterpret_cast<float3*>(pAiMesh->mNormals);
+            mesh.normals.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+
+            if (pAiMesh->HasTextureCoords(0))
+            {
+                createTexCrdList(pAiMesh->mTextureCoords[0], pAiMesh->mNumVertices, converted.texCrds);
+                assert(!converted.texCrds.empty());
+                mesh.texCrds.pData = converted.texCrds.data();
+                mesh.texCrds.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+            }
+
+            if (loadTangents && pAiMesh->HasTangentsAndBitangents())
+            {
+                createTangentList(pAiMesh->mTangents, pAiMesh->mBitangents, pAiMesh->mNormals, pAiMesh->mNumVertices, converted.tangents);
+                assert(!converted.tangents.empty());
+                mesh.tangents.pData = converted.tangents.data();
+                mesh.tangents.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+            }
+
+            if (pAiMesh->HasBones())
+            {
+                loadBones(pAiMesh, data, converted.boneWeights, converted.boneIds);
+                mesh.boneIDs.pData = converted.boneIds.data();
+                mesh.boneIDs.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                mesh.boneWeights.pData = converted.boneWeights.data();
+                mesh.boneWeights.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
             }
 
-            // Now we need to normalize the weights for each vertex, since in some models the sum is larger than 1
-            for (uint32_t i = 0; i < vertexCount; i++)
+            switch (perFaceIndexCount)
             {
-                float4& w = weights[i];
-                float f = 0;
-                for (uint32_t j = 0; j < Scene::kMaxBonesPerVertex; j++) f += w[j];
-                w /= f;
+            case 1: mesh.topology = Vao::Topology::PointList; break;
+            case 2: mesh.topology = Vao::Topology::LineList; break;
+            case 3: mesh.topology = Vao::Topology::TriangleList; break;
+            default:
+                logError("Error when creating mesh. Unknown topology with " + std::to_string(perFaceIndexCount) + " indices per face.");
+                should_not_get_here();
             }
+
+            mesh.pMaterial = data.materialMap.at(pAiMesh->mMaterialIndex);
         }
 
-        void createMeshes(ImporterData& data)
+        void createMeshes(ImporterData& data, TimeReport& timeReport)
         {
             const aiScene* pScene = data.pScene;
             const bool loadTangents = is_set(data.builder.getFlags(), SceneBuilder::Flags::UseOriginalTangentSpace);
 
             uint32_t meshCount = pScene->mNumMeshes;
+            auto range = NumericRange<uint32_t>(0, meshCount);
+
+            // Convert meshes from Assimp's format.
+            std::vector<ConvertedMesh> convertedMeshes(meshCount);
+            std::for_each(std::execution::par, range.begin(), range.end(), [&] (uint32_t i) {
+                convertMesh(pScene->mMeshes[i], data, loadTangents, convertedMeshes[i]);
+            });
+            timeReport.measure("Converting meshes");
 
             // Pre-process meshes.
             std::vector<SceneBuilder::ProcessedMesh> processedMeshes(meshCount);
-            auto range = NumericRange<uint32_t>(0, meshCount);
             std::for_each(std::execution::par, range.begin(), range.end(), [&] (uint32_t i) {
-                const aiMesh* pAiMesh = pScene->mMeshes[i];
-                const uint32_t perFaceIndexCount = pAiMesh->mFaces[0].mNumIndices;
-
-                SceneBuilder::Mesh mesh;
-                mesh.name = pAiMesh->mName.C_Str();
-                mesh.faceCount = pAiMesh->mNumFaces;
-
-                // Temporary memory for the vertex and index data.
-                std::vector<uint32_t> indexList;
-                std::vector<float2> texCrds;
-                std::vector<float4> tangents;
-                std::vector<uint4> boneIds;
-                std::vector<float4> boneWeights;
-
-                // Indices
-                createIndexList(pAiMesh, indexList);
-                assert(indexList.size() <= std::numeric_limits<uint32_t>::max());
-                mesh.indexCount = (uint32_t)indexList.size();
-                mesh.pIndices = indexList.data();
-
-                // Vertices
-                assert(pAiMesh->mVertices);
-                mesh.vertexCount = pAiMesh->mNumVertices;
-                static_assert(sizeof(pAiMesh->mVertices[0]) == sizeof(mesh.positions.pData[0]));
-                static_assert(sizeof(pAiMesh->mNormals[0]) == sizeof(mesh.normals.pData[0]));
-                mesh.positions.pData = reinterpret_cast<float3*>(pAiMesh->mVertices);
-                mesh.positions.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-                mesh.normals.pData = reinterpret_cast<float3*>(pAiMesh->mNormals);
-                mesh.normals.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-
-                if (pAiMesh->HasTextureCoords(0))
-                {
-                    createTexCrdList(pAiMesh->mTextureCoords[0], pAiMesh->mNumVertices, texCrds);
-                    assert(!texCrds.empty());
-                    mesh.texCrds.pData = texCrds.data();
-                    mesh.texCrds.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-                }
-
-                if (loadTangents && pAiMesh->HasTangentsAndBitangents())
-                {
-                    createTangentList(pAiMesh->mTangents, pAiMesh->mBitangents, pAiMesh->mNormals, pAiMesh->mNumVertices, tangents);
-                    assert(!tangents.empty());
-                    mesh.tangents.pData = tangents.data();
-                    mesh.tangents.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-                }
-
-                if (pAiMesh->HasBones())
-                {
-                    loadBones(pAiMesh, data, boneWeights, boneIds);
-                    mesh.boneIDs.pData = boneIds.data();
-                    mesh.boneIDs.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-                    mesh.boneWeights.pData = boneWeights.data();
-                    mesh.boneWeights.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-                }
-
-                switch (perFaceIndexCount)
-                {
-                case 1: mesh.topology = Vao::Topology::PointList; break;
-                case 2: mesh.topology = Vao::Topology::LineList; break;
-                case 3: mesh.topology = Vao::Topology::TriangleList; break;
-                default:
-                    logError("Error when creating mesh. Unknown topology with " + std::to_string(perFaceIndexCount) + " indices per face.");
-                    should_not_get_here();
-                }
-
-                mesh.pMaterial = data.materialMap.at(pAiMesh->mMaterialIndex);
-
-                processedMeshes[i] = data.builder.processMesh(mesh);
+                processedMeshes[i] = data.builder.processMesh(convertedMeshes[i].mesh);
             });
+            convertedMeshes.clear();
+            timeReport.measure("Processing meshes");
 
             // Add meshes to the scene.
             // We retain a deterministic order of the meshes in the global scene buffer by adding
-            // them sequentially after being processed in parallel.
-            uint32_t i = 0;
-            for (const auto& mesh : processedMeshes)
-            {
-                uint32_t meshID = data.builder.addProcessedMesh(mesh);
-                data.meshMap[i++] = meshID;
-            }
+            // them in a single batch after being processed in parallel.
+            std::vector<uint32_t> meshIDs = data.builder.addProcessedMeshes(std::move(processedMeshes));
+            for (uint32_t i = 0; i < meshCount; i++) data.meshMap[i] = meshIDs[i];
+            timeReport.measure("Adding meshes");
         }
 
         bool isBone(ImporterData& data, const std::string& name)
@@ -1063,9 +1111,9 @@ namespace Falcor
         }
         timeReport.measure("Creating scene graph");
 
-        createMeshes(data);
+        createMeshes(data, timeReport);
         addMeshInstances(data, data.pScene->mRootNode);
-        timeReport.measure("Creating meshes");
+        timeReport.measure("Adding mesh instances");
 
         if (createAnimations(data) == false)
         {
@@ -30,8 +30,9 @@
 
 namespace Falcor
 {
-    MaterialTextureLoader::MaterialTextureLoader(bool useSrgb)
+    MaterialTextureLoader::MaterialTextureLoader(bool useSrgb, bool useMipCache)
         : mUseSrgb(useSrgb)
+        , mUseMipCache(useMipCache)
     {
     }
 
@@ -58,7 +59,7 @@ namespace Falcor
         // Load texture if not already requested before.
         if (mRequestedTextures.find(textureKey) == mRequestedTextures.end())
         {
-            mRequestedTextures[textureKey] = mAsyncTextureLoader.loadFromFile(fullPath, true, srgb);
+            mRequestedTextures[textureKey] = mAsyncTextureLoader.loadFromFile(fullPath, true, srgb, Resource::BindFlags::ShaderResource, mUseMipCache);
         }
 
         // Store assignment to material for later.
@@ -43,7 +43,11 @@ namespace Falcor
     class MaterialTextureLoader
     {
     public:
-        MaterialTextureLoader(bool useSrgb);
+        /** Constructor.
+            \param[in] useSrgb Load color textures using sRGB format.
+            \param[in] useMipCache Load mip chains from DDS cache files next to the textures, and write them if missing or outdated.
+        */
+        MaterialTextureLoader(bool useSrgb, bool useMipCache = false);
         ~MaterialTextureLoader();
 
         /** Request loading a material texture.
@@ -57,6 +61,7 @@ namespace Falcor
         void assignTextures();
 
         bool mUseSrgb;
+        bool mUseMipCache;
 
         using TextureKey = std::pair<std::string, bool>; // filename, srgb
 
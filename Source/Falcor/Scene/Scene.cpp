@@ -29,8 +29,10 @@
 #include "Scene.h"
 #include "Raytracing/RtProgram/RtProgram.h"
 #include "Raytracing/RtProgramVars.h"
+#include "Utils/NumericRange.h"
 #include <sstream>
 #include <numeric>
+#include <execution>
 
 namespace Falcor
 {
@@ -83,12 +85,40 @@ namespace Falcor
         const std::string kAddViewpoint = "addViewpoint";
         const std::string kRemoveViewpoint = "kRemoveViewpoint";
         const std::string kSelectViewpoint = "selectViewpoint";
+        const std::string kBuildCPUBVH = "buildCPUBVH";
+        const std::string kCPUBVH = "cpuBVH";
+        const std::string kCastRay = "castRay";
+        const std::string kBVHQualityTracking = "bvhQualityTracking";
+        const std::string kDrawListDepthSort = "drawListDepthSort";
 
         // Checks if the transform flips the coordinate system handedness (its determinant is negative).
         bool doesTransformFlip(const glm::mat4& m)
         {
             return glm::determinant((glm::mat3)m) < 0.f;
         }
+
+        // Draw list bucket of a mesh instance. Bucket order is clockwise before counterclockwise, 16-bit before 32-bit indices.
+        uint32_t getDrawBucket(bool ccw, bool use16BitIndices)
+        {
+            return (ccw ? 2 : 0) | (use16BitIndices ? 0 : 1);
+        }
+
+        /** Convert a CPU BVH hit to a mesh instance hit.
+            \param[in] triangleOffsets Offset of the first triangle of each mesh instance in the BVH.
+            \param[in] hit BVH hit.
+        */
+        Scene::CPUHit createCPUHit(const std::vector<uint32_t>& triangleOffsets, const CPUBVH::Hit& hit)
+        {
+            Scene::CPUHit result;
+            if (!hit.isValid()) return result;
+
+            auto it = std::upper_bound(triangleOffsets.begin(), triangleOffsets.end(), hit.triangleIndex);
+            result.meshInstanceID = (uint32_t)std::distance(triangleOffsets.begin(), it) - 1;
+            result.primitiveIndex = hit.triangleIndex - triangleOffsets[result.meshInstanceID];
+            result.t = hit.t;
+            result.barycentrics = hit.barycentrics;
+            return result;
+        }
     }
 
     const FileDialogFilterVec& Scene::getFileExtensionFilters()
@@ -131,6 +161,15 @@ namespace Falcor
             mpLightCollection = LightCollection::create(pContext, shared_from_this());
             mpLightCollection->setShaderData(mpSceneBlock["lightCollection"]);
 
+            // The light collection is built once, so the CPU geometry is no longer needed unless it was requested.
+            if (!mKeepCPUGeometry)
+            {
+                mCPUIndexData.clear();
+                mCPUIndexData.shrink_to_fit();
+                mCPUStaticVertexData.clear();
+                mCPUStaticVertexData.shrink_to_fit();
+            }
+
             mSceneStats.emissiveMemoryInBytes = mpLightCollection->getMemoryUsageInBytes();
         }
         return mpLightCollection;
@@ -162,11 +201,11 @@ namespace Falcor
             // Draw the primitives.
             if (isIndexed)
             {
-                pContext->drawIndexedIndirect(pState, pVars, draw.count, draw.pBuffer.get(), 0, nullptr, 0);
+                pContext->drawIndexedIndirect(pState, pVars, draw.count, mpDrawBuffer.get(), draw.offset, nullptr, 0);
             }
             else
             {
-                pContext->drawIndirect(pState, pVars, draw.count, draw.pBuffer.get(), 0, nullptr, 0);
+                pContext->drawIndirect(pState, pVars, draw.count, mpDrawBuffer.get(), draw.offset, nullptr, 0);
             }
         }
 
@@ -426,7 +465,6 @@ namespace Falcor
         updateProceduralPrimitives(true);
 
         updateBounds();
-        createDrawList();
         if (mCameras.size() == 0)
         {
             // Create a new camera to use in the event of a scene with no cameras
@@ -436,6 +474,7 @@ namespace Falcor
         setCameraController(mCamCtrlType);
         initializeCameras();
         uploadSelectedCamera();
+        createDrawList(); // Requires the camera for sorting front-to-back
         addViewpoint();
         updateLights(true);
         updateVolumes(true);
@@ -548,11 +587,7 @@ namespace Falcor
         s.geometryMemoryInBytes += mpRtAABBBuffer ? mpRtAABBBuffer->getSize() : 0;
         s.geometryMemoryInBytes += mpProceduralPrimitivesBuffer ? mpProceduralPrimitivesBuffer->getSize() : 0;
         s.geometryMemoryInBytes += pDrawID ? pDrawID->getSize() : 0;
-        for (const auto& draw : mDrawArgs)
-        {
-            assert(draw.pBuffer);
-            s.geometryMemoryInBytes += draw.pBuffer->getSize();
-        }
+        s.geometryMemoryInBytes += mpDrawBuffer ? mpDrawBuffer->getSize() : 0;
         s.geometryMemoryInBytes += mpCurvesBuffer ? mpCurvesBuffer->getSize() : 0;
         s.geometryMemoryInBytes += mpCurveInstancesBuffer ? mpCurveInstancesBuffer->getSize() : 0;
 
@@ -792,8 +827,8 @@ namespace Falcor
         // Early out if no volumes have changed.
         if (!forceUpdate && combinedUpdates == Volume::UpdateFlags::None) return UpdateFlags::None;
 
-        // Upload grids.
-        if (forceUpdate)
+        // Upload grids. Streamed grid sequences replace the grid buffers when the grid frame changes.
+        if (forceUpdate || is_set(combinedUpdates, Volume::UpdateFlags::GridsChanged))
         {
             auto var = mpSceneBlock["grids"];
             for (size_t i = 0; i < mGrids.size(); ++i)
@@ -904,9 +939,15 @@ namespace Falcor
             updateMeshInstances(false);
         }
 
+        // Re-sort the draw list when the depth order or the triangle winding of the instances may have changed.
+        bool drawOrderChanged = mRebuildDrawList || is_set(mUpdates, UpdateFlags::MeshesMoved);
+        if (isDrawListDepthSortEnabled()) drawOrderChanged |= is_set(mUpdates, UpdateFlags::CameraMoved) || is_set(mUpdates, UpdateFlags::CameraSwitched);
+        if (drawOrderChanged && mpDrawBuffer) updateDrawList(pContext);
+
         // If a transform in the scene changed, update BLASes with skinned meshes
         if (mBlasData.size() && mHasSkinnedMesh && is_set(mUpdates, UpdateFlags::SceneGraphChanged))
         {
+            if (mpBVHQualityTracker) mpBVHQualityTracker->update();
             mTlasCache.clear();
             buildBlas(pContext);
         }
@@ -1069,6 +1110,25 @@ namespace Falcor
             }
         }
 
+        if (mHasSkinnedMesh)
+        {
+            if (auto blasGroup = widget.group("BLAS Quality"))
+            {
+                bool trackingEnabled = isBVHQualityTrackingEnabled();
+                if (blasGroup.checkbox("Enable tracking", trackingEnabled)) setBVHQualityTrackingEnabled(trackingEnabled);
+                blasGroup.tooltip("Estimate the quality of refitted BLASes with skinned meshes on the CPU, and rebuild them once they are too degraded.", true);
+
+                if (mpBVHQualityTracker) mpBVHQualityTracker->renderUI(blasGroup);
+            }
+        }
+
+        if (auto drawListGroup = widget.group("Draw List"))
+        {
+            bool depthSortEnabled = isDrawListDepthSortEnabled();
+            if (drawListGroup.checkbox("Sort front-to-back", depthSortEnabled)) setDrawListDepthSortEnabled(depthSortEnabled);
+            drawListGroup.tooltip("Sort the rasterized mesh instances front-to-back within each material and mesh. The draw list is re-sorted whenever the camera moves.", true);
+        }
+
         if (auto statsGroup = widget.group("Statistics"))
         {
             const auto& s = mSceneStats;
@@ -1101,6 +1161,14 @@ namespace Falcor
                 << "  Curve vertex buffer memory: " << formatByteSize(s.curveVertexMemoryInBytes) << std::endl
                 << std::endl;
 
+            // Draw list stats.
+            oss << "Draw list stats:" << std::endl
+                << "  Instance count: " << s.drawInstanceCount << std::endl
+                << "  Draw count: " << s.drawCount << std::endl
+                << "  Draw call count: " << s.drawCallCount << std::endl
+                << "  Sort time: " << std::fixed << std::setprecision(3) << s.drawListSortTime << " ms" << std::endl
+                << std::endl;
+
             // Raytracing stats.
             oss << "Raytracing stats:" << std::endl
                 << "  BLAS groups: " << s.blasGroupCount << std::endl
@@ -1352,78 +1420,136 @@ namespace Falcor
         mBlasUpdateMode = mode;
     }
 
+    void Scene::setBVHQualityTrackingEnabled(bool enabled)
+    {
+        if (enabled == isBVHQualityTrackingEnabled()) return;
+
+        mpBVHQualityTracker = enabled ? BVHQualityTracker::create(this) : nullptr;
+        mRebuildBlas = true;
+    }
+
     void Scene::createDrawList()
     {
-        assert(mDrawArgs.empty());
-        auto pMatricesBuffer = mpSceneBlock->getBuffer("worldMatrices");
-        const glm::mat4* matrices = (glm::mat4*)pMatricesBuffer->map(Buffer::MapType::Read); // #SCENEV2 This will cause the pipeline to flush and sync, but it's probably not too bad as this only happens once
+        assert(mDrawArgs.empty() && !mpDrawBuffer);
+        if (mMeshInstanceData.empty()) return;
+
+        // Merging instances never produces more draws than there are mesh instances.
+        size_t argSize = hasIndexBuffer() ? sizeof(D3D12_DRAW_INDEXED_ARGUMENTS) : sizeof(D3D12_DRAW_ARGUMENTS);
+        mpDrawBuffer = Buffer::create(argSize * mMeshInstanceData.size(), Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None);
+        mpDrawBuffer->setName("Scene draw buffer");
+
+        updateDrawList(gpDevice->getRenderContext());
+    }
+
+    void Scene::updateDrawList(RenderContext* pContext)
+    {
+        assert(mpDrawBuffer);
+        mRebuildDrawList = false;
+
+        // Create the sort items from the CPU copy of the global matrices. This avoids reading back the matrices from the GPU.
+        const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+        const auto& pCamera = mCameras[mSelectedCamera];
+        const float3 cameraPos = pCamera->getPosition();
+        const float3 cameraDir = glm::normalize(pCamera->getTarget() - cameraPos);
+        const bool isIndexed = hasIndexBuffer();
 
-        // Helper to create the draw-indirect buffer.
-        auto createDrawBuffer = [this](const auto& drawMeshes, bool ccw, ResourceFormat ibFormat = ResourceFormat::Unknown)
+        mDrawItems.resize(mMeshInstanceData.size());
+        for (size_t instanceID = 0; instanceID < mMeshInstanceData.size(); instanceID++)
         {
-            if (drawMeshes.size() > 0)
-            {
-                DrawArgs draw;
-                draw.pBuffer = Buffer::create(sizeof(drawMeshes[0]) * drawMeshes.size(), Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None, drawMeshes.data());
-                draw.pBuffer->setName("Scene draw buffer");
-                assert(drawMeshes.size() <= std::numeric_limits<uint32_t>::max());
-                draw.count = (uint32_t)drawMeshes.size();
-                draw.ccw = ccw;
-                draw.ibFormat = ibFormat;
-                mDrawArgs.push_back(draw);
-            }
-        };
+            const auto& instance = mMeshInstanceData[instanceID];
+            const auto& mesh = mMeshDesc[instance.meshID];
+            const auto& transform = globalMatrices[instance.globalMatrixID];
+            assert(isIndexed || mesh.indexCount == 0);
+
+            float3 center = float3(transform * float4(mMeshBBs[instance.meshID].center(), 1.f));
 
-        if (hasIndexBuffer())
+            auto& item = mDrawItems[instanceID];
+            item.bucket = getDrawBucket(!doesTransformFlip(transform), isIndexed && mesh.use16BitIndices());
+            item.materialID = instance.materialID;
+            item.meshID = instance.meshID;
+            item.depth = glm::dot(center - cameraPos, cameraDir);
+        }
+
+        const auto& draws = mDrawListBuilder.build(mDrawItems);
+        const auto& order = mDrawListBuilder.getOrder();
+
+        // Upload the draw IDs. The vertex shader fetches the mesh instance ID of each instance slot from this buffer.
+        const auto& pDrawIDBuffer = mpVao->getVertexBuffer(kDrawIdBufferIndex);
+        ResourceFormat drawIDFormat = mpVao->getVertexLayout()->getBufferLayout(kDrawIdBufferIndex)->getElementFormat(0);
+        if (drawIDFormat == ResourceFormat::R16Uint)
+        {
+            std::vector<uint16_t> drawIDs(order.begin(), order.end());
+            pContext->updateBuffer(pDrawIDBuffer.get(), drawIDs.data(), 0, drawIDs.size() * sizeof(uint16_t));
+        }
+        else if (drawIDFormat == ResourceFormat::R32Uint)
         {
-            std::vector<D3D12_DRAW_INDEXED_ARGUMENTS> drawClockwiseMeshes[2], drawCounterClockwiseMeshes[2];
+            pContext->updateBuffer(pDrawIDBuffer.get(), order.data(), 0, order.size() * sizeof(uint32_t));
+        }
+        else should_not_get_here();
 
-            uint32_t instanceID = 0;
-            for (const auto& instance : mMeshInstanceData)
+        // Upload the draw-indirect arguments. The draws of each bucket are contiguous, so each bucket is drawn with a single indirect draw call.
+        size_t argSize = 0;
+        if (isIndexed)
+        {
+            std::vector<D3D12_DRAW_INDEXED_ARGUMENTS> drawArgs(draws.size());
+            for (size_t i = 0; i < draws.size(); i++)
             {
-                const auto& mesh = mMeshDesc[instance.meshID];
-                const auto& transform = matrices[instance.globalMatrixID];
+                const auto& mesh = mMeshDesc[draws[i].meshID];
                 bool use16Bit = mesh.use16BitIndices();
 
-                D3D12_DRAW_INDEXED_ARGUMENTS draw;
+                auto& draw = drawArgs[i];
                 draw.IndexCountPerInstance = mesh.indexCount;
-                draw.InstanceCount = 1;
+                draw.InstanceCount = draws[i].instanceCount;
                 draw.StartIndexLocation = mesh.ibOffset * (use16Bit ? 2 : 1);
                 draw.BaseVertexLocation = mesh.vbOffset;
-                draw.StartInstanceLocation = instanceID++;
-
-                int i = use16Bit ? 0 : 1;
-                (doesTransformFlip(transform)) ? drawClockwiseMeshes[i].push_back(draw) : drawCounterClockwiseMeshes[i].push_back(draw);
+                draw.StartInstanceLocation = draws[i].firstInstance;
             }
-
-            createDrawBuffer(drawClockwiseMeshes[0], false, ResourceFormat::R16Uint);
-            createDrawBuffer(drawClockwiseMeshes[1], false, ResourceFormat::R32Uint);
-            createDrawBuffer(drawCounterClockwiseMeshes[0], true, ResourceFormat::R16Uint);
-            createDrawBuffer(drawCounterClockwiseMeshes[1], true, ResourceFormat::R32Uint);
+            argSize = sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+            pContext->updateBuffer(mpDrawBuffer.get(), drawArgs.data(), 0, drawArgs.size() * argSize);
         }
         else
         {
-            std::vector<D3D12_DRAW_ARGUMENTS> drawClockwiseMeshes, drawCounterClockwiseMeshes;
-
-            uint32_t instanceID = 0;
-            for (const auto& instance : mMeshInstanceData)
+            std::vector<D3D12_DRAW_ARGUMENTS> drawArgs(draws.size());
+            for (size_t i = 0; i < draws.size(); i++)
             {
-                const auto& mesh = mMeshDesc[instance.meshID];
-                const auto& transform = matrices[instance.globalMatrixID];
-                assert(mesh.indexCount == 0);
+                const auto& mesh = mMeshDesc[draws[i].meshID];
 
-                D3D12_DRAW_ARGUMENTS draw;
+                auto& draw = drawArgs[i];
                 draw.VertexCountPerInstance = mesh.vertexCount;
-                draw.InstanceCount = 1;
+                draw.InstanceCount = draws[i].instanceCount;
                 draw.StartVertexLocation = mesh.vbOffset;
-                draw.StartInstanceLocation = instanceID++;
-
-                (doesTransformFlip(transform)) ? drawClockwiseMeshes.push_back(draw) : drawCounterClockwiseMeshes.push_back(draw);
+                draw.StartInstanceLocation = draws[i].firstInstance;
             }
+            argSize = sizeof(D3D12_DRAW_ARGUMENTS);
+            pContext->updateBuffer(mpDrawBuffer.get(), drawArgs.data(), 0, drawArgs.size() * argSize);
+        }
 
-            createDrawBuffer(drawClockwiseMeshes, false);
-            createDrawBuffer(drawCounterClockwiseMeshes, true);
+        mDrawArgs.clear();
+        for (size_t i = 0; i < draws.size(); i++)
+        {
+            if (i == 0 || draws[i].bucket != draws[i - 1].bucket)
+            {
+                DrawArgs draw;
+                draw.offset = i * argSize;
+                draw.ccw = (draws[i].bucket & 2) != 0;
+                draw.ibFormat = isIndexed ? ((draws[i].bucket & 1) ? ResourceFormat::R32Uint : ResourceFormat::R16Uint) : ResourceFormat::Unknown;
+                mDrawArgs.push_back(draw);
+            }
+            mDrawArgs.back().count++;
         }
+
+        auto& s = mSceneStats;
+        s.drawInstanceCount = mMeshInstanceData.size();
+        s.drawCount = draws.size();
+        s.drawCallCount = mDrawArgs.size();
+        s.drawListSortTime = mDrawListBuilder.getStats().sortTime;
+    }
+
+    void Scene::setDrawListDepthSortEnabled(bool enabled)
+    {
+        if (enabled == isDrawListDepthSortEnabled()) return;
+        mDrawListBuilder.setDepthSortEnabled(enabled);
+        mRebuildDrawList = true;
     }
 
     void Scene::initGeomDesc(RenderContext* pContext)
@@ -1585,8 +1711,9 @@ namespace Falcor
             // For all other BLASes, compaction just adds overhead.
             // TODO: Add compaction on/off switch for profiling.
             // TODO: Disable compaction for skinned meshes if update performance becomes a problem.
+            // With quality tracking enabled, refitted BLASes may be rebuilt in-place and can't be compacted either.
             blas.updateMode = mBlasUpdateMode;
-            blas.useCompaction = !blas.hasSkinnedMesh || blas.updateMode != UpdateMode::Rebuild;
+            blas.useCompaction = !blas.hasSkinnedMesh || (blas.updateMode != UpdateMode::Rebuild && !mpBVHQualityTracker);
 
             // Setup build parameters.
             D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& inputs = blas.buildInputs;
@@ -1873,6 +2000,7 @@ namespace Falcor
             if (!mHasSkinnedMesh) mpBlasScratch.reset();
 
             updateRaytracingBLASStats();
+            if (mpBVHQualityTracker) mpBVHQualityTracker->reset();
             mRebuildBlas = false;
         }
 
@@ -1905,7 +2033,15 @@ namespace Falcor
                 asDesc.ScratchAccelerationStructureData = mpBlasScratch->getGpuAddress() + blas.scratchByteOffset;
                 asDesc.DestAccelerationStructureData = pBlas->getGpuAddress() + blas.blasByteOffset;
 
-                if (blas.updateMode == UpdateMode::Refit)
+                // Rebuild refitted BLASes that the quality tracker deems too degraded.
+                bool refit = blas.updateMode == UpdateMode::Refit;
+                if (refit && mpBVHQualityTracker && mpBVHQualityTracker->isRebuildRecommended(blasId))
+                {
+                    mpBVHQualityTracker->notifyRebuilt(blasId);
+                    refit = false;
+                }
+
+                if (refit)
                 {
                     // Set source address to destination address to update in place.
                     asDesc.SourceAccelerationStructureData = asDesc.DestAccelerationStructureData;
@@ -2264,6 +2400,98 @@ namespace Falcor
         }
     }
 
+    uint3 Scene::getMeshTriangleIndices(uint32_t meshInstanceID, uint32_t triangleIndex) const
+    {
+        const MeshInstanceData& instance = mMeshInstanceData[meshInstanceID];
+        uint3 vtxIndices = uint3(triangleIndex * 3) + uint3(0, 1, 2);
+        if (mMeshDesc[instance.meshID].indexCount > 0)
+        {
+            if (instance.flags & (uint32_t)MeshInstanceFlags::Use16BitIndices)
+            {
+                const uint16_t* pIndices = reinterpret_cast<const uint16_t*>(mCPUIndexData.data() + instance.ibOffset) + triangleIndex * 3;
+                vtxIndices = uint3(pIndices[0], pIndices[1], pIndices[2]);
+            }
+            else
+            {
+                const uint32_t* pIndices = mCPUIndexData.data() + instance.ibOffset + triangleIndex * 3;
+                vtxIndices = uint3(pIndices[0], pIndices[1], pIndices[2]);
+            }
+        }
+        return vtxIndices + instance.vbOffset;
+    }
+
+    void Scene::buildCPUBVH(const CPUBVH::BuildOptions& options)
+    {
+        if (!mMeshInstanceData.empty() && mCPUStaticVertexData.empty())
+        {
+            throw std::exception("Scene::buildCPUBVH() - The scene has no CPU geometry. Build the scene with SceneBuilder::Flags::KeepCPUGeometry.");
+        }
+
+        // Compute the triangle offset of each mesh instance.
+        // Skinned meshes are only available in their animated state on the GPU.
+        mCPUBVHTriangleOffsets.assign(getMeshInstanceCount() + 1, 0);
+        for (uint32_t instanceID = 0; instanceID < getMeshInstanceCount(); instanceID++)
+        {
+            const MeshInstanceData& instance = mMeshInstanceData[instanceID];
+            uint32_t triangleCount = instance.hasDynamicData() ? 0 : mMeshDesc[instance.meshID].getTriangleCount();
+            mCPUBVHTriangleOffsets[instanceID + 1] = mCPUBVHTriangleOffsets[instanceID] + triangleCount;
+        }
+
+        // Transform the triangles to world space in parallel.
+        const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+        std::vector<float3> vertices((size_t)mCPUBVHTriangleOffsets.back() * 3);
+        NumericRange<uint32_t> instanceRange(0, getMeshInstanceCount());
+        std::for_each(std::execution::par, instanceRange.begin(), instanceRange.end(), [&] (uint32_t instanceID)
+        {
+            const MeshInstanceData& instance = mMeshInstanceData[instanceID];
+            const glm::mat4& worldMat = globalMatrices[instance.globalMatrixID];
+            const uint32_t firstTriangle = mCPUBVHTriangleOffsets[instanceID];
+            for (uint32_t triangleIndex = 0; triangleIndex < mCPUBVHTriangleOffsets[instanceID + 1] - firstTriangle; triangleIndex++)
+            {
+                const uint3 vtxIndices = getMeshTriangleIndices(instanceID, triangleIndex);
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    vertices[(size_t)(firstTriangle + triangleIndex) * 3 + j] = float3(worldMat * float4(mCPUStaticVertexData[vtxIndices[j]].position, 1.f));
+                }
+            }
+        });
+
+        mpCPUBVH = CPUBVH::create(vertices, options);
+    }
+
+    Scene::CPUHit Scene::castRayCPU(const CPUBVH::Ray& ray) const
+    {
+        if (!mpCPUBVH) throw std::exception("Scene::castRayCPU() - The CPU BVH has not been built. Call buildCPUBVH() first.");
+
+        CPUBVH::Hit hit;
+        mpCPUBVH->intersect(ray, hit);
+        return createCPUHit(mCPUBVHTriangleOffsets, hit);
+    }
+
+    std::vector<Scene::CPUHit> Scene::castRaysCPU(const std::vector<CPUBVH::Ray>& rays) const
+    {
+        if (!mpCPUBVH) throw std::exception("Scene::castRaysCPU() - The CPU BVH has not been built. Call buildCPUBVH() first.");
+
+        std::vector<CPUHit> hits(rays.size());
+        const uint32_t packetCount = (uint32_t)((rays.size() + CPUBVH::kPacketSize - 1) / CPUBVH::kPacketSize);
+        NumericRange<uint32_t> packetRange(0, packetCount);
+        std::for_each(std::execution::par, packetRange.begin(), packetRange.end(), [&] (uint32_t packetIndex)
+        {
+            const uint32_t first = packetIndex * CPUBVH::kPacketSize;
+            const uint32_t rayCount = std::min(CPUBVH::kPacketSize, (uint32_t)rays.size() - first);
+            CPUBVH::Hit packetHits[CPUBVH::kPacketSize];
+            mpCPUBVH->intersectPacket(&rays[first], packetHits, rayCount);
+            for (uint32_t i = 0; i < rayCount; i++) hits[first + i] = createCPUHit(mCPUBVHTriangleOffsets, packetHits[i]);
+        });
+        return hits;
+    }
+
+    bool Scene::isOccludedCPU(const CPUBVH::Ray& ray) const
+    {
+        if (!mpCPUBVH) throw std::exception("Scene::isOccludedCPU() - The CPU BVH has not been built. Call buildCPUBVH() first.");
+        return mpCPUBVH->isOccluded(ray);
+    }
+
     void Scene::setEnvMap(EnvMap::SharedPtr pEnvMap)
     {
         if (mpEnvMap == pEnvMap) return;
@@ -2439,11 +2667,29 @@ namespace Falcor
         d["gridVoxelCount"] = gridVoxelCount;
         d["gridMemoryInBytes"] = gridMemoryInBytes;
 
+        // Draw list stats
+        d["drawInstanceCount"] = drawInstanceCount;
+        d["drawCount"] = drawCount;
+        d["drawCallCount"] = drawCallCount;
+        d["drawListSortTime"] = drawListSortTime;
+
+        return d;
+    }
+
+    pybind11::dict Scene::CPUHit::toPython() const
+    {
+        pybind11::dict d;
+        d["meshInstanceID"] = meshInstanceID;
+        d["primitiveIndex"] = primitiveIndex;
+        d["t"] = t;
+        d["barycentrics"] = barycentrics;
         return d;
     }
 
     SCRIPT_BINDING(Scene)
     {
+        SCRIPT_BINDING_DEPENDENCY(CPUBVH)
+
         pybind11::class_<Scene, Scene::SharedPtr> scene(m, "Scene");
         scene.def_property_readonly(kStats.c_str(), [] (const Scene* pScene) { return pScene->getSceneStats().toPython(); });
         scene.def_property_readonly(kBounds.c_str(), &Scene::getSceneBounds, pybind11::return_value_policy::copy);
@@ -2458,6 +2704,8 @@ namespace Falcor
         scene.def_property(kAnimated.c_str(), &Scene::isAnimated, &Scene::setIsAnimated);
         scene.def_property(kLoopAnimations.c_str(), &Scene::isLooped, &Scene::setIsLooped);
         scene.def_property(kRenderSettings.c_str(), pybind11::overload_cast<void>(&Scene::getRenderSettings, pybind11::const_), &Scene::setRenderSettings);
+        scene.def_property(kBVHQualityTracking.c_str(), &Scene::isBVHQualityTrackingEnabled, &Scene::setBVHQualityTrackingEnabled);
+        scene.def_property(kDrawListDepthSort.c_str(), &Scene::isDrawListDepthSortEnabled, &Scene::setDrawListDepthSortEnabled);
 
         scene.def(kSetEnvMap.c_str(), &Scene::loadEnvMap, "filename"_a);
         scene.def(kGetLight.c_str(), &Scene::getLight, "index"_a);
@@ -2473,6 +2721,21 @@ namespace Falcor
         scene.def(kRemoveViewpoint.c_str(), &Scene::removeViewpoint); // remove the selected viewpoint
         scene.def(kSelectViewpoint.c_str(), &Scene::selectViewpoint, "index"_a); // select a viewpoint by index
 
+        // CPU ray queries
+        scene.def(kBuildCPUBVH.c_str(), &Scene::buildCPUBVH, "options"_a = CPUBVH::BuildOptions());
+        scene.def_property_readonly(kCPUBVH.c_str(), &Scene::getCPUBVH);
+        auto castRay = [] (const Scene* pScene, const float3& origin, const float3& dir, float tMax) -> pybind11::object
+        {
+            CPUBVH::Ray ray;
+            ray.origin = origin;
+            ray.dir = dir;
+            ray.tMax = tMax;
+            Scene::CPUHit hit = pScene->castRayCPU(ray);
+            if (!hit.isValid()) return pybind11::none();
+            return hit.toPython();
+        };
+        scene.def(kCastRay.c_str(), castRay, "origin"_a, "dir"_a, "tMax"_a = std::numeric_limits<float>::max());
+
         // RenderSettings
         ScriptBindings::SerializableStruct<Scene::RenderSettings> renderSettings(m, "SceneRenderSettings");
 #define field(f_) field(#f_, &Scene::RenderSettings::f_)
@@ -40,6 +40,9 @@
 #include "Experimental/Scene/Lights/EnvMap.h"
 #include "SceneTypes.slang"
 #include "HitInfo.h"
+#include "DrawListBuilder.h"
+#include "CPU/CPUBVH.h"
+#include "CPU/BVHQualityTracker.h"
 
 // Indicating the implementation of curve back-face culling is in anyhit shaders or intersection shaders.
 // Currently, the performance numbers on BabyCheetah scene with 20 indirect bounces are 77ms (with anyhit) and 73ms (without anyhit).
@@ -239,6 +242,12 @@ namespace Falcor
             uint64_t gridVoxelCount = 0;            ///< Total number of voxels in all grids.
             uint64_t gridMemoryInBytes = 0;         ///< Total memory in bytes used by the grids.
 
+            // Draw list stats
+            uint64_t drawInstanceCount = 0;         ///< Number of mesh instances in the draw list.
+            uint64_t drawCount = 0;                 ///< Number of indirect draws after merging instances of the same mesh.
+            uint64_t drawCallCount = 0;             ///< Number of indirect draw calls issued when rasterizing the scene.
+            double drawListSortTime = 0.0;          ///< Time spent sorting the draw list in its last update in ms.
+
             /** Get the total memory usage.
             */
             uint64_t getTotalMemory() const
@@ -382,6 +391,26 @@ namespace Falcor
         */
         const MeshInstanceData& getMeshInstance(uint32_t instanceID) const { return mMeshInstanceData[instanceID]; }
 
+        /** Get a CPU copy of the global index buffer.
+            The copy is kept if the scene was built with SceneBuilder::Flags::KeepCPUGeometry. Scenes with emissive materials
+            also keep it until the light collection is built, which extracts the emissive triangles from it on the CPU. Otherwise it is empty.
+        */
+        const std::vector<uint32_t>& getMeshIndexData() const { return mCPUIndexData; }
+
+        /** Get a CPU copy of the global static vertex buffer.
+            The copy is kept if the scene was built with SceneBuilder::Flags::KeepCPUGeometry. Scenes with emissive materials
+            also keep it until the light collection is built, which extracts the emissive triangles from it on the CPU. Otherwise it is empty.
+        */
+        const std::vector<PackedStaticVertexData>& getMeshStaticData() const { return mCPUStaticVertexData; }
+
+        /** Get the vertex indices of a triangle of a mesh instance, same as Scene::getIndices() on the GPU.
+            The indices refer to the CPU copy of the global static vertex buffer, see getMeshStaticData().
+            \param[in] meshInstanceID Mesh instance ID.
+            \param[in] triangleIndex Triangle index within the mesh.
+            \return Vertex indices.
+        */
+        uint3 getMeshTriangleIndices(uint32_t meshInstanceID, uint32_t triangleIndex) const;
+
         /** Get a curve desc.
         */
         const CurveDesc& getCurve(uint32_t curveID) const { return mCurveDesc[curveID]; }
@@ -438,6 +467,49 @@ namespace Falcor
         */
         const AABB& getCurveBounds(uint32_t curveID) const { return mCurveBBs[curveID]; }
 
+        /** Triangle hit found by a ray query on the CPU.
+        */
+        struct CPUHit
+        {
+            uint32_t meshInstanceID = CPUBVH::kInvalidIndex;
+            uint32_t primitiveIndex = CPUBVH::kInvalidIndex;    ///< Triangle index within the mesh.
+            float t = 0.f;                                      ///< Hit distance along the ray.
+            float2 barycentrics = float2(0.f);                  ///< Barycentrics of vertices 1 and 2 of the triangle.
+
+            bool isValid() const { return meshInstanceID != CPUBVH::kInvalidIndex; }
+            pybind11::dict toPython() const;
+        };
+
+        /** Build a BVH over the triangles of all mesh instances for ray queries on the CPU, such as picking.
+            The scene needs to be built with SceneBuilder::Flags::KeepCPUGeometry. Skinned meshes are ignored.
+            The BVH uses the current transforms of the mesh instances and needs to be rebuilt after they change.
+            \param[in] options BVH build options.
+        */
+        void buildCPUBVH(const CPUBVH::BuildOptions& options = CPUBVH::BuildOptions());
+
+        /** Get the CPU BVH, or nullptr if buildCPUBVH() has not been called.
+        */
+        const CPUBVH::SharedPtr& getCPUBVH() const { return mpCPUBVH; }
+
+        /** Find the closest triangle hit along a ray using the CPU BVH.
+            \param[in] ray Ray, the hit distance is limited to [tMin, tMax].
+            \return The closest hit. The hit is invalid if no triangle was hit.
+        */
+        CPUHit castRayCPU(const CPUBVH::Ray& ray) const;
+
+        /** Find the closest triangle hits for a list of rays using the CPU BVH.
+            The rays are traced in parallel, in packets of consecutive rays. Coherent rays should therefore be stored next to each other.
+            \param[in] rays Rays, the hit distances are limited to [tMin, tMax].
+            \return The closest hit per ray.
+        */
+        std::vector<CPUHit> castRaysCPU(const std::vector<CPUBVH::Ray>& rays) const;
+
+        /** Test if any triangle is hit along a ray using the CPU BVH.
+            \param[in] ray Ray, the hit distance is limited to [tMin, tMax].
+            \return True if a triangle was hit.
+        */
+        bool isOccludedCPU(const CPUBVH::Ray& ray) const;
+
         /** Get a list of all lights in the scene.
         */
         const std::vector<Light::SharedPtr>& getLights() { return mLights; };
@@ -484,6 +556,30 @@ namespace Falcor
         */
         UpdateMode getBlasUpdateMode() { return mBlasUpdateMode; }
 
+        /** Enable/disable tracking of the BLAS quality on the CPU.
+            When enabled, BLASes with skinned meshes that are refitted (UpdateMode::Refit) are rebuilt instead
+            whenever the tracker estimates that refitting has degraded them too much. See BVHQualityTracker.
+            Changing this setting causes the BLASes to be rebuilt, since such BLASes are then not compacted.
+        */
+        void setBVHQualityTrackingEnabled(bool enabled);
+
+        /** Check if BLAS quality tracking is enabled.
+        */
+        bool isBVHQualityTrackingEnabled() const { return mpBVHQualityTracker != nullptr; }
+
+        /** Get the BLAS quality tracker, or nullptr if tracking is disabled.
+        */
+        const BVHQualityTracker::SharedPtr& getBVHQualityTracker() const { return mpBVHQualityTracker; }
+
+        /** Enable/disable sorting the draw list front-to-back.
+            When enabled (default), the draw list is re-sorted whenever the camera moves. The draws are always sorted by material and mesh.
+        */
+        void setDrawListDepthSortEnabled(bool enabled);
+
+        /** Check if the draw list is sorted front-to-back.
+        */
+        bool isDrawListDepthSortEnabled() const { return mDrawListBuilder.isDepthSortEnabled(); }
+
         /** Update the scene. Call this once per frame to update the camera location, animations, etc.
             \param pContext
             \param currentTime The current time in seconds
@@ -615,6 +711,7 @@ namespace Falcor
     private:
         friend class SceneBuilder;
         friend class AnimationController;
+        friend class BVHQualityTracker;
 
         static constexpr uint32_t kStaticDataBufferIndex = 0;
         static constexpr uint32_t kDrawIdBufferIndex = kStaticDataBufferIndex + 1;
@@ -662,6 +759,11 @@ namespace Falcor
         */
         void createDrawList();
 
+        /** Sort the mesh instances and update the draw-indirect arguments and draw IDs.
+            Instances are sorted by winding, index format, material, mesh and depth, and instances of the same mesh are merged into instanced draws.
+        */
+        void updateDrawList(RenderContext* pContext);
+
         /** Initialize geometry descs for each BLAS.
         */
         void initGeomDesc(RenderContext* pContext);
@@ -723,7 +825,7 @@ namespace Falcor
 
         struct DrawArgs
         {
-            Buffer::SharedPtr pBuffer;      ///< Buffer holding the draw-indirect arguments.
+            uint64_t offset = 0;            ///< Offset in bytes of the first draw in the draw-indirect buffer.
             uint32_t count = 0;             ///< Number of draws.
             bool ccw = true;                ///< True if counterclockwise triangle winding.
             ResourceFormat ibFormat = ResourceFormat::Unknown;  ///< Index buffer format.
@@ -753,6 +855,10 @@ namespace Falcor
         Vao::SharedPtr mpVao;                                       ///< Vertex array object for the global vertex/index buffers.
         Vao::SharedPtr mpVao16Bit;                                  ///< VAO for drawing meshes with 16-bit vertex indices.
         std::vector<DrawArgs> mDrawArgs;                            ///< List of draw arguments for rasterizing the scene.
+        Buffer::SharedPtr mpDrawBuffer;                             ///< Buffer holding the draw-indirect arguments of all draws.
+        DrawListBuilder mDrawListBuilder;                           ///< Sorts the mesh instances and merges them into instanced draws.
+        std::vector<DrawListBuilder::Item> mDrawItems;              ///< Draw list items, one per mesh instance.
+        bool mRebuildDrawList = false;                              ///< True if the draw list needs to be updated, even if nothing moved.
 
         Vao::SharedPtr mpCurveVao;                                  ///< Vertex array object for the global curve vertex/index buffers.
 
@@ -799,6 +905,11 @@ namespace Falcor
         HitInfo mHitInfo;                                           ///< Geometry hit info requirements.
         AABB mSceneBB;                                              ///< Bounding boxes of the entire scene in world space.
         std::vector<bool> mMeshHasDynamicData;                      ///< Whether a Mesh has dynamic data, meaning it is skinned.
+        std::vector<uint32_t> mCPUIndexData;                        ///< Copy of the global index buffer (only for KeepCPUGeometry, or for scenes with emissive materials until the light collection is built).
+        std::vector<PackedStaticVertexData> mCPUStaticVertexData;   ///< Copy of the global static vertex buffer (only for KeepCPUGeometry, or for scenes with emissive materials until the light collection is built).
+        bool mKeepCPUGeometry = false;                              ///< Keep the CPU geometry after the light collection is built (SceneBuilder::Flags::KeepCPUGeometry).
+        CPUBVH::SharedPtr mpCPUBVH;                                 ///< BVH for ray queries on the CPU, built on request.
+        std::vector<uint32_t> mCPUBVHTriangleOffsets;               ///< Offset of the first triangle of each mesh instance in the CPU BVH, and the total triangle count.
         SceneStats mSceneStats;                                     ///< Scene statistics.
         RenderSettings mRenderSettings;                             ///< Render settings.
         RenderSettings mPrevRenderSettings;
@@ -902,6 +1013,7 @@ namespace Falcor
         Buffer::SharedPtr mpBlasStaticWorldMatrices;        ///< Object-to-world transform matrices in row-major format. Only valid for static meshes.
         bool mRebuildBlas = true;                           ///< Flag to indicate BLASes need to be rebuilt.
         bool mHasSkinnedMesh = false;                       ///< Whether the scene has a skinned mesh at all.
+        BVHQualityTracker::SharedPtr mpBVHQualityTracker;   ///< Tracks the quality of refitted BLASes. Only created if enabled.
 
         std::string mFilename;
     };
@@ -242,6 +242,16 @@ namespace Falcor
 
         mpScene->mpAnimationController = AnimationController::create(mpScene.get(), mBuffersData.staticData, mBuffersData.dynamicData, mAnimations);
 
+        // Hand the global mesh data over to the scene if there are emissive materials or if it was requested.
+        // The light collection extracts the emissive triangles from it on the CPU. Unless requested, the scene releases it once the light collection is built.
+        mpScene->mKeepCPUGeometry = is_set(mFlags, Flags::KeepCPUGeometry);
+        if (is_set(mFlags, Flags::KeepCPUGeometry) ||
+            std::any_of(mMaterials.begin(), mMaterials.end(), [] (const Material::SharedPtr& pMaterial) { return pMaterial->isEmissive(); }))
+        {
+            mpScene->mCPUIndexData = std::move(mBuffersData.indexData);
+            mpScene->mCPUStaticVertexData = std::move(mBuffersData.staticData);
+        }
+
         // Finalize the scene object. This is where the final setup is done.
         mpScene->finalize();
 
@@ -493,6 +503,23 @@ namespace Falcor
     }
 
     uint32_t SceneBuilder::addProcessedMesh(const ProcessedMesh& mesh)
+    {
+        return addProcessedMesh(ProcessedMesh(mesh));
+    }
+
+    std::vector<uint32_t> SceneBuilder::addProcessedMeshes(std::vector<ProcessedMesh>&& meshes)
+    {
+        std::vector<uint32_t> meshIDs;
+        meshIDs.reserve(meshes.size());
+        mMeshes.reserve(mMeshes.size() + meshes.size());
+
+        for (auto& mesh : meshes) meshIDs.push_back(addProcessedMesh(std::move(mesh)));
+        meshes.clear();
+
+        return meshIDs;
+    }
+
+    uint32_t SceneBuilder::addProcessedMesh(ProcessedMesh&& mesh)
     {
         const bool isIndexed = !is_set(mFlags, Flags::NonIndexedVertices);
 
@@ -523,7 +550,7 @@ namespace Falcor
             spec.hasDynamicData = true;
         }
 
-        mMeshes.push_back(spec);
+        mMeshes.push_back(std::move(spec));
 
         if (mMeshes.size() > std::numeric_limits<uint32_t>::max())
         {
@@ -677,7 +704,7 @@ namespace Falcor
 
     void SceneBuilder::loadMaterialTexture(const Material::SharedPtr& pMaterial, Material::TextureSlot slot, const std::string& filename)
     {
-        if (!mpMaterialTextureLoader) mpMaterialTextureLoader.reset(new MaterialTextureLoader(!is_set(mFlags, Flags::AssumeLinearSpaceTextures)));
+        if (!mpMaterialTextureLoader) mpMaterialTextureLoader.reset(new MaterialTextureLoader(!is_set(mFlags, Flags::AssumeLinearSpaceTextures), is_set(mFlags, Flags::CacheTextureMips)));
         mpMaterialTextureLoader->loadTexture(pMaterial, slot, filename);
     }
 
@@ -2006,6 +2033,8 @@ namespace Falcor
         flags.value("Force32BitIndices", SceneBuilder::Flags::Force32BitIndices);
         flags.value("RTDontMergeStatic", SceneBuilder::Flags::RTDontMergeStatic);
         flags.value("RTDontMergeDynamic", SceneBuilder::Flags::RTDontMergeDynamic);
+        flags.value("CacheTextureMips", SceneBuilder::Flags::CacheTextureMips);
+        flags.value("KeepCPUGeometry", SceneBuilder::Flags::KeepCPUGeometry);
         ScriptBindings::addEnumBinaryOperators(flags);
 
         pybind11::class_<SceneBuilder, SceneBuilder::SharedPtr> sceneBuilder(m, "SceneBuilder");
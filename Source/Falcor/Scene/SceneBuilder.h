@@ -61,6 +61,8 @@ namespace Falcor
             Force32BitIndices           = 0x80,   ///< Force 32-bit indices for all meshes. By default, 16-bit indices are used for small meshes.
             RTDontMergeStatic           = 0x100,  ///< For raytracing, don't merge all static meshes into single pre-transformed BLAS.
             RTDontMergeDynamic          = 0x200,  ///< For raytracing, don't merge all dynamic meshes with identical transforms into single BLAS.
+            CacheTextureMips            = 0x400,  ///< Cache the mip chains of material textures as DDS files next to the source images. Subsequent loads skip mip generation.
+            KeepCPUGeometry             = 0x800,  ///< Keep a CPU copy of the global index and static vertex buffers in the scene. Required for ray tracing the scene on the CPU.
 
             Default = None
         };
@@ -317,6 +319,19 @@ namespace Falcor
         */
         uint32_t addProcessedMesh(const ProcessedMesh& mesh);
 
+        /** Add a pre-processed mesh. The mesh data is moved into the builder instead of being copied.
+            \param mesh The pre-processed mesh.
+            \return The ID of the mesh in the scene. Note that all of the instances share the same mesh ID.
+        */
+        uint32_t addProcessedMesh(ProcessedMesh&& mesh);
+
+        /** Add a batch of pre-processed meshes. The mesh data is moved into the builder instead of being copied.
+            Use this to add meshes that were processed in parallel, in a deterministic order.
+            \param meshes The pre-processed meshes.
+            \return The IDs of the meshes in the scene, in the same order as the input.
+        */
+        std::vector<uint32_t> addProcessedMeshes(std::vector<ProcessedMesh>&& meshes);
+
         // Procedural primitives, including custom primitives, curves, etc.
 
         // Custom primitives
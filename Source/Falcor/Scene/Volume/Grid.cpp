@@ -32,6 +32,7 @@
 #include <nanovdb/util/GridStats.h>
 #include <nanovdb/util/GridBuilder.h>
 #include <nanovdb/util/OpenToNanoVDB.h>
+#include <nanovdb/util/NanoToOpenVDB.h>
 #include <openvdb/openvdb.h>
 #pragma warning(default:4146 4244 4267 4275 4996)
 
@@ -53,6 +54,68 @@ namespace Falcor
         {
             return int3(c[0], c[1], c[2]);
         }
+
+        const Gui::DropdownList kQuantizationList =
+        {
+            { (uint32_t)Grid::Quantization::Float, "Float" },
+            { (uint32_t)Grid::Quantization::Fp4, "Fp4" },
+            { (uint32_t)Grid::Quantization::Fp8, "Fp8" },
+            { (uint32_t)Grid::Quantization::Fp16, "Fp16" },
+            { (uint32_t)Grid::Quantization::FpN, "FpN" },
+        };
+
+        bool isSupportedGridType(nanovdb::GridType gridType)
+        {
+            switch (gridType)
+            {
+            case nanovdb::GridType::Float:
+            case nanovdb::GridType::Fp4:
+            case nanovdb::GridType::Fp8:
+            case nanovdb::GridType::Fp16:
+            case nanovdb::GridType::FpN:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /** Convert an OpenVDB float grid to a NanoVDB grid with the given storage format.
+            The NanoVDB converter processes the tree in parallel.
+        */
+        nanovdb::GridHandle<nanovdb::HostBuffer> convertToNanoVDB(const openvdb::FloatGrid& grid, Grid::Quantization quantization, float tolerance)
+        {
+            switch (quantization)
+            {
+            case Grid::Quantization::Fp4:
+                return nanovdb::openToNanoVDB<nanovdb::HostBuffer, openvdb::FloatTree, nanovdb::Fp4>(grid);
+            case Grid::Quantization::Fp8:
+                return nanovdb::openToNanoVDB<nanovdb::HostBuffer, openvdb::FloatTree, nanovdb::Fp8>(grid);
+            case Grid::Quantization::Fp16:
+                return nanovdb::openToNanoVDB<nanovdb::HostBuffer, openvdb::FloatTree, nanovdb::Fp16>(grid);
+            case Grid::Quantization::FpN:
+            {
+                nanovdb::OpenToNanoVDB<float, nanovdb::FpN, nanovdb::AbsDiff> converter;
+                if (tolerance > 0.f) converter.oracle() = nanovdb::AbsDiff(tolerance);
+                return converter(grid);
+            }
+            default:
+                return nanovdb::openToNanoVDB<nanovdb::HostBuffer, openvdb::FloatTree, float>(grid);
+            }
+        }
+
+        /** Convert a NanoVDB float grid to a different storage format, going through OpenVDB.
+        */
+        nanovdb::GridHandle<nanovdb::HostBuffer> quantizeNanoVDB(const nanovdb::GridHandle<nanovdb::HostBuffer>& handle, Grid::Quantization quantization, float tolerance)
+        {
+            openvdb::initialize();
+            auto floatGrid = openvdb::gridPtrCast<openvdb::FloatGrid>(nanovdb::nanoToOpenVDB(handle));
+            if (!floatGrid)
+            {
+                logWarning("Error when quantizing grid. Failed to convert grid to OpenVDB.");
+                return {};
+            }
+            return convertToNanoVDB(*floatGrid, quantization, tolerance);
+        }
     }
 
     Grid::SharedPtr Grid::createSphere(float radius, float voxelSize, float blendRange)
@@ -67,7 +130,7 @@ namespace Falcor
         return SharedPtr(new Grid(std::move(handle)));
     }
 
-    Grid::SharedPtr Grid::createFromFile(const std::string& filename, const std::string& gridname)
+    Grid::SharedPtr Grid::createFromFile(const std::string& filename, const std::string& gridname, Quantization quantization, float tolerance)
     {
         std::string fullpath;
         if (!findFileInDataDirectories(filename, fullpath))
@@ -76,20 +139,20 @@ namespace Falcor
             return nullptr;
         }
 
-        auto ext = getExtensionFromFile(fullpath);
-        if (ext == "nvdb")
-        {
-            return createFromNanoVDBFile(fullpath, gridname);
-        }
-        else if (ext == "vdb")
-        {
-            return createFromOpenVDBFile(fullpath, gridname);
-        }
-        else
+        auto handle = loadGridHandle(fullpath, gridname, quantization, tolerance);
+        return handle ? SharedPtr(new Grid(std::move(handle))) : nullptr;
+    }
+
+    Grid::SharedPtr Grid::createQuantized(const SharedPtr& pGrid, Quantization quantization, float tolerance)
+    {
+        if (!pGrid || pGrid->getQuantization() != Quantization::Float)
         {
-            logWarning("Error when loading grid. Unsupported grid file '" + filename + "'");
+            logWarning("Error when quantizing grid. Only grids stored as 32-bit floats can be quantized.");
             return nullptr;
         }
+
+        auto handle = quantizeNanoVDB(pGrid->mGridHandle, quantization, tolerance);
+        return handle ? SharedPtr(new Grid(std::move(handle))) : nullptr;
     }
 
     void Grid::renderUI(Gui::Widgets& widget)
@@ -100,38 +163,43 @@ namespace Falcor
             << "Maximum index: " << to_string(getMaxIndex()) << std::endl
             << "Minimum value: " << getMinValue() << std::endl
             << "Maximum value: " << getMaxValue() << std::endl
-            << "Memory: " << formatByteSize(getGridSizeInBytes()) << std::endl;
+            << "Memory: " << formatByteSize(getGridSizeInBytes()) << " (" << kQuantizationList[(uint32_t)getQuantization()].label << ")" << std::endl
+            << "Majorant grid: " << to_string(mpMajorantGrid->getDimensions()) << " bricks, " << mpMajorantGrid->getLevelCount() << " levels" << std::endl
+            << "Majorant grid memory: " << formatByteSize(mpMajorantGrid->getSizeInBytes()) << std::endl;
         widget.text(oss.str());
     }
 
     void Grid::setShaderData(const ShaderVar& var)
     {
         var["buf"] = mpBuffer;
+        var["gridType"] = (uint32_t)mGridType;
+        var["majorants"] = mpMajorantGrid->getTexture();
+        var["majorantOrigin"] = mpMajorantGrid->getOrigin();
     }
 
     int3 Grid::getMinIndex() const
     {
-        return cast(mpFloatGrid->indexBBox().min());
+        return visitGrid([] (const auto& grid) { return cast(grid.indexBBox().min()); });
     }
 
     int3 Grid::getMaxIndex() const
     {
-        return cast(mpFloatGrid->indexBBox().max());
+        return visitGrid([] (const auto& grid) { return cast(grid.indexBBox().max()); });
     }
 
     float Grid::getMinValue() const
     {
-        return mpFloatGrid->tree().root().valueMin();
+        return visitGrid([] (const auto& grid) { return (float)grid.tree().root().valueMin(); });
     }
 
     float Grid::getMaxValue() const
     {
-        return mpFloatGrid->tree().root().valueMax();
+        return visitGrid([] (const auto& grid) { return (float)grid.tree().root().valueMax(); });
     }
 
     uint64_t Grid::getVoxelCount() const
     {
-        return mpFloatGrid->activeVoxelCount();
+        return visitGrid([] (const auto& grid) { return (uint64_t)grid.activeVoxelCount(); });
     }
 
     uint64_t Grid::getGridSizeInBytes() const
@@ -139,15 +207,32 @@ namespace Falcor
         return mpBuffer ? mpBuffer->getSize() : (uint64_t)0;
     }
 
+    Grid::Quantization Grid::getQuantization() const
+    {
+        switch (mGridType)
+        {
+        case nanovdb::GridType::Fp4: return Quantization::Fp4;
+        case nanovdb::GridType::Fp8: return Quantization::Fp8;
+        case nanovdb::GridType::Fp16: return Quantization::Fp16;
+        case nanovdb::GridType::FpN: return Quantization::FpN;
+        default: return Quantization::Float;
+        }
+    }
+
     AABB Grid::getWorldBounds() const
     {
-        auto bounds = mpFloatGrid->worldBBox();
+        auto bounds = visitGrid([] (const auto& grid) { return grid.worldBBox(); });
         return AABB(cast(bounds.min()), cast(bounds.max()));
     }
 
     float Grid::getValue(const int3& ijk) const
     {
-        return mAccessor.getValue(nanovdb::Coord(ijk.x, ijk.y, ijk.z));
+        auto getValue = [&] (const auto& accessor) -> float
+        {
+            if constexpr (std::is_same_v<std::decay_t<decltype(accessor)>, std::monostate>) return 0.f;
+            else return accessor.getValue(nanovdb::Coord(ijk.x, ijk.y, ijk.z));
+        };
+        return std::visit(getValue, mAccessor);
     }
 
     const nanovdb::GridHandle<nanovdb::HostBuffer>& Grid::getGridHandle() const
@@ -155,16 +240,37 @@ namespace Falcor
         return mGridHandle;
     }
 
+    MajorantGrid::CollisionStats Grid::estimateCollisions(uint32_t rayCount, uint32_t level, uint32_t seed) const
+    {
+        return visitGrid([&] (const auto& grid) { return mpMajorantGrid->estimateCollisions(grid, rayCount, level, seed); });
+    }
+
     Grid::Grid(nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle)
         : mGridHandle(std::move(gridHandle))
-        , mpFloatGrid(mGridHandle.grid<float>())
-        , mAccessor(mpFloatGrid->getAccessor())
     {
-        if (!mpFloatGrid->hasMinMax())
+        initGridData();
+    }
+
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::replaceGridHandle(nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle)
+    {
+        assert(gridHandle && gridHandle.gridMetaData() && isSupportedGridType(gridHandle.gridMetaData()->gridType()));
+        std::swap(mGridHandle, gridHandle);
+        initGridData();
+        return gridHandle;
+    }
+
+    void Grid::initGridData()
+    {
+        mGridType = mGridHandle.gridMetaData()->gridType();
+        assert(isSupportedGridType(mGridType));
+
+        if (auto pFloatGrid = mGridHandle.grid<float>(); pFloatGrid && !pFloatGrid->hasMinMax())
         {
-            nanovdb::gridStats(*mpFloatGrid);
+            nanovdb::gridStats(*pFloatGrid);
         }
 
+        mAccessor = visitGrid([] (const auto& grid) { return Accessor(grid.getAccessor()); });
+
         mpBuffer = Buffer::createStructured(
             sizeof(uint32_t),
             uint32_t(div_round_up(mGridHandle.size(), sizeof(uint32_t))),
@@ -172,34 +278,71 @@ namespace Falcor
             Buffer::CpuAccess::None,
             mGridHandle.data()
         );
+
+        mpMajorantGrid = visitGrid([] (const auto& grid) { return MajorantGrid::create(grid); });
     }
 
-    Grid::SharedPtr Grid::createFromNanoVDBFile(const std::string& path, const std::string& gridname)
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::loadGridHandle(const std::string& path, const std::string& gridname, Quantization quantization, float tolerance)
+    {
+        nanovdb::GridHandle<nanovdb::HostBuffer> handle;
+
+        auto ext = getExtensionFromFile(path);
+        if (ext == "nvdb")
+        {
+            handle = loadNanoVDBFile(path, gridname, quantization, tolerance);
+        }
+        else if (ext == "vdb")
+        {
+            handle = loadOpenVDBFile(path, gridname, quantization, tolerance);
+        }
+        else
+        {
+            logWarning("Error when loading grid. Unsupported grid file '" + path + "'");
+        }
+
+        // Compute the statistics here, so that it happens on the loading thread.
+        // Quantized grids always have statistics, as they are needed for the quantization.
+        if (auto pFloatGrid = handle.grid<float>(); pFloatGrid && !pFloatGrid->hasMinMax())
+        {
+            nanovdb::gridStats(*pFloatGrid);
+        }
+
+        return handle;
+    }
+
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::loadNanoVDBFile(const std::string& path, const std::string& gridname, Quantization quantization, float tolerance)
     {
         if (!nanovdb::io::hasGrid(path, gridname))
         {
             logWarning("Error when loading grid. Can't find grid '" + gridname + "' in '" + path + "'");
-            return nullptr;
+            return {};
         }
 
         auto handle = nanovdb::io::readGrid(path, gridname);
         if (!handle)
         {
             logWarning("Error when loading grid.");
-            return nullptr;
+            return {};
         }
 
-        auto floatGrid = handle.grid<float>();
-        if (!floatGrid || floatGrid->gridType() != nanovdb::GridType::Float)
+        auto gridType = handle.gridMetaData()->gridType();
+        if (!isSupportedGridType(gridType))
         {
             logWarning("Error when loading grid. Grid '" + gridname + "' in '" + path + "' is not of type float");
-            return nullptr;
+            return {};
         }
 
-        return SharedPtr(new Grid(std::move(handle)));
+        // Grids stored in a quantized format are used as is.
+        if (gridType != nanovdb::GridType::Float)
+        {
+            if (quantization != Quantization::Float) logWarning("Grid '" + gridname + "' in '" + path + "' is already quantized. Ignoring requested quantization.");
+            return handle;
+        }
+
+        return quantization == Quantization::Float ? std::move(handle) : quantizeNanoVDB(handle, quantization, tolerance);
     }
 
-    Grid::SharedPtr Grid::createFromOpenVDBFile(const std::string& path, const std::string& gridname)
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::loadOpenVDBFile(const std::string& path, const std::string& gridname, Quantization quantization, float tolerance)
     {
         openvdb::initialize();
 
@@ -221,35 +364,50 @@ namespace Falcor
         if (!baseGrid)
         {
             logWarning("Error when loading grid. Can't find grid '" + gridname + "' in '" + path + "'");
-            return nullptr;
+            return {};
         }
 
         if (!baseGrid->isType<openvdb::FloatGrid>())
         {
             logWarning("Error when loading grid. Grid '" + gridname + "' in '" + path + "' is not of type float");
-            return nullptr;
+            return {};
         }
 
         openvdb::FloatGrid::Ptr floatGrid = openvdb::gridPtrCast<openvdb::FloatGrid>(baseGrid);
-        auto handle = nanovdb::openToNanoVDB(floatGrid);
-
-        return SharedPtr(new Grid(std::move(handle)));
+        return convertToNanoVDB(*floatGrid, quantization, tolerance);
     }
 
 
     SCRIPT_BINDING(Grid)
     {
         pybind11::class_<Grid, Grid::SharedPtr> grid(m, "Grid");
+
+        pybind11::enum_<Grid::Quantization> quantization(grid, "Quantization");
+        quantization.value("Float", Grid::Quantization::Float);
+        quantization.value("Fp4", Grid::Quantization::Fp4);
+        quantization.value("Fp8", Grid::Quantization::Fp8);
+        quantization.value("Fp16", Grid::Quantization::Fp16);
+        quantization.value("FpN", Grid::Quantization::FpN);
+
         grid.def_property_readonly("voxelCount", &Grid::getVoxelCount);
         grid.def_property_readonly("minIndex", &Grid::getMinIndex);
         grid.def_property_readonly("maxIndex", &Grid::getMaxIndex);
         grid.def_property_readonly("minValue", &Grid::getMinValue);
         grid.def_property_readonly("maxValue", &Grid::getMaxValue);
+        grid.def_property_readonly("sizeInBytes", &Grid::getGridSizeInBytes);
+        grid.def_property_readonly("quantization", &Grid::getQuantization);
+        grid.def_property_readonly("majorantLevelCount", [] (const Grid& grid) { return grid.getMajorantGrid()->getLevelCount(); });
 
         grid.def("getValue", &Grid::getValue, "ijk"_a);
+        auto estimateCollisions = [] (const Grid& grid, uint32_t rayCount, uint32_t level, uint32_t seed)
+        {
+            return grid.estimateCollisions(rayCount, level, seed).toPython();
+        };
+        grid.def("estimateCollisions", estimateCollisions, "rayCount"_a = 4096, "level"_a = 0, "seed"_a = 0);
 
         grid.def_static("createSphere", &Grid::createSphere, "radius"_a, "voxelSize"_a, "blendRange"_a = 3.f);
         grid.def_static("createBox", &Grid::createBox, "width"_a, "height"_a, "depth"_a, "voxelSize"_a, "blendRange"_a = 3.f);
-        grid.def_static("createFromFile", &Grid::createFromFile, "filename"_a, "gridname"_a);
+        grid.def_static("createFromFile", &Grid::createFromFile, "filename"_a, "gridname"_a, "quantization"_a = Grid::Quantization::Float, "tolerance"_a = 0.f);
+        grid.def_static("createQuantized", &Grid::createQuantized, "grid"_a, "quantization"_a, "tolerance"_a = 0.f);
     }
 }
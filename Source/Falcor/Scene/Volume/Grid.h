@@ -31,6 +31,8 @@
 #include <nanovdb/util/GridHandle.h>
 #include <nanovdb/util/HostBuffer.h>
 #pragma warning(default:4244 4267)
+#include "MajorantGrid.h"
+#include <variant>
 
 namespace Falcor
 {
@@ -41,6 +43,18 @@ namespace Falcor
     public:
         using SharedPtr = std::shared_ptr<Grid>;
 
+        /** Storage format of the grid values, using NanoVDB's quantized grid types.
+            Quantized values are stored per leaf node relative to the leaf's minimum and maximum value.
+        */
+        enum class Quantization
+        {
+            Float,  ///< 32-bit floats (no quantization).
+            Fp4,    ///< 4-bit quantization.
+            Fp8,    ///< 8-bit quantization.
+            Fp16,   ///< 16-bit quantization.
+            FpN,    ///< Variable bit-width per leaf node, chosen to keep the absolute error below a tolerance.
+        };
+
         /** Create a sphere voxel grid.
             \param[in] radius Radius of the sphere in world units.
             \param[in] voxelSize Size of a voxel in world units.
@@ -63,9 +77,19 @@ namespace Falcor
             Currently only OpenVDB and NanoVDB grids of type float are supported.
             \param[in] filename Filename of the grid. Can also include a full path or relative path from a data directory.
             \param[in] gridname Name of the grid to load.
+            \param[in] quantization Storage format to convert the grid to.
+            \param[in] tolerance Absolute error tolerance for Quantization::FpN. If zero, NanoVDB chooses a tolerance based on the grid class.
             \return A new grid, or nullptr if the grid failed to load.
         */
-        static SharedPtr createFromFile(const std::string& filename, const std::string& gridname);
+        static SharedPtr createFromFile(const std::string& filename, const std::string& gridname, Quantization quantization = Quantization::Float, float tolerance = 0.f);
+
+        /** Create a quantized copy of a grid.
+            \param[in] pGrid Grid to convert. Needs to be stored as 32-bit floats.
+            \param[in] quantization Storage format to convert the grid to.
+            \param[in] tolerance Absolute error tolerance for Quantization::FpN. If zero, NanoVDB chooses a tolerance based on the grid class.
+            \return A new grid, or nullptr if the grid cannot be converted.
+        */
+        static SharedPtr createQuantized(const SharedPtr& pGrid, Quantization quantization, float tolerance = 0.f);
 
         /** Render the UI.
         */
@@ -97,9 +121,14 @@ namespace Falcor
         uint64_t getVoxelCount() const;
 
         /** Get the size of the grid in bytes as allocated in GPU memory.
+            This reflects the reduced size of quantized grids.
         */
         uint64_t getGridSizeInBytes() const;
 
+        /** Get the storage format of the grid values.
+        */
+        Quantization getQuantization() const;
+
         /** Get the grid's bounds in world space.
         */
         AABB getWorldBounds() const;
@@ -114,15 +143,69 @@ namespace Falcor
         */
         const nanovdb::GridHandle<nanovdb::HostBuffer>& getGridHandle() const;
 
+        /** Get the majorant grid, storing conservative maximum values per brick of voxels.
+        */
+        const MajorantGrid::SharedPtr& getMajorantGrid() const { return mpMajorantGrid; }
+
+        /** Estimate the expected number of null and real collisions per ray when tracking through the grid,
+            using the global maximum value as majorant compared to using the majorant grid.
+            \param[in] rayCount Number of random rays.
+            \param[in] level Majorant grid level.
+            \param[in] seed Random seed.
+            \return Collision statistics.
+        */
+        MajorantGrid::CollisionStats estimateCollisions(uint32_t rayCount = 4096, uint32_t level = 0, uint32_t seed = 0) const;
+
     private:
+        friend class GridStreamer;
+
         Grid(nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle);
 
-        static SharedPtr createFromNanoVDBFile(const std::string& path, const std::string& gridname);
-        static SharedPtr createFromOpenVDBFile(const std::string& path, const std::string& gridname);
+        /** Load a grid from a file into a host buffer, including grid statistics. This function is thread-safe.
+            \param[in] path Full path of the grid file.
+            \param[in] gridname Name of the grid to load.
+            \param[in] quantization Storage format to convert the grid to.
+            \param[in] tolerance Absolute error tolerance for Quantization::FpN.
+            \return The grid handle, or an empty handle if the grid failed to load.
+        */
+        static nanovdb::GridHandle<nanovdb::HostBuffer> loadGridHandle(const std::string& path, const std::string& gridname, Quantization quantization = Quantization::Float, float tolerance = 0.f);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> loadNanoVDBFile(const std::string& path, const std::string& gridname, Quantization quantization, float tolerance);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> loadOpenVDBFile(const std::string& path, const std::string& gridname, Quantization quantization, float tolerance);
+
+        /** Call a function with the typed NanoVDB grid.
+        */
+        template<typename F>
+        decltype(auto) visitGrid(F&& func) const
+        {
+            switch (mGridType)
+            {
+            case nanovdb::GridType::Fp4: return func(*mGridHandle.grid<nanovdb::Fp4>());
+            case nanovdb::GridType::Fp8: return func(*mGridHandle.grid<nanovdb::Fp8>());
+            case nanovdb::GridType::Fp16: return func(*mGridHandle.grid<nanovdb::Fp16>());
+            case nanovdb::GridType::FpN: return func(*mGridHandle.grid<nanovdb::FpN>());
+            default: return func(*mGridHandle.grid<float>());
+            }
+        }
+
+        /** Replace the grid data, keeping this grid object. Used to stream grid sequences.
+            \param[in] gridHandle The new grid data.
+            \return The previous grid data.
+        */
+        nanovdb::GridHandle<nanovdb::HostBuffer> replaceGridHandle(nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle);
+
+        void initGridData();
+
+        using Accessor = std::variant<std::monostate,
+            nanovdb::NanoGrid<float>::AccessorType,
+            nanovdb::NanoGrid<nanovdb::Fp4>::AccessorType,
+            nanovdb::NanoGrid<nanovdb::Fp8>::AccessorType,
+            nanovdb::NanoGrid<nanovdb::Fp16>::AccessorType,
+            nanovdb::NanoGrid<nanovdb::FpN>::AccessorType>;
 
         nanovdb::GridHandle<nanovdb::HostBuffer> mGridHandle;
-        nanovdb::FloatGrid* mpFloatGrid;
-        nanovdb::FloatGrid::AccessorType mAccessor;
+        nanovdb::GridType mGridType = nanovdb::GridType::Float;
+        Accessor mAccessor;
         Buffer::SharedPtr mpBuffer;
+        MajorantGrid::SharedPtr mpMajorantGrid;
     };
 }
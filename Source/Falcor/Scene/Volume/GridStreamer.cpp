@@ -0,0 +1,365 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "GridStreamer.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kInvalidDistance = std::numeric_limits<uint32_t>::max();
+    }
+
+    pybind11::dict GridStreamer::Stats::toPython() const
+    {
+        pybind11::dict d;
+        d["frameRequests"] = frameRequests;
+        d["frameHits"] = frameHits;
+        d["frameMisses"] = frameMisses;
+        d["stallTimeMs"] = stallTimeMs;
+        d["maxStallTimeMs"] = maxStallTimeMs;
+        d["framesDecoded"] = framesDecoded;
+        d["framesEvicted"] = framesEvicted;
+        d["residentFrames"] = residentFrames;
+        d["residentBytes"] = residentBytes;
+        return d;
+    }
+
+    GridStreamer::SharedPtr GridStreamer::create(const std::vector<std::string>& filenames, const std::string& gridname, const Desc& desc)
+    {
+        if (filenames.empty())
+        {
+            logWarning("Error when streaming grid sequence. No grid files specified.");
+            return nullptr;
+        }
+
+        SharedPtr pStreamer = SharedPtr(new GridStreamer(filenames, gridname, desc));
+        if (!pStreamer->mpGrid) return nullptr;
+
+        pStreamer->runWorkers();
+        {
+            std::lock_guard<std::mutex> lock(pStreamer->mMutex);
+            pStreamer->updateWindow();
+        }
+
+        return pStreamer;
+    }
+
+    GridStreamer::GridStreamer(const std::vector<std::string>& filenames, const std::string& gridname, const Desc& desc)
+        : mGridname(gridname)
+        , mDesc(desc)
+    {
+        mDesc.threadCount = std::max(mDesc.threadCount, 1u);
+
+        for (const auto& filename : filenames)
+        {
+            std::string fullpath;
+            if (!findFileInDataDirectories(filename, fullpath)) logWarning("Error when streaming grid sequence. Can't find grid file '" + filename + "'");
+            mFilenames.push_back(fullpath);
+        }
+
+        // Load the first frame synchronously.
+        if (mFilenames[0].empty()) return;
+        auto handle = Grid::loadGridHandle(mFilenames[0], mGridname, mDesc.quantization, mDesc.tolerance);
+        if (!handle) return;
+
+        mpGrid = Grid::SharedPtr(new Grid(std::move(handle)));
+        mStats.framesDecoded = 1;
+    }
+
+    GridStreamer::~GridStreamer()
+    {
+        terminateWorkers();
+    }
+
+    bool GridStreamer::setFrame(uint32_t frame)
+    {
+        frame = std::min(frame, getFrameCount() - 1);
+
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        if (frame == mFrame) return false;
+        mFrame = frame;
+        mStats.frameRequests++;
+
+        bool changed = false;
+
+        if (frame != mGridFrame)
+        {
+            // Request the frame at highest priority unless it is already loading.
+            auto it = mFrames.find(frame);
+            if (it == mFrames.end()) it = mFrames.emplace(frame, Frame()).first;
+            if (it->second.state == Frame::State::Queued)
+            {
+                mRequestQueue.erase(std::remove(mRequestQueue.begin(), mRequestQueue.end(), frame), mRequestQueue.end());
+                mRequestQueue.push_front(frame);
+                mCondition.notify_one();
+            }
+
+            // Stall until the frame is decoded.
+            auto isLoaded = [&] () { auto state = mFrames.at(frame).state; return state == Frame::State::Ready || state == Frame::State::Failed; };
+            if (isLoaded())
+            {
+                mStats.frameHits++;
+            }
+            else
+            {
+                auto startTime = CpuTimer::getCurrentTimePoint();
+                mLoadedCondition.wait(lock, isLoaded);
+                double stallTimeMs = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+                mStats.frameMisses++;
+                mStats.stallTimeMs += stallTimeMs;
+                mStats.maxStallTimeMs = std::max(mStats.maxStallTimeMs, stallTimeMs);
+            }
+
+            // Swap the frame into the grid and keep the previous frame around as a decoded frame.
+            auto& entry = mFrames.at(frame);
+            if (entry.state == Frame::State::Ready)
+            {
+                Frame prevEntry;
+                prevEntry.state = Frame::State::Ready;
+                prevEntry.handle = mpGrid->replaceGridHandle(std::move(entry.handle));
+                mFrames.erase(frame);
+                mFrames.emplace(mGridFrame, std::move(prevEntry));
+                mGridFrame = frame;
+                changed = true;
+            }
+            else
+            {
+                logWarning("Error when streaming grid sequence. Failed to load frame " + std::to_string(frame) + " from '" + mFilenames[frame] + "'");
+            }
+        }
+        else
+        {
+            mStats.frameHits++;
+        }
+
+        updateWindow();
+
+        return changed;
+    }
+
+    GridStreamer::Stats GridStreamer::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        Stats stats = mStats;
+        stats.residentFrames = 1;
+        stats.residentBytes = mpGrid->getGridSizeInBytes();
+        for (const auto& [frame, entry] : mFrames)
+        {
+            if (entry.state != Frame::State::Ready) continue;
+            stats.residentFrames++;
+            stats.residentBytes += entry.handle.size();
+        }
+        return stats;
+    }
+
+    void GridStreamer::resetStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats = Stats();
+    }
+
+    void GridStreamer::renderUI(Gui::Widgets& widget)
+    {
+        auto stats = getStats();
+
+        std::ostringstream oss;
+        oss << "Frames: " << getFrameCount() << std::endl
+            << "Resident frames: " << stats.residentFrames << std::endl
+            << "Resident memory: " << formatByteSize(stats.residentBytes) << " / " << formatByteSize(mDesc.memoryBudget) << std::endl
+            << "Frame hits: " << stats.frameHits << std::endl
+            << "Frame misses: " << stats.frameMisses << std::endl
+            << "Stall time: " << std::fixed << std::setprecision(2) << stats.stallTimeMs << " ms (max " << stats.maxStallTimeMs << " ms)" << std::endl
+            << "Frames decoded: " << stats.framesDecoded << std::endl
+            << "Frames evicted: " << stats.framesEvicted << std::endl;
+        widget.text(oss.str());
+
+        if (widget.button("Reset stats")) resetStats();
+    }
+
+    void GridStreamer::runWorkers()
+    {
+        for (uint32_t i = 0; i < mDesc.threadCount; ++i)
+        {
+            mThreads.emplace_back([&] () {
+                while (true)
+                {
+                    // Wait on condition until more work is ready.
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mCondition.wait(lock, [&] () { return mTerminate || !mRequestQueue.empty(); });
+
+                    if (mTerminate) break;
+
+                    // Pop next frame from queue.
+                    uint32_t frame = mRequestQueue.front();
+                    mRequestQueue.pop_front();
+
+                    auto it = mFrames.find(frame);
+                    if (it == mFrames.end() || it->second.state != Frame::State::Queued) continue;
+                    it->second.state = Frame::State::Loading;
+
+                    lock.unlock();
+
+                    // Decode the grid (this part is running in parallel).
+                    nanovdb::GridHandle<nanovdb::HostBuffer> handle;
+                    if (!mFilenames[frame].empty()) handle = Grid::loadGridHandle(mFilenames[frame], mGridname, mDesc.quantization, mDesc.tolerance);
+
+                    lock.lock();
+
+                    // Frames in loading state are never removed, so the entry is still valid.
+                    auto& entry = mFrames.at(frame);
+                    entry.state = handle ? Frame::State::Ready : Frame::State::Failed;
+                    entry.handle = std::move(handle);
+                    mStats.framesDecoded++;
+
+                    // Drop the frame if the window moved on while decoding.
+                    if (frame != mFrame && !isInWindow(frame))
+                    {
+                        mFrames.erase(frame);
+                        mStats.framesEvicted++;
+                    }
+                    else
+                    {
+                        evictFrames();
+                    }
+
+                    mLoadedCondition.notify_all();
+                }
+            });
+        }
+    }
+
+    void GridStreamer::terminateWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTerminate = true;
+        }
+
+        mCondition.notify_all();
+
+        for (auto& thread : mThreads) thread.join();
+    }
+
+    bool GridStreamer::isInWindow(uint32_t frame) const
+    {
+        return getWindowDistance(frame) != kInvalidDistance;
+    }
+
+    uint32_t GridStreamer::getWindowDistance(uint32_t frame) const
+    {
+        // Frames ahead of the current frame are ranked by distance, frames behind are ranked after all frames ahead.
+        const uint32_t frameCount = getFrameCount();
+        if (frame == mFrame) return 0;
+
+        uint32_t ahead = frame > mFrame ? frame - mFrame : (mDesc.loop ? frame + frameCount - mFrame : kInvalidDistance);
+        if (ahead <= mDesc.prefetchCount) return ahead;
+
+        uint32_t behind = frame < mFrame ? mFrame - frame : (mDesc.loop ? mFrame + frameCount - frame : kInvalidDistance);
+        if (behind <= mDesc.keepBehindCount) return mDesc.prefetchCount + behind;
+
+        return kInvalidDistance;
+    }
+
+    void GridStreamer::updateWindow()
+    {
+        // Remove frames that are outside the window, except for frames currently loading.
+        for (auto it = mFrames.begin(); it != mFrames.end();)
+        {
+            if (it->second.state != Frame::State::Loading && !isInWindow(it->first))
+            {
+                if (it->second.state == Frame::State::Ready) mStats.framesEvicted++;
+                it = mFrames.erase(it);
+            }
+            else ++it;
+        }
+
+        // Queue frames ahead of the current frame in order of distance.
+        mRequestQueue.clear();
+        const uint32_t frameCount = getFrameCount();
+        const uint32_t prefetchCount = std::min(mDesc.prefetchCount, frameCount - 1);
+        for (uint32_t i = 1; i <= prefetchCount; ++i)
+        {
+            uint32_t frame = mFrame + i;
+            if (frame >= frameCount)
+            {
+                if (!mDesc.loop) break;
+                frame -= frameCount;
+            }
+            if (frame == mGridFrame) continue;
+
+            auto it = mFrames.find(frame);
+            if (it == mFrames.end()) it = mFrames.emplace(frame, Frame()).first;
+            if (it->second.state == Frame::State::Queued) mRequestQueue.push_back(frame);
+        }
+
+        evictFrames();
+
+        mCondition.notify_all();
+    }
+
+    void GridStreamer::evictFrames()
+    {
+        uint64_t residentBytes = mpGrid->getGridSizeInBytes();
+        for (const auto& [frame, entry] : mFrames) residentBytes += entry.handle.size();
+
+        while (residentBytes > mDesc.memoryBudget)
+        {
+            // Find the decoded frame farthest from the current frame.
+            auto evictIt = mFrames.end();
+            uint32_t evictDistance = 0;
+            for (auto it = mFrames.begin(); it != mFrames.end(); ++it)
+            {
+                uint32_t distance = getWindowDistance(it->first);
+                if (it->second.state == Frame::State::Ready && it->first != mFrame && distance >= evictDistance)
+                {
+                    evictIt = it;
+                    evictDistance = distance;
+                }
+            }
+            if (evictIt == mFrames.end()) break;
+
+            residentBytes -= evictIt->second.handle.size();
+            mFrames.erase(evictIt);
+            mStats.framesEvicted++;
+
+            // Stop decoding frames that are even farther away, they would be evicted as well.
+            for (auto it = mFrames.begin(); it != mFrames.end();)
+            {
+                if (it->second.state == Frame::State::Queued && getWindowDistance(it->first) >= evictDistance)
+                {
+                    mRequestQueue.erase(std::remove(mRequestQueue.begin(), mRequestQueue.end(), it->first), mRequestQueue.end());
+                    it = mFrames.erase(it);
+                }
+                else ++it;
+            }
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Grid.h"
+#include <deque>
+#include <map>
+
+namespace Falcor
+{
+    /** Streams a sequence of grids from files.
+        Instead of keeping all frames of a sequence resident in memory, the streamer keeps a sliding window of decoded
+        frames around the current frame. Frames ahead of the current frame are decoded on background threads and frames
+        outside the window are evicted, as well as the frames farthest ahead when exceeding the memory budget.
+        The current frame is held by a single grid object (see getGrid()) whose data is replaced when the frame changes.
+        This allows the scene to bind the grid once and see all frames of the sequence.
+    */
+    class dlldecl GridStreamer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<GridStreamer>;
+
+        /** Streaming options.
+        */
+        struct Desc
+        {
+            uint32_t prefetchCount = 4;                 ///< Number of frames to decode ahead of the current frame.
+            uint32_t keepBehindCount = 1;               ///< Number of frames to keep resident behind the current frame.
+            uint64_t memoryBudget = 4ull << 30;         ///< Host memory budget for decoded frames in bytes, including the current frame.
+            uint32_t threadCount = 2;                   ///< Number of decoding threads.
+            bool loop = true;                           ///< Prefetch the start of the sequence when approaching the end.
+            Grid::Quantization quantization = Grid::Quantization::Float;    ///< Storage format to convert the grids to.
+            float tolerance = 0.f;                      ///< Absolute error tolerance for Grid::Quantization::FpN.
+        };
+
+        /** Streaming statistics.
+        */
+        struct Stats
+        {
+            uint64_t frameRequests = 0;                 ///< Number of frame changes.
+            uint64_t frameHits = 0;                     ///< Number of frame changes with the frame already decoded.
+            uint64_t frameMisses = 0;                   ///< Number of frame changes stalling on the frame to be decoded.
+            double stallTimeMs = 0.0;                   ///< Total time spent stalling on frame misses in milliseconds.
+            double maxStallTimeMs = 0.0;                ///< Longest stall on a frame miss in milliseconds.
+            uint64_t framesDecoded = 0;                 ///< Number of frames decoded.
+            uint64_t framesEvicted = 0;                 ///< Number of decoded frames evicted before use.
+            uint32_t residentFrames = 0;                ///< Number of decoded frames resident in memory.
+            uint64_t residentBytes = 0;                 ///< Host memory used by decoded frames in bytes.
+
+            pybind11::dict toPython() const;
+        };
+
+        /** Create a grid streamer and load the first frame.
+            \param[in] filenames Filenames of the grids. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] desc Streaming options.
+            \return A new object, or nullptr if the first frame failed to load.
+        */
+        static SharedPtr create(const std::vector<std::string>& filenames, const std::string& gridname, const Desc& desc = Desc());
+
+        /** Destructor.
+            Blocks until the worker threads are terminated.
+        */
+        ~GridStreamer();
+
+        /** Get the grid holding the current frame.
+        */
+        const Grid::SharedPtr& getGrid() const { return mpGrid; }
+
+        /** Get the current frame.
+        */
+        uint32_t getFrame() const { return mFrame; }
+
+        /** Get the number of frames in the sequence.
+        */
+        uint32_t getFrameCount() const { return (uint32_t)mFilenames.size(); }
+
+        /** Set the current frame. This replaces the data of the grid and has to be called from the main thread.
+            Blocks if the frame has not been decoded yet (frame miss). Frames that fail to load keep the previous grid data.
+            \param[in] frame Frame index.
+            \return Returns true if the grid data changed.
+        */
+        bool setFrame(uint32_t frame);
+
+        /** Get the streaming options.
+        */
+        const Desc& getDesc() const { return mDesc; }
+
+        /** Get the streaming statistics.
+        */
+        Stats getStats() const;
+
+        /** Reset the streaming statistics.
+        */
+        void resetStats();
+
+        /** Render the UI.
+        */
+        void renderUI(Gui::Widgets& widget);
+
+    private:
+        GridStreamer(const std::vector<std::string>& filenames, const std::string& gridname, const Desc& desc);
+
+        struct Frame
+        {
+            enum class State { Queued, Loading, Ready, Failed };
+
+            State state = State::Queued;
+            nanovdb::GridHandle<nanovdb::HostBuffer> handle;
+        };
+
+        void runWorkers();
+        void terminateWorkers();
+
+        // The following functions expect mMutex to be locked.
+        bool isInWindow(uint32_t frame) const;
+        uint32_t getWindowDistance(uint32_t frame) const;
+        void updateWindow();
+        void evictFrames();
+
+        std::vector<std::string> mFilenames;        ///< Full paths of the grid files.
+        std::string mGridname;                      ///< Name of the grid to load.
+        Desc mDesc;                                 ///< Streaming options.
+
+        Grid::SharedPtr mpGrid;                     ///< Grid holding the current frame.
+        uint32_t mFrame = 0;                        ///< Current frame.
+        uint32_t mGridFrame = 0;                    ///< Frame the grid data is from (differs from mFrame if frames failed to load).
+
+        std::map<uint32_t, Frame> mFrames;          ///< Queued, loading and decoded frames (excluding the frame held by the grid).
+        std::deque<uint32_t> mRequestQueue;         ///< Frames to decode, in order of priority.
+        std::condition_variable mCondition;         ///< Condition variable for workers to wait on.
+        std::condition_variable mLoadedCondition;   ///< Condition variable to wait on for loaded frames.
+        mutable std::mutex mMutex;                  ///< Mutex for synchronizing access to shared resources.
+        std::vector<std::thread> mThreads;          ///< Worker threads.
+        bool mTerminate = false;                    ///< Flag to terminate worker threads.
+        Stats mStats;                               ///< Streaming statistics.
+    };
+}
@@ -0,0 +1,338 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "MajorantGrid.h"
+#include <execution>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kLeafDim = nanovdb::NanoLeaf<float>::DIM;
+        static_assert(MajorantGrid::kBrickSize == kLeafDim, "Majorant grid bricks need to match NanoVDB leaf nodes");
+
+        int floorDiv(int a, int b)
+        {
+            return (a >= 0 ? a : a - b + 1) / b;
+        }
+
+        int3 floorDiv(const int3& a, int b)
+        {
+            return int3(floorDiv(a.x, b), floorDiv(a.y, b), floorDiv(a.z, b));
+        }
+
+        uint32_t getUpperPowerOf2(uint32_t a)
+        {
+            return isPowerOf2(a) ? a : getLowerPowerOf2(a) << 1;
+        }
+
+        /** Atomic maximum of non-negative floats, which order the same as their bit patterns.
+        */
+        void atomicMax(std::atomic<uint32_t>& a, float value)
+        {
+            assert(value >= 0.f);
+            uint32_t bits = glm::floatBitsToUint(value);
+            uint32_t current = a.load(std::memory_order_relaxed);
+            while (current < bits && !a.compare_exchange_weak(current, bits, std::memory_order_relaxed)) {}
+        }
+
+        /** Intersect a ray with a box and return the exit distance (or 0 if the ray origin is outside).
+        */
+        float intersectBoxExit(const float3& origin, const float3& dir, const float3& boxMin, const float3& boxMax)
+        {
+            float tExit = std::numeric_limits<float>::max();
+            for (int i = 0; i < 3; i++)
+            {
+                if (dir[i] > 0.f) tExit = std::min(tExit, (boxMax[i] - origin[i]) / dir[i]);
+                else if (dir[i] < 0.f) tExit = std::min(tExit, (boxMin[i] - origin[i]) / dir[i]);
+            }
+            return std::max(tExit, 0.f);
+        }
+    }
+
+    pybind11::dict MajorantGrid::CollisionStats::toPython() const
+    {
+        pybind11::dict d;
+        d["rayCount"] = rayCount;
+        d["level"] = level;
+        d["realCollisions"] = realCollisions;
+        d["globalNullCollisions"] = globalNullCollisions;
+        d["gridNullCollisions"] = gridNullCollisions;
+        d["cellsVisited"] = cellsVisited;
+        return d;
+    }
+
+    template<typename BuildT>
+    MajorantGrid::SharedPtr MajorantGrid::create(const nanovdb::NanoGrid<BuildT>& grid, bool hierarchical)
+    {
+        using LeafT = nanovdb::NanoLeaf<BuildT>;
+
+        SharedPtr pMajorantGrid = SharedPtr(new MajorantGrid());
+
+        // Compute the brick range. The index bounds are extended by one voxel, as interpolated lookups reach into neighboring voxels.
+        uint3 dims(1);
+        if (grid.activeVoxelCount() > 0)
+        {
+            const auto& bbox = grid.indexBBox();
+            int3 minIndex = int3(bbox.min()[0], bbox.min()[1], bbox.min()[2]) - 1;
+            int3 maxIndex = int3(bbox.max()[0], bbox.max()[1], bbox.max()[2]) + 1;
+            pMajorantGrid->mOrigin = floorDiv(minIndex, kBrickSize) * int(kBrickSize);
+            uint3 brickCount = uint3((maxIndex - pMajorantGrid->mOrigin) / int(kBrickSize) + 1);
+
+            // Round up to powers of two, so that each cell of a coarser level covers exactly 2x2x2 cells.
+            dims = uint3(getUpperPowerOf2(brickCount.x), getUpperPowerOf2(brickCount.y), getUpperPowerOf2(brickCount.z));
+        }
+
+        const int3 origin = pMajorantGrid->mOrigin;
+        const size_t brickCount = size_t(dims.x) * dims.y * dims.z;
+        auto brickIndex = [&] (const int3& brick) { return (size_t(brick.z) * dims.y + brick.y) * dims.x + brick.x; };
+        auto isValidBrick = [&] (const int3& brick) { return glm::all(glm::greaterThanEqual(brick, int3(0))) && glm::all(glm::lessThan(brick, int3(dims))); };
+
+        std::unique_ptr<std::atomic<uint32_t>[]> majorants(new std::atomic<uint32_t>[brickCount]);
+        std::vector<uint8_t> hasLeaf(brickCount, 0);
+        for (size_t i = 0; i < brickCount; i++) majorants[i].store(0, std::memory_order_relaxed);
+
+        // Process the leaf nodes in parallel. The maximum of the voxels on each face, edge and corner of a leaf node is also
+        // propagated to the neighboring brick to account for lookups reaching across the brick boundary.
+        const auto& tree = grid.tree();
+        const uint32_t leafCount = tree.template nodeCount<LeafT>();
+        std::for_each(std::execution::par, NumericRange<uint32_t>(0, leafCount).begin(), NumericRange<uint32_t>(0, leafCount).end(), [&] (uint32_t leafIndex)
+        {
+            const LeafT* pLeaf = tree.template getNode<LeafT>(leafIndex);
+            const auto& leafOrigin = pLeaf->origin();
+            int3 brick = floorDiv(int3(leafOrigin[0], leafOrigin[1], leafOrigin[2]) - origin, kBrickSize);
+            if (!isValidBrick(brick)) return;
+            hasLeaf[brickIndex(brick)] = 1;
+
+            float neighborMax[3][3][3] = {};
+            for (uint32_t x = 0; x < kLeafDim; x++)
+            {
+                int x0 = x == 0 ? 0 : 1, x1 = x == kLeafDim - 1 ? 2 : 1;
+                for (uint32_t y = 0; y < kLeafDim; y++)
+                {
+                    int y0 = y == 0 ? 0 : 1, y1 = y == kLeafDim - 1 ? 2 : 1;
+                    for (uint32_t z = 0; z < kLeafDim; z++)
+                    {
+                        float value = (float)pLeaf->getValue((x * kLeafDim + y) * kLeafDim + z);
+                        if (!(value > 0.f)) continue;
+                        int z0 = z == 0 ? 0 : 1, z1 = z == kLeafDim - 1 ? 2 : 1;
+                        for (int i = x0; i <= x1; i++) for (int j = y0; j <= y1; j++) for (int k = z0; k <= z1; k++)
+                        {
+                            neighborMax[i][j][k] = std::max(neighborMax[i][j][k], value);
+                        }
+                    }
+                }
+            }
+
+            for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++) for (int k = 0; k < 3; k++)
+            {
+                int3 neighbor = brick + int3(i - 1, j - 1, k - 1);
+                if (neighborMax[i][j][k] > 0.f && isValidBrick(neighbor)) atomicMax(majorants[brickIndex(neighbor)], neighborMax[i][j][k]);
+            }
+        });
+
+        // Bricks without a leaf node have a constant value (tile or background value).
+        std::for_each(std::execution::par, NumericRange<uint32_t>(0, dims.z).begin(), NumericRange<uint32_t>(0, dims.z).end(), [&] (uint32_t z)
+        {
+            auto accessor = grid.getAccessor();
+            for (uint32_t y = 0; y < dims.y; y++)
+            {
+                for (uint32_t x = 0; x < dims.x; x++)
+                {
+                    int3 brick(x, y, z);
+                    if (hasLeaf[brickIndex(brick)]) continue;
+                    int3 ijk = origin + brick * int(kBrickSize);
+                    float value = (float)accessor.getValue(nanovdb::Coord(ijk.x, ijk.y, ijk.z));
+                    if (!(value > 0.f)) continue;
+                    for (int i = -1; i <= 1; i++) for (int j = -1; j <= 1; j++) for (int k = -1; k <= 1; k++)
+                    {
+                        int3 neighbor = brick + int3(i, j, k);
+                        if (isValidBrick(neighbor)) atomicMax(majorants[brickIndex(neighbor)], value);
+                    }
+                }
+            }
+        });
+
+        auto& levels = pMajorantGrid->mLevels;
+        auto& levelDims = pMajorantGrid->mDimensions;
+
+        levels.emplace_back(brickCount);
+        levelDims.push_back(dims);
+        for (size_t i = 0; i < brickCount; i++) levels[0][i] = glm::uintBitsToFloat(majorants[i].load(std::memory_order_relaxed));
+
+        // Build the coarser levels.
+        while (hierarchical && glm::any(glm::greaterThan(levelDims.back(), uint3(1))))
+        {
+            const uint3 srcDims = levelDims.back();
+            const uint3 dstDims = glm::max(srcDims / 2u, uint3(1));
+            std::vector<float> dst(size_t(dstDims.x) * dstDims.y * dstDims.z);
+            const auto& src = levels.back();
+
+            std::for_each(std::execution::par, NumericRange<uint32_t>(0, dstDims.z).begin(), NumericRange<uint32_t>(0, dstDims.z).end(), [&] (uint32_t z)
+            {
+                for (uint32_t y = 0; y < dstDims.y; y++)
+                {
+                    for (uint32_t x = 0; x < dstDims.x; x++)
+                    {
+                        float value = 0.f;
+                        for (uint32_t k = 2 * z; k <= std::min(2 * z + 1, srcDims.z - 1); k++)
+                            for (uint32_t j = 2 * y; j <= std::min(2 * y + 1, srcDims.y - 1); j++)
+                                for (uint32_t i = 2 * x; i <= std::min(2 * x + 1, srcDims.x - 1); i++)
+                                    value = std::max(value, src[(size_t(k) * srcDims.y + j) * srcDims.x + i]);
+                        dst[(size_t(z) * dstDims.y + y) * dstDims.x + x] = value;
+                    }
+                }
+            });
+
+            levels.push_back(std::move(dst));
+            levelDims.push_back(dstDims);
+        }
+
+        return pMajorantGrid;
+    }
+
+    uint3 MajorantGrid::getDimensions(uint32_t level) const
+    {
+        assert(level < getLevelCount());
+        return mDimensions[level];
+    }
+
+    float MajorantGrid::getMajorant(const int3& cell, uint32_t level) const
+    {
+        assert(level < getLevelCount());
+        const uint3 dims = mDimensions[level];
+        if (glm::any(glm::lessThan(cell, int3(0))) || glm::any(glm::greaterThanEqual(cell, int3(dims)))) return 0.f;
+        return mLevels[level][(size_t(cell.z) * dims.y + cell.y) * dims.x + cell.x];
+    }
+
+    float MajorantGrid::getMajorantAtIndex(const int3& ijk, uint32_t level) const
+    {
+        return getMajorant(floorDiv(ijk - mOrigin, getCellSize(level)), level);
+    }
+
+    template<typename BuildT>
+    MajorantGrid::CollisionStats MajorantGrid::estimateCollisions(const nanovdb::NanoGrid<BuildT>& grid, uint32_t rayCount, uint32_t level, uint32_t seed) const
+    {
+        level = std::min(level, getLevelCount() - 1);
+
+        CollisionStats stats;
+        stats.rayCount = rayCount;
+        stats.level = level;
+        if (rayCount == 0 || grid.activeVoxelCount() == 0) return stats;
+
+        const auto& bbox = grid.indexBBox();
+        const float3 boxMin = float3(bbox.min()[0], bbox.min()[1], bbox.min()[2]);
+        const float3 boxMax = float3(bbox.max()[0], bbox.max()[1], bbox.max()[2]) + 1.f;
+        const float globalMajorant = std::max((float)grid.tree().root().valueMax(), 0.f);
+
+        // Integrate the densities along each ray with a fixed step size, using nearest-neighbor lookups.
+        const float kStepSize = 0.25f;
+        std::vector<std::array<double, 4>> results(rayCount);
+        std::for_each(std::execution::par, NumericRange<uint32_t>(0, rayCount).begin(), NumericRange<uint32_t>(0, rayCount).end(), [&] (uint32_t rayIndex)
+        {
+            std::seed_seq seedSeq{ seed, rayIndex };
+            std::mt19937 rng(seedSeq);
+            std::uniform_real_distribution<float> dist;
+
+            float3 origin = boxMin + float3(dist(rng), dist(rng), dist(rng)) * (boxMax - boxMin);
+            float cosTheta = 1.f - 2.f * dist(rng);
+            float sinTheta = std::sqrt(std::max(0.f, 1.f - cosTheta * cosTheta));
+            float phi = 2.f * (float)M_PI * dist(rng);
+            float3 dir = float3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+            float tExit = intersectBoxExit(origin, dir, boxMin, boxMax);
+
+            auto accessor = grid.getAccessor();
+            double real = 0.0, globalNull = 0.0, gridNull = 0.0, cells = 0.0;
+            int3 prevCell(std::numeric_limits<int>::min());
+            for (float t = 0.5f * kStepSize; t < tExit; t += kStepSize)
+            {
+                int3 ijk = int3(glm::floor(origin + t * dir));
+                float density = std::max((float)accessor.getValue(nanovdb::Coord(ijk.x, ijk.y, ijk.z)), 0.f);
+                float majorant = getMajorantAtIndex(ijk, level);
+                assert(majorant >= density);
+
+                real += density * kStepSize;
+                globalNull += (globalMajorant - density) * kStepSize;
+                gridNull += (majorant - density) * kStepSize;
+
+                int3 cell = floorDiv(ijk - mOrigin, getCellSize(level));
+                if (cell != prevCell) cells += 1.0;
+                prevCell = cell;
+            }
+            results[rayIndex] = { real, globalNull, gridNull, cells };
+        });
+
+        for (const auto& r : results)
+        {
+            stats.realCollisions += r[0];
+            stats.globalNullCollisions += r[1];
+            stats.gridNullCollisions += r[2];
+            stats.cellsVisited += r[3];
+        }
+        stats.realCollisions /= rayCount;
+        stats.globalNullCollisions /= rayCount;
+        stats.gridNullCollisions /= rayCount;
+        stats.cellsVisited /= rayCount;
+
+        return stats;
+    }
+
+    const Texture::SharedPtr& MajorantGrid::getTexture() const
+    {
+        if (!mpTexture)
+        {
+            // Pack all levels, they are uploaded as the mip chain.
+            std::vector<float> data;
+            for (const auto& level : mLevels) data.insert(data.end(), level.begin(), level.end());
+
+            const uint3 dims = mDimensions[0];
+            mpTexture = Texture::create3D(dims.x, dims.y, dims.z, ResourceFormat::R32Float, getLevelCount(), data.data());
+        }
+        return mpTexture;
+    }
+
+    uint64_t MajorantGrid::getSizeInBytes() const
+    {
+        uint64_t size = 0;
+        for (const auto& level : mLevels) size += level.size() * sizeof(float);
+        return size;
+    }
+
+#define INSTANTIATE_MAJORANT_GRID(BuildT) \
+    template dlldecl MajorantGrid::SharedPtr MajorantGrid::create<BuildT>(const nanovdb::NanoGrid<BuildT>& grid, bool hierarchical); \
+    template dlldecl MajorantGrid::CollisionStats MajorantGrid::estimateCollisions<BuildT>(const nanovdb::NanoGrid<BuildT>& grid, uint32_t rayCount, uint32_t level, uint32_t seed) const;
+
+    INSTANTIATE_MAJORANT_GRID(float)
+    INSTANTIATE_MAJORANT_GRID(nanovdb::Fp4)
+    INSTANTIATE_MAJORANT_GRID(nanovdb::Fp8)
+    INSTANTIATE_MAJORANT_GRID(nanovdb::Fp16)
+    INSTANTIATE_MAJORANT_GRID(nanovdb::FpN)
+
+#undef INSTANTIATE_MAJORANT_GRID
+}
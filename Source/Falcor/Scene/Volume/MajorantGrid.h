@@ -0,0 +1,128 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#pragma warning(disable:4244 4267)
+#include <nanovdb/NanoVDB.h>
+#pragma warning(default:4244 4267)
+
+namespace Falcor
+{
+    /** Coarse grid of conservative maximum values (majorants) of a NanoVDB grid.
+        Level 0 stores the maximum value of each brick of 8x8x8 voxels (aligned to NanoVDB leaf nodes), dilated by one voxel
+        so that it also bounds trilinear and stochastic lookups. Each further level stores the maximum of 2x2x2 cells of the
+        previous level, which allows skipping empty space hierarchically with a DDA. The levels are uploaded as the mip chain of
+        a 3D texture (see Grid.slang).
+        Negative values are clamped to zero, as they are treated as zero density when tracking.
+    */
+    class dlldecl MajorantGrid
+    {
+    public:
+        using SharedPtr = std::shared_ptr<MajorantGrid>;
+
+        static const uint32_t kBrickSize = 8;   ///< Size of a brick in voxels. Needs to match kMajorantBrickSize in Grid.slang.
+
+        /** Expected number of collisions per ray when tracking through the grid.
+            Values are optical depths in index-space units (unit voxel size and density scale).
+        */
+        struct CollisionStats
+        {
+            uint32_t rayCount = 0;                  ///< Number of rays.
+            uint32_t level = 0;                     ///< Majorant grid level used.
+            double realCollisions = 0.0;            ///< Expected real collisions per ray.
+            double globalNullCollisions = 0.0;      ///< Expected null collisions per ray using the global maximum value as majorant.
+            double gridNullCollisions = 0.0;        ///< Expected null collisions per ray using the majorant grid.
+            double cellsVisited = 0.0;              ///< Average number of majorant grid cells visited per ray (DDA steps).
+
+            pybind11::dict toPython() const;
+        };
+
+        /** Build a majorant grid. Leaf nodes are processed in parallel.
+            \param[in] grid NanoVDB grid (float or quantized float).
+            \param[in] hierarchical Build all coarser levels, otherwise only bricks (level 0) are built.
+            \return A new object.
+        */
+        template<typename BuildT>
+        static SharedPtr create(const nanovdb::NanoGrid<BuildT>& grid, bool hierarchical = true);
+
+        /** Get the number of levels.
+        */
+        uint32_t getLevelCount() const { return (uint32_t)mLevels.size(); }
+
+        /** Get the number of cells of a level.
+        */
+        uint3 getDimensions(uint32_t level = 0) const;
+
+        /** Get the size of a cell of a level in voxels.
+        */
+        uint32_t getCellSize(uint32_t level = 0) const { return kBrickSize << level; }
+
+        /** Get the index-space position of the first voxel of cell (0,0,0).
+        */
+        int3 getOrigin() const { return mOrigin; }
+
+        /** Get the majorant of a cell.
+            \param[in] cell Cell index. Cells outside the grid return zero.
+            \param[in] level Level.
+        */
+        float getMajorant(const int3& cell, uint32_t level = 0) const;
+
+        /** Get the majorant of the cell containing a voxel.
+            \param[in] ijk Index-space position of the voxel.
+            \param[in] level Level.
+        */
+        float getMajorantAtIndex(const int3& ijk, uint32_t level = 0) const;
+
+        /** Estimate the expected number of null and real collisions per ray when tracking through the grid.
+            Rays start at random points inside the grid bounds and are traced in random directions to the boundary.
+            The rays are processed in parallel and the estimate is deterministic for a given seed.
+            \param[in] grid NanoVDB grid the majorant grid was built from.
+            \param[in] rayCount Number of rays.
+            \param[in] level Majorant grid level.
+            \param[in] seed Random seed.
+            \return Collision statistics.
+        */
+        template<typename BuildT>
+        CollisionStats estimateCollisions(const nanovdb::NanoGrid<BuildT>& grid, uint32_t rayCount, uint32_t level = 0, uint32_t seed = 0) const;
+
+        /** Get the texture containing the majorant grid levels as mip levels. The texture is created on first use.
+        */
+        const Texture::SharedPtr& getTexture() const;
+
+        /** Get the size of the majorant grid in bytes.
+        */
+        uint64_t getSizeInBytes() const;
+
+    private:
+        MajorantGrid() = default;
+
+        int3 mOrigin = int3(0);
+        std::vector<uint3> mDimensions;
+        std::vector<std::vector<float>> mLevels;
+        mutable Texture::SharedPtr mpTexture;
+    };
+}
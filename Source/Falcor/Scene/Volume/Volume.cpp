@@ -71,6 +71,14 @@ namespace Falcor
             if (widget.var("Grid frame", gridFrame, 0u, mGridFrameCount - 1, 1u)) setGridFrame(gridFrame);
         }
 
+        for (uint32_t slotIndex = 0; slotIndex < (uint32_t)GridSlot::Count; ++slotIndex)
+        {
+            if (const auto& pStreamer = mGridStreamers[slotIndex])
+            {
+                if (auto group = widget.group(slotIndex == (uint32_t)GridSlot::Density ? "Density Streaming" : "Emission Streaming")) pStreamer->renderUI(group);
+            }
+        }
+
         if (const auto& densityGrid = getDensityGrid())
         {
             if (auto group = widget.group("Density Grid")) densityGrid->renderUI(group);
@@ -130,30 +138,41 @@ namespace Falcor
 
     uint32_t Volume::loadGridSequence(GridSlot slot, const std::string& path, const std::string& gridname, bool keepEmpty)
     {
-        std::string fullpath;
-        if (!findFileInDataDirectories(path, fullpath))
-        {
-            logWarning("Cannot find directory '" + path + "'");
-            return 0;
-        }
-        if (!std::filesystem::is_directory(fullpath))
-        {
-            logWarning("'" + path + "' is not a directory");
-            return 0;
-        }
+        std::vector<std::string> files;
+        if (!findGridFiles(path, files)) return 0;
+        return loadGridSequence(slot, files, gridname, keepEmpty);
+    }
 
-        // Enumerate grid files.
+    uint32_t Volume::streamGridSequence(GridSlot slot, const std::vector<std::string>& filenames, const std::string& gridname, const GridStreamer::Desc& desc)
+    {
+        uint32_t slotIndex = (uint32_t)slot;
+        assert(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
+
+        auto pStreamer = GridStreamer::create(filenames, gridname, desc);
+        if (!pStreamer) return 0;
+
+        setGridSequence(slot, GridSequence{pStreamer->getGrid()});
+        mGridStreamers[slotIndex] = pStreamer;
+        updateSequence();
+        pStreamer->setFrame(mGridFrame);
+        updateBounds();
+
+        return pStreamer->getFrameCount();
+    }
+
+    uint32_t Volume::streamGridSequence(GridSlot slot, const std::string& path, const std::string& gridname, const GridStreamer::Desc& desc)
+    {
         std::vector<std::string> files;
-        for (auto p : std::filesystem::directory_iterator(fullpath))
-        {
-            if (p.path().extension() == ".nvdb" || p.path().extension() == ".vdb") files.push_back(p.path().string());
-        }
+        if (!findGridFiles(path, files)) return 0;
+        return streamGridSequence(slot, files, gridname, desc);
+    }
 
-        // Sort by length first, then alpha-numerically.
-        auto cmp = [](const std::string& a, const std::string& b) { return a.length() != b.length() ? a.length() < b.length() : a < b; };
-        std::sort(files.begin(), files.end(), cmp);
+    const GridStreamer::SharedPtr& Volume::getGridStreamer(GridSlot slot) const
+    {
+        uint32_t slotIndex = (uint32_t)slot;
+        assert(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
 
-        return loadGridSequence(slot, files, gridname, keepEmpty);
+        return mGridStreamers[slotIndex];
     }
 
     void Volume::setGridSequence(GridSlot slot, const GridSequence& grids)
@@ -164,6 +183,7 @@ namespace Falcor
         if (mGrids[slotIndex] != grids)
         {
             mGrids[slotIndex] = grids;
+            mGridStreamers[slotIndex] = nullptr;
             updateSequence();
             updateBounds();
             markUpdates(UpdateFlags::GridsChanged);
@@ -210,6 +230,10 @@ namespace Falcor
         if (mGridFrame != gridFrame)
         {
             mGridFrame = gridFrame;
+            for (const auto& pStreamer : mGridStreamers)
+            {
+                if (pStreamer) pStreamer->setFrame(gridFrame);
+            }
             markUpdates(UpdateFlags::GridsChanged);
             updateBounds();
         }
@@ -287,10 +311,42 @@ namespace Falcor
         }
     }
 
+    bool Volume::findGridFiles(const std::string& path, std::vector<std::string>& files) const
+    {
+        std::string fullpath;
+        if (!findFileInDataDirectories(path, fullpath))
+        {
+            logWarning("Cannot find directory '" + path + "'");
+            return false;
+        }
+        if (!std::filesystem::is_directory(fullpath))
+        {
+            logWarning("'" + path + "' is not a directory");
+            return false;
+        }
+
+        // Enumerate grid files.
+        files.clear();
+        for (auto p : std::filesystem::directory_iterator(fullpath))
+        {
+            if (p.path().extension() == ".nvdb" || p.path().extension() == ".vdb") files.push_back(p.path().string());
+        }
+
+        // Sort by length first, then alpha-numerically.
+        auto cmp = [](const std::string& a, const std::string& b) { return a.length() != b.length() ? a.length() < b.length() : a < b; };
+        std::sort(files.begin(), files.end(), cmp);
+
+        return true;
+    }
+
     void Volume::updateSequence()
     {
         mGridFrameCount = 1;
         for (const auto& grids : mGrids) mGridFrameCount = std::max(mGridFrameCount, (uint32_t)grids.size());
+        for (const auto& pStreamer : mGridStreamers)
+        {
+            if (pStreamer) mGridFrameCount = std::max(mGridFrameCount, pStreamer->getFrameCount());
+        }
         setGridFrame(std::min(mGridFrame, mGridFrameCount - 1));
     }
 
@@ -329,6 +385,8 @@ namespace Falcor
 
     SCRIPT_BINDING(Volume)
     {
+        SCRIPT_BINDING_DEPENDENCY(Grid)
+
         pybind11::class_<Volume, Animatable, Volume::SharedPtr> volume(m, "Volume");
         volume.def_property("name", &Volume::getName, &Volume::setName);
         volume.def_property("gridFrame", &Volume::getGridFrame, &Volume::setGridFrame);
@@ -349,6 +407,31 @@ namespace Falcor
         volume.def("loadGridSequence",
             pybind11::overload_cast<Volume::GridSlot, const std::string&, const std::string&, bool>(&Volume::loadGridSequence),
             "slot"_a, "path"_a, "gridnames"_a, "keepEmpty"_a = true);
+
+        auto streamGridSequence = [] (Volume* pVolume, Volume::GridSlot slot, pybind11::object files, const std::string& gridname,
+            uint32_t prefetchCount, uint32_t keepBehindCount, uint64_t memoryBudgetMB, uint32_t threadCount, bool loop, Grid::Quantization quantization, float tolerance)
+        {
+            GridStreamer::Desc desc;
+            desc.prefetchCount = prefetchCount;
+            desc.keepBehindCount = keepBehindCount;
+            desc.memoryBudget = memoryBudgetMB << 20;
+            desc.threadCount = threadCount;
+            desc.loop = loop;
+            desc.quantization = quantization;
+            desc.tolerance = tolerance;
+            if (pybind11::isinstance<pybind11::str>(files)) return pVolume->streamGridSequence(slot, files.cast<std::string>(), gridname, desc);
+            return pVolume->streamGridSequence(slot, files.cast<std::vector<std::string>>(), gridname, desc);
+        };
+        GridStreamer::Desc defaultDesc;
+        volume.def("streamGridSequence", streamGridSequence, "slot"_a, "files"_a, "gridname"_a,
+            "prefetchCount"_a = defaultDesc.prefetchCount, "keepBehindCount"_a = defaultDesc.keepBehindCount, "memoryBudgetMB"_a = defaultDesc.memoryBudget >> 20,
+            "threadCount"_a = defaultDesc.threadCount, "loop"_a = defaultDesc.loop, "quantization"_a = defaultDesc.quantization, "tolerance"_a = defaultDesc.tolerance);
+        auto getStreamingStats = [] (Volume* pVolume, Volume::GridSlot slot)
+        {
+            const auto& pStreamer = pVolume->getGridStreamer(slot);
+            return pStreamer ? pybind11::object(pStreamer->getStats().toPython()) : pybind11::none();
+        };
+        volume.def("getStreamingStats", getStreamingStats, "slot"_a);
         pybind11::enum_<Volume::GridSlot> gridSlot(volume, "GridSlot");
         gridSlot.value("Density", Volume::GridSlot::Density);
         gridSlot.value("Emission", Volume::GridSlot::Emission);
@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include "Grid.h"
+#include "GridStreamer.h"
 #include "VolumeData.slang"
 #include "Scene/Animation/Animatable.h"
 
@@ -36,7 +37,8 @@ namespace Falcor
         The absorbing/scattering medium is defined by a density voxel grid and additional parameters.
         The emission is defined by an emission voxel grid and additional parameters.
         Grids are stored in grid slots (density, emission) and can either be static, using one grid per slot,
-        or dynamic, using a sequence of grids per slot.
+        or dynamic, using a sequence of grids per slot. Long sequences can be streamed from files instead of loading
+        all frames up front (see streamGridSequence()).
     */
     class dlldecl Volume : public Animatable
     {
@@ -129,6 +131,33 @@ namespace Falcor
         */
         uint32_t loadGridSequence(GridSlot slot, const std::string& path, const std::string& gridname, bool keepEmpty = true);
 
+        /** Stream a sequence of grids from files to a grid slot.
+            Only a window of frames around the current grid frame is kept in memory and frames ahead are decoded on background threads.
+            The grid sequence of the slot contains a single grid that holds the data of the current frame.
+            Note: This will replace any existing grid sequence for that slot.
+            \param[in] slot Grid slot.
+            \param[in] filenames Filenames of the grids. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] desc Streaming options.
+            \return Returns the length of the streamed sequence, or 0 if the first grid failed to load.
+        */
+        uint32_t streamGridSequence(GridSlot slot, const std::vector<std::string>& filenames, const std::string& gridname, const GridStreamer::Desc& desc = GridStreamer::Desc());
+
+        /** Stream a sequence of grids from a directory to a grid slot.
+            Note: This will replace any existing grid sequence for that slot.
+            \param[in] slot Grid slot.
+            \param[in] path Directory containing grid files. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] desc Streaming options.
+            \return Returns the length of the streamed sequence, or 0 if the first grid failed to load.
+        */
+        uint32_t streamGridSequence(GridSlot slot, const std::string& path, const std::string& gridname, const GridStreamer::Desc& desc = GridStreamer::Desc());
+
+        /** Get the grid streamer for the specified slot.
+            \return Returns the grid streamer, or nullptr if the slot is not streamed.
+        */
+        const GridStreamer::SharedPtr& getGridStreamer(GridSlot slot) const;
+
         /** Set the grid sequence for the specified slot.
         */
         void setGridSequence(GridSlot slot, const GridSequence& grids);
@@ -240,6 +269,7 @@ namespace Falcor
     private:
         Volume(const std::string& name);
 
+        bool findGridFiles(const std::string& path, std::vector<std::string>& files) const;
         void updateSequence();
         void updateBounds();
 
@@ -248,6 +278,7 @@ namespace Falcor
 
         std::string mName;
         std::array<GridSequence, (size_t)GridSlot::Count> mGrids;
+        std::array<GridStreamer::SharedPtr, (size_t)GridSlot::Count> mGridStreamers;
         uint32_t mGridFrame = 0;
         uint32_t mGridFrameCount = 1;
         AABB mBounds;
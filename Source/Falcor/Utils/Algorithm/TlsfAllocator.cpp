@@ -0,0 +1,296 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "TlsfAllocator.h"
+#include <intrin.h>
+
+namespace Falcor
+{
+    namespace
+    {
+        uint32_t findMsb(uint64_t v)
+        {
+            assert(v != 0);
+            unsigned long index;
+            _BitScanReverse64(&index, v);
+            return (uint32_t)index;
+        }
+
+        uint32_t findLsb(uint64_t v)
+        {
+            assert(v != 0);
+            unsigned long index;
+            _BitScanForward64(&index, v);
+            return (uint32_t)index;
+        }
+
+        uint64_t alignUp(uint64_t v, uint64_t alignment)
+        {
+            return (v + alignment - 1) & ~(alignment - 1);
+        }
+
+        template<uint32_t kSlBits>
+        void mapSize(uint64_t units, uint32_t& fl, uint32_t& sl)
+        {
+            const uint64_t kSlCount = 1ull << kSlBits;
+            if (units < kSlCount)
+            {
+                fl = 0;
+                sl = (uint32_t)units;
+            }
+            else
+            {
+                uint32_t msb = findMsb(units);
+                fl = msb - kSlBits + 1;
+                sl = (uint32_t)((units >> (msb - kSlBits)) - kSlCount);
+            }
+        }
+    }
+
+    TlsfAllocator::TlsfAllocator(uint64_t capacity, uint64_t granularity)
+        : mGranularity(granularity)
+    {
+        if (granularity == 0 || (granularity & (granularity - 1)) != 0)
+        {
+            throw std::exception("TlsfAllocator::TlsfAllocator() - granularity must be a power of two");
+        }
+
+        mGranularityShift = findMsb(granularity);
+        mCapacity = capacity & ~(granularity - 1);
+        for (auto& list : mFreeLists)
+        {
+            for (auto& head : list) head = kInvalidHandle;
+        }
+
+        if (mCapacity > 0) insertFreeBlock(createBlock(0, mCapacity));
+    }
+
+    TlsfAllocator::Allocation TlsfAllocator::allocate(uint64_t size, uint64_t alignment)
+    {
+        assert((alignment & (alignment - 1)) == 0);
+        size = alignUp(std::max(size, (uint64_t)1), mGranularity);
+        alignment = std::max(alignment, mGranularity);
+        if (size > mCapacity) return {};
+
+        // Search for a block that can hold the allocation at any alignment.
+        uint64_t units = (size + alignment - mGranularity) >> mGranularityShift;
+        uint32_t handle = findFreeBlock(units);
+        if (handle == kInvalidHandle) return {};
+        removeFreeBlock(handle);
+
+        // Return the padding in front of the aligned offset to the free lists.
+        uint64_t padding = alignUp(mBlocks[handle].offset, alignment) - mBlocks[handle].offset;
+        if (padding > 0)
+        {
+            uint32_t pad = handle;
+            handle = split(pad, padding);
+            insertFreeBlock(pad);
+        }
+
+        // Return the remainder.
+        if (mBlocks[handle].size > size)
+        {
+            insertFreeBlock(split(handle, size));
+        }
+
+        mAllocationCount++;
+        mUsedSize += size;
+
+        Allocation allocation;
+        allocation.offset = mBlocks[handle].offset;
+        allocation.size = size;
+        allocation.handle = handle;
+        return allocation;
+    }
+
+    void TlsfAllocator::free(const Allocation& allocation)
+    {
+        uint32_t handle = allocation.handle;
+        if (handle >= mBlocks.size() || mBlocks[handle].isFree || mBlocks[handle].offset != allocation.offset)
+        {
+            throw std::exception("TlsfAllocator::free() - invalid allocation");
+        }
+
+        assert(mAllocationCount > 0);
+        mAllocationCount--;
+        mUsedSize -= mBlocks[handle].size;
+
+        uint32_t prev = mBlocks[handle].prevPhys;
+        if (prev != kInvalidHandle && mBlocks[prev].isFree)
+        {
+            removeFreeBlock(prev);
+            handle = merge(prev, handle);
+        }
+
+        uint32_t next = mBlocks[handle].nextPhys;
+        if (next != kInvalidHandle && mBlocks[next].isFree)
+        {
+            removeFreeBlock(next);
+            handle = merge(handle, next);
+        }
+
+        insertFreeBlock(handle);
+    }
+
+    TlsfAllocator::Stats TlsfAllocator::getStats() const
+    {
+        Stats stats;
+        stats.capacity = mCapacity;
+        stats.usedSize = mUsedSize;
+        stats.freeSize = mCapacity - mUsedSize;
+        stats.allocationCount = mAllocationCount;
+
+        // The block at offset 0 is never merged away, so it always has handle 0.
+        for (uint32_t handle = mBlocks.empty() ? kInvalidHandle : 0; handle != kInvalidHandle; handle = mBlocks[handle].nextPhys)
+        {
+            const Block& block = mBlocks[handle];
+            if (!block.isFree) continue;
+            stats.freeBlockCount++;
+            stats.largestFreeBlock = std::max(stats.largestFreeBlock, block.size);
+        }
+        return stats;
+    }
+
+    uint32_t TlsfAllocator::createBlock(uint64_t offset, uint64_t size)
+    {
+        uint32_t handle;
+        if (mUnusedBlocks.size())
+        {
+            handle = mUnusedBlocks.back();
+            mUnusedBlocks.pop_back();
+        }
+        else
+        {
+            handle = (uint32_t)mBlocks.size();
+            mBlocks.emplace_back();
+        }
+
+        mBlocks[handle] = Block();
+        mBlocks[handle].offset = offset;
+        mBlocks[handle].size = size;
+        return handle;
+    }
+
+    void TlsfAllocator::destroyBlock(uint32_t handle)
+    {
+        mBlocks[handle] = Block();
+        mUnusedBlocks.push_back(handle);
+    }
+
+    void TlsfAllocator::insertFreeBlock(uint32_t handle)
+    {
+        uint32_t fl, sl;
+        mapSize<kSlBits>(mBlocks[handle].size >> mGranularityShift, fl, sl);
+
+        Block& block = mBlocks[handle];
+        uint32_t head = mFreeLists[fl][sl];
+        block.isFree = true;
+        block.prevFree = kInvalidHandle;
+        block.nextFree = head;
+        if (head != kInvalidHandle) mBlocks[head].prevFree = handle;
+        mFreeLists[fl][sl] = handle;
+        mSlBitmap[fl] |= 1u << sl;
+        mFlBitmap |= 1ull << fl;
+    }
+
+    void TlsfAllocator::removeFreeBlock(uint32_t handle)
+    {
+        uint32_t fl, sl;
+        mapSize<kSlBits>(mBlocks[handle].size >> mGranularityShift, fl, sl);
+
+        Block& block = mBlocks[handle];
+        assert(block.isFree);
+        if (block.prevFree != kInvalidHandle) mBlocks[block.prevFree].nextFree = block.nextFree;
+        if (block.nextFree != kInvalidHandle) mBlocks[block.nextFree].prevFree = block.prevFree;
+        if (mFreeLists[fl][sl] == handle)
+        {
+            mFreeLists[fl][sl] = block.nextFree;
+            if (block.nextFree == kInvalidHandle)
+            {
+                mSlBitmap[fl] &= ~(1u << sl);
+                if (mSlBitmap[fl] == 0) mFlBitmap &= ~(1ull << fl);
+            }
+        }
+        block.isFree = false;
+        block.prevFree = kInvalidHandle;
+        block.nextFree = kInvalidHandle;
+    }
+
+    uint32_t TlsfAllocator::findFreeBlock(uint64_t units) const
+    {
+        // Round the size up to the next list boundary so that any block in the found list is large enough.
+        if (units >= kSlCount)
+        {
+            uint64_t round = (1ull << (findMsb(units) - kSlBits)) - 1;
+            if (units + round < units) return kInvalidHandle;
+            units += round;
+        }
+
+        uint32_t fl, sl;
+        mapSize<kSlBits>(units, fl, sl);
+        if (fl >= kFlCount) return kInvalidHandle;
+
+        uint32_t slMap = mSlBitmap[fl] & (~0u << sl);
+        if (slMap == 0)
+        {
+            uint64_t flMap = fl + 1 < 64 ? mFlBitmap & (~0ull << (fl + 1)) : 0;
+            if (flMap == 0) return kInvalidHandle;
+            fl = findLsb(flMap);
+            slMap = mSlBitmap[fl];
+        }
+        sl = findLsb(slMap);
+        return mFreeLists[fl][sl];
+    }
+
+    uint32_t TlsfAllocator::split(uint32_t handle, uint64_t size)
+    {
+        assert(mBlocks[handle].size > size);
+        uint32_t remainder = createBlock(mBlocks[handle].offset + size, mBlocks[handle].size - size);
+
+        // createBlock() may reallocate the block storage, so don't hold references across it.
+        Block& block = mBlocks[handle];
+        Block& rest = mBlocks[remainder];
+        rest.prevPhys = handle;
+        rest.nextPhys = block.nextPhys;
+        if (block.nextPhys != kInvalidHandle) mBlocks[block.nextPhys].prevPhys = remainder;
+        block.nextPhys = remainder;
+        block.size = size;
+        return remainder;
+    }
+
+    uint32_t TlsfAllocator::merge(uint32_t first, uint32_t second)
+    {
+        assert(mBlocks[first].nextPhys == second);
+        Block& block = mBlocks[first];
+        block.size += mBlocks[second].size;
+        block.nextPhys = mBlocks[second].nextPhys;
+        if (block.nextPhys != kInvalidHandle) mBlocks[block.nextPhys].prevPhys = first;
+        destroyBlock(second);
+        return first;
+    }
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    /** Two-level segregated fit (TLSF) allocator.
+
+        Manages a linear range of [0, capacity) bytes without touching the memory itself, which makes it suitable
+        for sub-allocating GPU heaps. Free blocks are binned by size into first-level (power of two) and second-level
+        (linear subdivision) lists, with bitmaps to find a suitable list in O(1). Freed blocks are coalesced with
+        their free neighbors immediately.
+
+        All offsets and sizes are multiples of the granularity given at creation.
+    */
+    class dlldecl TlsfAllocator
+    {
+    public:
+        static const uint32_t kInvalidHandle = (uint32_t)-1;
+
+        struct Allocation
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;                  ///< Size of the allocation, rounded up to the granularity.
+            uint32_t handle = kInvalidHandle;   ///< Handle to pass to free().
+            bool isValid() const { return handle != kInvalidHandle; }
+        };
+
+        struct Stats
+        {
+            uint64_t capacity = 0;
+            uint64_t usedSize = 0;
+            uint64_t freeSize = 0;
+            uint64_t largestFreeBlock = 0;
+            uint32_t allocationCount = 0;
+            uint32_t freeBlockCount = 0;
+
+            /** Fraction of the free space that is not part of the largest free block. 0 means the free space is contiguous.
+            */
+            float getFragmentation() const { return freeSize > 0 ? 1.f - (float)((double)largestFreeBlock / (double)freeSize) : 0.f; }
+        };
+
+        /** Create an allocator.
+            \param[in] capacity Size of the managed range in bytes. Rounded down to the granularity.
+            \param[in] granularity Minimum allocation size and alignment in bytes. Must be a power of two.
+        */
+        TlsfAllocator(uint64_t capacity, uint64_t granularity = 1);
+
+        /** Allocate a range.
+            \param[in] size Size in bytes.
+            \param[in] alignment Alignment of the offset in bytes. Must be a power of two. Alignments smaller than the granularity are ignored.
+            \return An allocation, or an invalid allocation if there is no free block large enough.
+        */
+        Allocation allocate(uint64_t size, uint64_t alignment = 1);
+
+        /** Free an allocation made by this allocator.
+        */
+        void free(const Allocation& allocation);
+
+        uint64_t getCapacity() const { return mCapacity; }
+        uint64_t getGranularity() const { return mGranularity; }
+        bool isEmpty() const { return mAllocationCount == 0; }
+        Stats getStats() const;
+
+    private:
+        static const uint32_t kSlBits = 4;
+        static const uint32_t kSlCount = 1 << kSlBits;
+        static const uint32_t kFlCount = 64 - kSlBits + 1;
+
+        struct Block
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t prevPhys = kInvalidHandle;
+            uint32_t nextPhys = kInvalidHandle;
+            uint32_t prevFree = kInvalidHandle;
+            uint32_t nextFree = kInvalidHandle;
+            bool isFree = false;
+        };
+
+        uint32_t createBlock(uint64_t offset, uint64_t size);
+        void destroyBlock(uint32_t handle);
+        void insertFreeBlock(uint32_t handle);
+        void removeFreeBlock(uint32_t handle);
+        uint32_t findFreeBlock(uint64_t units) const;
+        uint32_t split(uint32_t handle, uint64_t size);
+        uint32_t merge(uint32_t first, uint32_t second);
+
+        uint64_t mCapacity;
+        uint64_t mGranularity;
+        uint32_t mGranularityShift;
+        uint32_t mAllocationCount = 0;
+        uint64_t mUsedSize = 0;
+
+        std::vector<Block> mBlocks;
+        std::vector<uint32_t> mUnusedBlocks;
+        uint64_t mFlBitmap = 0;
+        uint32_t mSlBitmap[kFlCount] = {};
+        uint32_t mFreeLists[kFlCount][kSlCount];
+    };
+}
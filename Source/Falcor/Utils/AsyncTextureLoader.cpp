@@ -27,6 +27,7 @@
  **************************************************************************/
 #include "stdafx.h"
 #include "AsyncTextureLoader.h"
+#include "Utils/Image/MipGenerator.h"
 
 namespace Falcor
 {
@@ -47,10 +48,10 @@ namespace Falcor
         gpDevice->flushAndSync();
     }
 
-    std::future<Texture::SharedPtr> AsyncTextureLoader::loadFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Resource::BindFlags bindFlags)
+    std::future<Texture::SharedPtr> AsyncTextureLoader::loadFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Resource::BindFlags bindFlags, bool useMipCache)
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        mRequestQueue.push(Request{filename, generateMipLevels, loadAsSrgb, bindFlags});
+        mRequestQueue.push(Request{filename, generateMipLevels, loadAsSrgb, bindFlags, useMipCache});
         mCondition.notify_one();
         return mRequestQueue.back().promise.get_future();
     }
@@ -96,7 +97,9 @@ namespace Falcor
                     lock.unlock();
 
                     // Load the textures (this part is running in parallel).
-                    Texture::SharedPtr pTexture = Texture::createFromFile(request.filename, request.generateMipLevels, request.loadAsSrgb, request.bindFlags);
+                    Texture::SharedPtr pTexture = request.generateMipLevels && request.useMipCache
+                        ? MipGenerator::createTextureFromFile(request.filename, request.loadAsSrgb, true, MipGenerator::kTextureLoadFilter, request.bindFlags)
+                        : Texture::createFromFile(request.filename, request.generateMipLevels, request.loadAsSrgb, request.bindFlags);
                     request.promise.set_value(pTexture);
 
                     lock.lock();
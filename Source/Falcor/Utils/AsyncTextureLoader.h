@@ -51,9 +51,10 @@ namespace Falcor
             \param[in] generateMipLevels Whether the mip-chain should be generated.
             \param[in] loadAsSrgb Load the texture using sRGB format. Only valid for 3 or 4 component textures.
             \param[in] bindFlags The bind flags to create the texture with.
+            \param[in] useMipCache Load the mip-chain from a DDS cache file next to the image, or write the cache file after generating the mips (see MipGenerator::kTextureLoadFilter).
             \return A future to a new texture, or nullptr if the texture failed to load.
         */
-        std::future<Texture::SharedPtr> loadFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource);
+        std::future<Texture::SharedPtr> loadFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource, bool useMipCache = false);
 
     private:
         void runWorkers(size_t threadCount);
@@ -65,6 +66,7 @@ namespace Falcor
             bool generateMipLevels;
             bool loadAsSrgb;
             Resource::BindFlags bindFlags;
+            bool useMipCache;
             std::promise<Texture::SharedPtr> promise;
         };
 
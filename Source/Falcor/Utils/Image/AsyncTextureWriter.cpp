@@ -0,0 +1,213 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "AsyncTextureWriter.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        std::unique_ptr<AsyncTextureWriter> gpInstance;
+    }
+
+    AsyncTextureWriter::AsyncTextureWriter(size_t threadCount, size_t maxPendingCaptures)
+        : mMaxPendingCaptures(std::max(maxPendingCaptures, size_t(1)))
+    {
+        runWorkers(std::max(threadCount, size_t(1)));
+    }
+
+    AsyncTextureWriter::~AsyncTextureWriter()
+    {
+        terminateWorkers();
+        reclaimStagingBuffers();
+    }
+
+    AsyncTextureWriter& AsyncTextureWriter::instance()
+    {
+        if (!gpInstance) gpInstance = std::make_unique<AsyncTextureWriter>();
+        return *gpInstance;
+    }
+
+    void AsyncTextureWriter::shutdown()
+    {
+        gpInstance.reset();
+    }
+
+    void AsyncTextureWriter::capture(CopyContext* pCtx, const Texture* pTexture, uint32_t subresource, const std::string& filename, Bitmap::FileFormat fileFormat, Bitmap::ExportFlags exportFlags)
+    {
+        assert(pCtx && pTexture);
+
+        // Apply back-pressure. Wait for a slot before recording the copy so that at most mMaxPendingCaptures readback buffers are alive.
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (mPendingCount >= mMaxPendingCaptures)
+            {
+                auto start = CpuTimer::getCurrentTimePoint();
+                mDoneCondition.wait(lock, [&] () { return mPendingCount < mMaxPendingCaptures; });
+                mStats.stallTimeMs += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            }
+        }
+
+        reclaimStagingBuffers();
+
+        Buffer::SharedPtr pStagingBuffer;
+        if (!mStagingBuffers.empty())
+        {
+            pStagingBuffer = mStagingBuffers.back();
+            mStagingBuffers.pop_back();
+        }
+
+        Request request;
+        request.pTask = pCtx->asyncReadTextureSubresource(pTexture, subresource, pStagingBuffer);
+        uint32_t mipLevel = pTexture->getSubresourceMipLevel(subresource);
+        request.filename = filename;
+        request.width = pTexture->getWidth(mipLevel);
+        request.height = pTexture->getHeight(mipLevel);
+        request.resourceFormat = pTexture->getFormat();
+        request.fileFormat = fileFormat;
+        request.exportFlags = exportFlags;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (request.pTask->getStagingBuffer() != pStagingBuffer) mStats.stagingBuffersCreated++;
+        mStats.capturesRequested++;
+        mPendingCount++;
+        mRequestQueue.push(std::move(request));
+        mCondition.notify_one();
+    }
+
+    void AsyncTextureWriter::waitForCompletion()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            auto start = CpuTimer::getCurrentTimePoint();
+            mDoneCondition.wait(lock, [&] () { return mPendingCount == 0; });
+            mStats.stallTimeMs += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        }
+
+        reclaimStagingBuffers();
+    }
+
+    size_t AsyncTextureWriter::getPendingCount()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPendingCount;
+    }
+
+    void AsyncTextureWriter::setMaxPendingCaptures(size_t maxPendingCaptures)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMaxPendingCaptures = std::max(maxPendingCaptures, size_t(1));
+        mDoneCondition.notify_all();
+    }
+
+    AsyncTextureWriter::Stats AsyncTextureWriter::getStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+    void AsyncTextureWriter::reclaimStagingBuffers()
+    {
+        std::vector<CopyContext::ReadTextureTask::SharedPtr> retiredTasks;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            retiredTasks.swap(mRetiredTasks);
+        }
+
+        // Keep at most one staging buffer per capture slot. The tasks (and any surplus buffers) are released here, on the calling thread.
+        for (const auto& pTask : retiredTasks)
+        {
+            if (mStagingBuffers.size() < mMaxPendingCaptures) mStagingBuffers.push_back(pTask->getStagingBuffer());
+        }
+    }
+
+    void AsyncTextureWriter::runWorkers(size_t threadCount)
+    {
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            mThreads.emplace_back([&] () {
+                while (true)
+                {
+                    // Wait on condition until more work is ready.
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mCondition.wait(lock, [&] () { return mTerminate || !mRequestQueue.empty(); });
+
+                    // Terminate thread unless there is more work to do.
+                    if (mRequestQueue.empty())
+                    {
+                        assert(mTerminate);
+                        break;
+                    }
+
+                    auto request = std::move(mRequestQueue.front());
+                    mRequestQueue.pop();
+
+                    lock.unlock();
+
+                    // Wait for the readback, encode and write the image (this part is running in parallel).
+                    auto start = CpuTimer::getCurrentTimePoint();
+                    bool success = true;
+                    try
+                    {
+                        std::vector<uint8_t> data = request.pTask->getData();
+                        Bitmap::saveImage(request.filename, request.width, request.height, request.fileFormat, request.exportFlags, request.resourceFormat, true, data.data());
+                    }
+                    catch (const std::exception& e)
+                    {
+                        logError("AsyncTextureWriter failed to write '" + request.filename + "': " + e.what());
+                        success = false;
+                    }
+                    double duration = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+                    lock.lock();
+
+                    // Hand the task back to the calling thread, which owns the staging buffers.
+                    mRetiredTasks.push_back(std::move(request.pTask));
+                    if (success) mStats.capturesWritten++;
+                    else mStats.capturesFailed++;
+                    mStats.encodeTimeMs += duration;
+                    mPendingCount--;
+                    mDoneCondition.notify_all();
+                }
+            });
+        }
+    }
+
+    void AsyncTextureWriter::terminateWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTerminate = true;
+        }
+
+        mCondition.notify_all();
+
+        for (auto& thread : mThreads) thread.join();
+        mThreads.clear();
+    }
+}
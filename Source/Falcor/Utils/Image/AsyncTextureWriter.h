@@ -0,0 +1,139 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/API/CopyContext.h"
+#include "Utils/Image/Bitmap.h"
+#include <queue>
+
+namespace Falcor
+{
+    /** Utility class to write textures to image files asynchronously.
+
+        Captures are processed in two stages. On the calling thread, the texture is copied into a readback buffer taken from
+        a pool of staging buffers and the copy is submitted without waiting for the GPU. Worker threads then wait for the copy,
+        encode the image and write it to disk. The number of captures in flight is bounded; when the limit is reached,
+        capture() blocks until a worker has finished (back-pressure).
+
+        All methods must be called from the thread that owns the render context. Staging buffers are only created and
+        released on that thread; workers hand finished readbacks back to it.
+    */
+    class dlldecl AsyncTextureWriter
+    {
+    public:
+        static const size_t kDefaultMaxPendingCaptures = 8;
+
+        struct Stats
+        {
+            uint64_t capturesRequested = 0;     ///< Total number of capture requests.
+            uint64_t capturesWritten = 0;       ///< Number of images successfully written to disk.
+            uint64_t capturesFailed = 0;        ///< Number of images that failed to be written.
+            uint64_t stagingBuffersCreated = 0; ///< Number of readback buffers that had to be allocated.
+            double stallTimeMs = 0.0;           ///< Total time the calling thread was blocked waiting for workers.
+            double encodeTimeMs = 0.0;          ///< Total time the workers spent on readback, encoding and writing.
+        };
+
+        /** Constructor.
+            \param[in] threadCount Number of worker threads.
+            \param[in] maxPendingCaptures Maximum number of captures in flight before capture() blocks.
+        */
+        AsyncTextureWriter(size_t threadCount = std::thread::hardware_concurrency(), size_t maxPendingCaptures = kDefaultMaxPendingCaptures);
+
+        /** Destructor.
+            Blocks until all pending captures are written.
+        */
+        ~AsyncTextureWriter();
+
+        /** Get the global writer instance used by Texture::captureToFile().
+            The instance is created on first use.
+        */
+        static AsyncTextureWriter& instance();
+
+        /** Wait for all pending captures of the global instance and destroy it.
+            Called during framework shutdown, before the device is destroyed.
+        */
+        static void shutdown();
+
+        /** Request writing a texture subresource to a file.
+            \param[in] pCtx Context to record the readback copy on.
+            \param[in] pTexture Texture to read from.
+            \param[in] subresource Subresource index.
+            \param[in] filename Output filename.
+            \param[in] fileFormat Destination file format.
+            \param[in] exportFlags Export flags.
+        */
+        void capture(CopyContext* pCtx, const Texture* pTexture, uint32_t subresource, const std::string& filename, Bitmap::FileFormat fileFormat, Bitmap::ExportFlags exportFlags);
+
+        /** Block until all pending captures have been written.
+        */
+        void waitForCompletion();
+
+        /** Get the number of captures that have been requested but not yet written.
+        */
+        size_t getPendingCount();
+
+        /** Set the maximum number of captures in flight. Values less than 1 are clamped to 1.
+        */
+        void setMaxPendingCaptures(size_t maxPendingCaptures);
+
+        /** Get the maximum number of captures in flight.
+        */
+        size_t getMaxPendingCaptures() const { return mMaxPendingCaptures; }
+
+        /** Get capture statistics.
+        */
+        Stats getStats();
+
+    private:
+        void runWorkers(size_t threadCount);
+        void terminateWorkers();
+        void reclaimStagingBuffers();
+
+        struct Request
+        {
+            CopyContext::ReadTextureTask::SharedPtr pTask;
+            std::string filename;
+            uint32_t width;
+            uint32_t height;
+            ResourceFormat resourceFormat;
+            Bitmap::FileFormat fileFormat;
+            Bitmap::ExportFlags exportFlags;
+        };
+
+        std::queue<Request> mRequestQueue;                                  ///< Requests waiting for a worker.
+        std::vector<CopyContext::ReadTextureTask::SharedPtr> mRetiredTasks; ///< Finished readbacks, owned by the workers until reclaimed by the calling thread.
+        std::vector<Buffer::SharedPtr> mStagingBuffers;                     ///< Pool of free readback buffers. Only accessed from the calling thread.
+        std::condition_variable mCondition;                                 ///< Condition variable for workers to wait on.
+        std::condition_variable mDoneCondition;                             ///< Condition variable signaled when a capture finishes.
+        std::mutex mMutex;                                                  ///< Mutex for synchronizing access to shared resources.
+        std::vector<std::thread> mThreads;                                  ///< Worker threads.
+        size_t mPendingCount = 0;                                           ///< Number of captures requested but not yet written.
+        size_t mMaxPendingCaptures;                                         ///< Maximum number of captures in flight.
+        bool mTerminate = false;                                            ///< Flag to terminate worker threads.
+        Stats mStats;
+    };
+}
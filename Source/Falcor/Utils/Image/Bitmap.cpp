@@ -29,8 +29,11 @@
 #include "Bitmap.h"
 #include "Core/API/Texture.h"
 #include "Utils/StringUtils.h"
+#include "Utils/NumericRange.h"
 
 #include <FreeImage.h>
+#include <emmintrin.h>
+#include <execution>
 
 namespace Falcor
 {
@@ -58,22 +61,84 @@ namespace Falcor
         return isHalfFormat || isLargeIntFormat;
     }
 
+    /** Number of rows processed per work item when converting images in parallel.
+    */
+    static const uint32_t kRowsPerTask = 32;
+
+    /** Calls func(firstRow, rowCount) for blocks of rows in parallel.
+    */
+    template<typename Func>
+    static void forEachRowBlock(uint32_t height, Func func)
+    {
+        uint32_t blockCount = (height + kRowsPerTask - 1) / kRowsPerTask;
+        auto range = NumericRange<uint32_t>(0, blockCount);
+        std::for_each(std::execution::par, range.begin(), range.end(), [&] (uint32_t block) {
+            uint32_t firstRow = block * kRowsPerTask;
+            func(firstRow, std::min(kRowsPerTask, height - firstRow));
+        });
+    }
+
+    /** Converts four half floats, stored in the low 16 bits of each lane, to floats.
+        Branchless SSE2 conversion that handles denormals, infinities and NaNs (after F. Giesen).
+    */
+    static inline __m128 halfToFloat4(__m128i h)
+    {
+        const __m128i maskNoSign = _mm_set1_epi32(0x7fff);
+        const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+        const __m128i wasInfNan = _mm_set1_epi32(0x7bff);
+        const __m128 expInfNan = _mm_castsi128_ps(_mm_set1_epi32(255 << 23));
+
+        __m128i expMant = _mm_and_si128(maskNoSign, h);
+        __m128i justSign = _mm_xor_si128(h, expMant);
+        __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)), magic);
+        __m128 infNanExp = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(expMant, wasInfNan)), expInfNan);
+        __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(justSign, 16));
+        return _mm_or_ps(scaled, _mm_or_ps(sign, infNanExp));
+    }
+
+    /** Converts an array of half floats to floats.
+    */
+    static void convertHalfToFloat(const uint16_t* pSrc, float* pDst, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc + i)), _mm_setzero_si128());
+            _mm_storeu_ps(pDst + i, halfToFloat4(h));
+        }
+        for (; i < count; i++)
+        {
+            pDst[i] = _mm_cvtss_f32(halfToFloat4(_mm_cvtsi32_si128(pSrc[i])));
+        }
+    }
+
     /** Converts half float image to RGBA float image.
     */
     static std::vector<float> convertHalfToRGBA32Float(uint32_t width, uint32_t height, uint32_t channelCount, const void* pData)
     {
-        std::vector<float> newData(width * height * 4u, 0.f);
-        const glm::detail::hdata* pSrc = reinterpret_cast<const glm::detail::hdata*>(pData);
+        std::vector<float> newData(width * height * 4u);
+        const uint16_t* pSrc = reinterpret_cast<const uint16_t*>(pData);
         float* pDst = newData.data();
 
-        for (uint32_t i = 0; i < width * height; ++i)
-        {
-            for (uint32_t c = 0; c < channelCount; ++c)
+        forEachRowBlock(height, [&] (uint32_t firstRow, uint32_t rowCount) {
+            const size_t srcOffset = (size_t)firstRow * width * channelCount;
+            const size_t dstOffset = (size_t)firstRow * width * 4;
+            if (channelCount == 4)
             {
-                *pDst++ = glm::detail::toFloat32(*pSrc++);
+                convertHalfToFloat(pSrc + srcOffset, pDst + dstOffset, (size_t)rowCount * width * 4);
+                return;
             }
-            pDst += (4 - channelCount);
-        }
+
+            // Convert the block into a packed temporary and expand to RGBA. Alpha defaults to 1.
+            std::vector<float> packed((size_t)rowCount * width * channelCount);
+            convertHalfToFloat(pSrc + srcOffset, packed.data(), packed.size());
+            for (size_t i = 0; i < (size_t)rowCount * width; ++i)
+            {
+                float4 v(0.f, 0.f, 0.f, 1.f);
+                for (uint32_t c = 0; c < channelCount; ++c) v[c] = packed[i * channelCount + c];
+                reinterpret_cast<float4*>(pDst + dstOffset)[i] = v;
+            }
+        });
 
         return newData;
     }
@@ -84,18 +149,21 @@ namespace Falcor
     template<typename SrcT>
     static std::vector<float> convertIntToRGBA32Float(uint32_t width, uint32_t height, uint32_t channelCount, const void* pData)
     {
-        std::vector<float> newData(width * height * 4u, 0.f);
+        std::vector<float> newData(width * height * 4u);
         const SrcT* pSrc = reinterpret_cast<const SrcT*>(pData);
         float* pDst = newData.data();
+        const float maxValue = float(std::numeric_limits<SrcT>::max());
 
-        for (uint32_t i = 0; i < width * height; ++i)
-        {
-            for (uint32_t c = 0; c < channelCount; ++c)
+        forEachRowBlock(height, [&] (uint32_t firstRow, uint32_t rowCount) {
+            const size_t first = (size_t)firstRow * width;
+            const size_t last = first + (size_t)rowCount * width;
+            for (size_t i = first; i < last; ++i)
             {
-                *pDst++ = float(*pSrc++) / float(std::numeric_limits<SrcT>::max());
+                float4 v(0.f, 0.f, 0.f, 1.f);
+                for (uint32_t c = 0; c < channelCount; ++c) v[c] = float(pSrc[i * channelCount + c]) / maxValue;
+                reinterpret_cast<float4*>(pDst)[i] = v;
             }
-            pDst += (4 - channelCount);
-        }
+        });
 
         return newData;
     }
@@ -137,12 +205,6 @@ namespace Falcor
             should_not_get_here();
         }
 
-        // Default alpha channel to 1.
-        if (channelCount < 4)
-        {
-            for (uint32_t i = 0; i < width * height; ++i) floatData[i * 4 + 3] = 1.f;
-        }
-
         return floatData;
     }
 
@@ -188,6 +250,40 @@ namespace Falcor
         return Bitmap::UniqueConstPtr(new Bitmap(width, height, format, pData));
     }
 
+    /** Copies the scanlines of a decoded image into bitmap memory in blocks of rows in parallel.
+        24-bit images are expanded to 32 bits with opaque alpha, which is equivalent to FreeImage_ConvertTo32Bits() followed by
+        FreeImage_ConvertToRawBits(), but avoids the intermediate image.
+    */
+    static void copyScanlines(FIBITMAP* pDib, uint8_t* pDst, uint32_t dstPitch, bool isTopDown)
+    {
+        const uint32_t width = FreeImage_GetWidth(pDib);
+        const uint32_t height = FreeImage_GetHeight(pDib);
+        const uint32_t srcBpp = FreeImage_GetBPP(pDib);
+        const uint32_t lineSize = FreeImage_GetLine(pDib);
+
+        forEachRowBlock(height, [&] (uint32_t firstRow, uint32_t rowCount) {
+            for (uint32_t y = firstRow; y < firstRow + rowCount; y++)
+            {
+                const uint8_t* pSrc = FreeImage_GetScanLine(pDib, isTopDown ? height - y - 1 : y);
+                uint8_t* pRow = pDst + size_t(y) * dstPitch;
+                if (srcBpp == 24)
+                {
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        pRow[4 * x + 0] = pSrc[3 * x + 0];
+                        pRow[4 * x + 1] = pSrc[3 * x + 1];
+                        pRow[4 * x + 2] = pSrc[3 * x + 2];
+                        pRow[4 * x + 3] = 0xff;
+                    }
+                }
+                else
+                {
+                    std::memcpy(pRow, pSrc, std::min(lineSize, dstPitch));
+                }
+            }
+        });
+    }
+
     Bitmap::UniqueConstPtr Bitmap::createFromFile(const std::string& filename, bool isTopDown)
     {
         std::string fullpath;
@@ -285,15 +381,8 @@ namespace Falcor
             return nullptr;
         }
 
-        // Convert the image to RGBX image
-        if (bpp == 24)
-        {
-            bpp = 32;
-            auto pNew = FreeImage_ConvertTo32Bits(pDib);
-            FreeImage_Unload(pDib);
-            pDib = pNew;
-        }
-        else if (bpp == 96 && (isRGB32fSupported() == false))
+        // Convert the image to RGBAF image. 24-bit images are expanded to RGBX while copying the scanlines below.
+        if (bpp == 96 && (isRGB32fSupported() == false))
         {
             bpp = 128;
             auto pNew = convertToRGBAF(pDib);
@@ -302,7 +391,14 @@ namespace Falcor
         }
 
         UniqueConstPtr pBmp = UniqueConstPtr(new Bitmap(width, height, format));
-        FreeImage_ConvertToRawBits(pBmp->getData(), pDib, pBmp->getRowPitch(), bpp, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
+        if (bpp == 16)
+        {
+            FreeImage_ConvertToRawBits(pBmp->getData(), pDib, pBmp->getRowPitch(), bpp, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
+        }
+        else
+        {
+            copyScanlines(pDib, pBmp->getData(), pBmp->getRowPitch(), isTopDown);
+        }
         FreeImage_Unload(pDib);
         return pBmp;
     }
@@ -449,7 +545,62 @@ namespace Falcor
         }
     }
 
-    void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData)
+    static int getExrSaveFlags(Bitmap::ExrCompression compression, Bitmap::ExportFlags exportFlags)
+    {
+        switch (compression)
+        {
+        case Bitmap::ExrCompression::Default:
+            if (is_set(exportFlags, Bitmap::ExportFlags::Uncompressed)) return EXR_NONE | EXR_FLOAT;
+            if (is_set(exportFlags, Bitmap::ExportFlags::Lossy)) return EXR_B44 | EXR_ZIP;
+            return 0;
+        case Bitmap::ExrCompression::None:
+            return EXR_NONE | (is_set(exportFlags, Bitmap::ExportFlags::Uncompressed) ? EXR_FLOAT : 0);
+        case Bitmap::ExrCompression::Zip:
+            return EXR_ZIP;
+        case Bitmap::ExrCompression::Piz:
+            return EXR_PIZ;
+        case Bitmap::ExrCompression::Pxr24:
+            return EXR_PXR24;
+        case Bitmap::ExrCompression::B44:
+            return EXR_B44;
+        default:
+            should_not_get_here();
+        }
+        return 0;
+    }
+
+    /** Copies 32-bit pixels into a FreeImage bitmap, flipping rows to FreeImage's bottom-up layout.
+        Swaps the R and B channels if swapRB is set and drops the alpha channel if the destination is 24 bits per pixel.
+    */
+    static void copyToFreeImage32(FIBITMAP* pImage, uint32_t width, uint32_t height, bool isTopDown, bool swapRB, bool forceOpaque, const uint8_t* pData)
+    {
+        const uint32_t dstBytesPerPixel = FreeImage_GetBPP(pImage) / 8;
+        assert(dstBytesPerPixel == 3 || dstBytesPerPixel == 4);
+
+        forEachRowBlock(height, [&] (uint32_t firstRow, uint32_t rowCount) {
+            for (uint32_t y = firstRow; y < firstRow + rowCount; y++)
+            {
+                const uint8_t* pSrc = pData + (size_t)y * width * 4;
+                uint8_t* pDst = FreeImage_GetScanLine(pImage, isTopDown ? height - y - 1 : y);
+                if (dstBytesPerPixel == 4 && !swapRB && !forceOpaque)
+                {
+                    std::memcpy(pDst, pSrc, (size_t)width * 4);
+                    continue;
+                }
+                const uint32_t r = swapRB ? 2 : 0;
+                const uint32_t b = swapRB ? 0 : 2;
+                for (uint32_t x = 0; x < width; x++, pSrc += 4, pDst += dstBytesPerPixel)
+                {
+                    pDst[0] = pSrc[r];
+                    pDst[1] = pSrc[1];
+                    pDst[2] = pSrc[b];
+                    if (dstBytesPerPixel == 4) pDst[3] = forceOpaque ? 0xff : pSrc[3];
+                }
+            }
+        });
+    }
+
+    void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData, ExrCompression exrCompression)
     {
         if (pData == nullptr)
         {
@@ -473,22 +624,6 @@ namespace Falcor
         FIBITMAP* pImage = nullptr;
         uint32_t bytesPerPixel = getFormatBytesPerBlock(resourceFormat);
 
-        // TODO: Replace this code for swapping channels. Can't use freeimage masks b/c they only care about 16 bpp images.
-        if (resourceFormat == ResourceFormat::RGBA8Unorm || resourceFormat == ResourceFormat::RGBA8Snorm || resourceFormat == ResourceFormat::RGBA8UnormSrgb)
-        {
-            for (uint32_t a = 0; a < width*height; a++)
-            {
-                uint32_t* pPixel = (uint32_t*)pData;
-                pPixel += a;
-                uint8_t* ch = (uint8_t*)pPixel;
-                std::swap(ch[0], ch[2]);
-                if (is_set(exportFlags, ExportFlags::ExportAlpha) == false)
-                {
-                    ch[3] = 0xff;
-                }
-            }
-        }
-
         if (fileFormat == Bitmap::FileFormat::PfmFile || fileFormat == Bitmap::FileFormat::ExrFile)
         {
             std::vector<float> floatData;
@@ -531,51 +666,58 @@ namespace Falcor
             bool scanlineCopy = exportAlpha ? bytesPerPixel == 16 : bytesPerPixel == 12;
 
             pImage = FreeImage_AllocateT(exportAlpha ? FIT_RGBAF : FIT_RGBF, width, height);
-            BYTE* head = (BYTE*)pData;
-            for (unsigned y = 0; y < height; y++)
-            {
-                float* dstBits = (float*)FreeImage_GetScanLine(pImage, height - y - 1);
-                if (scanlineCopy)
-                {
-                    std::memcpy(dstBits, head, bytesPerPixel * width);
-                }
-                else
+            const BYTE* pSrcData = (const BYTE*)pData;
+            forEachRowBlock(height, [&] (uint32_t firstRow, uint32_t rowCount) {
+                for (uint32_t y = firstRow; y < firstRow + rowCount; y++)
                 {
-                    assert(exportAlpha == false);
-                    for (unsigned x = 0; x < width; x++)
+                    const float* srcBits = (const float*)(pSrcData + (size_t)y * bytesPerPixel * width);
+                    float* dstBits = (float*)FreeImage_GetScanLine(pImage, height - y - 1);
+                    if (scanlineCopy)
                     {
-                        dstBits[x*3 + 0] = (((float*)head)[x*4 + 0]);
-                        dstBits[x*3 + 1] = (((float*)head)[x*4 + 1]);
-                        dstBits[x*3 + 2] = (((float*)head)[x*4 + 2]);
+                        std::memcpy(dstBits, srcBits, bytesPerPixel * width);
+                    }
+                    else
+                    {
+                        assert(exportAlpha == false);
+                        for (unsigned x = 0; x < width; x++)
+                        {
+                            dstBits[x*3 + 0] = srcBits[x*4 + 0];
+                            dstBits[x*3 + 1] = srcBits[x*4 + 1];
+                            dstBits[x*3 + 2] = srcBits[x*4 + 2];
+                        }
                     }
                 }
-                head += bytesPerPixel * width;
-            }
+            });
 
             if (fileFormat == Bitmap::FileFormat::ExrFile)
             {
-                flags = 0;
-                if (is_set(exportFlags, ExportFlags::Uncompressed))
-                {
-                    flags |= EXR_NONE | EXR_FLOAT;
-                }
-                else if (is_set(exportFlags, ExportFlags::Lossy))
-                {
-                    flags |= EXR_B44 | EXR_ZIP;
-                }
+                flags = getExrSaveFlags(exrCompression, exportFlags);
             }
         }
         else
         {
-            FIBITMAP* pTemp = FreeImage_ConvertFromRawBits((BYTE*)pData, width, height, bytesPerPixel * width, bytesPerPixel * 8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
-            if (is_set(exportFlags, ExportFlags::ExportAlpha) == false || fileFormat == Bitmap::FileFormat::JpegFile)
+            const bool exportAlpha = is_set(exportFlags, ExportFlags::ExportAlpha) && fileFormat != Bitmap::FileFormat::JpegFile;
+            if (bytesPerPixel == 4)
             {
-                pImage = FreeImage_ConvertTo24Bits(pTemp);
-                FreeImage_Unload(pTemp);
+                // Convert, swizzle and flip into the FreeImage bitmap in a single parallel pass.
+                // FreeImage stores 32-bit pixels as BGRA. Other 32-bit formats are passed through unchanged.
+                const bool isRGBA8 = resourceFormat == ResourceFormat::RGBA8Unorm || resourceFormat == ResourceFormat::RGBA8Snorm || resourceFormat == ResourceFormat::RGBA8UnormSrgb;
+                const bool forceOpaque = isRGBA8 && !is_set(exportFlags, ExportFlags::ExportAlpha);
+                pImage = FreeImage_Allocate(width, height, exportAlpha ? 32 : 24, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK);
+                copyToFreeImage32(pImage, width, height, isTopDown, isRGBA8, forceOpaque, (const uint8_t*)pData);
             }
             else
             {
-                pImage = pTemp;
+                FIBITMAP* pTemp = FreeImage_ConvertFromRawBits((BYTE*)pData, width, height, bytesPerPixel * width, bytesPerPixel * 8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
+                if (!exportAlpha)
+                {
+                    pImage = FreeImage_ConvertTo24Bits(pTemp);
+                    FreeImage_Unload(pTemp);
+                }
+                else
+                {
+                    pImage = pTemp;
+                }
             }
 
             std::vector<std::string> warnings;
@@ -56,6 +56,18 @@ namespace Falcor
                         //< See ImageIO. TODO: Remove(?) Bitmap IO implementation when ImageIO supports other formats
         };
 
+        /** Compression used when saving EXR files.
+        */
+        enum class ExrCompression
+        {
+            Default,    //< Derived from the export flags: PIZ, or none if ExportFlags::Uncompressed, or B44 if ExportFlags::Lossy
+            None,       //< No compression, fastest to write
+            Zip,        //< Lossless zlib compression of 16-scanline blocks
+            Piz,        //< Lossless wavelet compression, good for noisy images
+            Pxr24,      //< Lossy 24-bit float compression
+            B44,        //< Lossy fixed-rate compression of 4x4 blocks, fast to write and decode
+        };
+
         using UniquePtr = std::unique_ptr<Bitmap>;
         using UniqueConstPtr = std::unique_ptr<const Bitmap>;
 
@@ -84,8 +96,10 @@ namespace Falcor
             \param[in] ResourceFormat the format of the resource data
             \param[in] isTopDown Control the memory layout of the image. If true, the top-left pixel will be stored first, otherwise the bottom-left pixel will be stored first
             \param[in] pData Pointer to the buffer containing the image
+            \param[in] exrCompression Compression to use for EXR files. Ignored for other file formats.
+            Pixel format conversion and row flipping are done in parallel over rows. The buffer is not modified.
         */
-        static void saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData);
+        static void saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData, ExrCompression exrCompression = ExrCompression::Default);
 
         /**  Open dialog to save image to a file
             \param[in] pTexture Texture to save to file
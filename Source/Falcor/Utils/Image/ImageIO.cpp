@@ -28,6 +28,9 @@
 #include "stdafx.h"
 #include "ImageIO.h"
 #include "DirectXTex.h"
+#include "Utils/NumericRange.h"
+#include <atomic>
+#include <execution>
 #include <filesystem>
 
 namespace Falcor
@@ -160,19 +163,105 @@ namespace Falcor
             }
         }
 
-        void compress(ApiImage& image, ImageIO::CompressionMode mode)
+        /** Number of block rows compressed per work item.
+        */
+        const size_t kBlockRowsPerTask = 16;
+
+        DirectX::TEX_COMPRESS_FLAGS getCompressFlags(ImageIO::CompressionMode mode, ImageIO::CompressionQuality quality)
+        {
+            switch (mode)
+            {
+            case ImageIO::CompressionMode::BC1:
+            case ImageIO::CompressionMode::BC2:
+            case ImageIO::CompressionMode::BC3:
+                return quality == ImageIO::CompressionQuality::High ? DirectX::TEX_COMPRESS_DITHER : DirectX::TEX_COMPRESS_DEFAULT;
+            case ImageIO::CompressionMode::BC7:
+                if (quality == ImageIO::CompressionQuality::Fast) return DirectX::TEX_COMPRESS_BC7_QUICK;
+                if (quality == ImageIO::CompressionQuality::High) return DirectX::TEX_COMPRESS_BC7_USE_3SUBSETS;
+                return DirectX::TEX_COMPRESS_DEFAULT;
+            default:
+                return DirectX::TEX_COMPRESS_DEFAULT;
+            }
+        }
+
+        /** Compresses a set of images with the layout described by meta.
+            Each image is split into strips of block rows that are compressed in parallel. Blocks are encoded independently,
+            so the result is identical to compressing the whole image at once.
+        */
+        void compressImages(const DirectX::Image* pImages, size_t imageCount, const DirectX::TexMetadata& meta, DXGI_FORMAT format, DirectX::TEX_COMPRESS_FLAGS flags, DirectX::ScratchImage& result)
+        {
+            DirectX::TexMetadata compressedMeta = meta;
+            compressedMeta.format = format;
+            if (FAILED(result.Initialize(compressedMeta)) || result.GetImageCount() != imageCount)
+            {
+                throw std::exception("Failed to allocate compressed image.");
+            }
+
+            struct Strip
+            {
+                size_t image;
+                size_t firstRow;
+                size_t rowCount;
+            };
+
+            std::vector<Strip> strips;
+            for (size_t i = 0; i < imageCount; i++)
+            {
+                const size_t height = pImages[i].height;
+                for (size_t y = 0; y < height; y += 4 * kBlockRowsPerTask)
+                {
+                    strips.push_back({ i, y, std::min(4 * kBlockRowsPerTask, height - y) });
+                }
+            }
+
+            std::atomic<bool> failed = false;
+            std::for_each(std::execution::par, strips.begin(), strips.end(), [&] (const Strip& strip) {
+                const DirectX::Image& src = pImages[strip.image];
+                DirectX::Image srcStrip = src;
+                srcStrip.height = strip.rowCount;
+                srcStrip.pixels = src.pixels + strip.firstRow * src.rowPitch;
+                srcStrip.slicePitch = strip.rowCount * src.rowPitch;
+
+                DirectX::ScratchImage compressedStrip;
+                if (FAILED(DirectX::Compress(srcStrip, format, flags, DirectX::TEX_THRESHOLD_DEFAULT, compressedStrip)))
+                {
+                    failed = true;
+                    return;
+                }
+
+                const DirectX::Image& dst = result.GetImages()[strip.image];
+                const DirectX::Image* pCompressed = compressedStrip.GetImage(0, 0, 0);
+                assert(pCompressed->rowPitch == dst.rowPitch);
+                std::memcpy(dst.pixels + (strip.firstRow / 4) * dst.rowPitch, pCompressed->pixels, pCompressed->slicePitch);
+            });
+
+            if (failed)
+            {
+                throw std::exception("Failed to compress.");
+            }
+        }
+
+        void compress(ApiImage& image, ImageIO::CompressionMode mode, ImageIO::CompressionQuality quality)
         {
             if (isCompressedFormat(getResourceFormat(image.getFormat())))
             {
                 throw std::exception("Image is already compressed.");
             }
 
-            const DirectX::TEX_COMPRESS_FLAGS flags = mode == ImageIO::CompressionMode::BC7 ? DirectX::TEX_COMPRESS_BC7_QUICK : DirectX::TEX_COMPRESS_DEFAULT;
+            const DirectX::TEX_COMPRESS_FLAGS flags = getCompressFlags(mode, quality);
 
-            HRESULT result = S_OK;
             if (image.isSingleImage())
             {
-                result = DirectX::Compress(image.image, asCompressedFormat(image.getFormat(), mode), flags, DirectX::TEX_THRESHOLD_DEFAULT, image.scratchImage);
+                DirectX::TexMetadata meta = {};
+                meta.width = image.image.width;
+                meta.height = image.image.height;
+                meta.depth = 1;
+                meta.arraySize = 1;
+                meta.mipLevels = 1;
+                meta.format = image.image.format;
+                meta.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+                compressImages(&image.image, 1, meta, asCompressedFormat(meta.format, mode), flags, image.scratchImage);
 
                 // Clear bitmap since compression outputted to the scratchImage
                 image.image = {};
@@ -183,18 +272,13 @@ namespace Falcor
                 DirectX::ScratchImage inputImage(std::move(image.scratchImage));
                 const auto& meta = inputImage.GetMetadata();
 
-                result = DirectX::Compress(inputImage.GetImages(), inputImage.GetImageCount(), meta, asCompressedFormat(meta.format, mode), flags, DirectX::TEX_THRESHOLD_DEFAULT, image.scratchImage);
-            }
-
-            if (FAILED(result))
-            {
-                throw std::exception("Failed to compress.");
+                compressImages(inputImage.GetImages(), inputImage.GetImageCount(), meta, asCompressedFormat(meta.format, mode), flags, image.scratchImage);
             }
         }
 
         /** Saves image data to a DDS file. Optionally compresses image.
         */
-        void exportDDS(const std::string& filename, ApiImage& image, ImageIO::CompressionMode mode)
+        void exportDDS(const std::string& filename, ApiImage& image, ImageIO::CompressionMode mode, ImageIO::CompressionQuality quality)
         {
             validateSavePath(filename);
 
@@ -203,7 +287,7 @@ namespace Falcor
             {
                 if (mode != ImageIO::CompressionMode::None)
                 {
-                    compress(image, mode);
+                    compress(image, mode, quality);
                 }
             }
             catch (const std::exception& e)
@@ -230,6 +314,88 @@ namespace Falcor
                 throw std::exception(("Failed to export " + filename).c_str());
             }
         }
+
+        bool isBatchInput(const std::filesystem::path& path)
+        {
+            static const std::string kExtensions[] = { "png", "jpg", "jpeg", "tga", "bmp", "hdr", "exr", "pfm", "tif", "tiff" };
+            std::string ext = getExtensionFromFile(path.string());
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            return std::find(std::begin(kExtensions), std::end(kExtensions), ext) != std::end(kExtensions);
+        }
+
+        ImageIO::CompressionMode selectCompressionMode(ResourceFormat format)
+        {
+            if (getFormatType(format) == FormatType::Float) return ImageIO::CompressionMode::BC6;
+            switch (getFormatChannelCount(format))
+            {
+            case 1: return ImageIO::CompressionMode::BC4;
+            case 2: return ImageIO::CompressionMode::BC5;
+            default: return ImageIO::CompressionMode::BC7;
+            }
+        }
+
+        /** Builds a single-level mip chain from a bitmap. RGB16Float images are expanded to RGBA16Float, which can be stored in DDS files.
+        */
+        MipGenerator::MipChain createSingleLevelChain(const Bitmap& bitmap)
+        {
+            MipGenerator::MipChain chain;
+            chain.width = bitmap.getWidth();
+            chain.height = bitmap.getHeight();
+            chain.format = bitmap.getFormat();
+            chain.offsets.push_back(0);
+
+            if (chain.format == ResourceFormat::RGB16Float)
+            {
+                const uint16_t kOne = 0x3c00; // 1.0 in half precision
+                const size_t pixelCount = size_t(chain.width) * chain.height;
+                const uint16_t* pSrc = reinterpret_cast<const uint16_t*>(bitmap.getData());
+                chain.format = ResourceFormat::RGBA16Float;
+                chain.data.resize(pixelCount * 8);
+                uint16_t* pDst = reinterpret_cast<uint16_t*>(chain.data.data());
+                for (size_t i = 0; i < pixelCount; i++)
+                {
+                    pDst[4 * i + 0] = pSrc[3 * i + 0];
+                    pDst[4 * i + 1] = pSrc[3 * i + 1];
+                    pDst[4 * i + 2] = pSrc[3 * i + 2];
+                    pDst[4 * i + 3] = kOne;
+                }
+            }
+            else
+            {
+                chain.data.assign(bitmap.getData(), bitmap.getData() + bitmap.getSize());
+            }
+            return chain;
+        }
+
+        void convertImageToDDS(const std::filesystem::path& src, const std::filesystem::path& dst, const ImageIO::BatchDesc& desc)
+        {
+            Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(src.string(), true);
+            if (!pBitmap) throw std::exception("Failed to load image.");
+
+            MipGenerator::MipChain chain = createSingleLevelChain(*pBitmap);
+            if (desc.generateMips && MipGenerator::isFormatSupported(chain.format))
+            {
+                // Generate from the expanded level, as it has a format that can be stored.
+                auto pLevel = Bitmap::create(chain.width, chain.height, chain.format, chain.data.data());
+                chain = MipGenerator::generate(*pLevel, desc.mipFilter, desc.srgb);
+            }
+            if (desc.srgb) chain.format = linearToSrgbFormat(chain.format);
+
+            ImageIO::CompressionMode mode = desc.autoSelectMode ? selectCompressionMode(chain.format) : desc.mode;
+
+            std::filesystem::create_directories(dst.parent_path());
+            ImageIO::saveToDDS(dst.string(), chain, mode, desc.quality);
+        }
+    }
+
+    pybind11::dict ImageIO::BatchReport::toPython() const
+    {
+        pybind11::dict d;
+        d["filesConverted"] = filesConverted;
+        d["filesSkipped"] = filesSkipped;
+        d["filesFailed"] = filesFailed;
+        d["timeMs"] = timeMs;
+        return d;
     }
 
     Bitmap::UniqueConstPtr ImageIO::loadBitmapFromDDS(const std::string& filename)
@@ -284,7 +450,7 @@ namespace Falcor
         return pTex;
     }
 
-    void ImageIO::saveToDDS(const std::string& filename, const Bitmap& bitmap, CompressionMode mode)
+    void ImageIO::saveToDDS(const std::string& filename, const Bitmap& bitmap, CompressionMode mode, CompressionQuality quality)
     {
         ApiImage image;
         image.image.width = bitmap.getWidth();
@@ -294,10 +460,49 @@ namespace Falcor
         image.image.slicePitch = bitmap.getSize();
         image.image.pixels = bitmap.getData();
 
-        exportDDS(filename, image, mode);
+        exportDDS(filename, image, mode, quality);
+    }
+
+    void ImageIO::saveToDDS(const std::string& filename, const MipGenerator::MipChain& mipChain, CompressionMode mode, CompressionQuality quality)
+    {
+        DirectX::TexMetadata meta = {};
+        meta.width = mipChain.width;
+        meta.height = mipChain.height;
+        meta.depth = 1;
+        meta.arraySize = 1;
+        meta.mipLevels = mipChain.getMipCount();
+        meta.format = getDxgiFormat(mipChain.format);
+        meta.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+        if (meta.format == DXGI_FORMAT_UNKNOWN)
+        {
+            throw std::exception(("saveToDDS: Format " + to_string(mipChain.format) + " cannot be stored in a DDS file.").c_str());
+        }
+
+        ApiImage image;
+        auto& scratchImage = image.scratchImage;
+        if (FAILED(scratchImage.Initialize(meta)))
+        {
+            throw std::exception("saveToDDS: Failed to allocate image.");
+        }
+
+        const size_t bytesPerPixel = getFormatBytesPerBlock(mipChain.format);
+        for (uint32_t m = 0; m < mipChain.getMipCount(); m++)
+        {
+            const DirectX::Image* pImage = scratchImage.GetImage(m, 0, 0);
+            const uint8_t* pSrc = mipChain.getMipData(m);
+            const size_t rowSize = mipChain.getMipWidth(m) * bytesPerPixel;
+            assert(pImage->rowPitch >= rowSize);
+            for (uint32_t y = 0; y < mipChain.getMipHeight(m); y++)
+            {
+                std::memcpy(pImage->pixels + y * pImage->rowPitch, pSrc + y * rowSize, rowSize);
+            }
+        }
+
+        exportDDS(filename, image, mode, quality);
     }
 
-    void ImageIO::saveToDDS(CopyContext* pContext, const std::string& filename, const Texture::SharedPtr& pTexture, CompressionMode mode)
+    void ImageIO::saveToDDS(CopyContext* pContext, const std::string& filename, const Texture::SharedPtr& pTexture, CompressionMode mode, CompressionQuality quality)
     {
         DirectX::TexMetadata meta = {};
         meta.width = pTexture->getWidth();
@@ -343,7 +548,106 @@ namespace Falcor
             }
         }
 
-        exportDDS(filename, image, mode);
+        exportDDS(filename, image, mode, quality);
+    }
+
+    ImageIO::BatchReport ImageIO::convertDirectoryToDDS(const BatchDesc& desc)
+    {
+        namespace fs = std::filesystem;
+        auto startTime = CpuTimer::getCurrentTimePoint();
+
+        const fs::path srcDir = fs::absolute(desc.srcDirectory);
+        if (!fs::is_directory(srcDir))
+        {
+            throw std::exception(("convertDirectoryToDDS: " + desc.srcDirectory + " is not a directory.").c_str());
+        }
+        const fs::path dstDir = desc.dstDirectory.empty() ? srcDir : fs::absolute(desc.dstDirectory);
+
+        std::vector<fs::path> files;
+        auto addFile = [&] (const fs::directory_entry& entry) { if (entry.is_regular_file() && isBatchInput(entry.path())) files.push_back(entry.path()); };
+        if (desc.recursive)
+        {
+            for (const auto& entry : fs::recursive_directory_iterator(srcDir)) addFile(entry);
+        }
+        else
+        {
+            for (const auto& entry : fs::directory_iterator(srcDir)) addFile(entry);
+        }
+
+        // Convert the images in parallel. Each conversion also compresses its blocks in parallel.
+        std::atomic<uint32_t> converted = 0;
+        std::atomic<uint32_t> skipped = 0;
+        std::atomic<uint32_t> failed = 0;
+        std::for_each(std::execution::par, files.begin(), files.end(), [&] (const fs::path& src) {
+            fs::path dst = dstDir / fs::relative(src, srcDir);
+            dst.replace_extension(".dds");
+
+            if (!desc.overwrite && fs::exists(dst) && fs::last_write_time(dst) >= fs::last_write_time(src))
+            {
+                skipped++;
+                return;
+            }
+
+            try
+            {
+                convertImageToDDS(src, dst, desc);
+                converted++;
+            }
+            catch (const std::exception& e)
+            {
+                logWarning("convertDirectoryToDDS: Failed to convert '" + src.string() + "' (" + e.what() + ").");
+                failed++;
+            }
+        });
+
+        BatchReport report;
+        report.filesConverted = converted;
+        report.filesSkipped = skipped;
+        report.filesFailed = failed;
+        report.timeMs = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+
+        logInfo("convertDirectoryToDDS: Converted " + std::to_string(report.filesConverted) + " images (" + std::to_string(report.filesSkipped) + " up-to-date, " +
+            std::to_string(report.filesFailed) + " failed) in " + std::to_string(report.timeMs / 1000.0) + " s.");
+
+        return report;
     }
 
+    SCRIPT_BINDING(ImageIO)
+    {
+        SCRIPT_BINDING_DEPENDENCY(MipGenerator)
+
+        pybind11::enum_<ImageIO::CompressionMode> compressionMode(m, "CompressionMode");
+        compressionMode.value("BC1", ImageIO::CompressionMode::BC1);
+        compressionMode.value("BC2", ImageIO::CompressionMode::BC2);
+        compressionMode.value("BC3", ImageIO::CompressionMode::BC3);
+        compressionMode.value("BC4", ImageIO::CompressionMode::BC4);
+        compressionMode.value("BC5", ImageIO::CompressionMode::BC5);
+        compressionMode.value("BC6", ImageIO::CompressionMode::BC6);
+        compressionMode.value("BC7", ImageIO::CompressionMode::BC7);
+        compressionMode.value("None", ImageIO::CompressionMode::None);
+
+        pybind11::enum_<ImageIO::CompressionQuality> compressionQuality(m, "CompressionQuality");
+        compressionQuality.value("Fast", ImageIO::CompressionQuality::Fast);
+        compressionQuality.value("Normal", ImageIO::CompressionQuality::Normal);
+        compressionQuality.value("High", ImageIO::CompressionQuality::High);
+
+        auto convertDirectoryToDDS = [] (const std::string& srcDirectory, const std::string& dstDirectory, bool recursive, pybind11::object mode,
+            ImageIO::CompressionQuality quality, bool generateMips, MipGenerator::Filter mipFilter, bool srgb, bool overwrite)
+        {
+            ImageIO::BatchDesc desc;
+            desc.srcDirectory = srcDirectory;
+            desc.dstDirectory = dstDirectory;
+            desc.recursive = recursive;
+            desc.autoSelectMode = mode.is_none();
+            if (!desc.autoSelectMode) desc.mode = mode.cast<ImageIO::CompressionMode>();
+            desc.quality = quality;
+            desc.generateMips = generateMips;
+            desc.mipFilter = mipFilter;
+            desc.srgb = srgb;
+            desc.overwrite = overwrite;
+            return ImageIO::convertDirectoryToDDS(desc).toPython();
+        };
+        m.def("convertDirectoryToDDS", convertDirectoryToDDS, "srcDirectory"_a, "dstDirectory"_a = "", "recursive"_a = true, "mode"_a = pybind11::none(),
+            "quality"_a = ImageIO::CompressionQuality::Normal, "generateMips"_a = true, "mipFilter"_a = MipGenerator::Filter::Kaiser, "srgb"_a = false, "overwrite"_a = false);
+    }
 }
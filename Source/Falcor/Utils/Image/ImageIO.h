@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include "Utils/Image/Bitmap.h"
+#include "Utils/Image/MipGenerator.h"
 #include "Core/API/Texture.h"
 
 namespace Falcor
@@ -76,6 +77,45 @@ namespace Falcor
             None
         };
 
+        /** Quality presets for block compression. Higher quality searches more encoding modes and is slower.
+        */
+        enum class CompressionQuality
+        {
+            Fast,       ///< Fastest encoding. BC7 only tries a minimal set of modes.
+            Normal,     ///< BC7 tries all modes except the 3-subset modes.
+            High,       ///< BC7 tries all modes. BC1-BC3 use dithering.
+        };
+
+        /** Description of a batch conversion of a directory of images to DDS files.
+        */
+        struct BatchDesc
+        {
+            std::string srcDirectory;                           ///< Directory to search for images (png, jpg, tga, bmp, hdr, exr, pfm, tif).
+            std::string dstDirectory;                           ///< Output directory, mirroring the source directory structure. If empty, DDS files are written next to the images.
+            bool recursive = true;                              ///< Include subdirectories.
+            bool autoSelectMode = true;                         ///< Select the compression mode per image: BC4 for one channel, BC5 for two channels, BC6 for float images and BC7 otherwise.
+            CompressionMode mode = CompressionMode::BC7;        ///< Compression mode used for all images if autoSelectMode is false.
+            CompressionQuality quality = CompressionQuality::Normal;
+            bool generateMips = true;                           ///< Generate full mip chains on the CPU (see MipGenerator).
+            MipGenerator::Filter mipFilter = MipGenerator::Filter::Kaiser;
+            bool srgb = false;                                  ///< Treat 8-bit color images as sRGB. Mips are filtered in linear space and sRGB formats are written.
+            bool overwrite = false;                             ///< Convert all images. Otherwise, images are skipped if their DDS file is newer.
+        };
+
+        /** Result of a batch conversion.
+        */
+        struct BatchReport
+        {
+            uint32_t filesConverted = 0;
+            uint32_t filesSkipped = 0;                          ///< Images skipped because their DDS file was up-to-date.
+            uint32_t filesFailed = 0;
+            double timeMs = 0.0;
+
+            /** Convert to python dict.
+            */
+            pybind11::dict toPython() const;
+        };
+
         /** Load a DDS file to a Bitmap. If the file contains an image array and/or mips, only the first image will be loaded.
             Throws an exception if file cannot be found or there is a loading error.
             \param[in] filename Path of file to load.
@@ -96,9 +136,19 @@ namespace Falcor
             \param[in] filename Filename to save to.
             \param[in] bitmap Bitmap object to save.
             \param[in] mode Block compression mode. By default, will save data as-is and will not decompress if already compressed.
+            \param[in] quality Block compression quality preset.
         */
-        static void saveToDDS(const std::string& filename, const Bitmap& bitmap, CompressionMode mode = CompressionMode::None);
-        static void saveToDDS(const std::string& filename, const Bitmap::UniqueConstPtr& pBitmap, CompressionMode mode = CompressionMode::None);
+        static void saveToDDS(const std::string& filename, const Bitmap& bitmap, CompressionMode mode = CompressionMode::None, CompressionQuality quality = CompressionQuality::Fast);
+        static void saveToDDS(const std::string& filename, const Bitmap::UniqueConstPtr& pBitmap, CompressionMode mode = CompressionMode::None, CompressionQuality quality = CompressionQuality::Fast);
+
+        /** Saves a mip chain generated on the CPU to a DDS file. All levels are saved.
+            Throws an exception if filename is invalid, the format cannot be stored in a DDS file or the image cannot be saved.
+            \param[in] filename Filename to save to.
+            \param[in] mipChain Mip chain to save.
+            \param[in] mode Block compression mode. By default, will save data as-is.
+            \param[in] quality Block compression quality preset.
+        */
+        static void saveToDDS(const std::string& filename, const MipGenerator::MipChain& mipChain, CompressionMode mode = CompressionMode::None, CompressionQuality quality = CompressionQuality::Fast);
 
         /** Saves a Texture to a DDS file. All mips and array images are saved.
             Throws an exception of filename is invalid or image cannot be saved.
@@ -109,8 +159,18 @@ namespace Falcor
             \param[in] filename Filename to save to.
             \param[in] pBitmap Bitmap object to save.
             \param[in] mode Block compression mode. By default, will save data as-is and will not decompress if already compressed.
+            \param[in] quality Block compression quality preset.
+        */
+        static void saveToDDS(CopyContext* pContext, const std::string& filename, const Texture::SharedPtr& pTexture, CompressionMode mode = CompressionMode::None, CompressionQuality quality = CompressionQuality::Fast);
+
+        /** Convert all images in a directory to DDS files, optionally with mips and block compression.
+            Images are converted in parallel and the blocks of each image are compressed in parallel.
+            Images that fail to convert are reported as warnings and counted in the report.
+            Throws an exception if the source directory does not exist.
+            \param[in] desc Batch description.
+            \return Report of the conversion.
         */
-        static void saveToDDS(CopyContext* pContext, const std::string& filename, const Texture::SharedPtr& pTexture, CompressionMode mode = CompressionMode::None);
+        static BatchReport convertDirectoryToDDS(const BatchDesc& desc);
     };
 
 }
@@ -0,0 +1,449 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "MipGenerator.h"
+#include "ImageIO.h"
+#include "Utils/NumericRange.h"
+#include "Utils/StringUtils.h"
+#include "glm/gtc/constants.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include <array>
+#include <emmintrin.h>
+#include <execution>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kRowsPerTask = 16;   ///< Number of rows processed per work item.
+        const float kKaiserWidth = 3.f;     ///< Kaiser filter support radius in destination pixels.
+        const float kKaiserAlpha = 4.f;     ///< Kaiser window shape parameter.
+
+        /** Calls func(row) for all rows in parallel, in blocks of kRowsPerTask rows.
+        */
+        template<typename Func>
+        void forEachRow(uint32_t height, Func func)
+        {
+            uint32_t blockCount = (height + kRowsPerTask - 1) / kRowsPerTask;
+            auto range = NumericRange<uint32_t>(0, blockCount);
+            std::for_each(std::execution::par, range.begin(), range.end(), [&] (uint32_t block) {
+                uint32_t lastRow = std::min(height, (block + 1) * kRowsPerTask);
+                for (uint32_t row = block * kRowsPerTask; row < lastRow; row++) func(row);
+            });
+        }
+
+        /** Pixel layout of a supported format.
+        */
+        struct PixelLayout
+        {
+            enum class Type { Unorm8, Float16, Float32 };
+            Type type;
+            uint32_t channelCount;
+            uint32_t bytesPerPixel;
+        };
+
+        bool getPixelLayout(ResourceFormat format, PixelLayout& layout)
+        {
+            if (format == ResourceFormat::Unknown || isCompressedFormat(format) || isDepthStencilFormat(format)) return false;
+
+            uint32_t channelCount = getFormatChannelCount(format);
+            uint32_t bits = getNumChannelBits(format, 0);
+            for (uint32_t c = 1; c < channelCount; c++)
+            {
+                if (getNumChannelBits(format, c) != bits) return false;
+            }
+            if (channelCount == 0 || channelCount > 4 || getFormatBytesPerBlock(format) != channelCount * bits / 8) return false;
+
+            FormatType type = getFormatType(format);
+            if ((type == FormatType::Unorm || type == FormatType::UnormSrgb) && bits == 8) layout.type = PixelLayout::Type::Unorm8;
+            else if (type == FormatType::Float && bits == 16) layout.type = PixelLayout::Type::Float16;
+            else if (type == FormatType::Float && bits == 32) layout.type = PixelLayout::Type::Float32;
+            else return false;
+
+            layout.channelCount = channelCount;
+            layout.bytesPerPixel = getFormatBytesPerBlock(format);
+            return true;
+        }
+
+        float srgbToLinear(float v)
+        {
+            return v <= 0.04045f ? v * (1.f / 12.92f) : std::pow((v + 0.055f) * (1.f / 1.055f), 2.4f);
+        }
+
+        float linearToSrgb(float v)
+        {
+            return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.f / 2.4f) - 0.055f;
+        }
+
+        const float* getSrgbToLinearTable()
+        {
+            static const auto table = [] () {
+                std::array<float, 256> t;
+                for (uint32_t i = 0; i < 256; i++) t[i] = srgbToLinear(i / 255.f);
+                return t;
+            }();
+            return table.data();
+        }
+
+        /** Image with four float channels per pixel, used as working format.
+        */
+        struct FloatImage
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<float4> pixels;
+
+            void resize(uint32_t w, uint32_t h) { width = w; height = h; pixels.resize(size_t(w) * h); }
+            float4* getRow(uint32_t y) { return pixels.data() + size_t(y) * width; }
+            const float4* getRow(uint32_t y) const { return pixels.data() + size_t(y) * width; }
+        };
+
+        void decodeImage(const uint8_t* pSrc, const PixelLayout& layout, bool linearize, FloatImage& image)
+        {
+            const float* pSrgbTable = getSrgbToLinearTable();
+            const uint32_t colorChannels = linearize ? std::min(3u, layout.channelCount) : 0;
+            const size_t rowPitch = size_t(image.width) * layout.bytesPerPixel;
+
+            forEachRow(image.height, [&] (uint32_t y) {
+                const uint8_t* pRow = pSrc + y * rowPitch;
+                float4* pDst = image.getRow(y);
+                for (uint32_t x = 0; x < image.width; x++)
+                {
+                    float4 v(0.f, 0.f, 0.f, 1.f);
+                    for (uint32_t c = 0; c < layout.channelCount; c++)
+                    {
+                        size_t i = size_t(x) * layout.channelCount + c;
+                        switch (layout.type)
+                        {
+                        case PixelLayout::Type::Unorm8:
+                            v[c] = c < colorChannels ? pSrgbTable[pRow[i]] : pRow[i] * (1.f / 255.f);
+                            break;
+                        case PixelLayout::Type::Float16:
+                            v[c] = glm::unpackHalf1x16(reinterpret_cast<const uint16_t*>(pRow)[i]);
+                            break;
+                        case PixelLayout::Type::Float32:
+                            v[c] = reinterpret_cast<const float*>(pRow)[i];
+                            break;
+                        }
+                    }
+                    pDst[x] = v;
+                }
+            });
+        }
+
+        void encodeImage(const FloatImage& image, const PixelLayout& layout, bool linearize, uint8_t* pDst)
+        {
+            const uint32_t colorChannels = linearize ? std::min(3u, layout.channelCount) : 0;
+            const size_t rowPitch = size_t(image.width) * layout.bytesPerPixel;
+
+            forEachRow(image.height, [&] (uint32_t y) {
+                const float4* pSrc = image.getRow(y);
+                uint8_t* pRow = pDst + y * rowPitch;
+                for (uint32_t x = 0; x < image.width; x++)
+                {
+                    for (uint32_t c = 0; c < layout.channelCount; c++)
+                    {
+                        size_t i = size_t(x) * layout.channelCount + c;
+                        float v = pSrc[x][c];
+                        switch (layout.type)
+                        {
+                        case PixelLayout::Type::Unorm8:
+                            v = glm::clamp(v, 0.f, 1.f);
+                            if (c < colorChannels) v = linearToSrgb(v);
+                            pRow[i] = (uint8_t)(v * 255.f + 0.5f);
+                            break;
+                        case PixelLayout::Type::Float16:
+                            reinterpret_cast<uint16_t*>(pRow)[i] = glm::packHalf1x16(v);
+                            break;
+                        case PixelLayout::Type::Float32:
+                            reinterpret_cast<float*>(pRow)[i] = v;
+                            break;
+                        }
+                    }
+                }
+            });
+        }
+
+        /** Modified Bessel function of the first kind of order zero.
+        */
+        float besselI0(float x)
+        {
+            float sum = 1.f;
+            float term = 1.f;
+            float halfX = 0.5f * x;
+            for (uint32_t k = 1; k < 32; k++)
+            {
+                term *= (halfX / k) * (halfX / k);
+                sum += term;
+                if (term < sum * 1e-7f) break;
+            }
+            return sum;
+        }
+
+        float evalKaiser(float t)
+        {
+            float x = t / kKaiserWidth;
+            if (std::abs(x) >= 1.f) return 0.f;
+            float sinc = t == 0.f ? 1.f : std::sin(glm::pi<float>() * t) / (glm::pi<float>() * t);
+            return sinc * besselI0(kKaiserAlpha * std::sqrt(1.f - x * x)) / besselI0(kKaiserAlpha);
+        }
+
+        /** One-dimensional resampling kernel with a fixed number of taps per destination pixel.
+            Source indices are clamped to the image (clamp addressing).
+        */
+        struct Kernel1D
+        {
+            uint32_t tapCount = 0;
+            std::vector<uint32_t> indices;  ///< Source index of each tap, tapCount entries per destination pixel.
+            std::vector<float> weights;     ///< Normalized weight of each tap.
+        };
+
+        Kernel1D createKernel(uint32_t srcSize, uint32_t dstSize, MipGenerator::Filter filter)
+        {
+            const float scale = float(srcSize) / float(dstSize); // Source pixels per destination pixel.
+            const bool isBox = filter == MipGenerator::Filter::Box;
+            const float srcRadius = (isBox ? 0.5f : kKaiserWidth) * scale;
+
+            // Box footprints are aligned to source pixels if the sizes divide evenly, otherwise they can straddle one extra pixel.
+            Kernel1D kernel;
+            kernel.tapCount = (uint32_t)std::ceil(2.f * srcRadius) + (isBox && srcSize % dstSize == 0 ? 0 : 1);
+            kernel.indices.reserve(size_t(dstSize) * kernel.tapCount);
+            kernel.weights.reserve(size_t(dstSize) * kernel.tapCount);
+
+            for (uint32_t x = 0; x < dstSize; x++)
+            {
+                const float center = (x + 0.5f) * scale;
+                const int first = isBox ? (int)std::floor(center - srcRadius) : (int)std::ceil(center - srcRadius - 0.5f);
+                size_t start = kernel.weights.size();
+                float sum = 0.f;
+
+                for (uint32_t t = 0; t < kernel.tapCount; t++)
+                {
+                    int i = first + (int)t;
+                    float w = 0.f;
+                    if (isBox)
+                    {
+                        // Overlap of the source pixel with the destination pixel footprint.
+                        float lo = std::max(float(i), center - srcRadius);
+                        float hi = std::min(float(i + 1), center + srcRadius);
+                        w = std::max(0.f, hi - lo);
+                    }
+                    else
+                    {
+                        w = evalKaiser((i + 0.5f - center) / scale);
+                    }
+                    sum += w;
+                    kernel.indices.push_back((uint32_t)glm::clamp(i, 0, (int)srcSize - 1));
+                    kernel.weights.push_back(w);
+                }
+
+                assert(sum > 0.f);
+                for (size_t j = start; j < kernel.weights.size(); j++) kernel.weights[j] /= sum;
+            }
+
+            return kernel;
+        }
+
+        /** Downsample an image with a separable filter. The horizontal pass writes to a temporary image of size dstWidth x srcHeight.
+        */
+        void downsample(const FloatImage& src, FloatImage& tmp, FloatImage& dst, MipGenerator::Filter filter)
+        {
+            const Kernel1D kernelX = createKernel(src.width, dst.width, filter);
+            const Kernel1D kernelY = createKernel(src.height, dst.height, filter);
+
+            tmp.resize(dst.width, src.height);
+
+            forEachRow(src.height, [&] (uint32_t y) {
+                const float* pSrc = &src.getRow(y)->x;
+                float* pDst = &tmp.getRow(y)->x;
+                const uint32_t* pIndex = kernelX.indices.data();
+                const float* pWeight = kernelX.weights.data();
+                for (uint32_t x = 0; x < dst.width; x++)
+                {
+                    __m128 acc = _mm_setzero_ps();
+                    for (uint32_t t = 0; t < kernelX.tapCount; t++, pIndex++, pWeight++)
+                    {
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(*pWeight), _mm_loadu_ps(pSrc + 4 * size_t(*pIndex))));
+                    }
+                    _mm_storeu_ps(pDst + 4 * size_t(x), acc);
+                }
+            });
+
+            forEachRow(dst.height, [&] (uint32_t y) {
+                float* pDst = &dst.getRow(y)->x;
+                const size_t kernelOffset = size_t(y) * kernelY.tapCount;
+                for (uint32_t x = 0; x < dst.width; x++) _mm_storeu_ps(pDst + 4 * size_t(x), _mm_setzero_ps());
+
+                for (uint32_t t = 0; t < kernelY.tapCount; t++)
+                {
+                    const float* pSrc = &tmp.getRow(kernelY.indices[kernelOffset + t])->x;
+                    const __m128 w = _mm_set1_ps(kernelY.weights[kernelOffset + t]);
+                    for (uint32_t x = 0; x < dst.width; x++)
+                    {
+                        __m128 acc = _mm_loadu_ps(pDst + 4 * size_t(x));
+                        _mm_storeu_ps(pDst + 4 * size_t(x), _mm_add_ps(acc, _mm_mul_ps(w, _mm_loadu_ps(pSrc + 4 * size_t(x)))));
+                    }
+                }
+            });
+        }
+    }
+
+    bool MipGenerator::isFormatSupported(ResourceFormat format)
+    {
+        PixelLayout layout;
+        return getPixelLayout(format, layout);
+    }
+
+    MipGenerator::MipChain MipGenerator::generate(const Bitmap& bitmap, Filter filter, bool srgb)
+    {
+        const ResourceFormat format = bitmap.getFormat();
+        PixelLayout layout;
+        if (!getPixelLayout(format, layout))
+        {
+            throw std::exception(("MipGenerator: Unsupported format " + to_string(format) + ".").c_str());
+        }
+
+        const bool linearize = layout.type == PixelLayout::Type::Unorm8 && (isSrgbFormat(format) || (srgb && isSrgbFormat(linearToSrgbFormat(format))));
+
+        MipChain chain;
+        chain.width = bitmap.getWidth();
+        chain.height = bitmap.getHeight();
+        chain.format = format;
+
+        const uint32_t mipCount = bitScanReverse(chain.width | chain.height) + 1;
+        size_t size = 0;
+        for (uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            chain.offsets.push_back(size);
+            size += size_t(chain.getMipWidth(mip)) * chain.getMipHeight(mip) * layout.bytesPerPixel;
+        }
+        chain.data.resize(size);
+
+        // The most detailed level is copied as-is.
+        assert(bitmap.getRowPitch() == chain.width * layout.bytesPerPixel);
+        std::memcpy(chain.data.data(), bitmap.getData(), size_t(chain.width) * chain.height * layout.bytesPerPixel);
+
+        // Each level is filtered from the previous one in floating point, without intermediate quantization.
+        FloatImage src, tmp, dst;
+        src.resize(chain.width, chain.height);
+        decodeImage(bitmap.getData(), layout, linearize, src);
+
+        for (uint32_t mip = 1; mip < mipCount; mip++)
+        {
+            dst.resize(chain.getMipWidth(mip), chain.getMipHeight(mip));
+            downsample(src, tmp, dst, filter);
+            encodeImage(dst, layout, linearize, chain.data.data() + chain.offsets[mip]);
+            std::swap(src, dst);
+        }
+
+        return chain;
+    }
+
+    Texture::SharedPtr MipGenerator::createTextureFromFile(const std::string& filename, bool loadAsSrgb, bool useCache, Filter filter, Texture::BindFlags bindFlags)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logWarning("Error when loading image file. Can't find image file '" + filename + "'");
+            return nullptr;
+        }
+
+        // DDS files are loaded with the mips they contain.
+        if (hasSuffix(fullpath, ".dds"))
+        {
+            return Texture::createFromFile(fullpath, true, loadAsSrgb, bindFlags);
+        }
+
+        const std::string cacheFilename = getCacheFilename(fullpath, loadAsSrgb, filter);
+        if (useCache && doesFileExist(cacheFilename) && getFileModifiedTime(cacheFilename) >= getFileModifiedTime(fullpath))
+        {
+            try
+            {
+                Texture::SharedPtr pTex = ImageIO::loadTextureFromDDS(cacheFilename, loadAsSrgb);
+                if (pTex)
+                {
+                    pTex->setSourceFilename(fullpath);
+                    return pTex;
+                }
+            }
+            catch (const std::exception& e)
+            {
+                logWarning("Failed to load mip cache '" + cacheFilename + "' (" + e.what() + "). Regenerating the mips.");
+            }
+        }
+
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(fullpath, true);
+        if (!pBitmap) return nullptr;
+
+        const ResourceFormat format = pBitmap->getFormat();
+        const ResourceFormat texFormat = loadAsSrgb ? linearToSrgbFormat(format) : format;
+
+        Texture::SharedPtr pTex;
+        if (isFormatSupported(format))
+        {
+            MipChain chain = generate(*pBitmap, filter, loadAsSrgb);
+            pTex = Texture::create2D(chain.width, chain.height, texFormat, 1, chain.getMipCount(), chain.data.data(), bindFlags);
+
+            if (useCache)
+            {
+                try
+                {
+                    ImageIO::saveToDDS(cacheFilename, chain);
+                }
+                catch (const std::exception& e)
+                {
+                    logWarning("Failed to write mip cache '" + cacheFilename + "' (" + e.what() + ").");
+                }
+            }
+        }
+        else
+        {
+            pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, Texture::kMaxPossible, pBitmap->getData(), bindFlags);
+        }
+
+        if (pTex != nullptr)
+        {
+            pTex->setSourceFilename(fullpath);
+        }
+
+        return pTex;
+    }
+
+    std::string MipGenerator::getCacheFilename(const std::string& filename, bool srgb, Filter filter)
+    {
+        return filename + (filter == Filter::Box ? ".box" : ".kaiser") + (srgb ? ".srgb" : "") + ".dds";
+    }
+
+    SCRIPT_BINDING(MipGenerator)
+    {
+        pybind11::enum_<MipGenerator::Filter> filter(m, "MipFilter");
+        filter.value("Box", MipGenerator::Filter::Box);
+        filter.value("Kaiser", MipGenerator::Filter::Kaiser);
+    }
+}
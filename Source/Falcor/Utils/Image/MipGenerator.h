@@ -0,0 +1,105 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Utils/Image/Bitmap.h"
+#include "Core/API/Texture.h"
+
+namespace Falcor
+{
+    /** Generates texture mip chains on the CPU.
+
+        Each level is filtered from the previous one with a separable filter in 32-bit float precision, using all
+        available cores. 8-bit color channels can be filtered in linear space (sRGB-correct), in which case the alpha
+        channel is filtered as-is. The resulting mip chain can be uploaded as initial data of a texture, so that no
+        GPU mip generation is required, and cached as a DDS file next to the source image.
+    */
+    class dlldecl MipGenerator
+    {
+    public:
+        enum class Filter
+        {
+            Box,        ///< Box filter (area average). Exact for non-power-of-two sizes.
+            Kaiser,     ///< Kaiser-windowed sinc filter. Sharper than the box filter with little ringing.
+        };
+
+        /** Filter used when loading textures with mips, both with and without the mip cache.
+            All load paths must use the same filter, so that a texture gets the same mip chain regardless of how it was loaded.
+        */
+        static const Filter kTextureLoadFilter = Filter::Box;
+
+        /** A full mip chain with all levels stored in a single buffer.
+            Levels are tightly packed in order from the most detailed one, which is the layout Texture::create2D() expects as initial data.
+        */
+        struct MipChain
+        {
+            uint32_t width = 0;                         ///< Width of the most detailed level.
+            uint32_t height = 0;                        ///< Height of the most detailed level.
+            ResourceFormat format = ResourceFormat::Unknown;
+            std::vector<size_t> offsets;                ///< Byte offset of each level in the data buffer.
+            std::vector<uint8_t> data;                  ///< Image data of all levels.
+
+            uint32_t getMipCount() const { return (uint32_t)offsets.size(); }
+            uint32_t getMipWidth(uint32_t mip) const { return std::max(1u, width >> mip); }
+            uint32_t getMipHeight(uint32_t mip) const { return std::max(1u, height >> mip); }
+            const uint8_t* getMipData(uint32_t mip) const { return data.data() + offsets[mip]; }
+        };
+
+        /** Check if mip chains can be generated for a format.
+            Supported are uncompressed 8-bit unorm and 16/32-bit float formats with up to four channels.
+        */
+        static bool isFormatSupported(ResourceFormat format);
+
+        /** Generate a full mip chain.
+            Throws an exception if the format of the bitmap is not supported.
+            \param[in] bitmap Image of the most detailed level.
+            \param[in] filter Downsampling filter.
+            \param[in] srgb Filter the RGB channels in linear space, treating the data as sRGB encoded. Only applies to 8-bit formats with an sRGB variant.
+                Images in an sRGB format are always filtered in linear space.
+            \return The mip chain, including a copy of the most detailed level.
+        */
+        static MipChain generate(const Bitmap& bitmap, Filter filter = Filter::Box, bool srgb = false);
+
+        /** Load an image file and create a texture with a mip chain generated on the CPU.
+            Optionally, the mip chain is cached as a DDS file next to the image file (see getCacheFilename()). If a cache file
+            exists that is newer than the image file, the texture is loaded from the cache and no mips are generated.
+            Formats that are not supported fall back to generating the mips on the GPU (and are not cached).
+            \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory.
+            \param[in] loadAsSrgb Load the texture using sRGB format. Mips are filtered in linear space.
+            \param[in] useCache Load the mip chain from the cache file if valid, and write the cache file otherwise.
+            \param[in] filter Downsampling filter.
+            \param[in] bindFlags The bind flags to create the texture with.
+            \return A new texture, or nullptr if the texture failed to load.
+        */
+        static Texture::SharedPtr createTextureFromFile(const std::string& filename, bool loadAsSrgb, bool useCache, Filter filter = Filter::Box, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+        /** Get the name of the DDS cache file for an image file.
+            The name encodes the filter and color space, e.g. 'wood.png.box.srgb.dds'.
+        */
+        static std::string getCacheFilename(const std::string& filename, bool srgb, Filter filter);
+    };
+}
@@ -38,6 +38,20 @@ namespace Falcor
             \param[in] pointCount Number of control points
         */
         CubicSpline(const T* controlPoints, uint32_t pointCount)
+        {
+            setControlPoints(controlPoints, pointCount);
+        }
+
+        /** Creates an empty spline. Call setControlPoints() before interpolating.
+        */
+        CubicSpline() = default;
+
+        /** Recompute a position-based cubic spline from a new set of control points.
+            Internal storage is reused, so calling this repeatedly on the same object avoids heap allocations once the capacity is large enough.
+            \param[in] controlPoints Array of control points
+            \param[in] pointCount Number of control points
+        */
+        void setControlPoints(const T* controlPoints, uint32_t pointCount)
         {
             // The following code is based on the article from http://graphicsrunner.blogspot.co.uk/2008/05/camera-animation-part-ii.html
             static const T kHalf  = T(0.5f);
@@ -47,7 +61,8 @@ namespace Falcor
             static const T kFour = T(4);
 
             // Calculate Gamma
-            std::vector<T> gamma(pointCount);
+            auto& gamma = mGamma;
+            gamma.resize(pointCount);
             gamma[0] = kHalf;
             for(uint32_t i = 1; i < pointCount - 1; i++)
             {
@@ -56,7 +71,8 @@ namespace Falcor
             gamma[pointCount - 1] = kOne / (kTwo - gamma[pointCount - 2]);
 
             // Calculate Delta
-            std::vector<T> delta(pointCount);
+            auto& delta = mDelta;
+            delta.resize(pointCount);
             delta[0] = kThree * (controlPoints[1] - controlPoints[0]) * gamma[0];
 
             for(uint32_t i = 1; i < pointCount; i++)
@@ -66,7 +82,8 @@ namespace Falcor
             }
 
             // Calculate D
-            std::vector<T> D(pointCount);
+            auto& D = mD;
+            D.resize(pointCount);
             D[pointCount - 1] = delta[pointCount - 1];
 
             for(int32_t i = int32_t(pointCount - 2); i >= 0; i--)
@@ -136,6 +153,18 @@ namespace Falcor
             }
         }
 
+        /** Get the number of spline sections, i.e., one less than the number of control points.
+        */
+        uint32_t getSectionCount() const { return (uint32_t)mCoefficient.size(); }
+
+        /** Evaluate the derivative of the spline with respect to the section parameter.
+        */
+        T derivative(uint32_t section, float point) const
+        {
+            const CubicCoeff& coeff = mCoefficient[section];
+            return ((T(3) * coeff.d * point) + T(2) * coeff.c) * point + coeff.b;
+        }
+
         T interpolate(uint32_t section, float point) const
         {
             const CubicCoeff& coeff = mCoefficient[section];
@@ -149,5 +178,10 @@ namespace Falcor
             T a, b, c, d;
         };
         std::vector<CubicCoeff> mCoefficient;
+
+        // Scratch storage for the position-based solver.
+        std::vector<T> mGamma;
+        std::vector<T> mDelta;
+        std::vector<T> mD;
     };
 }
\ No newline at end of file
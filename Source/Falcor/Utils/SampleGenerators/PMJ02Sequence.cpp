@@ -0,0 +1,207 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "PMJ02Sequence.h"
+#include "SobolSequence.h"
+#include "Utils/NumericRange.h"
+#include <execution>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Index of the stratum of a 0.32 fixed point value when dividing [0,1) into 2^bits strata.
+        */
+        inline uint32_t stratum(uint32_t v, uint32_t bits)
+        {
+            return bits > 0 ? v >> (32 - bits) : 0;
+        }
+
+        class Generator
+        {
+        public:
+            Generator(uint32_t sampleCount, uint32_t seed)
+                : mRng(seed)
+                , mPoints(sampleCount)
+            {
+                mPoints[0] = uint2(mRng(), mRng());
+
+                // Extend the sequence by alternating between even (4^k) and odd (2 * 4^k) powers of two.
+                for (uint32_t n = 1, gridBits = 0; n < sampleCount; n *= 2)
+                {
+                    if (n == (1u << (2 * gridBits))) extendEven(n, gridBits);
+                    else extendOdd(n, gridBits++);
+                }
+            }
+
+            std::vector<uint2>& getPoints() { return mPoints; }
+
+        private:
+            /** Extend the sequence from 4^k to 2 * 4^k samples.
+                Each new sample is placed in the subquadrant diagonally opposite to the existing sample in the same grid cell.
+            */
+            void extendEven(uint32_t n, uint32_t gridBits)
+            {
+                initOccupied(2 * n);
+                for (uint32_t s = 0; s < n; s++)
+                {
+                    const uint2 p = mPoints[s];
+                    generateSample(n + s, p, 1 - subquadrant(p.x, gridBits), 1 - subquadrant(p.y, gridBits), gridBits);
+                }
+            }
+
+            /** Extend the sequence from 2 * 4^k to 4^(k+1) samples.
+                The first half of the new samples are placed in one of the two unoccupied subquadrants (chosen randomly),
+                the second half in the remaining subquadrant.
+            */
+            void extendOdd(uint32_t n, uint32_t gridBits)
+            {
+                initOccupied(2 * n);
+                const uint32_t half = n / 2;
+                std::vector<uint2> halves(half);
+                for (uint32_t s = 0; s < half; s++)
+                {
+                    const uint2 p = mPoints[s];
+                    uint2 h = { subquadrant(p.x, gridBits), subquadrant(p.y, gridBits) };
+                    if (mRng() & 1) h.x = 1 - h.x;
+                    else h.y = 1 - h.y;
+                    halves[s] = h;
+                    generateSample(n + s, p, h.x, h.y, gridBits);
+                }
+                for (uint32_t s = 0; s < half; s++)
+                {
+                    generateSample(n + half + s, mPoints[s], 1 - halves[s].x, 1 - halves[s].y, gridBits);
+                }
+            }
+
+            static uint32_t subquadrant(uint32_t v, uint32_t gridBits)
+            {
+                return stratum(v, gridBits + 1) & 1;
+            }
+
+            /** Mark the elementary intervals occupied by the first n samples, for a sequence of 'count' samples.
+            */
+            void initOccupied(uint32_t count)
+            {
+                mCountBits = 0;
+                while ((1u << mCountBits) < count) mCountBits++;
+
+                mOccupied.resize(mCountBits + 1);
+                for (auto& occupied : mOccupied) occupied.assign(count, false);
+                for (uint32_t s = 0; s < count / 2; s++) markOccupied(mPoints[s]);
+            }
+
+            /** Index of the elementary interval of shape 2^k x 2^(countBits-k) containing a point.
+            */
+            uint32_t interval(const uint2& p, uint32_t k) const
+            {
+                return (stratum(p.y, mCountBits - k) << k) | stratum(p.x, k);
+            }
+
+            void markOccupied(const uint2& p)
+            {
+                for (uint32_t k = 0; k <= mCountBits; k++) mOccupied[k][interval(p, k)] = true;
+            }
+
+            /** Generate a sample in the given subquadrant of the grid cell containing an existing point.
+                To reduce the number of rejected candidates, the sample is placed directly in unoccupied
+                strata of the finest horizontal and vertical elementary intervals.
+            */
+            void generateSample(uint32_t index, const uint2& p, uint32_t xhalf, uint32_t yhalf, uint32_t gridBits)
+            {
+                const uint32_t cellBits = mCountBits - gridBits - 1;
+                const uint32_t x0 = ((stratum(p.x, gridBits) << 1) | xhalf) << cellBits;
+                const uint32_t y0 = ((stratum(p.y, gridBits) << 1) | yhalf) << cellBits;
+
+                mFreeX.clear();
+                mFreeY.clear();
+                for (uint32_t c = 0; c < (1u << cellBits); c++)
+                {
+                    if (!mOccupied[mCountBits][x0 + c]) mFreeX.push_back(x0 + c);
+                    if (!mOccupied[0][y0 + c]) mFreeY.push_back(y0 + c);
+                }
+                assert(!mFreeX.empty() && !mFreeY.empty());
+
+                const uint32_t jitterBits = 32 - mCountBits;
+                while (true)
+                {
+                    uint2 q;
+                    q.x = (mFreeX[mRng() % mFreeX.size()] << jitterBits) | (mRng() >> mCountBits);
+                    q.y = (mFreeY[mRng() % mFreeY.size()] << jitterBits) | (mRng() >> mCountBits);
+
+                    bool valid = true;
+                    for (uint32_t k = 1; k < mCountBits && valid; k++) valid = !mOccupied[k][interval(q, k)];
+
+                    if (valid)
+                    {
+                        mPoints[index] = q;
+                        markOccupied(q);
+                        return;
+                    }
+                }
+            }
+
+            std::mt19937 mRng;
+            std::vector<uint2> mPoints;
+            std::vector<std::vector<bool>> mOccupied;   ///< Occupied elementary intervals for each shape 2^k x 2^(countBits-k).
+            std::vector<uint32_t> mFreeX;
+            std::vector<uint32_t> mFreeY;
+            uint32_t mCountBits = 0;
+        };
+    }
+
+    std::vector<uint2> PMJ02Sequence::generate(uint32_t sampleCount, uint32_t seed)
+    {
+        if (sampleCount == 0 || !isPowerOf2(sampleCount) || sampleCount > kMaxSampleCount)
+        {
+            throw std::exception("PMJ02Sequence: Sample count must be a power of two and at most 65536");
+        }
+
+        Generator generator(sampleCount, seed);
+        return std::move(generator.getPoints());
+    }
+
+    std::vector<uint2> PMJ02Sequence::generateTables(uint32_t tableCount, uint32_t sampleCount, uint32_t seed)
+    {
+        std::vector<uint2> result((size_t)tableCount * sampleCount);
+
+        std::for_each(std::execution::par, NumericRange<uint32_t>(0, tableCount).begin(), NumericRange<uint32_t>(0, tableCount).end(), [&](uint32_t table)
+        {
+            auto points = generate(sampleCount, SobolSequence::hashCombine(seed, table));
+            std::copy(points.begin(), points.end(), result.begin() + (size_t)table * sampleCount);
+        });
+
+        return result;
+    }
+
+    Buffer::SharedPtr PMJ02Sequence::createTableBuffer()
+    {
+        static const std::vector<uint2> tables = generateTables(PMJ02_TABLE_COUNT, PMJ02_TABLE_SIZE, 0);
+        return Buffer::createStructured(sizeof(uint2), (uint32_t)tables.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, tables.data(), false);
+    }
+}
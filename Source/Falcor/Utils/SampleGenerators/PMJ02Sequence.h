@@ -0,0 +1,68 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Utils/Sampling/SampleGeneratorType.slangh"
+
+namespace Falcor
+{
+    /** Progressive multi-jittered (0,2) sequence generator on the CPU.
+
+        Implements the construction from Christensen et al., "Progressive Multi-Jittered Sample Sequences", EGSR 2018.
+        Every prefix of 2^m samples is a (0,m,2)-net, i.e. it is stratified in all elementary intervals of area 2^-m.
+        Points are stored in 0.32 fixed point. Generation of a single sequence is sequential,
+        but multiple independent sequences are generated in parallel.
+
+        The GPU sample generator of type SAMPLE_GENERATOR_PMJ02 uses the tables exported by createTableBuffer().
+    */
+    class dlldecl PMJ02Sequence
+    {
+    public:
+        static const uint32_t kMaxSampleCount = 1 << 16;
+
+        /** Generate a PMJ02 sequence.
+            \param[in] sampleCount Number of samples. Must be a power of two and at most kMaxSampleCount.
+            \param[in] seed Seed of the random number generator.
+            \return Sample points in 0.32 fixed point.
+        */
+        static std::vector<uint2> generate(uint32_t sampleCount, uint32_t seed);
+
+        /** Generate multiple independent PMJ02 sequences in parallel.
+            \param[in] tableCount Number of sequences.
+            \param[in] sampleCount Number of samples per sequence. Must be a power of two and at most kMaxSampleCount.
+            \param[in] seed Seed of the random number generator.
+            \return Sample points in 0.32 fixed point, stored as tableCount consecutive sequences.
+        */
+        static std::vector<uint2> generateTables(uint32_t tableCount, uint32_t sampleCount, uint32_t seed);
+
+        /** Create a GPU buffer holding the tables used by the GPU sample generator.
+            The tables are generated on first use and cached.
+            \return Structured buffer of PMJ02_TABLE_COUNT * PMJ02_TABLE_SIZE uint2 values.
+        */
+        static Buffer::SharedPtr createTableBuffer();
+    };
+}
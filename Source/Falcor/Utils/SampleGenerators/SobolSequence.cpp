@@ -0,0 +1,172 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "SobolSequence.h"
+#include "Utils/NumericRange.h"
+#include <execution>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Direction numbers by Joe and Kuo, "Constructing Sobol sequences with better two-dimensional projections", 2008.
+            Dimension 0 is the van der Corput sequence and has no entry.
+        */
+        struct DirectionNumbers
+        {
+            uint32_t s;         ///< Degree of the primitive polynomial.
+            uint32_t a;         ///< Coefficients of the primitive polynomial.
+            uint32_t m[6];      ///< Initial direction numbers.
+        };
+
+        const DirectionNumbers kDirectionNumbers[SobolSequence::kMaxDimensions - 1] =
+        {
+            { 1, 0, { 1 } },
+            { 2, 1, { 1, 3 } },
+            { 3, 1, { 1, 3, 1 } },
+            { 3, 2, { 1, 1, 1 } },
+            { 4, 1, { 1, 1, 3, 3 } },
+            { 4, 4, { 1, 3, 5, 13 } },
+            { 5, 2, { 1, 1, 5, 5, 17 } },
+            { 5, 4, { 1, 1, 5, 5, 5 } },
+            { 5, 7, { 1, 1, 7, 11, 19 } },
+            { 5, 11, { 1, 1, 5, 1, 1 } },
+            { 5, 13, { 1, 1, 1, 3, 11 } },
+            { 5, 14, { 1, 3, 5, 5, 31 } },
+            { 6, 1, { 1, 3, 3, 9, 7, 49 } },
+            { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+            { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+        };
+
+        struct GeneratorMatrices
+        {
+            uint32_t columns[SobolSequence::kMaxDimensions][32];
+
+            GeneratorMatrices()
+            {
+                for (uint32_t k = 0; k < 32; k++) columns[0][k] = 1u << (31 - k);
+
+                for (uint32_t d = 1; d < SobolSequence::kMaxDimensions; d++)
+                {
+                    const auto& dn = kDirectionNumbers[d - 1];
+                    uint32_t* v = columns[d];
+                    for (uint32_t k = 0; k < 32; k++)
+                    {
+                        if (k < dn.s)
+                        {
+                            v[k] = dn.m[k] << (31 - k);
+                        }
+                        else
+                        {
+                            // Recurrence relation of the primitive polynomial.
+                            v[k] = v[k - dn.s] ^ (v[k - dn.s] >> dn.s);
+                            for (uint32_t l = 1; l < dn.s; l++)
+                            {
+                                if ((dn.a >> (dn.s - 1 - l)) & 1) v[k] ^= v[k - l];
+                            }
+                        }
+                    }
+                }
+            }
+        };
+
+        const GeneratorMatrices kMatrices;
+
+        /** Multiply the generator matrix with the sample index.
+            Branchless so that loops over multiple indices can be vectorized.
+        */
+        inline uint32_t multiply(const uint32_t* columns, uint32_t index)
+        {
+            uint32_t result = 0;
+            for (uint32_t k = 0; k < 32; k++) result ^= columns[k] & (0u - ((index >> k) & 1));
+            return result;
+        }
+
+        const uint32_t kChunkSize = 1024;   ///< Number of samples generated per parallel work item.
+    }
+
+    const uint32_t* SobolSequence::getGeneratorMatrix(uint32_t dimension)
+    {
+        assert(dimension < kMaxDimensions);
+        return kMatrices.columns[dimension];
+    }
+
+    uint32_t SobolSequence::sample(uint32_t index, uint32_t dimension)
+    {
+        assert(dimension < kMaxDimensions);
+        return multiply(kMatrices.columns[dimension], index);
+    }
+
+    uint32_t SobolSequence::sampleOwen(uint32_t index, uint32_t dimension, uint32_t seed)
+    {
+        const uint32_t blockSeed = hashCombine(seed, dimension / kBlockDimensions);
+        const uint32_t d = dimension % kBlockDimensions;
+        uint32_t x = multiply(kMatrices.columns[d], nestedUniformScramble(index, blockSeed));
+        return nestedUniformScramble(x, hashCombine(blockSeed, d));
+    }
+
+    std::vector<float> SobolSequence::generate(uint32_t sampleCount, uint32_t dimensionCount, uint32_t seed, uint32_t firstSample)
+    {
+        std::vector<float> result((size_t)sampleCount * dimensionCount);
+        const uint32_t chunkCount = (sampleCount + kChunkSize - 1) / kChunkSize;
+
+        std::for_each(std::execution::par, NumericRange<uint32_t>(0, chunkCount).begin(), NumericRange<uint32_t>(0, chunkCount).end(), [&](uint32_t chunk)
+        {
+            const uint32_t begin = chunk * kChunkSize;
+            const uint32_t count = std::min(kChunkSize, sampleCount - begin);
+            uint32_t indices[kChunkSize];
+
+            for (uint32_t block = 0; block * kBlockDimensions < dimensionCount; block++)
+            {
+                // All dimensions of a block share the same shuffled sample indices.
+                const uint32_t blockSeed = hashCombine(seed, block);
+                for (uint32_t i = 0; i < count; i++) indices[i] = nestedUniformScramble(firstSample + begin + i, blockSeed);
+
+                const uint32_t blockEnd = std::min(dimensionCount, (block + 1) * kBlockDimensions);
+                for (uint32_t dimension = block * kBlockDimensions; dimension < blockEnd; dimension++)
+                {
+                    const uint32_t d = dimension % kBlockDimensions;
+                    const uint32_t* columns = kMatrices.columns[d];
+                    const uint32_t scrambleSeed = hashCombine(blockSeed, d);
+                    float* dst = result.data() + (size_t)begin * dimensionCount + dimension;
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        dst[(size_t)i * dimensionCount] = toFloat(nestedUniformScramble(multiply(columns, indices[i]), scrambleSeed));
+                    }
+                }
+            }
+        });
+
+        return result;
+    }
+
+    Buffer::SharedPtr SobolSequence::createGeneratorMatrixBuffer()
+    {
+        return Buffer::createStructured(sizeof(uint32_t), kBlockDimensions * 32, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, kMatrices.columns, false);
+    }
+}
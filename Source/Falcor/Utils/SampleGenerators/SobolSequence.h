@@ -0,0 +1,143 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Utils/Sampling/SampleGeneratorType.slangh"
+
+namespace Falcor
+{
+    /** Owen-scrambled Sobol sequence generator on the CPU.
+
+        The sequence is evaluated from generator matrices built from the Joe-Kuo direction numbers.
+        Scrambling follows Burley, "Practical Hash-based Owen Scrambling", JCGT 2020:
+        The sample index is shuffled and the sample values are scrambled using a hash-based
+        nested uniform scramble, which preserves the stratification of the sequence.
+        Higher dimensions are padded with independently scrambled blocks of SOBOL_BLOCK_DIMENSIONS dimensions.
+
+        The same construction is used by the GPU sample generator of type SAMPLE_GENERATOR_SOBOL,
+        which uses the generator matrices exported by createGeneratorMatrixBuffer().
+    */
+    class dlldecl SobolSequence
+    {
+    public:
+        static const uint32_t kMaxDimensions = 16;  ///< Number of dimensions with generator matrices.
+        static const uint32_t kBlockDimensions = SOBOL_BLOCK_DIMENSIONS;
+
+        /** Get the generator matrix of a dimension.
+            \param[in] dimension Dimension, must be less than kMaxDimensions.
+            \return Pointer to 32 column vectors. Column i is the contribution of bit i of the sample index.
+        */
+        static const uint32_t* getGeneratorMatrix(uint32_t dimension);
+
+        /** Evaluate the unscrambled Sobol sequence.
+            \param[in] index Sample index.
+            \param[in] dimension Dimension, must be less than kMaxDimensions.
+            \return Sample value in 0.32 fixed point.
+        */
+        static uint32_t sample(uint32_t index, uint32_t dimension);
+
+        /** Evaluate the Owen-scrambled and shuffled Sobol sequence.
+            \param[in] index Sample index.
+            \param[in] dimension Dimension. There is no limit, higher dimensions are padded.
+            \param[in] seed Seed of the scrambling.
+            \return Sample value in 0.32 fixed point.
+        */
+        static uint32_t sampleOwen(uint32_t index, uint32_t dimension, uint32_t seed);
+
+        /** Generate a table of Owen-scrambled Sobol samples.
+            Samples are generated in parallel, with the inner loops written to allow auto-vectorization.
+            \param[in] sampleCount Number of samples.
+            \param[in] dimensionCount Number of dimensions per sample.
+            \param[in] seed Seed of the scrambling.
+            \param[in] firstSample Index of the first sample to generate.
+            \return Sample values in [0,1), stored as sampleCount consecutive vectors of dimensionCount values.
+        */
+        static std::vector<float> generate(uint32_t sampleCount, uint32_t dimensionCount, uint32_t seed, uint32_t firstSample = 0);
+
+        /** Create a GPU buffer holding the generator matrices used by the GPU sample generator.
+            \return Structured buffer of kBlockDimensions * 32 uint values.
+        */
+        static Buffer::SharedPtr createGeneratorMatrixBuffer();
+
+        /** Hash-based permutation by Laine and Karras, improved by Burley.
+            Each output bit only depends on the input bits of lower significance.
+        */
+        static uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed)
+        {
+            x += seed;
+            x ^= x * 0x6c50b47cu;
+            x ^= x * 0xb82f1e52u;
+            x ^= x * 0xc7afe638u;
+            x ^= x * 0x8d22f6e6u;
+            return x;
+        }
+
+        /** Hash-based nested uniform scramble (Owen scramble) of a 0.32 fixed point value.
+        */
+        static uint32_t nestedUniformScramble(uint32_t x, uint32_t seed)
+        {
+            x = reverseBits(x);
+            x = laineKarrasPermutation(x, seed);
+            return reverseBits(x);
+        }
+
+        /** Reverse the bits of a 32-bit value.
+        */
+        static uint32_t reverseBits(uint32_t x)
+        {
+            x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+            x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+            x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+            x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+            return (x >> 16) | (x << 16);
+        }
+
+        /** Convert a 0.32 fixed point value to a float in [0,1).
+        */
+        static float toFloat(uint32_t x) { return (x >> 8) * (1.f / (1 << 24)); }
+
+        /** Derive a new seed from a seed and a value. Matches the seed derivation of the GPU sample generators.
+        */
+        static uint32_t hashCombine(uint32_t seed, uint32_t v)
+        {
+            return jenkinsHash(seed ^ jenkinsHash(v));
+        }
+
+        /** 32-bit hash function by Robert Jenkins. Same as jenkinsHash() in HashUtils.slang.
+        */
+        static uint32_t jenkinsHash(uint32_t a)
+        {
+            a = (a + 0x7ed55d16) + (a << 12);
+            a = (a ^ 0xc761c23c) ^ (a >> 19);
+            a = (a + 0x165667b1) + (a << 5);
+            a = (a + 0xd3a2646c) ^ (a << 9);
+            a = (a + 0xfd7046c5) + (a << 3);
+            a = (a ^ 0xb55a4f09) ^ (a >> 16);
+            return a;
+        }
+    };
+}
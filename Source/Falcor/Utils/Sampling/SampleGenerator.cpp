@@ -27,9 +27,52 @@
  **************************************************************************/
 #include "stdafx.h"
 #include "SampleGenerator.h"
+#include "Utils/SampleGenerators/SobolSequence.h"
+#include "Utils/SampleGenerators/PMJ02Sequence.h"
 
 namespace Falcor
 {
+    namespace
+    {
+        /** Low-discrepancy sample generators using precomputed tables on the GPU.
+        */
+        class SobolSampleGenerator : public SampleGenerator
+        {
+        public:
+            SobolSampleGenerator()
+                : SampleGenerator(SAMPLE_GENERATOR_SOBOL)
+                , mpGeneratorMatrices(SobolSequence::createGeneratorMatrixBuffer())
+            {}
+
+            bool setShaderData(ShaderVar const& var) const override
+            {
+                var["gSobolGeneratorMatrices"] = mpGeneratorMatrices;
+                return true;
+            }
+
+        private:
+            Buffer::SharedPtr mpGeneratorMatrices;
+        };
+
+        class PMJ02SampleGenerator : public SampleGenerator
+        {
+        public:
+            PMJ02SampleGenerator()
+                : SampleGenerator(SAMPLE_GENERATOR_PMJ02)
+                , mpTable(PMJ02Sequence::createTableBuffer())
+            {}
+
+            bool setShaderData(ShaderVar const& var) const override
+            {
+                var["gPMJ02Table"] = mpTable;
+                return true;
+            }
+
+        private:
+            Buffer::SharedPtr mpTable;
+        };
+    }
+
     static std::map<uint32_t, std::function<SampleGenerator::SharedPtr()>> sFactory;
     static Gui::DropdownList sGuiDropdownList;
 
@@ -67,6 +110,8 @@ namespace Falcor
     {
         registerType(SAMPLE_GENERATOR_TINY_UNIFORM, "Tiny uniform (32-bit)", [] () { return SharedPtr(new SampleGenerator(SAMPLE_GENERATOR_TINY_UNIFORM)); });
         registerType(SAMPLE_GENERATOR_UNIFORM, "Uniform (128-bit)", [] () { return SharedPtr(new SampleGenerator(SAMPLE_GENERATOR_UNIFORM)); });
+        registerType(SAMPLE_GENERATOR_SOBOL, "Owen-scrambled Sobol", [] () { return SharedPtr(new SobolSampleGenerator()); });
+        registerType(SAMPLE_GENERATOR_PMJ02, "PMJ02", [] () { return SharedPtr(new PMJ02SampleGenerator()); });
     }
 
     // Automatically register basic sampler types.
@@ -27,6 +27,9 @@
  **************************************************************************/
 #include "stdafx.h"
 #include "VideoEncoder.h"
+#include "Utils/NumericRange.h"
+#include <emmintrin.h>
+#include <execution>
 
 extern "C"
 {
@@ -71,6 +74,99 @@ namespace Falcor
             }
         }
 
+        /** Number of rows converted per parallel work item. Must be even so that 4:2:0 row pairs are not split.
+        */
+        const uint32_t kRowsPerTask = 16;
+
+        /** BT.601 limited-range RGB to YUV coefficients in 8.8 fixed point (the libswscale default).
+        */
+        const int kYCoeffs[3] = { 66, 129, 25 };
+        const int kUCoeffs[3] = { -38, -74, 112 };
+        const int kVCoeffs[3] = { 112, -94, -18 };
+
+        /** Computes the luma of four 8-bit 4-channel pixels (SSE2).
+            \param[in] px Four pixels.
+            \param[in] coeffs Luma coefficient per channel as 16-bit values, repeated for two pixels.
+            \return Luma values in the low byte of each 32-bit lane.
+        */
+        inline __m128i computeLuma4(__m128i px, __m128i coeffs)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coeffs);   // Pixels 0,1: [c0+c1, c2+c3] each
+            __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coeffs);   // Pixels 2,3
+            lo = _mm_add_epi32(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1))); // [y0, y0, y1, y1]
+            hi = _mm_add_epi32(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1))); // [y2, y2, y3, y3]
+            lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0));
+            hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0));
+            __m128i y = _mm_unpacklo_epi64(lo, hi);                                 // [y0, y1, y2, y3]
+            return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(y, _mm_set1_epi32(128)), 8), _mm_set1_epi32(16));
+        }
+
+        /** Converts 8-bit RGBA or BGRA pixels to planar YUV 4:2:0 or 4:2:2 in parallel over rows.
+        */
+        void convertToYuv(const uint8_t* pSrc, uint32_t width, uint32_t height, bool isBGRA, bool is420, AVFrame* pFrame)
+        {
+            const uint32_t r = isBGRA ? 2 : 0;
+            const uint32_t b = isBGRA ? 0 : 2;
+            const __m128i lumaCoeffs = isBGRA ? _mm_setr_epi16(25, 129, 66, 0, 25, 129, 66, 0) : _mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0);
+            const uint32_t chromaRows = is420 ? 2 : 1;
+
+            uint32_t blockCount = (height + kRowsPerTask - 1) / kRowsPerTask;
+            auto range = NumericRange<uint32_t>(0, blockCount);
+            std::for_each(std::execution::par, range.begin(), range.end(), [&] (uint32_t block) {
+                const uint32_t firstRow = block * kRowsPerTask;
+                const uint32_t lastRow = std::min(firstRow + kRowsPerTask, height);
+
+                // Luma, four pixels at a time.
+                for (uint32_t y = firstRow; y < lastRow; y++)
+                {
+                    const uint8_t* pRow = pSrc + (size_t)y * width * 4;
+                    uint8_t* pDst = pFrame->data[0] + (size_t)y * pFrame->linesize[0];
+                    uint32_t x = 0;
+                    for (; x + 4 <= width; x += 4)
+                    {
+                        __m128i luma = computeLuma4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + x * 4)), lumaCoeffs);
+                        luma = _mm_packus_epi16(_mm_packs_epi32(luma, luma), luma);
+                        int32_t packed = _mm_cvtsi128_si32(luma);
+                        std::memcpy(pDst + x, &packed, 4);
+                    }
+                    for (; x < width; x++)
+                    {
+                        const uint8_t* p = pRow + x * 4;
+                        pDst[x] = uint8_t(((kYCoeffs[0] * p[r] + kYCoeffs[1] * p[1] + kYCoeffs[2] * p[b] + 128) >> 8) + 16);
+                    }
+                }
+
+                // Chroma, averaged over 2x1 (4:2:2) or 2x2 (4:2:0) pixel blocks.
+                for (uint32_t y = firstRow; y < lastRow; y += chromaRows)
+                {
+                    const uint32_t rowCount = std::min(chromaRows, height - y);
+                    const uint32_t cy = y / chromaRows;
+                    uint8_t* pU = pFrame->data[1] + (size_t)cy * pFrame->linesize[1];
+                    uint8_t* pV = pFrame->data[2] + (size_t)cy * pFrame->linesize[2];
+                    for (uint32_t x = 0; x < width; x += 2)
+                    {
+                        const uint32_t colCount = std::min(2u, width - x);
+                        int sum[3] = { 0, 0, 0 };
+                        for (uint32_t j = 0; j < rowCount; j++)
+                        {
+                            const uint8_t* p = pSrc + ((size_t)(y + j) * width + x) * 4;
+                            for (uint32_t i = 0; i < colCount; i++, p += 4)
+                            {
+                                sum[0] += p[r];
+                                sum[1] += p[1];
+                                sum[2] += p[b];
+                            }
+                        }
+                        const int n = int(rowCount * colCount);
+                        const int R = (sum[0] + n / 2) / n, G = (sum[1] + n / 2) / n, B = (sum[2] + n / 2) / n;
+                        pU[x / 2] = uint8_t(((kUCoeffs[0] * R + kUCoeffs[1] * G + kUCoeffs[2] * B + 128) >> 8) + 128);
+                        pV[x / 2] = uint8_t(((kVCoeffs[0] * R + kVCoeffs[1] * G + kVCoeffs[2] * B + 128) >> 8) + 128);
+                    }
+                }
+            });
+        }
+
         AVCodecID getCodecID(VideoEncoder::Codec codec)
         {
             switch (codec)
@@ -288,17 +384,22 @@ namespace Falcor
 
         mFormat = desc.format;
         mRowPitch = getFormatBytesPerBlock(desc.format) * desc.width;
-        if(desc.flipY)
-        {
-            mpFlippedImage = new uint8_t[desc.height * mRowPitch];
-        }
+        mFlipY = desc.flipY;
+        mQueuePolicy = desc.queuePolicy;
+        mQueueSize = std::max(desc.queueSize, 1u);
 
         assert(isFormatSupported(desc.format));
-        mpSwsContext = sws_getContext(desc.width, desc.height, getPictureFormatFromFalcorFormat(desc.format), desc.width, desc.height, mpCodecContext->pix_fmt, SWS_POINT, nullptr, nullptr, nullptr);
-        if(mpSwsContext == nullptr)
+        // Planar YUV output is converted by convertToYuv(). Other formats go through libswscale.
+        if (mpCodecContext->pix_fmt != AV_PIX_FMT_YUV420P && mpCodecContext->pix_fmt != AV_PIX_FMT_YUV422P)
         {
-            return error(mFilename, "Failed to allocate SWScale context");
+            mpSwsContext = sws_getContext(desc.width, desc.height, getPictureFormatFromFalcorFormat(desc.format), desc.width, desc.height, mpCodecContext->pix_fmt, SWS_POINT, nullptr, nullptr, nullptr);
+            if(mpSwsContext == nullptr)
+            {
+                return error(mFilename, "Failed to allocate SWScale context");
+            }
         }
+
+        mThread = std::thread(&VideoEncoder::encoderThread, this);
         return true;
     }
 
@@ -337,6 +438,17 @@ namespace Falcor
 
     void VideoEncoder::endCapture()
     {
+        // Encode the remaining frames and stop the encoder thread.
+        if (mThread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mTerminate = true;
+            }
+            mQueueCondition.notify_all();
+            mThread.join();
+        }
+
         if(mpOutputContext)
         {
             // Flush the codex
@@ -349,51 +461,155 @@ namespace Falcor
             avcodec_free_context(&mpCodecContext);
             av_frame_free(&mpFrame);
             sws_freeContext(mpSwsContext);
+            mpSwsContext = nullptr;
             avformat_free_context(mpOutputContext);
             mpOutputContext = nullptr;
             mpOutputStream = nullptr;
         }
-        safe_delete(mpFlippedImage)
+        mFramePool.clear();
     }
 
     void VideoEncoder::appendFrame(const void* pData)
     {
-        if(mpFlippedImage)
+        if (!mThread.joinable()) return;
+
+        std::unique_ptr<uint8_t[]> pBuffer;
         {
-            // Flip the image
-            for(int32_t h = 0; h < mpCodecContext->height; h++)
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStats.framesSubmitted++;
+
+            if (mFramesInFlight >= mQueueSize)
             {
-                const uint8_t* pSrc = (uint8_t*)pData + h * mRowPitch;
-                uint8_t* pDst = mpFlippedImage + (mpCodecContext->height - 1 - h) * mRowPitch;
-                memcpy(pDst, pSrc, mRowPitch);
+                if (mQueuePolicy == QueuePolicy::DropFrames)
+                {
+                    mStats.framesDropped++;
+                    return;
+                }
+
+                auto start = CpuTimer::getCurrentTimePoint();
+                mSlotCondition.wait(lock, [&] () { return mFramesInFlight < mQueueSize; });
+                mStats.stallTimeMs += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
             }
 
-            pData = mpFlippedImage;
+            mFramesInFlight++;
+            if (!mFramePool.empty())
+            {
+                pBuffer = std::move(mFramePool.back());
+                mFramePool.pop_back();
+            }
         }
 
-        uint8_t* src[AV_NUM_DATA_POINTERS] = {0};
-        int32_t rowPitch[AV_NUM_DATA_POINTERS] = {0};
-        src[0] = (uint8_t*)pData;
-        rowPitch[0] = (int32_t)mRowPitch;
+        // Copy the frame, flipping it if the image memory layout is bottom->top.
+        const uint32_t height = (uint32_t)mpCodecContext->height;
+        if (!pBuffer) pBuffer.reset(new uint8_t[(size_t)height * mRowPitch]);
+        if (mFlipY)
+        {
+            for (uint32_t h = 0; h < height; h++)
+            {
+                const uint8_t* pSrc = (const uint8_t*)pData + (size_t)h * mRowPitch;
+                uint8_t* pDst = pBuffer.get() + (size_t)(height - 1 - h) * mRowPitch;
+                std::memcpy(pDst, pSrc, mRowPitch);
+            }
+        }
+        else
+        {
+            std::memcpy(pBuffer.get(), pData, (size_t)height * mRowPitch);
+        }
 
-        // Scale and convert the image
-        sws_scale(mpSwsContext, src, rowPitch, 0, mpCodecContext->height, mpFrame->data, mpFrame->linesize);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFrameQueue.push_back({ std::move(pBuffer), CpuTimer::getCurrentTimePoint() });
+        }
+        mQueueCondition.notify_one();
+    }
 
-        // Encode the frame
+    void VideoEncoder::encoderThread()
+    {
+        while (true)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mQueueCondition.wait(lock, [&] () { return mTerminate || !mFrameQueue.empty(); });
+
+            // Exit once the queue is drained.
+            if (mFrameQueue.empty())
+            {
+                assert(mTerminate);
+                break;
+            }
+
+            QueuedFrame frame = std::move(mFrameQueue.front());
+            mFrameQueue.pop_front();
+            lock.unlock();
+
+            auto start = CpuTimer::getCurrentTimePoint();
+            encodeFrame(frame.pData.get());
+            auto end = CpuTimer::getCurrentTimePoint();
+
+            lock.lock();
+            double latency = CpuTimer::calcDuration(frame.submitTime, end);
+            mStats.framesEncoded++;
+            mStats.avgLatencyMs += (latency - mStats.avgLatencyMs) / (double)mStats.framesEncoded;
+            mStats.maxLatencyMs = std::max(mStats.maxLatencyMs, latency);
+            mStats.encodeTimeMs += CpuTimer::calcDuration(start, end);
+            mStats.encodeFps = mStats.framesEncoded * 1000.0 / mStats.encodeTimeMs;
+            mFramePool.push_back(std::move(frame.pData));
+            mFramesInFlight--;
+            lock.unlock();
+            mSlotCondition.notify_all();
+        }
+    }
+
+    void VideoEncoder::encodeFrame(const uint8_t* pData)
+    {
+        // The codec may still hold a reference to the previous frame's buffers.
+        if (av_frame_make_writable(mpFrame) < 0)
+        {
+            error(mFilename, "Can't make video frame writable");
+            return;
+        }
+
+        if (mpSwsContext)
+        {
+            uint8_t* src[AV_NUM_DATA_POINTERS] = {0};
+            int32_t rowPitch[AV_NUM_DATA_POINTERS] = {0};
+            src[0] = (uint8_t*)pData;
+            rowPitch[0] = (int32_t)mRowPitch;
+
+            // Scale and convert the image
+            sws_scale(mpSwsContext, src, rowPitch, 0, mpCodecContext->height, mpFrame->data, mpFrame->linesize);
+        }
+        else
+        {
+            bool isBGRA = getPictureFormatFromFalcorFormat(mFormat) == AV_PIX_FMT_BGRA;
+            convertToYuv(pData, mpCodecContext->width, mpCodecContext->height, isBGRA, mpCodecContext->pix_fmt == AV_PIX_FMT_YUV420P, mpFrame);
+        }
+
+        // Encode the frame. If the codec's output is full, drain it and try again.
         int r = avcodec_send_frame(mpCodecContext, mpFrame);
-        mpFrame->pts++;
         if(r == AVERROR(EAGAIN))
         {
             if(flush(mpCodecContext, mpOutputContext, mpOutputStream, mFilename) == false)
             {
                 return;
             }
+            r = avcodec_send_frame(mpCodecContext, mpFrame);
         }
-        else if(r < 0)
+        mpFrame->pts++;
+
+        if(r < 0)
         {
             error(mFilename, "Can't send video frame");
             return;
         }
+
+        // Write out any packets that are ready.
+        flush(mpCodecContext, mpOutputContext, mpOutputStream, mFilename);
+    }
+
+    VideoEncoder::Stats VideoEncoder::getStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
     }
 
     FileDialogFilterVec VideoEncoder::getSupportedContainerForCodec(Codec codec)
@@ -433,5 +649,9 @@ namespace Falcor
         codec.value("MPEG2", VideoEncoder::Codec::MPEG2);
         codec.value("H264", VideoEncoder::Codec::H264);
         codec.value("HEVC", VideoEncoder::Codec::HEVC);
+
+        pybind11::enum_<VideoEncoder::QueuePolicy> queuePolicy(m, "VideoQueuePolicy");
+        queuePolicy.value("Block", VideoEncoder::QueuePolicy::Block);
+        queuePolicy.value("DropFrames", VideoEncoder::QueuePolicy::DropFrames);
     }
 }
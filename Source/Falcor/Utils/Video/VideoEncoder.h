@@ -26,6 +26,11 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
+#include "Utils/Timing/CpuTimer.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 struct AVFormatContext;
 struct AVStream;
@@ -50,6 +55,14 @@ namespace Falcor
             MPEG4,
         };
 
+        /** What appendFrame() does when the frame queue is full.
+        */
+        enum class QueuePolicy : int32_t
+        {
+            Block,      ///< Wait for the encoder thread to free a slot. No frames are lost.
+            DropFrames, ///< Discard the new frame. The renderer never waits on the encoder.
+        };
+
         struct Desc
         {
             uint32_t fps = 60;
@@ -61,6 +74,20 @@ namespace Falcor
             ResourceFormat format = ResourceFormat::BGRA8UnormSrgb;
             bool flipY = false;
             std::string filename;
+            uint32_t queueSize = 4;                     ///< Maximum number of frames waiting to be encoded.
+            QueuePolicy queuePolicy = QueuePolicy::Block;
+        };
+
+        struct Stats
+        {
+            uint64_t framesSubmitted = 0;   ///< Frames passed to appendFrame().
+            uint64_t framesEncoded = 0;     ///< Frames sent to the codec.
+            uint64_t framesDropped = 0;     ///< Frames discarded because the queue was full (QueuePolicy::DropFrames).
+            double avgLatencyMs = 0.0;      ///< Average time from appendFrame() until the frame was sent to the codec.
+            double maxLatencyMs = 0.0;      ///< Maximum time from appendFrame() until the frame was sent to the codec.
+            double encodeTimeMs = 0.0;      ///< Total time the encoder thread spent converting and encoding.
+            double stallTimeMs = 0.0;       ///< Total time appendFrame() blocked waiting for a free slot.
+            double encodeFps = 0.0;         ///< Encoder throughput in frames per second of encoder thread time.
         };
 
         ~VideoEncoder();
@@ -71,15 +98,35 @@ namespace Falcor
         */
         static UniquePtr create(const Desc& desc);
 
+        /** Queue a frame for encoding.
+            The data is copied into a buffer from the encoder's pool, so the caller may reuse the memory as soon as the call returns.
+            Color conversion and encoding happen on the encoder thread.
+            \param[in] pData Image data in the format given at creation, width * height pixels with tightly packed rows.
+        */
         void appendFrame(const void* pData);
+
+        /** Encode all queued frames, stop the encoder thread and finalize the file.
+        */
         void endCapture();
 
+        /** Get encoder statistics. Can be called at any time, including after endCapture().
+        */
+        Stats getStats();
+
         static bool isFormatSupported(ResourceFormat format);
         static FileDialogFilterVec getSupportedContainerForCodec(Codec codec);
 
     private:
         VideoEncoder(const std::string& filename);
         bool init(const Desc& desc);
+        void encoderThread();
+        void encodeFrame(const uint8_t* pData);
+
+        struct QueuedFrame
+        {
+            std::unique_ptr<uint8_t[]> pData;
+            CpuTimer::TimePoint submitTime;
+        };
 
         AVFormatContext* mpOutputContext = nullptr;
         AVStream*        mpOutputStream  = nullptr;
@@ -90,6 +137,18 @@ namespace Falcor
         const std::string mFilename;
         ResourceFormat mFormat;
         uint32_t mRowPitch = 0;
-        uint8_t* mpFlippedImage = nullptr; // Used in case the image memory layout if bottom->top
+        bool mFlipY = false;
+        QueuePolicy mQueuePolicy = QueuePolicy::Block;
+        size_t mQueueSize = 0;
+
+        std::deque<QueuedFrame> mFrameQueue;                ///< Frames waiting for the encoder thread.
+        std::vector<std::unique_ptr<uint8_t[]>> mFramePool; ///< Free frame buffers.
+        std::mutex mMutex;
+        std::condition_variable mQueueCondition;            ///< Signaled when a frame is queued or the thread should exit.
+        std::condition_variable mSlotCondition;             ///< Signaled when the encoder thread frees a slot.
+        std::thread mThread;
+        bool mTerminate = false;
+        size_t mFramesInFlight = 0;                         ///< Queued frames plus the frame being encoded.
+        Stats mStats;
     };
 }
@@ -40,6 +40,9 @@ namespace Mogwai
         const std::string kUI = "ui";
         const std::string kOutputs = "outputs";
         const std::string kCapture = "capture";
+        const std::string kWaitForCompletion = "waitForCompletion";
+        const std::string kPendingCaptures = "pendingCaptures";
+        const std::string kMaxPendingCaptures = "maxPendingCaptures";
 
         template<typename T>
         std::vector<typename T::value_type::first_type> getFirstOfPair(const T& pair)
@@ -70,6 +73,19 @@ namespace Mogwai
             w.tooltip("Capture all available outputs instead of the marked ones only.");
 
             if (w.button("Capture Current Frame")) capture();
+
+            auto& writer = AsyncTextureWriter::instance();
+            uint32_t maxPending = (uint32_t)writer.getMaxPendingCaptures();
+            if (w.var("Max Pending Captures", maxPending, 1u, 256u)) writer.setMaxPendingCaptures(maxPending);
+            w.tooltip("Maximum number of images being read back and written in the background. Capturing blocks the renderer when the limit is reached.");
+
+            auto stats = writer.getStats();
+            std::string s;
+            s += "Pending: " + std::to_string(writer.getPendingCount()) + "\n";
+            s += "Written: " + std::to_string(stats.capturesWritten) + ", failed: " + std::to_string(stats.capturesFailed) + "\n";
+            s += "Renderer stall: " + std::to_string(stats.stallTimeMs) + " ms\n";
+            s += "Readback/encode: " + std::to_string(stats.encodeTimeMs) + " ms\n";
+            w.text(s);
         }
     }
 
@@ -86,6 +102,7 @@ namespace Mogwai
         auto printGraph = [](FrameCapture* pFC, RenderGraph* pGraph) { pybind11::print(pFC->graphFramesStr(pGraph)); };
         frameCapture.def(kPrintFrames.c_str(), printGraph, "graph"_a);
         frameCapture.def(kCapture.c_str(), &FrameCapture::capture);
+        frameCapture.def(kWaitForCompletion.c_str(), [](FrameCapture* pFC) { AsyncTextureWriter::instance().waitForCompletion(); });
         auto printAllGraphs = [](FrameCapture* pFC)
         {
             std::string s;
@@ -98,6 +115,11 @@ namespace Mogwai
         auto getUI = [](FrameCapture* pFC) { return pFC->mShowUI; };
         auto setUI = [](FrameCapture* pFC, bool show) { pFC->mShowUI = show; };
         frameCapture.def_property(kUI.c_str(), getUI, setUI);
+        auto getPendingCaptures = [](FrameCapture* pFC) { return AsyncTextureWriter::instance().getPendingCount(); };
+        frameCapture.def_property_readonly(kPendingCaptures.c_str(), getPendingCaptures);
+        auto getMaxPendingCaptures = [](FrameCapture* pFC) { return AsyncTextureWriter::instance().getMaxPendingCaptures(); };
+        auto setMaxPendingCaptures = [](FrameCapture* pFC, size_t maxPending) { AsyncTextureWriter::instance().setMaxPendingCaptures(maxPending); };
+        frameCapture.def_property(kMaxPendingCaptures.c_str(), getMaxPendingCaptures, setMaxPendingCaptures);
     }
 
     std::string FrameCapture::getScriptVar() const
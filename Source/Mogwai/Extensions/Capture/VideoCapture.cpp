@@ -42,6 +42,8 @@ namespace Mogwai
         const std::string kAddRanges = "addRanges";
         const std::string kPrint = "print";
         const std::string kOutputs = "outputs";
+        const std::string kQueueSize = "queueSize";
+        const std::string kDropFrames = "dropFrames";
 
         Texture::SharedPtr createTextureForBlit(const Texture* pSource)
         {
@@ -70,6 +72,10 @@ namespace Mogwai
             CaptureTrigger::renderUI(w);
             w.separator();
             mpEncoderUI->render(w, true);
+            w.var("Queue Size", mQueueSize, 1u, 64u);
+            w.tooltip("Maximum number of frames waiting to be encoded.");
+            w.checkbox("Drop Frames", mDropFrames);
+            w.tooltip("Drop frames when the queue is full instead of blocking the renderer.");
         }
     }
 
@@ -80,6 +86,8 @@ namespace Mogwai
         d.codec = mpEncoderUI->getCodec();
         d.fps = mpEncoderUI->getFPS();
         d.gopSize = mpEncoderUI->getGopSize();
+        d.queueSize = mQueueSize;
+        d.queuePolicy = mDropFrames ? VideoEncoder::QueuePolicy::DropFrames : VideoEncoder::QueuePolicy::Block;
 
         for (uint32_t i = 0 ; i < pGraph->getOutputCount() ; i++)
         {
@@ -113,7 +121,17 @@ namespace Mogwai
 
     void VideoCapture::endRange(RenderGraph* pGraph, const Range& r)
     {
-        for (const auto& e : mEncoders) e.pEncoder->endCapture();
+        for (const auto& e : mEncoders)
+        {
+            e.pEncoder->endCapture();
+
+            auto stats = e.pEncoder->getStats();
+            std::string s = "Video capture of '" + e.output + "': " + std::to_string(stats.framesEncoded) + " frames encoded, " + std::to_string(stats.framesDropped) + " dropped";
+            s += ", encoder " + std::to_string(stats.encodeFps) + " fps, latency avg " + std::to_string(stats.avgLatencyMs) + " ms, max " + std::to_string(stats.maxLatencyMs) + " ms";
+            s += ", renderer stalled " + std::to_string(stats.stallTimeMs) + " ms";
+            logInfo(s);
+        }
+        mEncoders.clear();
     }
 
     void VideoCapture::triggerFrame(RenderContext* pCtx, RenderGraph* pGraph, uint64_t frameID)
@@ -159,6 +177,14 @@ namespace Mogwai
         auto setGopSize = [](VideoCapture* pVC, uint32_t gop) {pVC->mpEncoderUI->setGopSize(gop); return pVC; };
         videoCapture.def_property(kGopSize.c_str(), getGopSize, setGopSize);
 
+        auto getQueueSize = [](VideoCapture* pVC) { return pVC->mQueueSize; };
+        auto setQueueSize = [](VideoCapture* pVC, uint32_t size) { pVC->mQueueSize = std::max(size, 1u); return pVC; };
+        videoCapture.def_property(kQueueSize.c_str(), getQueueSize, setQueueSize);
+
+        auto getDropFrames = [](VideoCapture* pVC) { return pVC->mDropFrames; };
+        auto setDropFrames = [](VideoCapture* pVC, bool drop) { pVC->mDropFrames = drop; return pVC; };
+        videoCapture.def_property(kDropFrames.c_str(), getDropFrames, setDropFrames);
+
         // Ranges
         videoCapture.def(kAddRanges.c_str(), pybind11::overload_cast<const RenderGraph*, const range_vec&>(&VideoCapture::addRanges), "graph"_a, "ranges"_a);
         videoCapture.def(kAddRanges.c_str(), pybind11::overload_cast<const std::string&, const range_vec&>(&VideoCapture::addRanges), "name"_a, "ranges"_a);
@@ -190,6 +216,8 @@ namespace Mogwai
         s += ScriptWriter::makeSetProperty(var, kFps, mpEncoderUI->getFPS());
         s += ScriptWriter::makeSetProperty(var, kBitrate, mpEncoderUI->getBitrate());
         s += ScriptWriter::makeSetProperty(var, kGopSize, mpEncoderUI->getGopSize());
+        s += ScriptWriter::makeSetProperty(var, kQueueSize, mQueueSize);
+        s += ScriptWriter::makeSetProperty(var, kDropFrames, mDropFrames);
 
         for (const auto& g : mGraphRanges)
         {
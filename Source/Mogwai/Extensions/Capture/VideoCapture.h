@@ -53,6 +53,8 @@ namespace Mogwai
         std::string graphRangesStr(const RenderGraph* pGraph);
 
         VideoEncoderUI::UniquePtr mpEncoderUI;
+        uint32_t mQueueSize = 4;
+        bool mDropFrames = false;
 
         struct EncodeData
         {
@@ -64,6 +64,7 @@ int main(int argc, char** argv)
     parser.helpParams.programName = "FalcorTest";
     args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
     args::ValueFlag<std::string> filterFlag(parser, "filter", "Regular expression for filtering tests to run.", {'f', "filter"});
+    args::Flag warpFlag(parser, "warp", "Run on the software rasterizer. Use this on machines without a GPU.", {"warp"});
     args::CompletionFlag completionFlag(parser, {"complete"});
 
     try
@@ -103,6 +104,7 @@ int main(int argc, char** argv)
     config.windowDesc.mode = Window::WindowMode::Minimized;
     config.windowDesc.resizableWindow = true;
     config.windowDesc.width = config.windowDesc.height = 2;
+    config.deviceDesc.useSoftwareAdapter = args::get(warpFlag);
     Sample::run(config, pRenderer, argc, argv);
     return sReturnCode;
 }
@@ -0,0 +1,234 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        class MockHeapBackend : public BufferAllocator::Backend
+        {
+        public:
+            ApiObjectHandle createHeap(uint64_t size) override
+            {
+                mHeapCount++;
+                return nullptr;
+            }
+
+            uint32_t mHeapCount = 0;
+        };
+    }
+
+    CPU_TEST(TlsfAllocator)
+    {
+        TlsfAllocator alloc(1024, 16);
+        EXPECT_EQ(alloc.getCapacity(), 1024);
+
+        // Sizes are rounded up to the granularity.
+        auto a = alloc.allocate(10);
+        auto b = alloc.allocate(100);
+        auto c = alloc.allocate(16, 64);
+        EXPECT(a.isValid() && b.isValid() && c.isValid());
+        EXPECT_EQ(a.offset, 0);
+        EXPECT_EQ(a.size, 16);
+        EXPECT_EQ(b.offset, 16);
+        EXPECT_EQ(b.size, 112);
+        EXPECT_EQ(c.offset, 128);
+        EXPECT_EQ(c.offset % 64, 0);
+
+        auto stats = alloc.getStats();
+        EXPECT_EQ(stats.allocationCount, 3);
+        EXPECT_EQ(stats.usedSize, 144);
+        EXPECT_EQ(stats.freeBlockCount, 1);
+        EXPECT_EQ(stats.getFragmentation(), 0.f);
+
+        // Freeing the middle allocation leaves a hole.
+        alloc.free(b);
+        stats = alloc.getStats();
+        EXPECT_EQ(stats.freeBlockCount, 2);
+        EXPECT_EQ(stats.largestFreeBlock, 1024 - 144);
+        EXPECT_GT(stats.getFragmentation(), 0.f);
+
+        // The hole is reused for an allocation that fits.
+        auto d = alloc.allocate(64);
+        EXPECT_EQ(d.offset, 16);
+
+        // Oversized requests fail.
+        EXPECT(!alloc.allocate(2048).isValid());
+
+        // Freeing everything coalesces back into a single block.
+        alloc.free(a);
+        alloc.free(c);
+        alloc.free(d);
+        stats = alloc.getStats();
+        EXPECT(alloc.isEmpty());
+        EXPECT_EQ(stats.freeBlockCount, 1);
+        EXPECT_EQ(stats.largestFreeBlock, 1024);
+        EXPECT(alloc.allocate(1024).isValid());
+    }
+
+    CPU_TEST(TlsfAllocatorRandom)
+    {
+        const uint64_t kCapacity = 1 << 24;
+        TlsfAllocator alloc(kCapacity, 256);
+        std::mt19937 rng;
+        std::vector<TlsfAllocator::Allocation> live;
+
+        for (uint32_t i = 0; i < 10000; i++)
+        {
+            if (live.empty() || rng() % 3 != 0)
+            {
+                uint64_t size = 1 + rng() % 100000;
+                uint64_t alignment = 1ull << (rng() % 16);
+                auto a = alloc.allocate(size, alignment);
+                if (!a.isValid()) continue;
+                EXPECT_EQ(a.offset % std::max(alignment, (uint64_t)256), 0);
+                EXPECT_LE(a.offset + a.size, kCapacity);
+                for (const auto& b : live) EXPECT(a.offset + a.size <= b.offset || b.offset + b.size <= a.offset) << "overlapping allocations";
+                live.push_back(a);
+            }
+            else
+            {
+                size_t index = rng() % live.size();
+                alloc.free(live[index]);
+                live[index] = live.back();
+                live.pop_back();
+            }
+        }
+
+        for (const auto& a : live) alloc.free(a);
+        auto stats = alloc.getStats();
+        EXPECT_EQ(stats.allocationCount, 0);
+        EXPECT_EQ(stats.freeBlockCount, 1);
+        EXPECT_EQ(stats.largestFreeBlock, kCapacity);
+    }
+
+    CPU_TEST(BufferAllocatorDeferredRelease)
+    {
+        auto pBackend = std::make_unique<MockHeapBackend>();
+        MockHeapBackend* pMock = pBackend.get();
+
+        BufferAllocator::Desc desc;
+        desc.heapSize = 1024;
+        desc.maxAllocationSize = 512;
+        desc.granularity = 64;
+        auto pAllocator = BufferAllocator::create(std::move(pBackend), desc, nullptr);
+
+        // Requests above the limit are not sub-allocated.
+        EXPECT(!pAllocator->allocate(1000).isValid());
+        EXPECT_EQ(pMock->mHeapCount, 0);
+
+        // Fill the first heap, the next allocation creates a second heap.
+        auto a = pAllocator->allocate(512);
+        auto b = pAllocator->allocate(512);
+        auto c = pAllocator->allocate(100);
+        EXPECT(a.isValid() && b.isValid() && c.isValid());
+        EXPECT_EQ(a.heapIndex, 0);
+        EXPECT_EQ(b.heapIndex, 0);
+        EXPECT_EQ(c.heapIndex, 1);
+        EXPECT_EQ(pMock->mHeapCount, 2);
+        EXPECT_EQ(pAllocator->getStats().heapCount, 2);
+        EXPECT_EQ(pAllocator->getStats().usedSize, 1024 + 128);
+
+        // Released memory isn't reused before the GPU reaches the fence value.
+        pAllocator->release(a, 5);
+        EXPECT(!a.isValid());
+        EXPECT_EQ(pAllocator->getStats().pendingReleaseCount, 1);
+        pAllocator->executeDeferredReleases(4);
+        EXPECT_EQ(pAllocator->getStats().pendingReleaseCount, 1);
+        auto d = pAllocator->allocate(512);
+        EXPECT_EQ(d.heapIndex, 1);
+
+        pAllocator->executeDeferredReleases(5);
+        auto stats = pAllocator->getStats();
+        EXPECT_EQ(stats.pendingReleaseCount, 0);
+        EXPECT_EQ(stats.usedSize, 512 + 128 + 512);
+        EXPECT_EQ(pAllocator->allocate(512).heapIndex, 0);
+
+        // Empty heaps are released, except for the last one.
+        pAllocator->release(c, 6);
+        pAllocator->release(d, 6);
+        pAllocator->executeDeferredReleases(6);
+        EXPECT_EQ(pAllocator->getStats().heapCount, 1);
+        EXPECT_EQ(pMock->mHeapCount, 2);
+    }
+
+    GPU_TEST(BufferAllocatorSubAllocatedBuffers)
+    {
+        const auto& pAllocator = gpDevice->getBufferAllocator();
+        if (!pAllocator) return;
+
+        auto before = pAllocator->getStats();
+
+        const uint32_t kBufferCount = 16;
+        std::vector<Buffer::SharedPtr> buffers;
+        for (uint32_t i = 0; i < kBufferCount; i++)
+        {
+            std::vector<uint32_t> data(64 + i, i);
+            buffers.push_back(Buffer::create(data.size() * sizeof(uint32_t), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, data.data()));
+        }
+
+        auto after = pAllocator->getStats();
+        EXPECT_EQ(after.allocationCount, before.allocationCount + kBufferCount);
+
+        for (uint32_t i = 0; i < kBufferCount; i++)
+        {
+            const uint32_t* pData = static_cast<const uint32_t*>(buffers[i]->map(Buffer::MapType::Read));
+            for (uint32_t j = 0; j < 64 + i; j++) EXPECT_EQ(pData[j], i) << "buffer " << i << " element " << j;
+            buffers[i]->unmap();
+        }
+    }
+
+    GPU_TEST(BufferAllocatorClearsReusedMemory)
+    {
+        const auto& pAllocator = gpDevice->getBufferAllocator();
+        if (!pAllocator) return;
+
+        const uint32_t kElementCount = 1024;
+        const auto bindFlags = Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess;
+        std::vector<uint32_t> data(kElementCount, 0xdeadbeef);
+        Buffer::SharedPtr pBuffer = Buffer::create(kElementCount * sizeof(uint32_t), bindFlags, Buffer::CpuAccess::None, data.data());
+        const uint32_t* pData = static_cast<const uint32_t*>(pBuffer->map(Buffer::MapType::Read));
+        EXPECT_EQ(pData[0], 0xdeadbeef);
+        pBuffer->unmap();
+
+        // Free the buffer and return its memory to the heap once the GPU is idle.
+        auto usedSize = pAllocator->getStats().usedSize;
+        pBuffer = nullptr;
+        ctx.getRenderContext()->flush(true);
+        pAllocator->executeDeferredReleases(std::numeric_limits<uint64_t>::max());
+        EXPECT_LT(pAllocator->getStats().usedSize, usedSize);
+
+        // A buffer created without init data in the same memory must not see the old contents.
+        pBuffer = Buffer::create(kElementCount * sizeof(uint32_t), bindFlags, Buffer::CpuAccess::None, nullptr);
+        pData = static_cast<const uint32_t*>(pBuffer->map(Buffer::MapType::Read));
+        for (uint32_t i = 0; i < kElementCount; i++) EXPECT_EQ(pData[i], 0u) << "element " << i;
+        pBuffer->unmap();
+    }
+}
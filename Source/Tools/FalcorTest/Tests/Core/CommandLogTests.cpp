@@ -0,0 +1,116 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+
+namespace Falcor
+{
+    CPU_TEST(CommandLog)
+    {
+        auto pLog = CommandLog::create();
+        pLog->record({ CommandLog::Type::UpdateBuffer, nullptr, 256 });
+        pLog->record({ CommandLog::Type::Draw, nullptr, 0, 3, 1 });
+        pLog->record({ CommandLog::Type::DrawIndexed, nullptr, 0, 36, 4 });
+        pLog->record({ CommandLog::Type::UpdateTexture, nullptr, 1024, 1 });
+
+        const auto& stats = pLog->getStats();
+        EXPECT_EQ(stats.getTotalCount(), 4);
+        EXPECT_EQ(stats.getDrawCount(), 2);
+        EXPECT_EQ(stats.getCount(CommandLog::Type::UpdateBuffer), 1);
+        EXPECT_EQ(stats.uploadedBytes, 1280);
+
+        const auto& commands = pLog->getCommands();
+        EXPECT_EQ(commands.size(), 4);
+        if (commands.size() == 4)
+        {
+            EXPECT(commands[2].type == CommandLog::Type::DrawIndexed);
+            EXPECT_EQ(commands[2].count, 36);
+            EXPECT_EQ(commands[2].instanceCount, 4);
+        }
+
+        pLog->clear();
+        EXPECT(pLog->getCommands().empty());
+        EXPECT_EQ(stats.getTotalCount(), 0);
+        EXPECT_EQ(stats.uploadedBytes, 0);
+
+        // Logs that don't keep commands still count them.
+        auto pStatsLog = CommandLog::create(false);
+        pStatsLog->record({ CommandLog::Type::Dispatch, nullptr, 0, 64 });
+        EXPECT(pStatsLog->getCommands().empty());
+        EXPECT_EQ(pStatsLog->getStats().getCount(CommandLog::Type::Dispatch), 1);
+    }
+
+    GPU_TEST(CommandLogContext)
+    {
+        RenderContext* pContext = ctx.getRenderContext();
+        const uint32_t elementCount = 64;
+        std::vector<uint32_t> data(elementCount, 7);
+
+        auto pBuffer = Buffer::create(elementCount * sizeof(uint32_t), ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess, Buffer::CpuAccess::None);
+        auto pCopy = Buffer::create(elementCount * sizeof(uint32_t), ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None);
+        auto pTexture = Texture::create2D(4, 4, ResourceFormat::RGBA8Unorm, 1, 1, nullptr, ResourceBindFlags::RenderTarget);
+        pContext->flush(true);
+
+        auto pLog = CommandLog::create();
+        pContext->setCommandLog(pLog);
+        EXPECT(pContext->getCommandLog() == pLog);
+
+        pContext->updateBuffer(pBuffer.get(), data.data());
+        pContext->clearUAV(pBuffer->getUAV().get(), uint4(0));
+        pContext->copyResource(pCopy.get(), pBuffer.get());
+        pContext->clearRtv(pTexture->getRTV().get(), float4(1));
+        pContext->flush(true);
+
+        const auto& stats = pLog->getStats();
+        EXPECT_EQ(stats.getCount(CommandLog::Type::UpdateBuffer), 1);
+        EXPECT_EQ(stats.getCount(CommandLog::Type::CopyBufferRegion), 1);
+        EXPECT_EQ(stats.getCount(CommandLog::Type::ClearUav), 1);
+        EXPECT_EQ(stats.getCount(CommandLog::Type::CopyResource), 1);
+        EXPECT_EQ(stats.getCount(CommandLog::Type::ClearRtv), 1);
+        EXPECT_EQ(stats.getCount(CommandLog::Type::Submit), 1);
+        EXPECT_GE(stats.getCount(CommandLog::Type::ResourceBarrier), 3);
+        EXPECT_EQ(stats.uploadedBytes, data.size() * sizeof(uint32_t));
+        EXPECT_EQ(stats.getDrawCount(), 0);
+
+        // The stream is in recording order, with the copy that executes the upload following it.
+        std::vector<CommandLog::Type> order;
+        for (const auto& c : pLog->getCommands())
+        {
+            if (c.type != CommandLog::Type::ResourceBarrier) order.push_back(c.type);
+        }
+        std::vector<CommandLog::Type> expected = { CommandLog::Type::UpdateBuffer, CommandLog::Type::CopyBufferRegion, CommandLog::Type::ClearUav,
+            CommandLog::Type::CopyResource, CommandLog::Type::ClearRtv, CommandLog::Type::Submit };
+        EXPECT(order == expected);
+        EXPECT(pLog->getCommands()[0].pResource == pBuffer.get());
+
+        // Nothing is recorded once the log is detached.
+        pContext->setCommandLog(nullptr);
+        pContext->updateBuffer(pBuffer.get(), data.data());
+        pContext->flush(true);
+        EXPECT_EQ(stats.getCount(CommandLog::Type::UpdateBuffer), 1);
+    }
+}
@@ -27,6 +27,9 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 
+// The handle benchmark is disabled by default as it only logs the timing of variable lookups by name and by handle.
+//#define RUN_BENCHMARK_TESTS
+
 namespace Falcor
 {
     /** GPU test for builtin constant buffer using cbuffer syntax.
@@ -64,4 +67,86 @@ namespace Falcor
         EXPECT_EQ(result[2], 5.5f);
         ctx.unmapBuffer("result");
     }
+
+    /** GPU test for setting constant buffer variables through pre-resolved handles.
+    */
+    GPU_TEST(UniformVarHandle)
+    {
+        ctx.createProgram("Tests/Core/ConstantBufferTests.cs.slang", "testCbuffer2", Program::DefineList(), Shader::CompilerFlags::None);
+        ctx.allocateStructuredBuffer("result", 3);
+
+        auto a = ctx["params2"]["a"].getUniformHandle<int32_t>();
+        auto b = ctx["params2"]["b"].getUniformHandle<uint32_t>();
+        auto c = ctx["params2"]["c"].getUniformHandle<float>();
+        EXPECT(a.isValid() && b.isValid() && c.isValid());
+        EXPECT(!ctx["params2"]["c"].getUniformHandle<int32_t>().isValid());
+        EXPECT_EQ(c.getByteOffset(), ctx["params2"]["c"].getByteOffset());
+
+        ParameterBlock* pBlock = a.getBlock();
+        a.set(1);
+        b.set(3u);
+        c.set(5.5f);
+        ctx.runProgram(1, 1, 1);
+
+        const float* result = ctx.mapBuffer<const float>("result");
+        EXPECT_EQ(result[0], 1);
+        EXPECT_EQ(result[1], 3);
+        EXPECT_EQ(result[2], 5.5f);
+        ctx.unmapBuffer("result");
+
+        // The constant buffer was written, so nothing should be dirty. Setting an unchanged value should not dirty the block.
+        auto range = pBlock->getDirtyUniformRange();
+        EXPECT_GE(range.first, range.second);
+        EXPECT(!c.set(5.5f));
+        range = pBlock->getDirtyUniformRange();
+        EXPECT_GE(range.first, range.second);
+
+        // A changed value should dirty only its own bytes.
+        EXPECT(c.set(7.25f));
+        range = pBlock->getDirtyUniformRange();
+        EXPECT_EQ(range.first, c.getByteOffset());
+        EXPECT_EQ(range.second, c.getByteOffset() + sizeof(float));
+
+        // Batched update.
+        int32_t newA = 2;
+        uint32_t newB = 11;
+        const ParameterBlock::UniformUpdate updates[] =
+        {
+            { a.getByteOffset(), &newA, sizeof(newA) },
+            { b.getByteOffset(), &newB, sizeof(newB) },
+        };
+        EXPECT(pBlock->updateUniformData(updates, std::size(updates)));
+        EXPECT(!pBlock->updateUniformData(updates, std::size(updates)));
+        ctx.runProgram(1, 1, 1);
+
+        result = ctx.mapBuffer<const float>("result");
+        EXPECT_EQ(result[0], 2);
+        EXPECT_EQ(result[1], 11);
+        EXPECT_EQ(result[2], 7.25f);
+        ctx.unmapBuffer("result");
+    }
+
+    /** Microbenchmark comparing string lookups against pre-resolved handles for setting constant buffer variables.
+    */
+#ifdef RUN_BENCHMARK_TESTS
+    GPU_TEST(UniformVarHandleBenchmark)
+#else
+    GPU_TEST(UniformVarHandleBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        ctx.createProgram("Tests/Core/ConstantBufferTests.cs.slang", "testCbuffer2", Program::DefineList(), Shader::CompilerFlags::None);
+        const uint32_t kIterations = 100000;
+
+        auto start = CpuTimer::getCurrentTimePoint();
+        for (uint32_t i = 0; i < kIterations; i++) ctx["params2"]["c"] = (float)i;
+        double stringMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        auto c = ctx["params2"]["c"].getUniformHandle<float>();
+        start = CpuTimer::getCurrentTimePoint();
+        for (uint32_t i = 0; i < kIterations; i++) c.set((float)i);
+        double handleMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        EXPECT_EQ(*reinterpret_cast<const float*>((const uint8_t*)c.getBlock()->getRawData() + c.getByteOffset()), (float)(kIterations - 1));
+        logInfo("UniformVarHandleBenchmark: " + std::to_string(kIterations) + " sets, string path " + std::to_string(stringMs * 1000.0 / kIterations) + " us/set, handle " + std::to_string(handleMs * 1000.0 / kIterations) + " us/set");
+    }
 }
@@ -0,0 +1,177 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <random>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        struct Item
+        {
+            uint32_t id = 0;
+            uint64_t fenceValue = 0;
+        };
+    }
+
+    CPU_TEST(DeferredReleaseQueueStress)
+    {
+        const uint32_t kThreadCount = 8;
+        const uint32_t kItemsPerThread = 20000;
+        const uint32_t kItemCount = kThreadCount * kItemsPerThread;
+
+        // Use a small ring so that the overflow path is exercised too.
+        DeferredReleaseQueue<Item> queue(64);
+        std::atomic<uint64_t> fence{ 1 };
+        std::atomic<uint32_t> producersDone{ 0 };
+        std::vector<uint32_t> releaseCount(kItemCount, 0);
+        std::atomic<uint32_t> earlyReleases{ 0 };
+
+        auto consume = [&]()
+        {
+            uint64_t completed = fence.load() - 1;
+            queue.release(completed, [&](Item& item)
+            {
+                if (item.fenceValue > completed) earlyReleases++;
+                releaseCount[item.id]++;
+            });
+        };
+
+        std::vector<std::thread> producers;
+        for (uint32_t t = 0; t < kThreadCount; t++)
+        {
+            producers.emplace_back([&, t]()
+            {
+                for (uint32_t i = 0; i < kItemsPerThread; i++)
+                {
+                    uint64_t fenceValue = fence.load();
+                    queue.push(fenceValue, { t * kItemsPerThread + i, fenceValue });
+                }
+                producersDone++;
+            });
+        }
+
+        // Two consumers compete for the queue while the fence advances.
+        std::thread consumer([&]() { while (producersDone.load() < kThreadCount) consume(); });
+        while (producersDone.load() < kThreadCount)
+        {
+            fence++;
+            consume();
+        }
+
+        for (auto& t : producers) t.join();
+        consumer.join();
+
+        fence++;
+        consume();
+        EXPECT_EQ(queue.getPendingCount(), 0);
+        EXPECT_EQ(earlyReleases.load(), 0);
+
+        uint32_t wrongCount = 0;
+        for (uint32_t count : releaseCount) wrongCount += count != 1 ? 1 : 0;
+        EXPECT_EQ(wrongCount, 0) << "items not released exactly once";
+    }
+
+    CPU_TEST(DeferredReleaseQueueTryPop)
+    {
+        DeferredReleaseQueue<uint32_t> queue(4);
+        for (uint32_t i = 0; i < 10; i++) queue.push(10 - i, i);
+        EXPECT_EQ(queue.getPendingCount(), 10);
+
+        // Objects come out in fence order, and only once their fence value is reached.
+        uint32_t value;
+        EXPECT(!queue.tryPop(0, value));
+        EXPECT(queue.tryPop(1, value));
+        EXPECT_EQ(value, 9);
+        EXPECT(!queue.tryPop(1, value));
+        EXPECT_EQ(queue.release(5), 4);
+        EXPECT(queue.tryPop(6, value));
+        EXPECT_EQ(value, 4);
+        queue.clear();
+        EXPECT_EQ(queue.getPendingCount(), 0);
+    }
+
+    GPU_TEST(GpuMemoryHeapMultithreaded)
+    {
+        const uint32_t kThreadCount = 8;
+        const uint32_t kAllocationsPerThread = 2000;
+        auto pFence = GpuFence::create();
+        auto pHeap = GpuMemoryHeap::create(GpuMemoryHeap::Type::Upload, 64 * 1024, pFence);
+
+        std::vector<std::vector<std::pair<GpuMemoryHeap::Allocation, uint32_t>>> allocations(kThreadCount);
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < kThreadCount; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                std::mt19937 rng(t);
+                for (uint32_t i = 0; i < kAllocationsPerThread; i++)
+                {
+                    uint32_t size = 4 * (1 + rng() % 1024);
+                    auto data = pHeap->allocate(size, 16);
+                    uint32_t pattern = (t << 24) | i;
+                    std::fill_n((uint32_t*)data.pData, size / 4, pattern);
+                    allocations[t].push_back({ data, size });
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+
+        // Overlapping allocations would have overwritten each other's patterns.
+        uint32_t corrupted = 0;
+        for (uint32_t t = 0; t < kThreadCount; t++)
+        {
+            for (uint32_t i = 0; i < kAllocationsPerThread; i++)
+            {
+                const auto& [data, size] = allocations[t][i];
+                uint32_t pattern = (t << 24) | i;
+                const uint32_t* pData = (const uint32_t*)data.pData;
+                if (std::any_of(pData, pData + size / 4, [pattern](uint32_t v) { return v != pattern; })) corrupted++;
+            }
+        }
+        EXPECT_EQ(corrupted, 0);
+
+        // Release from all threads concurrently, then retire everything once the GPU passed the fence.
+        threads.clear();
+        for (uint32_t t = 0; t < kThreadCount; t++)
+        {
+            threads.emplace_back([&, t]() { for (auto& a : allocations[t]) pHeap->release(a.first); });
+        }
+        for (auto& t : threads) t.join();
+
+        pFence->gpuSignal(ctx.getRenderContext()->getLowLevelData()->getCommandQueue());
+        pFence->syncCpu();
+        pHeap->executeDeferredReleases();
+
+        // The freed pages are recycled, so a full page can be allocated without growing the heap.
+        auto data = pHeap->allocate(64 * 1024);
+        EXPECT_EQ(data.offset, 0);
+        pHeap->release(data);
+    }
+}
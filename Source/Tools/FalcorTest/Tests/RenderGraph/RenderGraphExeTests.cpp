@@ -0,0 +1,486 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "RenderGraph/RenderGraph.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+// The render graph benchmarks are disabled by default as they execute graphs for many frames and only log timings.
+//#define RUN_BENCHMARK_TESTS
+
+namespace Falcor
+{
+    namespace
+    {
+        const std::string kInput = "input";
+        const std::string kOutputs[] = { "output0", "output1", "output2", "output3" };
+
+        std::atomic<uint32_t> sExecuteCounter{ 0 };
+
+        /** Render pass that does no work besides looking up its resources, either by name or by handle.
+        */
+        class NoOpPass : public RenderPass
+        {
+        public:
+            using SharedPtr = std::shared_ptr<NoOpPass>;
+
+            static SharedPtr create() { return SharedPtr(new NoOpPass()); }
+
+            RenderPassReflection reflect(const CompileData& compileData) override
+            {
+                RenderPassReflection reflector;
+                reflector.addInput(kInput, "Input");
+                for (const auto& output : kOutputs) reflector.addOutput(output, "Output").texture2D(1, 1).format(output == kOutputs[1] ? mOutput1Format : ResourceFormat::R32Float);
+                return reflector;
+            }
+
+            void compile(RenderContext* pContext, const CompileData& compileData) override
+            {
+                mHandles.clear();
+                compileCount++;
+            }
+
+            bool supportsParallelRecording() const override { return parallelRecording; }
+
+            void execute(RenderContext* pContext, const RenderData& renderData) override
+            {
+                executeCount++;
+                executeOrder = sExecuteCounter++;
+                executeContext = pContext;
+
+                // Stands in for CPU-heavy draw submission without recording GPU work
+                uint64_t hash = 0;
+                for (uint32_t i = 0; i < cpuWork; i++) hash = hash * 6364136223846793005ull + i;
+                workResult = hash;
+
+                if (pLegacyResources)
+                {
+                    resources[0] = pLegacyResources->getResource(getName() + '.' + kInput).get();
+                    for (size_t i = 0; i < std::size(kOutputs); i++) resources[i + 1] = pLegacyResources->getResource(getName() + '.' + kOutputs[i]).get();
+                }
+                else if (useHandles)
+                {
+                    if (mHandles.empty())
+                    {
+                        mHandles.push_back(renderData.getHandle(kInput));
+                        for (const auto& output : kOutputs) mHandles.push_back(renderData.getHandle(output));
+                    }
+                    for (size_t i = 0; i < mHandles.size(); i++) resources[i] = renderData[mHandles[i]].get();
+                }
+                else
+                {
+                    resources[0] = renderData[kInput].get();
+                    for (size_t i = 0; i < std::size(kOutputs); i++) resources[i + 1] = renderData[kOutputs[i]].get();
+                }
+                output0State = resources[1]->isStateGlobal() ? resources[1]->getGlobalState() : Resource::State::Undefined;
+            }
+
+            std::string getDesc() override { return "No-op pass"; }
+
+            /** Change the format of the second output. Notifies the graph even if the format is unchanged.
+            */
+            void setOutput1Format(ResourceFormat format)
+            {
+                mOutput1Format = format;
+                mPassChangedCB();
+            }
+
+            bool useHandles = false;
+            ResourceCache::SharedPtr pLegacyResources;     ///< If set, resources are looked up by their full name in this cache, like RenderData did before field handles.
+            Resource* resources[1 + std::size(kOutputs)] = {};
+            uint32_t compileCount = 0;
+            bool parallelRecording = false;
+            uint32_t cpuWork = 0;
+            uint32_t executeCount = 0;
+            uint32_t executeOrder = 0;
+            RenderContext* executeContext = nullptr;
+            Resource::State output0State = Resource::State::Undefined;
+            uint64_t workResult = 0;
+
+        private:
+            NoOpPass() = default;
+            std::vector<ResourceCache::Handle> mHandles;
+            ResourceFormat mOutput1Format = ResourceFormat::R32Float;
+        };
+
+        /** Create a graph with a chain of no-op passes. The input of the first pass is a graph input.
+        */
+        RenderGraph::SharedPtr createChain(uint32_t passCount, std::vector<NoOpPass::SharedPtr>& passes)
+        {
+            RenderGraph::SharedPtr pGraph = RenderGraph::create("No-op chain");
+            for (uint32_t i = 0; i < passCount; i++)
+            {
+                passes.push_back(NoOpPass::create());
+                pGraph->addPass(passes.back(), "pass" + std::to_string(i));
+                if (i > 0) pGraph->addEdge("pass" + std::to_string(i - 1) + "." + kOutputs[0], "pass" + std::to_string(i) + "." + kInput);
+            }
+            pGraph->markOutput("pass" + std::to_string(passCount - 1) + "." + kOutputs[0]);
+            return pGraph;
+        }
+    }
+
+    GPU_TEST(RenderGraphExe_ResourceHandles)
+    {
+        RenderContext* pRenderContext = ctx.getRenderContext();
+        std::vector<NoOpPass::SharedPtr> passes;
+        RenderGraph::SharedPtr pGraph = createChain(3, passes);
+        Texture::SharedPtr pInput = Texture::create2D(1, 1, ResourceFormat::R32Float);
+        pGraph->setInput("pass0." + kInput, pInput);
+
+        pGraph->execute(pRenderContext);
+        std::vector<std::vector<Resource*>> byName;
+        for (const auto& pPass : passes) byName.emplace_back(std::begin(pPass->resources), std::end(pPass->resources));
+
+        for (const auto& pPass : passes) pPass->useHandles = true;
+        pGraph->execute(pRenderContext);
+
+        for (size_t i = 0; i < passes.size(); i++)
+        {
+            for (size_t j = 0; j < byName[i].size(); j++)
+            {
+                EXPECT(byName[i][j] != nullptr) << "pass " << i << ", field " << j;
+                EXPECT(byName[i][j] == passes[i]->resources[j]) << "pass " << i << ", field " << j;
+            }
+            if (i > 0) EXPECT(passes[i]->resources[0] == passes[i - 1]->resources[1]) << "pass " << i;
+        }
+        EXPECT(passes[0]->resources[0] == pInput.get());
+        EXPECT(passes.back()->resources[1] == pGraph->getOutput("pass2." + kOutputs[0]).get());
+
+        // Handles follow external resources set after compilation.
+        Texture::SharedPtr pOtherInput = Texture::create2D(1, 1, ResourceFormat::R32Float);
+        pGraph->setInput("pass0." + kInput, pOtherInput);
+        pGraph->execute(pRenderContext);
+        EXPECT(passes[0]->resources[0] == pOtherInput.get());
+    }
+
+    GPU_TEST(RenderGraph_IncrementalCompilation)
+    {
+        RenderContext* pRenderContext = ctx.getRenderContext();
+        std::vector<NoOpPass::SharedPtr> passes;
+        RenderGraph::SharedPtr pGraph = createChain(4, passes);
+        pGraph->setInput("pass0." + kInput, Texture::create2D(1, 1, ResourceFormat::R32Float));
+
+        auto getResources = [&]()
+        {
+            std::vector<std::vector<Resource*>> resources;
+            for (const auto& pPass : passes) resources.emplace_back(std::begin(pPass->resources), std::end(pPass->resources));
+            return resources;
+        };
+
+        pGraph->execute(pRenderContext);
+        const auto& stats = pGraph->getCompilationStats();
+        EXPECT(!stats.incremental);
+        EXPECT_EQ(stats.reflectedPasses.size(), 4);
+        EXPECT_EQ(stats.compiledPasses.size(), 4);
+        EXPECT_EQ(stats.reusedResourceCount, 0);
+        uint32_t resourceCount = stats.allocatedResourceCount;
+        auto initial = getResources();
+
+        // Notifying a change without changing the reflection recompiles the pass and its downstream consumers, and keeps all resources.
+        passes[2]->setOutput1Format(ResourceFormat::R32Float);
+        pGraph->execute(pRenderContext);
+        EXPECT(stats.incremental);
+        EXPECT(stats.reflectedPasses == std::vector<std::string>({ "pass2", "pass3" }));
+        EXPECT(stats.compiledPasses == std::vector<std::string>({ "pass2", "pass3" }));
+        EXPECT_EQ(passes[0]->compileCount, 1);
+        EXPECT_EQ(passes[1]->compileCount, 1);
+        EXPECT_EQ(passes[2]->compileCount, 2);
+        EXPECT_EQ(passes[3]->compileCount, 2);
+        EXPECT_EQ(stats.reusedResourceCount, resourceCount);
+        EXPECT_EQ(stats.allocatedResourceCount, 0);
+        EXPECT(getResources() == initial);
+
+        // Changing a field only replaces that resource.
+        passes[1]->setOutput1Format(ResourceFormat::R16Float);
+        pGraph->execute(pRenderContext);
+        EXPECT(stats.reflectedPasses == std::vector<std::string>({ "pass1", "pass2", "pass3" }));
+        EXPECT_EQ(passes[0]->compileCount, 1);
+        EXPECT_EQ(stats.reusedResourceCount, resourceCount - 1);
+        EXPECT_EQ(stats.allocatedResourceCount, 1);
+        auto updated = getResources();
+        for (size_t i = 0; i < passes.size(); i++)
+        {
+            for (size_t j = 0; j < updated[i].size(); j++)
+            {
+                bool changed = (i == 1 && j == 2);
+                EXPECT_EQ(updated[i][j] != initial[i][j], changed) << "pass " << i << ", field " << j;
+            }
+        }
+        EXPECT(passes[1]->resources[2]->asTexture()->getFormat() == ResourceFormat::R16Float);
+    }
+
+    GPU_TEST(RenderGraph_IncrementalCompilationHandles)
+    {
+        RenderContext* pRenderContext = ctx.getRenderContext();
+        std::vector<NoOpPass::SharedPtr> passes;
+        RenderGraph::SharedPtr pGraph = createChain(3, passes);
+        pGraph->setInput("pass0." + kInput, Texture::create2D(1, 1, ResourceFormat::R32Float));
+
+        pGraph->execute(pRenderContext);
+        std::vector<std::vector<Resource*>> byName;
+        for (const auto& pPass : passes) byName.emplace_back(std::begin(pPass->resources), std::end(pPass->resources));
+        for (const auto& pPass : passes) pPass->useHandles = true;
+        pGraph->execute(pRenderContext);
+
+        // Adding and removing an unrelated pass doesn't recompile the chain, so its passes keep the handles they got before.
+        auto checkHandles = [&]()
+        {
+            for (size_t i = 0; i < passes.size(); i++)
+            {
+                EXPECT_EQ(passes[i]->compileCount, 1) << "pass " << i;
+                for (size_t j = 0; j < byName[i].size(); j++) EXPECT(byName[i][j] == passes[i]->resources[j]) << "pass " << i << ", field " << j;
+            }
+        };
+
+        auto pExtra = NoOpPass::create();
+        pExtra->useHandles = true;
+        pGraph->addPass(pExtra, "extra");
+        pGraph->setInput("extra." + kInput, Texture::create2D(1, 1, ResourceFormat::R32Float));
+        pGraph->markOutput("extra." + kOutputs[0]);
+        pGraph->execute(pRenderContext);
+        checkHandles();
+        EXPECT_EQ(pExtra->compileCount, 1);
+        for (auto pResource : pExtra->resources) EXPECT(pResource != nullptr);
+
+        pGraph->removePass("extra");
+        pGraph->execute(pRenderContext);
+        checkHandles();
+    }
+
+    GPU_TEST(RenderGraph_ParallelRecording)
+    {
+        RenderContext* pRenderContext = ctx.getRenderContext();
+
+        // A chain of passes with independent branches hanging off each pass of the chain.
+        const uint32_t chainLength = 3;
+        const uint32_t branchCount = 6;
+        std::vector<NoOpPass::SharedPtr> passes;
+        RenderGraph::SharedPtr pGraph = createChain(chainLength, passes);
+        std::vector<std::pair<uint32_t, NoOpPass::SharedPtr>> branches;
+        for (uint32_t i = 0; i < chainLength; i++)
+        {
+            for (uint32_t j = 0; j < branchCount; j++)
+            {
+                std::string name = "branch" + std::to_string(i) + "_" + std::to_string(j);
+                auto pPass = NoOpPass::create();
+                pGraph->addPass(pPass, name);
+                pGraph->addEdge("pass" + std::to_string(i) + "." + kOutputs[0], name + "." + kInput);
+                pGraph->markOutput(name + "." + kOutputs[0]);
+                branches.emplace_back(i, pPass);
+            }
+        }
+        pGraph->setInput("pass0." + kInput, Texture::create2D(1, 1, ResourceFormat::R32Float));
+
+        // Mix passes that record on worker threads with passes that don't.
+        for (size_t i = 0; i < branches.size(); i++) branches[i].second->parallelRecording = (i % 3) != 0;
+        for (auto& pPass : passes) pPass->parallelRecording = true;
+
+        auto getResources = [&]()
+        {
+            std::vector<Resource*> resources;
+            for (const auto& pPass : passes) resources.insert(resources.end(), std::begin(pPass->resources), std::end(pPass->resources));
+            for (const auto& [i, pPass] : branches) resources.insert(resources.end(), std::begin(pPass->resources), std::end(pPass->resources));
+            return resources;
+        };
+
+        pGraph->execute(pRenderContext);
+        auto serialResources = getResources();
+
+        pGraph->setParallelRecordingEnabled(true);
+        pGraph->setInstrumentationEnabled(true);
+        pGraph->execute(pRenderContext);
+        pGraph->setInstrumentationEnabled(false);
+        EXPECT(getResources() == serialResources);
+
+        // Every pass is recorded once, after the pass it depends on. Passes that don't support it are recorded on the graph's context.
+        for (uint32_t i = 0; i < chainLength; i++)
+        {
+            EXPECT_EQ(passes[i]->executeCount, 2) << "pass " << i;
+            if (i > 0) EXPECT_GT(passes[i]->executeOrder, passes[i - 1]->executeOrder) << "pass " << i;
+        }
+        for (const auto& [i, pPass] : branches)
+        {
+            EXPECT_EQ(pPass->executeCount, 2);
+            EXPECT_GT(pPass->executeOrder, passes[i]->executeOrder);
+            EXPECT_EQ(pPass->executeContext == pRenderContext, !pPass->parallelRecording);
+
+            // The outputs were transitioned to the state resolved at compile time before the pass was recorded.
+            if (pPass->parallelRecording) EXPECT(pPass->output0State == Resource::State::RenderTarget);
+        }
+
+        const auto& frames = pGraph->getFrameRecords();
+        EXPECT_EQ(frames.size(), 1);
+        if (!frames.empty()) EXPECT_EQ(frames[0].passCpuTimes.size(), chainLength * (branchCount + 1));
+    }
+
+    GPU_TEST(RenderGraph_Instrumentation)
+    {
+        RenderContext* pRenderContext = ctx.getRenderContext();
+        std::vector<NoOpPass::SharedPtr> passes;
+        RenderGraph::SharedPtr pGraph = createChain(3, passes);
+        pGraph->setInput("pass0." + kInput, Texture::create2D(1, 1, ResourceFormat::R32Float));
+
+        pGraph->setInstrumentationEnabled(true);
+        for (uint32_t i = 0; i < 3; i++) pGraph->execute(pRenderContext);
+        pGraph->setInstrumentationEnabled(false);
+        pGraph->execute(pRenderContext);
+
+        auto pReport = pGraph->getCompilationReport();
+        EXPECT(pReport != nullptr);
+        if (!pReport) return;
+
+        // Resource reads/writes. Inputs are reported by the name of the output they alias.
+        EXPECT_EQ(pReport->passes.size(), 3);
+        EXPECT(pReport->passes[0].reads == std::vector<std::string>({ "pass0." + kInput }));
+        EXPECT(pReport->passes[1].reads == std::vector<std::string>({ "pass0." + kOutputs[0] }));
+        EXPECT_EQ(pReport->passes[1].writes.size(), std::size(kOutputs));
+
+        // All resources have the same size. Each pass' outputs are alive during the pass, output0 is also alive during the next pass.
+        const auto& memory = pReport->memory;
+        EXPECT_EQ(memory.resources.size(), 3 * std::size(kOutputs));
+        uint64_t size = memory.resources[0].size;
+        EXPECT_GT(size, 0);
+        EXPECT_EQ(memory.totalSize, 12 * size);
+        EXPECT_EQ(memory.peakLiveSize, 5 * size);
+        EXPECT_EQ(memory.peakTimePoint, 1);
+        EXPECT_EQ(pReport->passes[0].transientSize, 4 * size);
+        EXPECT_EQ(pReport->passes[2].transientSize, 3 * size); // The graph output isn't transient
+
+        const auto& frames = pGraph->getFrameRecords();
+        EXPECT_EQ(frames.size(), 3);
+        for (const auto& frame : frames)
+        {
+            EXPECT(frame.pCompilation == pReport);
+            EXPECT_EQ(frame.passCpuTimes.size(), 3);
+            EXPECT_GE(frame.cpuTime, 0.0);
+        }
+
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "RenderGraph_Instrumentation.json";
+        EXPECT(pGraph->exportInstrumentation(path.string()));
+        EXPECT_GT(std::filesystem::file_size(path), 0);
+        std::filesystem::remove(path);
+
+        pGraph->clearFrameRecords();
+        EXPECT(pGraph->getFrameRecords().empty());
+    }
+
+#ifdef RUN_BENCHMARK_TESTS
+    GPU_TEST(RenderGraphExeBenchmark)
+#else
+    GPU_TEST(RenderGraphExeBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        RenderContext* pRenderContext = ctx.getRenderContext();
+        const uint32_t passCount = 40;
+        const uint32_t frameCount = 1000;
+
+        std::vector<NoOpPass::SharedPtr> passes;
+        RenderGraph::SharedPtr pGraph = createChain(passCount, passes);
+        pGraph->setInput("pass0." + kInput, Texture::create2D(1, 1, ResourceFormat::R32Float));
+        pGraph->execute(pRenderContext);
+
+        // The baseline concatenates the full resource name and hashes it on every lookup. The resources are registered
+        // as external resources, which ResourceCache::getResource() searches first.
+        auto pLegacyResources = ResourceCache::create();
+        for (const auto& pPass : passes)
+        {
+            pLegacyResources->registerExternalResource(pPass->getName() + '.' + kInput, pPass->resources[0]->shared_from_this());
+            for (size_t i = 0; i < std::size(kOutputs); i++) pLegacyResources->registerExternalResource(pPass->getName() + '.' + kOutputs[i], pPass->resources[i + 1]->shared_from_this());
+        }
+
+        auto measure = [&](bool useHandles, const ResourceCache::SharedPtr& pLegacy)
+        {
+            for (const auto& pPass : passes)
+            {
+                pPass->useHandles = useHandles;
+                pPass->pLegacyResources = pLegacy;
+            }
+            pGraph->execute(pRenderContext);
+
+            auto startTime = CpuTimer::getCurrentTimePoint();
+            for (uint32_t i = 0; i < frameCount; i++) pGraph->execute(pRenderContext);
+            return CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()) * 1e3 / frameCount;
+        };
+
+        double byFullName = measure(false, pLegacyResources);
+        double byName = measure(false, nullptr);
+        double byHandle = measure(true, nullptr);
+        logInfo("RenderGraphExeBenchmark: " + std::to_string(passCount) + " no-op passes with " + std::to_string(std::size(passes[0]->resources)) + " lookups each, "
+            + std::to_string(byFullName) + " us/frame by full name (legacy), " + std::to_string(byName) + " us/frame by name, " + std::to_string(byHandle) + " us/frame by handle");
+
+        EXPECT(passes.back()->resources[1] != nullptr);
+    }
+
+#ifdef RUN_BENCHMARK_TESTS
+    GPU_TEST(RenderGraphParallelRecordingBenchmark)
+#else
+    GPU_TEST(RenderGraphParallelRecordingBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        RenderContext* pRenderContext = ctx.getRenderContext();
+        const uint32_t passCount = 16;
+        const uint32_t frameCount = 20;
+
+        // Independent passes reading the output of a common source pass. The passes only do CPU work, so the timing is not affected by the GPU.
+        std::vector<NoOpPass::SharedPtr> passes;
+        RenderGraph::SharedPtr pGraph = createChain(1, passes);
+        for (uint32_t i = 0; i < passCount; i++)
+        {
+            std::string name = "branch" + std::to_string(i);
+            passes.push_back(NoOpPass::create());
+            pGraph->addPass(passes.back(), name);
+            pGraph->addEdge("pass0." + kOutputs[0], name + "." + kInput);
+            pGraph->markOutput(name + "." + kOutputs[0]);
+        }
+        pGraph->setInput("pass0." + kInput, Texture::create2D(1, 1, ResourceFormat::R32Float));
+        for (auto& pPass : passes)
+        {
+            pPass->parallelRecording = true;
+            pPass->cpuWork = 1 << 20;
+        }
+
+        auto measure = [&](bool parallel)
+        {
+            pGraph->setParallelRecordingEnabled(parallel);
+            pGraph->execute(pRenderContext);
+
+            auto startTime = CpuTimer::getCurrentTimePoint();
+            for (uint32_t i = 0; i < frameCount; i++) pGraph->execute(pRenderContext);
+            return CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()) / frameCount;
+        };
+
+        double serial = measure(false);
+        double parallel = measure(true);
+        logInfo("RenderGraphParallelRecordingBenchmark: " + std::to_string(passCount) + " independent passes on " + std::to_string(std::thread::hardware_concurrency()) + " threads, "
+            + std::to_string(serial) + " ms/frame serial, " + std::to_string(parallel) + " ms/frame parallel");
+
+        for (size_t i = 1; i < passes.size(); i++) EXPECT_EQ(passes[i]->workResult, passes[0]->workResult);
+    }
+}
@@ -0,0 +1,237 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/SampleGenerators/SobolSequence.h"
+#include "Utils/SampleGenerators/PMJ02Sequence.h"
+#include <random>
+
+/** CPU tests and benchmarks for the low-discrepancy sequence generators.
+*/
+
+// The sequence benchmark is disabled by default as it generates and integrates large point sets of every sequence.
+//#define RUN_BENCHMARK_TESTS
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Check if 2^m points in 0.32 fixed point form a (0,m,2)-net,
+            i.e. if every elementary interval of area 2^-m contains exactly one point.
+        */
+        bool isNet(const uint2* points, uint32_t m)
+        {
+            const uint32_t n = 1u << m;
+            std::vector<uint32_t> counts(n);
+            for (uint32_t k = 0; k <= m; k++)
+            {
+                std::fill(counts.begin(), counts.end(), 0);
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    uint32_t x = k > 0 ? points[i].x >> (32 - k) : 0;
+                    uint32_t y = k < m ? points[i].y >> (32 - (m - k)) : 0;
+                    if (++counts[(y << k) | x] > 1) return false;
+                }
+            }
+            return true;
+        }
+
+        /** Compute the L2 star discrepancy of a 2D point set using Warnock's formula.
+        */
+        double l2StarDiscrepancy(const std::vector<float2>& points)
+        {
+            const double n = (double)points.size();
+            double sum1 = 0.0, sum2 = 0.0;
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                const double xi = points[i].x, yi = points[i].y;
+                sum1 += (1.0 - xi * xi) * (1.0 - yi * yi);
+                for (size_t j = 0; j < points.size(); j++)
+                {
+                    sum2 += (1.0 - std::max(xi, (double)points[j].x)) * (1.0 - std::max(yi, (double)points[j].y));
+                }
+            }
+            return std::sqrt(1.0 / 9.0 - sum1 / (2.0 * n) + sum2 / (n * n));
+        }
+
+        /** Estimate the area of the quarter disk (pi/4) and return the absolute error.
+        */
+        double quarterDiskError(const std::vector<float2>& points)
+        {
+            size_t inside = 0;
+            for (const auto& p : points) inside += (p.x * p.x + p.y * p.y < 1.f) ? 1 : 0;
+            return std::abs((double)inside / points.size() - (double)M_PI / 4.0);
+        }
+
+        using PointSetFunc = std::function<std::vector<float2>(uint32_t count, uint32_t seed)>;
+
+        std::vector<float2> randomPoints(uint32_t count, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> u;
+            std::vector<float2> points(count);
+            for (auto& p : points) p = float2(u(rng), u(rng));
+            return points;
+        }
+
+        std::vector<float2> sobolPoints(uint32_t count, uint32_t seed)
+        {
+            auto values = SobolSequence::generate(count, 2, seed);
+            std::vector<float2> points(count);
+            for (uint32_t i = 0; i < count; i++) points[i] = float2(values[2 * i], values[2 * i + 1]);
+            return points;
+        }
+
+        std::vector<float2> pmj02Points(uint32_t count, uint32_t seed)
+        {
+            auto values = PMJ02Sequence::generate(count, seed);
+            std::vector<float2> points(count);
+            for (uint32_t i = 0; i < count; i++) points[i] = float2(SobolSequence::toFloat(values[i].x), SobolSequence::toFloat(values[i].y));
+            return points;
+        }
+    }
+
+    CPU_TEST(SobolSequence_GeneratorMatrices)
+    {
+        // Dimension 0 is the van der Corput sequence.
+        for (uint32_t i = 0; i < 1024; i++) EXPECT_EQ(SobolSequence::sample(i, 0), SobolSequence::reverseBits(i));
+
+        // Each dimension is a (0,1)-sequence: the first 2^m samples fall in distinct intervals of size 2^-m.
+        for (uint32_t d = 0; d < SobolSequence::kMaxDimensions; d++)
+        {
+            std::vector<bool> occupied(1024);
+            for (uint32_t i = 0; i < 1024; i++)
+            {
+                uint32_t j = SobolSequence::sample(i, d) >> 22;
+                EXPECT(!occupied[j]) << "d = " << d << " i = " << i;
+                occupied[j] = true;
+            }
+        }
+
+        // The first two dimensions form a (0,2)-sequence.
+        std::vector<uint2> points(1024);
+        for (uint32_t i = 0; i < 1024; i++) points[i] = uint2(SobolSequence::sample(i, 0), SobolSequence::sample(i, 1));
+        for (uint32_t m = 0; m <= 10; m++)
+        {
+            for (uint32_t offset = 0; offset < 1024; offset += 1u << m) EXPECT(isNet(points.data() + offset, m)) << "m = " << m << " offset = " << offset;
+        }
+    }
+
+    CPU_TEST(SobolSequence_OwenScrambled)
+    {
+        for (uint32_t seed = 0; seed < 4; seed++)
+        {
+            // The first two dimensions of each padded block form (0,m,2)-nets for all prefixes.
+            for (uint32_t d = 0; d < 3 * SobolSequence::kBlockDimensions; d += SobolSequence::kBlockDimensions)
+            {
+                std::vector<uint2> points(1024);
+                for (uint32_t i = 0; i < 1024; i++) points[i] = uint2(SobolSequence::sampleOwen(i, d, seed), SobolSequence::sampleOwen(i, d + 1, seed));
+                for (uint32_t m = 0; m <= 10; m++) EXPECT(isNet(points.data(), m)) << "seed = " << seed << " d = " << d << " m = " << m;
+            }
+
+            // Bulk generation matches the per-sample evaluation.
+            const uint32_t kDimensions = 7;
+            auto values = SobolSequence::generate(2000, kDimensions, seed, 100);
+            for (uint32_t i = 0; i < 2000; i++)
+            {
+                for (uint32_t d = 0; d < kDimensions; d++)
+                {
+                    EXPECT_EQ(values[i * kDimensions + d], SobolSequence::toFloat(SobolSequence::sampleOwen(100 + i, d, seed))) << "i = " << i << " d = " << d;
+                }
+            }
+        }
+    }
+
+    CPU_TEST(PMJ02Sequence_Stratification)
+    {
+        for (uint32_t seed = 0; seed < 2; seed++)
+        {
+            auto points = PMJ02Sequence::generate(1024, seed);
+            for (uint32_t m = 0; m <= 10; m++) EXPECT(isNet(points.data(), m)) << "seed = " << seed << " m = " << m;
+        }
+
+        auto tables = PMJ02Sequence::generateTables(4, 256, 1);
+        for (uint32_t t = 0; t < 4; t++)
+        {
+            EXPECT(isNet(tables.data() + t * 256, 8)) << "t = " << t;
+        }
+    }
+
+#ifdef RUN_BENCHMARK_TESTS
+    CPU_TEST(LowDiscrepancySequenceBenchmark)
+#else
+    CPU_TEST(LowDiscrepancySequenceBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        const std::vector<std::pair<std::string, PointSetFunc>> kPointSets =
+        {
+            { "Random", randomPoints },
+            { "Sobol", sobolPoints },
+            { "PMJ02", pmj02Points },
+        };
+        const uint32_t kTrials = 16;
+
+        // Measure discrepancy and convergence of the quarter disk integral.
+        std::map<std::string, double> discrepancy, error;
+        for (const auto& [name, func] : kPointSets)
+        {
+            for (uint32_t count = 64; count <= 1024; count *= 4)
+            {
+                double d = 0.0, e = 0.0;
+                for (uint32_t trial = 0; trial < kTrials; trial++)
+                {
+                    auto points = func(count, trial);
+                    d += l2StarDiscrepancy(points);
+                    e += quarterDiskError(points);
+                }
+                d /= kTrials;
+                e /= kTrials;
+                logInfo("LowDiscrepancySequenceBenchmark: " + name + ": " + std::to_string(count) + " samples, L2 star discrepancy " + std::to_string(d) + ", quarter disk error " + std::to_string(e));
+                discrepancy[name] = d;
+                error[name] = e;
+            }
+        }
+
+        // Both sequences should be significantly better than random points at 1024 samples.
+        EXPECT_LT(discrepancy["Sobol"], 0.25 * discrepancy["Random"]);
+        EXPECT_LT(discrepancy["PMJ02"], 0.25 * discrepancy["Random"]);
+        EXPECT_LT(error["Sobol"], 0.5 * error["Random"]);
+        EXPECT_LT(error["PMJ02"], 0.5 * error["Random"]);
+
+        // Measure table generation throughput.
+        auto measure = [](const std::string& name, std::function<size_t()> func)
+        {
+            auto start = CpuTimer::getCurrentTimePoint();
+            size_t count = func();
+            double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            logInfo("LowDiscrepancySequenceBenchmark: " + name + ": " + std::to_string(ms) + " ms, " + std::to_string(count) + " values");
+        };
+
+        measure("Sobol 1M x 8D", []() { return SobolSequence::generate(1 << 20, 8, 0).size(); });
+        measure("PMJ02 16 x 4096", []() { return 2 * PMJ02Sequence::generateTables(PMJ02_TABLE_COUNT, PMJ02_TABLE_SIZE, 0).size(); });
+    }
+}
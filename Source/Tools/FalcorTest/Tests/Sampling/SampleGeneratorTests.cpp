@@ -27,6 +27,7 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Sampling/SampleGenerator.h"
+#include "Utils/SampleGenerators/SobolSequence.h"
 
 /** GPU tests for the SampleGenerator utility class.
 */
@@ -144,6 +145,22 @@ namespace Falcor
 
             ctx.unmapBuffer("result");
         }
+
+        /** 32-bit bit interleave (Morton code), same as interleave_32bit() in BitTricks.slang.
+        */
+        uint32_t interleave_32bit(uint2 v)
+        {
+            auto spread = [](uint32_t x)
+            {
+                x &= 0x0000ffff;
+                x = (x | (x << 8)) & 0x00FF00FF;
+                x = (x | (x << 4)) & 0x0F0F0F0F;
+                x = (x | (x << 2)) & 0x33333333;
+                x = (x | (x << 1)) & 0x55555555;
+                return x;
+            };
+            return spread(v.x) | (spread(v.y) << 1);
+        }
     }
 
     /** Tests for the different types of sample generators.
@@ -161,4 +178,49 @@ namespace Falcor
     {
         testSampleGenerator(ctx, SAMPLE_GENERATOR_UNIFORM, 0.002, true);
     }
+
+    GPU_TEST(SampleGenerator_Sobol)
+    {
+        // Consecutive sample numbers are stratified, so instances are not expected to be uncorrelated.
+        testSampleGenerator(ctx, SAMPLE_GENERATOR_SOBOL, 0.003, false);
+    }
+
+    GPU_TEST(SampleGenerator_PMJ02)
+    {
+        testSampleGenerator(ctx, SAMPLE_GENERATOR_PMJ02, 0.005, false);
+    }
+
+    GPU_TEST(SampleGenerator_SobolMatchesCPU)
+    {
+        SampleGenerator::SharedPtr pSampleGenerator = SampleGenerator::create(SAMPLE_GENERATOR_SOBOL);
+        ctx.createProgram(kShaderFile, "test", pSampleGenerator->getDefines(), Shader::CompilerFlags::None, "6_2");
+        pSampleGenerator->setShaderData(ctx.vars().getRootVar());
+
+        const uint3 dispatchDim = { 16, 16, 8 };
+        const size_t numSamples = dispatchDim.x * dispatchDim.y * dispatchDim.z * kDimensions;
+        ctx.allocateStructuredBuffer("result", uint32_t(numSamples));
+        ctx["CB"]["gDispatchDim"] = dispatchDim;
+        ctx["CB"]["gDimensions"] = kDimensions;
+        ctx.runProgram(dispatchDim);
+
+        // The GPU generator seeds the sequence with a hash of the pixel and uses the sample number as index.
+        const float* result = ctx.mapBuffer<const float>("result");
+        size_t i = 0;
+        for (uint32_t z = 0; z < dispatchDim.z; z++)
+        {
+            for (uint32_t y = 0; y < dispatchDim.y; y++)
+            {
+                for (uint32_t x = 0; x < dispatchDim.x; x++)
+                {
+                    const uint32_t seed = SobolSequence::jenkinsHash(interleave_32bit(uint2(x, y)));
+                    for (uint32_t d = 0; d < kDimensions; d++, i++)
+                    {
+                        float ref = SobolSequence::toFloat(SobolSequence::sampleOwen(z, d, seed));
+                        EXPECT_EQ(result[i], ref) << "x = " << x << " y = " << y << " z = " << z << " d = " << d;
+                    }
+                }
+            }
+        }
+        ctx.unmapBuffer("result");
+    }
 }
@@ -0,0 +1,125 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Create a scene with a single skinned mesh of four triangles, each bound to its own bone.
+            Bones A and B start next to each other at the origin, C and D at x = 10, so that the tracked
+            hierarchy groups {A, B} and {C, D}. The animation swaps B and C, which makes both groups
+            span the whole mesh.
+        */
+        Scene::SharedPtr createSkinnedScene()
+        {
+            auto pBuilder = SceneBuilder::create();
+
+            uint32_t meshNodeID = pBuilder->addNode({ "Mesh", glm::identity<glm::mat4>(), glm::identity<glm::mat4>() });
+
+            const float kBoneX[] = { 0.f, 1.f, 10.f, 11.f };
+            std::vector<uint32_t> indices;
+            std::vector<float3> positions;
+            std::vector<uint4> boneIDs;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                uint32_t boneID = pBuilder->addNode({ "Bone" + std::to_string(i), glm::identity<glm::mat4>(), glm::identity<glm::mat4>() });
+                for (const float3& p : { float3(0.f, 0.f, 0.f), float3(0.5f, 0.f, 0.f), float3(0.f, 0.5f, 0.5f) })
+                {
+                    indices.push_back((uint32_t)positions.size());
+                    positions.push_back(p + float3(kBoneX[i], 0.f, 0.f));
+                    boneIDs.push_back(uint4(boneID, 0, 0, 0));
+                }
+            }
+            const std::vector<float3> normals(positions.size(), float3(0.f, 0.f, 1.f));
+            const std::vector<float4> boneWeights(positions.size(), float4(1.f, 0.f, 0.f, 0.f));
+
+            SceneBuilder::Mesh mesh;
+            mesh.name = "Skinned";
+            mesh.faceCount = 4;
+            mesh.vertexCount = (uint32_t)positions.size();
+            mesh.indexCount = (uint32_t)indices.size();
+            mesh.pIndices = indices.data();
+            mesh.topology = Vao::Topology::TriangleList;
+            mesh.pMaterial = Material::create("Skinned");
+            mesh.positions = { positions.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            mesh.normals = { normals.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            mesh.boneIDs = { boneIDs.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            mesh.boneWeights = { boneWeights.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            pBuilder->addMeshInstance(meshNodeID, pBuilder->addMesh(mesh));
+
+            // Move bone B (node 2) next to D and bone C (node 3) next to A over one second.
+            for (auto [nodeID, offset] : { std::make_pair(2u, 10.f), std::make_pair(3u, -10.f) })
+            {
+                auto pAnimation = Animation::create("Bone" + std::to_string(nodeID - 1), nodeID, 1.0);
+                pAnimation->addKeyframe({ 0.0 });
+                pAnimation->addKeyframe({ 1.0, float3(offset, 0.f, 0.f) });
+                pBuilder->addAnimation(pAnimation);
+            }
+
+            return pBuilder->getScene();
+        }
+    }
+
+    GPU_TEST(BVHQualityTracker)
+    {
+        Scene::SharedPtr pScene = createSkinnedScene();
+        EXPECT(pScene != nullptr);
+        if (!pScene) return;
+
+        // The scene only updates the tracker when it has BLASes, so drive it directly.
+        pScene->setBVHQualityTrackingEnabled(true);
+        const auto& pTracker = pScene->getBVHQualityTracker();
+        EXPECT(pTracker->isTracked(0));
+        EXPECT_EQ(pTracker->getStats().trackedGroupCount, 1u);
+        EXPECT_EQ(pTracker->getSAHRatio(0), 1.f);
+        EXPECT(!pTracker->isRebuildRecommended(0));
+
+        // Below the threshold the BLAS is only refitted.
+        pTracker->setOptions({ 1000.f });
+        pScene->update(ctx.getRenderContext(), 0.5);
+        pTracker->update();
+        EXPECT_GT(pTracker->getSAHRatio(0), 1.f);
+        EXPECT(!pTracker->isRebuildRecommended(0));
+        EXPECT_EQ(pTracker->getStats().refitCount, 1u);
+        EXPECT_EQ(pTracker->getStats().rebuildCount, 0u);
+
+        // Exceeding the threshold recommends a rebuild.
+        pTracker->setOptions({ 1.5f });
+        pScene->update(ctx.getRenderContext(), 1.0);
+        pTracker->update();
+        EXPECT_GT(pTracker->getSAHRatio(0), 1.5f);
+        EXPECT(pTracker->isRebuildRecommended(0));
+        EXPECT_EQ(pTracker->getStats().rebuildCount, 1u);
+
+        // Rebuilding resets the recommendation and the SAH ratio.
+        pTracker->notifyRebuilt(0);
+        EXPECT(!pTracker->isRebuildRecommended(0));
+        EXPECT_EQ(pTracker->getSAHRatio(0), 1.f);
+    }
+}
@@ -0,0 +1,340 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/CPU/CPUBVH.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <bitset>
+#include <execution>
+#include <random>
+
+// The BVH benchmark is disabled by default as it builds and traverses a scene of about 575k triangles with every builder.
+//#define RUN_BENCHMARK_TESTS
+
+namespace Falcor
+{
+    namespace
+    {
+        bool intersectTriangle(const CPUBVH::Ray& ray, const float3* v, float& t)
+        {
+            const float3 e1 = v[1] - v[0];
+            const float3 e2 = v[2] - v[0];
+            const float3 p = glm::cross(ray.dir, e2);
+            const float det = glm::dot(e1, p);
+            if (det == 0.f) return false;
+            const float invDet = 1.f / det;
+            const float3 s = ray.origin - v[0];
+            const float u = glm::dot(s, p) * invDet;
+            const float3 q = glm::cross(s, e1);
+            const float w = glm::dot(ray.dir, q) * invDet;
+            t = glm::dot(e2, q) * invDet;
+            return u >= 0.f && w >= 0.f && u + w <= 1.f && t >= ray.tMin && t <= ray.tMax;
+        }
+
+        /** Find the closest hit by testing all triangles.
+        */
+        CPUBVH::Hit intersectBruteForce(const std::vector<float3>& vertices, const CPUBVH::Ray& ray)
+        {
+            CPUBVH::Hit hit;
+            hit.t = ray.tMax;
+            for (uint32_t i = 0; i < vertices.size() / 3; i++)
+            {
+                float t;
+                if (intersectTriangle(ray, &vertices[i * 3], t) && t < hit.t)
+                {
+                    hit.triangleIndex = i;
+                    hit.t = t;
+                }
+            }
+            return hit;
+        }
+
+        /** Create random triangles in a box of size 10, with vertices up to 'size' apart.
+        */
+        std::vector<float3> createRandomTriangles(std::mt19937& rng, uint32_t triangleCount, float size)
+        {
+            std::uniform_real_distribution<float> u(0.f, 1.f);
+            std::vector<float3> vertices;
+            for (uint32_t i = 0; i < triangleCount; i++)
+            {
+                const float3 center = float3(u(rng), u(rng), u(rng)) * 10.f;
+                for (uint32_t j = 0; j < 3; j++) vertices.push_back(glm::clamp(center + (float3(u(rng), u(rng), u(rng)) - 0.5f) * size, float3(0.f), float3(10.f)));
+            }
+            return vertices;
+        }
+
+        /** Create thin triangles in random directions, which have large overlapping bounds.
+            \param[in] length Maximum extent of a triangle along each axis.
+        */
+        std::vector<float3> createSlivers(std::mt19937& rng, uint32_t triangleCount, float length)
+        {
+            std::uniform_real_distribution<float> u(0.f, 1.f);
+            std::vector<float3> vertices;
+            for (uint32_t i = 0; i < triangleCount; i++)
+            {
+                const float3 p0 = float3(u(rng), u(rng), u(rng)) * 10.f;
+                const float3 p1 = glm::clamp(p0 + (float3(u(rng), u(rng), u(rng)) * 2.f - 1.f) * length, float3(0.f), float3(10.f));
+                const float3 offset = float3(u(rng), u(rng), u(rng)) * 0.05f;
+                vertices.push_back(p0);
+                vertices.push_back(p1);
+                vertices.push_back(p1 + offset);
+            }
+            return vertices;
+        }
+
+        std::vector<CPUBVH::BuildOptions> getBuildConfigs()
+        {
+            std::vector<CPUBVH::BuildOptions> configs;
+            for (auto builder : { CPUBVH::Builder::BinnedSAH, CPUBVH::Builder::SBVH })
+            {
+                for (uint32_t width : { 4u, 8u })
+                {
+                    CPUBVH::BuildOptions options;
+                    options.builder = builder;
+                    options.width = width;
+                    configs.push_back(options);
+                }
+            }
+            return configs;
+        }
+
+        std::string getConfigName(const CPUBVH::BuildOptions& options)
+        {
+            return std::string(options.builder == CPUBVH::Builder::SBVH ? "SBVH" : "BinnedSAH") + "/" + std::to_string(options.width) + "-wide";
+        }
+    }
+
+    CPU_TEST(CPUBVH_BruteForce)
+    {
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+        auto randomPoint = [&] () { return float3(u(rng), u(rng), u(rng)) * 10.f; };
+
+        std::vector<float3> vertices = createRandomTriangles(rng, 1000, 1.f);
+        std::vector<float3> slivers = createSlivers(rng, 1000, 10.f);
+        vertices.insert(vertices.end(), slivers.begin(), slivers.end());
+        const uint32_t triangleCount = (uint32_t)vertices.size() / 3;
+
+        // Packets of rays from a common origin towards nearby targets, and with random tMax.
+        const uint32_t packetCount = 500;
+        std::vector<CPUBVH::Ray> rays;
+        for (uint32_t i = 0; i < packetCount; i++)
+        {
+            const float3 origin = randomPoint();
+            const float3 target = randomPoint();
+            for (uint32_t j = 0; j < CPUBVH::kPacketSize; j++)
+            {
+                CPUBVH::Ray ray;
+                ray.origin = origin;
+                ray.dir = glm::normalize(target + (float3(u(rng), u(rng), u(rng)) - 0.5f) - origin);
+                ray.tMax = i % 2 ? std::numeric_limits<float>::max() : 5.f * u(rng);
+                rays.push_back(ray);
+            }
+        }
+
+        std::vector<CPUBVH::Hit> expected(rays.size());
+        for (size_t i = 0; i < rays.size(); i++) expected[i] = intersectBruteForce(vertices, rays[i]);
+
+        for (const auto& options : getBuildConfigs())
+        {
+            auto pBVH = CPUBVH::create(vertices, options);
+            const std::string name = getConfigName(options);
+            EXPECT_EQ(pBVH->getTriangleCount(), triangleCount) << name;
+            EXPECT_EQ(pBVH->getWidth(), options.width) << name;
+            EXPECT_GE(pBVH->getReferenceCount(), triangleCount) << name;
+
+            for (uint32_t i = 0; i < rays.size(); i++)
+            {
+                const CPUBVH::Ray& ray = rays[i];
+                const bool isExpectedHit = expected[i].isValid();
+
+                CPUBVH::Hit hit;
+                bool isHit = pBVH->intersect(ray, hit);
+                EXPECT_EQ(isHit, isExpectedHit) << name << " ray " << i;
+                EXPECT_EQ(hit.triangleIndex, expected[i].triangleIndex) << name << " ray " << i;
+                if (isHit) EXPECT_LE(std::abs(hit.t - expected[i].t), 1e-4f * expected[i].t) << name << " ray " << i;
+                EXPECT_EQ(pBVH->isOccluded(ray), isExpectedHit) << name << " ray " << i;
+            }
+
+            for (uint32_t i = 0; i < packetCount; i++)
+            {
+                // Test full packets and packets with a single ray.
+                const uint32_t rayCount = i % 4 == 3 ? 1 : CPUBVH::kPacketSize;
+                const uint32_t first = i * CPUBVH::kPacketSize;
+
+                CPUBVH::Hit hits[CPUBVH::kPacketSize];
+                uint32_t hitMask = pBVH->intersectPacket(&rays[first], hits, rayCount);
+                uint32_t occludedMask = pBVH->isOccludedPacket(&rays[first], rayCount);
+                for (uint32_t j = 0; j < rayCount; j++)
+                {
+                    const CPUBVH::Hit& hit = expected[first + j];
+                    EXPECT_EQ((hitMask >> j) & 1, hit.isValid() ? 1u : 0u) << name << " packet " << i << " ray " << j;
+                    EXPECT_EQ((occludedMask >> j) & 1, hit.isValid() ? 1u : 0u) << name << " packet " << i << " ray " << j;
+                    EXPECT_EQ(hits[j].triangleIndex, hit.triangleIndex) << name << " packet " << i << " ray " << j;
+                    if (hit.isValid()) EXPECT_LE(std::abs(hits[j].t - hit.t), 1e-4f * hit.t) << name << " packet " << i << " ray " << j;
+                }
+                EXPECT_EQ(hitMask >> rayCount, 0u) << name << " packet " << i;
+            }
+        }
+    }
+
+    CPU_TEST(CPUBVH_Build)
+    {
+        std::mt19937 rng(1);
+        const std::vector<float3> vertices = createSlivers(rng, 20000, 10.f);
+        const uint32_t triangleCount = (uint32_t)vertices.size() / 3;
+
+        // The parallel binned SAH build produces the same hierarchy as the serial build.
+        CPUBVH::BuildOptions options;
+        options.parallel = false;
+        auto pSerial = CPUBVH::create(vertices, options);
+        options.parallel = true;
+        auto pParallel = CPUBVH::create(vertices, options);
+        EXPECT_EQ(pSerial->getNodeCount(), pParallel->getNodeCount());
+        EXPECT_EQ(pSerial->getSAHCost(), pParallel->getSAHCost());
+        EXPECT_EQ(pParallel->getReferenceCount(), triangleCount);
+
+        // Spatial splits reduce the SAH cost for overlapping triangles, within the duplication budget.
+        options.builder = CPUBVH::Builder::SBVH;
+        options.maxDuplication = 0.5f;
+        auto pSBVH = CPUBVH::create(vertices, options);
+        EXPECT_LT(pSBVH->getSAHCost(), pParallel->getSAHCost());
+        EXPECT_GT(pSBVH->getReferenceCount(), triangleCount);
+        EXPECT_LE(pSBVH->getReferenceCount(), (uint32_t)(triangleCount * 1.5f));
+
+        // Without a duplication budget the SBVH only uses object splits.
+        options.maxDuplication = 0.f;
+        EXPECT_EQ(CPUBVH::create(vertices, options)->getReferenceCount(), triangleCount);
+
+        // Empty and single triangle hierarchies.
+        auto pEmpty = CPUBVH::create({});
+        CPUBVH::Ray ray;
+        ray.origin = float3(0.f, 0.f, -1.f);
+        ray.dir = float3(0.f, 0.f, 1.f);
+        CPUBVH::Hit hit;
+        EXPECT(!pEmpty->intersect(ray, hit));
+        EXPECT_EQ(pEmpty->isOccludedPacket(&ray, 1), 0u);
+
+        options.width = 8;
+        auto pSingle = CPUBVH::create({ float3(-1.f, -1.f, 0.f), float3(1.f, -1.f, 0.f), float3(0.f, 1.f, 0.f) }, options);
+        EXPECT(pSingle->intersect(ray, hit));
+        EXPECT_EQ(hit.triangleIndex, 0u);
+        EXPECT_EQ(hit.t, 1.f);
+        EXPECT_EQ(pSingle->intersectPacket(&ray, &hit, 1), 1u);
+    }
+
+#ifdef RUN_BENCHMARK_TESTS
+    CPU_TEST(CPUBVHBenchmark)
+#else
+    CPU_TEST(CPUBVHBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        // Dense height field with random slivers above it, viewed from above.
+        const uint32_t gridSize = 512;
+        auto gridPoint = [&] (uint32_t x, uint32_t z) { return float3(x * 10.f / gridSize, 0.5f * std::sin(x * 0.11f) * std::cos(z * 0.07f), z * 10.f / gridSize); };
+        std::vector<float3> vertices;
+        for (uint32_t z = 0; z < gridSize; z++)
+        {
+            for (uint32_t x = 0; x < gridSize; x++)
+            {
+                const float3 p[4] = { gridPoint(x, z), gridPoint(x, z + 1), gridPoint(x + 1, z + 1), gridPoint(x + 1, z) };
+                for (uint32_t i : { 0, 1, 2, 0, 2, 3 }) vertices.push_back(p[i]);
+            }
+        }
+        std::mt19937 rng(2);
+        for (const float3& v : createSlivers(rng, 50000, 1.f)) vertices.push_back(float3(v.x, 1.f + 0.2f * v.y, v.z));
+        const uint32_t triangleCount = (uint32_t)vertices.size() / 3;
+
+        // Primary rays in scanline order with 2x2 pixel packets.
+        const uint2 frameDim(512, 512);
+        const float3 eye(5.f, 8.f, -2.f);
+        const float3 target(5.f, 0.f, 5.f);
+        const float3 W = glm::normalize(target - eye);
+        const float3 U = glm::normalize(glm::cross(W, float3(0.f, 1.f, 0.f)));
+        const float3 V = glm::cross(U, W);
+        std::vector<CPUBVH::Ray> rays;
+        for (uint32_t y = 0; y < frameDim.y; y += 2)
+        {
+            for (uint32_t x = 0; x < frameDim.x; x += 2)
+            {
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    const float2 ndc = (float2(x + (i & 1), y + (i >> 1)) + 0.5f) / float2(frameDim) * 2.f - 1.f;
+                    CPUBVH::Ray ray;
+                    ray.origin = eye;
+                    ray.dir = glm::normalize(W + ndc.x * U + ndc.y * V);
+                    rays.push_back(ray);
+                }
+            }
+        }
+        const uint32_t packetCount = (uint32_t)rays.size() / CPUBVH::kPacketSize;
+        NumericRange<uint32_t> packetRange(0, packetCount);
+
+        auto measure = [&] (const std::function<uint32_t(uint32_t)>& tracePacket)
+        {
+            std::atomic<uint32_t> hitCount = 0;
+            auto startTime = CpuTimer::getCurrentTimePoint();
+            std::for_each(std::execution::par, packetRange.begin(), packetRange.end(), [&] (uint32_t i) { hitCount += tracePacket(i); });
+            double timeMs = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+            return std::make_pair(rays.size() / (timeMs * 1e3), hitCount.load());
+        };
+
+        for (const auto& options : getBuildConfigs())
+        {
+            auto pBVH = CPUBVH::create(vertices, options);
+            const std::string name = getConfigName(options);
+            logInfo("CPUBVHBenchmark: " + name + " build " + std::to_string(pBVH->getBuildTime()) + " ms, " + std::to_string(triangleCount) + " triangles, "
+                + std::to_string(pBVH->getReferenceCount()) + " references, " + std::to_string(pBVH->getNodeCount()) + " nodes, SAH cost " + std::to_string(pBVH->getSAHCost()));
+
+            auto single = measure([&] (uint32_t i)
+            {
+                uint32_t hitCount = 0;
+                CPUBVH::Hit hit;
+                for (uint32_t j = 0; j < CPUBVH::kPacketSize; j++) hitCount += pBVH->intersect(rays[i * CPUBVH::kPacketSize + j], hit) ? 1 : 0;
+                return hitCount;
+            });
+            auto packet = measure([&] (uint32_t i)
+            {
+                CPUBVH::Hit hits[CPUBVH::kPacketSize];
+                std::bitset<CPUBVH::kPacketSize> mask = pBVH->intersectPacket(&rays[i * CPUBVH::kPacketSize], hits);
+                return (uint32_t)mask.count();
+            });
+            auto occlusion = measure([&] (uint32_t i)
+            {
+                std::bitset<CPUBVH::kPacketSize> mask = pBVH->isOccludedPacket(&rays[i * CPUBVH::kPacketSize]);
+                return (uint32_t)mask.count();
+            });
+            logInfo("CPUBVHBenchmark: " + name + " single " + std::to_string(single.first) + " Mrays/s, packet " + std::to_string(packet.first)
+                + " Mrays/s, packet occlusion " + std::to_string(occlusion.first) + " Mrays/s");
+
+            EXPECT_EQ(single.second, packet.second) << name;
+            EXPECT_EQ(single.second, occlusion.second) << name;
+            EXPECT_GT(single.second, 0u) << name;
+        }
+    }
+}
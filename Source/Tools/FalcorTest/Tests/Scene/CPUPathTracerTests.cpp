@@ -0,0 +1,235 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/CPU/CPUPathTracer.h"
+#include "Utils/Timing/CpuTimer.h"
+
+// The path tracer benchmark is disabled by default as it builds a 256x256 height field and only logs build and render timings.
+//#define RUN_BENCHMARK_TESTS
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Add a quad as two triangles. The front-facing side is the side from which the vertices appear counter-clockwise.
+        */
+        void addQuad(CPUScene::Desc& desc, const float3& p0, const float3& p1, const float3& p2, const float3& p3, uint32_t materialID)
+        {
+            for (const float3& p : { p0, p1, p2, p0, p2, p3 }) desc.positions.push_back(p);
+            desc.materialIDs.push_back(materialID);
+            desc.materialIDs.push_back(materialID);
+        }
+
+        /** Create a diffuse MetalRough material with constant channels.
+        */
+        CPUScene::Material createMaterial(const float3& baseColor, const float3& emissive = float3(0.f))
+        {
+            CPUScene::Material material;
+            MaterialData& md = material.data;
+            md.baseColor = float4(baseColor, 1.f);
+            md.specular = float4(0.f);
+            md.emissive = emissive;
+            md.flags = PACK_SHADING_MODEL(md.flags, ShadingModelMetalRough);
+            md.flags = PACK_DIFFUSE_TYPE(md.flags, ChannelTypeConst);
+            md.flags = PACK_SPECULAR_TYPE(md.flags, ChannelTypeConst);
+            md.flags = PACK_EMISSIVE_TYPE(md.flags, ChannelTypeConst);
+            return material;
+        }
+
+        /** Create a pinhole camera.
+            \param[in] tanHalfFov Tangent of the half field of view.
+        */
+        CameraData createCamera(const float3& pos, const float3& dir, const float3& up, float tanHalfFov)
+        {
+            CameraData camera;
+            camera.posW = pos;
+            camera.cameraW = glm::normalize(dir);
+            camera.cameraU = glm::normalize(glm::cross(camera.cameraW, up)) * tanHalfFov;
+            camera.cameraV = glm::normalize(glm::cross(camera.cameraU, camera.cameraW)) * tanHalfFov;
+            camera.nearZ = 0.f;
+            return camera;
+        }
+
+        LightData createDirectionalLight(const float3& dir, const float3& intensity)
+        {
+            LightData light;
+            light.type = (uint32_t)LightType::Directional;
+            light.dirW = glm::normalize(dir);
+            light.intensity = intensity;
+            return light;
+        }
+
+        std::vector<float4> render(const CPUScene::SharedPtr& pScene, const CPUPathTracer::Options& options, uint32_t frameCount)
+        {
+            auto pPathTracer = CPUPathTracer::create(pScene, options);
+            for (uint32_t i = 0; i < frameCount; i++) pPathTracer->renderFrame();
+            return pPathTracer->getImage();
+        }
+    }
+
+    CPU_TEST(CPUTexture_Sample)
+    {
+        const float4 t00(1.f, 0.f, 0.f, 1.f), t10(0.f, 1.f, 0.f, 1.f), t01(0.f, 0.f, 1.f, 1.f), t11(1.f, 1.f, 1.f, 0.f);
+        auto pTexture = CPUTexture::create(2, 2, { t00, t10, t01, t11 });
+        const float4 border(0.5f);
+        const float4 average = (t00 + t10 + t01 + t11) * 0.25f;
+
+        EXPECT(pTexture->sample(float2(0.25f, 0.25f)) == t00);
+        EXPECT(pTexture->sample(float2(0.75f, 0.75f)) == t11);
+        EXPECT(pTexture->sample(float2(0.5f, 0.5f)) == average);
+        EXPECT(pTexture->sample(float2(0.f, 0.f), Sampler::AddressMode::Wrap, Sampler::AddressMode::Wrap) == average);
+        EXPECT(pTexture->sample(float2(0.f, 0.f), Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp) == t00);
+        EXPECT(pTexture->sample(float2(0.f, 0.f), Sampler::AddressMode::Border, Sampler::AddressMode::Border, border) == t00 * 0.25f + border * 0.75f);
+    }
+
+    CPU_TEST(CPUPathTracer_DirectLighting)
+    {
+        // Diffuse ground plane lit by a directional light from above, viewed from above with a narrow field of view.
+        // With zero roughness, the diffuse BRDF at normal incidence evaluates to albedo / pi.
+        const float3 albedo(0.2f, 0.5f, 0.8f);
+        const float3 intensity(2.f, 3.f, 4.f);
+
+        CPUScene::Desc desc;
+        desc.materials.push_back(createMaterial(albedo));
+        addQuad(desc, float3(-10.f, 0.f, -10.f), float3(-10.f, 0.f, 10.f), float3(10.f, 0.f, 10.f), float3(10.f, 0.f, -10.f), 0);
+        desc.lights.push_back(createDirectionalLight(float3(0.f, -1.f, 0.f), intensity));
+        desc.camera = createCamera(float3(0.f, 1.f, 0.f), float3(0.f, -1.f, 0.f), float3(0.f, 0.f, -1.f), 0.01f);
+
+        CPUPathTracer::Options options;
+        options.frameDim = uint2(8, 8);
+        options.maxBounces = 0;
+
+        const float3 expected = albedo * (float)M_1_PI * intensity;
+        for (const float4& c : render(CPUScene::create(desc), options, 4))
+        {
+            for (uint32_t i = 0; i < 3; i++) EXPECT_LE(std::abs(c[i] - expected[i]), 1e-4f * expected[i]) << "channel " << i;
+        }
+
+        // Add an occluder between the camera and the light. Its front-facing side faces the light.
+        desc.materials.push_back(createMaterial(float3(0.f)));
+        addQuad(desc, float3(-1.f, 0.5f, -1.f), float3(-1.f, 0.5f, 1.f), float3(1.f, 0.5f, 1.f), float3(1.f, 0.5f, -1.f), 1);
+        desc.camera.posW = float3(0.f, 0.25f, 0.f);
+
+        for (const float4& c : render(CPUScene::create(desc), options, 4))
+        {
+            EXPECT(float3(c) == float3(0.f));
+        }
+    }
+
+    CPU_TEST(CPUPathTracer_EmissiveEnclosure)
+    {
+        // Black cube with emissive walls facing inwards. Every path from the inside sees the emitted radiance,
+        // while the back-facing walls seen from the outside do not emit.
+        const float3 emissive(1.f, 2.f, 3.f);
+
+        CPUScene::Desc desc;
+        desc.materials.push_back(createMaterial(float3(0.f), emissive));
+        const float3 c[8] = { {-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1}, {-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1} };
+        addQuad(desc, c[0], c[1], c[2], c[3], 0);   // -z
+        addQuad(desc, c[5], c[4], c[7], c[6], 0);   // +z
+        addQuad(desc, c[4], c[0], c[3], c[7], 0);   // -x
+        addQuad(desc, c[1], c[5], c[6], c[2], 0);   // +x
+        addQuad(desc, c[4], c[5], c[1], c[0], 0);   // -y
+        addQuad(desc, c[3], c[2], c[6], c[7], 0);   // +y
+
+        CPUPathTracer::Options options;
+        options.frameDim = uint2(16, 16);
+        options.backgroundColor = float3(0.f);
+
+        desc.camera = createCamera(float3(0.f), float3(0.3f, 0.2f, -1.f), float3(0.f, 1.f, 0.f), 1.f);
+        for (const float4& c : render(CPUScene::create(desc), options, 2))
+        {
+            EXPECT(float3(c) == emissive);
+        }
+
+        desc.camera = createCamera(float3(0.f, 0.f, 5.f), float3(0.f, 0.f, -1.f), float3(0.f, 1.f, 0.f), 0.1f);
+        for (const float4& c : render(CPUScene::create(desc), options, 2))
+        {
+            EXPECT(float3(c) == float3(0.f));
+        }
+    }
+
+#ifdef RUN_BENCHMARK_TESTS
+    CPU_TEST(CPUPathTracerBenchmark)
+#else
+    CPU_TEST(CPUPathTracerBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        // Height field with sinusoidal bumps inside a diffuse box, lit by a directional and a point light.
+        const uint32_t gridSize = 256;
+        CPUScene::Desc desc;
+        desc.materials.push_back(createMaterial(float3(0.7f)));
+        desc.materials.push_back(createMaterial(float3(0.4f, 0.5f, 0.6f)));
+
+        auto height = [&] (uint32_t x, uint32_t z) { return 0.2f * std::sin(x * 0.15f) * std::cos(z * 0.1f); };
+        auto gridPoint = [&] (uint32_t x, uint32_t z) { return float3(x * 8.f / gridSize - 4.f, height(x, z), z * 8.f / gridSize - 4.f); };
+        for (uint32_t z = 0; z < gridSize; z++)
+        {
+            for (uint32_t x = 0; x < gridSize; x++)
+            {
+                addQuad(desc, gridPoint(x, z), gridPoint(x, z + 1), gridPoint(x + 1, z + 1), gridPoint(x + 1, z), 0);
+            }
+        }
+        addQuad(desc, float3(-4.f, 3.f, -4.f), float3(4.f, 3.f, -4.f), float3(4.f, 3.f, 4.f), float3(-4.f, 3.f, 4.f), 1);
+        addQuad(desc, float3(-4.f, -1.f, -4.f), float3(-4.f, 3.f, -4.f), float3(-4.f, 3.f, 4.f), float3(-4.f, -1.f, 4.f), 1);
+
+        desc.lights.push_back(createDirectionalLight(float3(1.f, -1.f, -0.5f), float3(1.f)));
+        LightData pointLight;
+        pointLight.posW = float3(0.f, 2.f, 0.f);
+        pointLight.intensity = float3(2.f);
+        desc.lights.push_back(pointLight);
+        desc.camera = createCamera(float3(0.f, 1.5f, 3.5f), float3(0.f, -0.5f, -1.f), float3(0.f, 1.f, 0.f), 0.6f);
+
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        auto pScene = CPUScene::create(desc);
+        double buildTimeMs = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+        logInfo("CPUPathTracerBenchmark: BVH build " + std::to_string(buildTimeMs) + " ms, " + std::to_string(pScene->getTriangleCount()) + " triangles, "
+            + std::to_string(pScene->getBVH()->getNodeCount()) + " nodes, SAH cost " + std::to_string(pScene->getBVH()->getSAHCost()));
+
+        CPUPathTracer::Options options;
+        options.frameDim = uint2(128, 128);
+        options.maxBounces = 3;
+        auto pPathTracer = CPUPathTracer::create(pScene, options);
+        for (uint32_t i = 0; i < 4; i++) pPathTracer->renderFrame();
+
+        const auto& stats = pPathTracer->getStats();
+        logInfo("CPUPathTracerBenchmark: " + std::to_string(stats.rayCount) + " rays in " + std::to_string(stats.renderTimeMs) + " ms, "
+            + std::to_string(stats.getRaysPerSecond() * 1e-6) + " Mrays/s");
+
+        EXPECT_EQ(pPathTracer->getFrameCount(), 4u);
+        EXPECT_GE(stats.rayCount, (uint64_t)options.frameDim.x * options.frameDim.y * 4);
+
+        float sum = 0.f;
+        for (const float4& c : pPathTracer->getImage())
+        {
+            EXPECT(std::isfinite(c.r) && std::isfinite(c.g) && std::isfinite(c.b));
+            sum += c.r + c.g + c.b;
+        }
+        EXPECT_GT(sum, 0.f);
+    }
+}
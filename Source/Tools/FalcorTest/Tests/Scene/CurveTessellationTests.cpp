@@ -0,0 +1,264 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Curves/CurveTessellation.h"
+#include "Utils/Math/MathHelpers.h"
+#include <random>
+
+// The tessellation benchmark is disabled by default as it tessellates 100k synthetic hair strands per mode.
+//#define RUN_BENCHMARK_TESTS
+
+namespace Falcor
+{
+    namespace
+    {
+        struct SyntheticHair
+        {
+            std::vector<int> vertexCounts;
+            std::vector<float3> points;
+            std::vector<float> widths;
+            std::vector<float2> UVs;
+        };
+
+        /** Generate wavy hair strands growing outwards from a unit sphere.
+            \param[in] strandCount Number of strands.
+            \param[in] pointsPerStrand Number of control points per strand.
+            \param[in] curliness Amplitude of the waves relative to the strand length. Zero gives straight strands.
+        */
+        SyntheticHair createSyntheticHair(uint32_t strandCount, uint32_t pointsPerStrand, float curliness, uint32_t seed = 0)
+        {
+            SyntheticHair hair;
+            hair.vertexCounts.assign(strandCount, (int)pointsPerStrand);
+            hair.points.reserve(strandCount * pointsPerStrand);
+            hair.widths.reserve(strandCount * pointsPerStrand);
+            hair.UVs.reserve(strandCount * pointsPerStrand);
+
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> u(0.f, 1.f);
+            const float kLength = 0.5f;
+
+            for (uint32_t i = 0; i < strandCount; i++)
+            {
+                float z = 2.f * u(rng) - 1.f;
+                float phi = 2.f * (float)M_PI * u(rng);
+                float r = std::sqrt(std::max(0.f, 1.f - z * z));
+                float3 root(r * std::cos(phi), r * std::sin(phi), z);
+                float3 s, t;
+                buildFrame(root, s, t);
+                float phase = 2.f * (float)M_PI * u(rng);
+
+                for (uint32_t j = 0; j < pointsPerStrand; j++)
+                {
+                    float v = (float)j / (float)(pointsPerStrand - 1);
+                    float angle = phase + 6.f * (float)M_PI * v;
+                    float3 offset = curliness * kLength * (std::cos(angle) * s + std::sin(angle) * t);
+                    hair.points.push_back(root + kLength * v * root + offset);
+                    hair.widths.push_back(0.01f * (1.f - 0.5f * v));
+                    hair.UVs.push_back(float2((float)i / (float)strandCount, v));
+                }
+            }
+            return hair;
+        }
+
+        uint32_t countSegments(const SyntheticHair& hair)
+        {
+            uint32_t segmentCount = 0;
+            for (int vertexCount : hair.vertexCounts) segmentCount += vertexCount - 1;
+            return segmentCount;
+        }
+    }
+
+    CPU_TEST(CurveTessellationSweptSphere)
+    {
+        const uint32_t kStrandCount = 500;
+        const uint32_t kPointsPerStrand = 12;
+        const uint32_t kSubdiv = 3;
+        SyntheticHair hair = createSyntheticHair(kStrandCount, kPointsPerStrand, 0.1f);
+
+        auto result = CurveTessellation::convertToLinearSweptSphere(kStrandCount, hair.vertexCounts.data(), hair.points.data(), hair.widths.data(), hair.UVs.data(), 1, kSubdiv, glm::mat4(1.f));
+
+        const size_t pointsPerStrand = kSubdiv * (kPointsPerStrand - 1) + 1;
+        EXPECT_EQ(result.points.size(), kStrandCount * pointsPerStrand);
+        EXPECT_EQ(result.radius.size(), result.points.size());
+        EXPECT_EQ(result.tangents.size(), result.points.size());
+        EXPECT_EQ(result.normals.size(), result.points.size());
+        EXPECT_EQ(result.texCrds.size(), result.points.size());
+        EXPECT_EQ(result.indices.size(), kStrandCount * (pointsPerStrand - 1));
+
+        // Segments connect consecutive points and never cross into the next strand.
+        for (uint32_t i = 0; i < kStrandCount; i++)
+        {
+            for (uint32_t j = 0; j < pointsPerStrand - 1; j++)
+            {
+                EXPECT_EQ(result.indices[i * (pointsPerStrand - 1) + j], i * pointsPerStrand + j);
+            }
+        }
+
+        // The spline interpolates the control points.
+        for (uint32_t i = 0; i < kStrandCount; i++)
+        {
+            for (uint32_t j = 0; j < kPointsPerStrand; j++)
+            {
+                size_t p = i * pointsPerStrand + j * kSubdiv;
+                size_t c = i * kPointsPerStrand + j;
+                EXPECT_LE(glm::length(result.points[p] - hair.points[c]), 1e-5f);
+                EXPECT_LE(std::abs(result.radius[p] - 0.5f * hair.widths[c]), 1e-6f);
+                EXPECT_LE(glm::length(result.texCrds[p] - hair.UVs[c]), 1e-5f);
+            }
+        }
+
+        // Pre-transformation scales positions and radii.
+        auto scaled = CurveTessellation::convertToLinearSweptSphere(kStrandCount, hair.vertexCounts.data(), hair.points.data(), hair.widths.data(), nullptr, 1, kSubdiv, glm::scale(glm::mat4(1.f), float3(2.f)));
+        EXPECT(scaled.texCrds.empty());
+        EXPECT_EQ(scaled.points.size(), result.points.size());
+        for (size_t p = 0; p < result.points.size(); p += 97)
+        {
+            EXPECT_LE(glm::length(scaled.points[p] - 2.f * result.points[p]), 1e-4f);
+            EXPECT_LE(std::abs(scaled.radius[p] - 2.f * result.radius[p]), 1e-5f);
+        }
+    }
+
+    CPU_TEST(CurveTessellationMesh)
+    {
+        const uint32_t kStrandCount = 200;
+        const uint32_t kPointsPerStrand = 8;
+        const uint32_t kSubdiv = 2;
+        const uint32_t kCrossSection = 4;
+        SyntheticHair hair = createSyntheticHair(kStrandCount, kPointsPerStrand, 0.1f);
+
+        auto result = CurveTessellation::convertToMesh(kStrandCount, hair.vertexCounts.data(), hair.points.data(), hair.widths.data(), hair.UVs.data(), kSubdiv, kCrossSection);
+
+        const size_t pointsPerStrand = kSubdiv * (kPointsPerStrand - 1) + 1;
+        const size_t vertexCount = kStrandCount * pointsPerStrand * kCrossSection;
+        const size_t faceCount = kStrandCount * (pointsPerStrand - 1) * 2 * kCrossSection;
+        EXPECT_EQ(result.vertices.size(), vertexCount);
+        EXPECT_EQ(result.normals.size(), vertexCount);
+        EXPECT_EQ(result.tangents.size(), vertexCount);
+        EXPECT_EQ(result.texCrds.size(), vertexCount);
+        EXPECT_EQ(result.faceVertexCounts.size(), faceCount);
+        EXPECT_EQ(result.faceVertexIndices.size(), faceCount * 3);
+
+        // All triangles reference vertices of their own strand.
+        const size_t indicesPerStrand = (pointsPerStrand - 1) * 6 * kCrossSection;
+        const size_t verticesPerStrand = pointsPerStrand * kCrossSection;
+        uint32_t failures = 0;
+        for (size_t f = 0; f < result.faceVertexIndices.size(); f++)
+        {
+            size_t strand = f / indicesPerStrand;
+            uint32_t v = result.faceVertexIndices[f];
+            if (v < strand * verticesPerStrand || v >= (strand + 1) * verticesPerStrand) failures++;
+        }
+        EXPECT_EQ(failures, 0u);
+        for (uint32_t count : result.faceVertexCounts) EXPECT_EQ(count, 3u);
+
+        // Vertices lie on the tube around the curve.
+        const float3 center = 0.25f * (result.vertices[0] + result.vertices[1] + result.vertices[2] + result.vertices[3]);
+        EXPECT_LE(glm::length(center - hair.points[0]), 1e-4f);
+        EXPECT_LE(std::abs(glm::length(result.vertices[0] - hair.points[0]) - 0.5f * hair.widths[0]), 1e-5f);
+    }
+
+    CPU_TEST(CurveTessellationAdaptive)
+    {
+        const uint32_t kStrandCount = 200;
+        const uint32_t kPointsPerStrand = 16;
+        SyntheticHair straight = createSyntheticHair(kStrandCount, kPointsPerStrand, 0.f);
+        SyntheticHair curly = createSyntheticHair(kStrandCount, kPointsPerStrand, 0.2f);
+        const uint32_t segmentCount = countSegments(straight);
+
+        CurveTessellation::SubdivisionDesc desc;
+        desc.adaptive = true;
+        desc.subdivPerSegment = 16;
+        desc.minSubdivPerSegment = 1;
+        desc.maxAngle = 0.05f;
+
+        // Straight strands need no subdivision, curly ones do.
+        auto straightResult = CurveTessellation::convertToLinearSweptSphere(kStrandCount, straight.vertexCounts.data(), straight.points.data(), straight.widths.data(), nullptr, 1, desc, glm::mat4(1.f));
+        auto curlyResult = CurveTessellation::convertToLinearSweptSphere(kStrandCount, curly.vertexCounts.data(), curly.points.data(), curly.widths.data(), nullptr, 1, desc, glm::mat4(1.f));
+        EXPECT_EQ(straightResult.indices.size(), segmentCount);
+        EXPECT_GT(curlyResult.indices.size(), 2 * segmentCount);
+        EXPECT_LE(curlyResult.indices.size(), 16 * segmentCount);
+        EXPECT_EQ(curlyResult.indices.size() + kStrandCount, curlyResult.points.size());
+        EXPECT_EQ(curlyResult.tangents.size(), curlyResult.points.size());
+
+        // Strands far away from the camera are tessellated more coarsely.
+        desc.screenLength = 2.f;
+        desc.pixelAngle = glm::radians(45.f) / 1080.f;
+        desc.cameraPosition = float3(0.f, 0.f, 4.f);
+        auto nearResult = CurveTessellation::convertToLinearSweptSphere(kStrandCount, curly.vertexCounts.data(), curly.points.data(), curly.widths.data(), nullptr, 1, desc, glm::mat4(1.f));
+        desc.cameraPosition = float3(0.f, 0.f, 400.f);
+        auto farResult = CurveTessellation::convertToLinearSweptSphere(kStrandCount, curly.vertexCounts.data(), curly.points.data(), curly.widths.data(), nullptr, 1, desc, glm::mat4(1.f));
+        EXPECT_LE(nearResult.indices.size(), curlyResult.indices.size());
+        EXPECT_LT(farResult.indices.size(), nearResult.indices.size());
+        EXPECT_GE(farResult.indices.size(), segmentCount);
+
+        // Adaptive mesh tessellation agrees with the swept sphere layout.
+        auto meshResult = CurveTessellation::convertToMesh(kStrandCount, curly.vertexCounts.data(), curly.points.data(), curly.widths.data(), nullptr, desc, 4);
+        EXPECT_EQ(meshResult.vertices.size(), farResult.points.size() * 4);
+        EXPECT_EQ(meshResult.faceVertexCounts.size(), farResult.indices.size() * 8);
+    }
+
+#ifdef RUN_BENCHMARK_TESTS
+    CPU_TEST(CurveTessellationBenchmark)
+#else
+    CPU_TEST(CurveTessellationBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        const uint32_t kStrandCount = 100000;
+        const uint32_t kPointsPerStrand = 16;
+        SyntheticHair hair = createSyntheticHair(kStrandCount, kPointsPerStrand, 0.1f);
+
+        auto benchmark = [&] (const std::string& name, auto func)
+        {
+            auto start = CpuTimer::getCurrentTimePoint();
+            size_t count = func();
+            double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            logInfo("CurveTessellationBenchmark: " + name + ": " + std::to_string(ms) + " ms, " + std::to_string(count) + " elements");
+            return count;
+        };
+
+        CurveTessellation::SubdivisionDesc adaptive;
+        adaptive.adaptive = true;
+        adaptive.subdivPerSegment = 8;
+        adaptive.maxAngle = 0.1f;
+
+        size_t fixedCount = benchmark("swept spheres, 4 subdivisions", [&] () {
+            return CurveTessellation::convertToLinearSweptSphere(kStrandCount, hair.vertexCounts.data(), hair.points.data(), hair.widths.data(), hair.UVs.data(), 1, 4, glm::mat4(1.f)).indices.size();
+        });
+        EXPECT_EQ(fixedCount, (size_t)countSegments(hair) * 4);
+
+        size_t adaptiveCount = benchmark("swept spheres, adaptive", [&] () {
+            return CurveTessellation::convertToLinearSweptSphere(kStrandCount, hair.vertexCounts.data(), hair.points.data(), hair.widths.data(), hair.UVs.data(), 1, adaptive, glm::mat4(1.f)).indices.size();
+        });
+        EXPECT_GE(adaptiveCount, (size_t)countSegments(hair));
+
+        size_t meshCount = benchmark("mesh, 4 subdivisions, 4 points per cross-section", [&] () {
+            return CurveTessellation::convertToMesh(kStrandCount, hair.vertexCounts.data(), hair.points.data(), hair.widths.data(), hair.UVs.data(), 4, 4).faceVertexCounts.size();
+        });
+        EXPECT_EQ(meshCount, (size_t)countSegments(hair) * 4 * 8);
+    }
+}
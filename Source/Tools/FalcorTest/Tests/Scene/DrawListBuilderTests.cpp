@@ -0,0 +1,162 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/DrawListBuilder.h"
+#include <random>
+#include <tuple>
+
+namespace Falcor
+{
+    namespace
+    {
+        std::vector<DrawListBuilder::Item> createRandomItems(std::mt19937& rng, uint32_t itemCount, uint32_t bucketCount, uint32_t materialCount, uint32_t meshCount)
+        {
+            std::uniform_real_distribution<float> u(-100.f, 100.f);
+            std::vector<DrawListBuilder::Item> items(itemCount);
+            for (auto& item : items)
+            {
+                item.bucket = rng() % bucketCount;
+                item.materialID = rng() % materialCount;
+                item.meshID = rng() % meshCount;
+                item.depth = u(rng);
+            }
+            return items;
+        }
+
+        /** Check that the order is a permutation sorted by bucket, material, mesh and depth, and that the draws cover it with maximal runs of the same mesh.
+        */
+        void validate(CPUUnitTestContext& ctx, const DrawListBuilder& builder, const std::vector<DrawListBuilder::Item>& items)
+        {
+            const auto& order = builder.getOrder();
+            const auto& draws = builder.getDraws();
+            EXPECT_EQ(order.size(), items.size());
+
+            std::vector<bool> visited(items.size(), false);
+            for (uint32_t index : order)
+            {
+                EXPECT(index < items.size() && !visited[index]) << "index = " << index;
+                if (index < items.size()) visited[index] = true;
+            }
+
+            // The depth is quantized in the sort key, so allow a small tolerance for its order.
+            auto key = [](const DrawListBuilder::Item& item) { return std::make_tuple(item.bucket, item.materialID, item.meshID); };
+            for (size_t i = 1; i < order.size(); i++)
+            {
+                const auto& prev = items[order[i - 1]];
+                const auto& item = items[order[i]];
+                EXPECT(key(prev) < key(item) || (key(prev) == key(item) && prev.depth <= item.depth + 1e-4f)) << "slot = " << i;
+            }
+
+            uint32_t slot = 0;
+            for (size_t i = 0; i < draws.size(); i++)
+            {
+                const auto& draw = draws[i];
+                EXPECT_EQ(draw.firstInstance, slot);
+                EXPECT_GT(draw.instanceCount, 0u);
+                for (uint32_t j = 0; j < draw.instanceCount && slot + j < order.size(); j++)
+                {
+                    const auto& item = items[order[slot + j]];
+                    EXPECT(item.bucket == draw.bucket && item.meshID == draw.meshID) << "draw = " << i << ", instance = " << j;
+                }
+                if (i > 0) EXPECT(draw.bucket != draws[i - 1].bucket || draw.meshID != draws[i - 1].meshID) << "draw = " << i;
+                slot += draw.instanceCount;
+            }
+            EXPECT_EQ(slot, items.size());
+            EXPECT_EQ(builder.getStats().drawCount, draws.size());
+        }
+    }
+
+    CPU_TEST(DrawListBuilder_Merge)
+    {
+        // Two buckets with instances of the same mesh in different input positions.
+        std::vector<DrawListBuilder::Item> items(6);
+        items[0] = { 1, 0, 3, 2.f };
+        items[1] = { 0, 0, 3, 5.f };
+        items[2] = { 1, 0, 3, 1.f };
+        items[3] = { 0, 0, 3, 4.f };
+        items[4] = { 0, 1, 2, 0.f };
+        items[5] = { 1, 0, 3, 3.f };
+
+        DrawListBuilder builder;
+        const auto& draws = builder.build(items);
+        validate(ctx, builder, items);
+
+        EXPECT_EQ(draws.size(), 3u);
+        EXPECT_EQ(draws[0].instanceCount, 2u);
+        EXPECT_EQ(draws[1].meshID, 2u);
+        EXPECT_EQ(draws[2].instanceCount, 3u);
+
+        const std::vector<uint32_t> expectedOrder = { 3, 1, 4, 2, 0, 5 };
+        EXPECT(builder.getOrder() == expectedOrder);
+
+        // Without depth sorting, instances with equal keys keep their input order.
+        builder.setDepthSortEnabled(false);
+        builder.build(items);
+        const std::vector<uint32_t> expectedStableOrder = { 1, 3, 4, 0, 2, 5 };
+        EXPECT(builder.getOrder() == expectedStableOrder);
+        EXPECT_EQ(builder.getStats().depthBits, 0u);
+    }
+
+    CPU_TEST(DrawListBuilder_Random)
+    {
+        std::mt19937 rng;
+        DrawListBuilder builder;
+
+        // Few meshes merge into instanced draws, many meshes use most of the key bits.
+        for (uint32_t meshCount : { 1u, 16u, 1u << 20 })
+        {
+            auto items = createRandomItems(rng, 10000, 4, 300, meshCount);
+            builder.build(items);
+            validate(ctx, builder, items);
+            if (meshCount == 1) EXPECT_LE(builder.getDraws().size(), 4u);
+        }
+
+        // Empty list.
+        builder.build({});
+        EXPECT(builder.getDraws().empty());
+        EXPECT(builder.getOrder().empty());
+    }
+
+    CPU_TEST(DrawListBuilder_KeyOverflow)
+    {
+        std::vector<DrawListBuilder::Item> items(1);
+        items[0] = { 1u << 31, 1u << 31, 1u << 31, 0.f };
+
+        DrawListBuilder builder;
+        bool thrown = false;
+        try
+        {
+            builder.build(items);
+        }
+        catch (const std::exception&)
+        {
+            thrown = true;
+        }
+        EXPECT(thrown);
+    }
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Returns the maximum absolute difference of all voxels (including a one voxel border) of two grids.
+        */
+        float getMaxError(const Grid& grid, const Grid& refGrid)
+        {
+            const int3 minIndex = refGrid.getMinIndex() - 1;
+            const int3 maxIndex = refGrid.getMaxIndex() + 1;
+            float maxError = 0.f;
+            for (int z = minIndex.z; z <= maxIndex.z; z++)
+            {
+                for (int y = minIndex.y; y <= maxIndex.y; y++)
+                {
+                    for (int x = minIndex.x; x <= maxIndex.x; x++)
+                    {
+                        int3 ijk(x, y, z);
+                        maxError = std::max(maxError, std::abs(grid.getValue(ijk) - refGrid.getValue(ijk)));
+                    }
+                }
+            }
+            return maxError;
+        }
+    }
+
+    GPU_TEST(GridQuantizationAccuracy)
+    {
+        auto pGrid = Grid::createSphere(16.f, 1.f, 6.f);
+        EXPECT(pGrid->getQuantization() == Grid::Quantization::Float);
+
+        // Fixed bit-width codecs quantize each leaf node's value range uniformly, so the error is bounded by the quantization step.
+        const float valueRange = pGrid->getMaxValue() - pGrid->getMinValue();
+        const std::pair<Grid::Quantization, uint32_t> kFixedCodecs[] =
+        {
+            { Grid::Quantization::Fp16, 16 },
+            { Grid::Quantization::Fp8, 8 },
+            { Grid::Quantization::Fp4, 4 },
+        };
+
+        uint64_t prevSize = pGrid->getGridSizeInBytes();
+        for (auto [quantization, bits] : kFixedCodecs)
+        {
+            auto pQuantizedGrid = Grid::createQuantized(pGrid, quantization);
+            EXPECT(pQuantizedGrid != nullptr);
+            if (!pQuantizedGrid) continue;
+
+            EXPECT(pQuantizedGrid->getQuantization() == quantization);
+            EXPECT_EQ(pQuantizedGrid->getVoxelCount(), pGrid->getVoxelCount());
+            EXPECT_LT(pQuantizedGrid->getGridSizeInBytes(), prevSize);
+            prevSize = pQuantizedGrid->getGridSizeInBytes();
+
+            const float step = valueRange / float((1u << bits) - 1);
+            EXPECT_LE(getMaxError(*pQuantizedGrid, *pGrid), step + 1e-6f);
+        }
+
+        // Variable bit-width codec respects the tolerance.
+        const float kTolerances[] = { 0.05f, 0.01f, 0.001f };
+        for (float tolerance : kTolerances)
+        {
+            auto pQuantizedGrid = Grid::createQuantized(pGrid, Grid::Quantization::FpN, tolerance);
+            EXPECT(pQuantizedGrid != nullptr);
+            if (!pQuantizedGrid) continue;
+
+            EXPECT(pQuantizedGrid->getQuantization() == Grid::Quantization::FpN);
+            EXPECT_LT(pQuantizedGrid->getGridSizeInBytes(), pGrid->getGridSizeInBytes());
+            EXPECT_LE(getMaxError(*pQuantizedGrid, *pGrid), tolerance + 1e-6f);
+        }
+    }
+
+    GPU_TEST(GridQuantizationMajorants)
+    {
+        auto pGrid = Grid::createQuantized(Grid::createSphere(16.f, 1.f, 6.f), Grid::Quantization::Fp8);
+        EXPECT(pGrid != nullptr);
+        if (!pGrid) return;
+
+        // The majorant grid is built from the decoded values.
+        const auto& pMajorantGrid = pGrid->getMajorantGrid();
+        const int3 minIndex = pGrid->getMinIndex();
+        const int3 maxIndex = pGrid->getMaxIndex();
+        uint32_t failures = 0;
+        for (int z = minIndex.z; z <= maxIndex.z; z++)
+        {
+            for (int y = minIndex.y; y <= maxIndex.y; y++)
+            {
+                for (int x = minIndex.x; x <= maxIndex.x; x++)
+                {
+                    int3 ijk(x, y, z);
+                    if (pMajorantGrid->getMajorantAtIndex(ijk) < pGrid->getValue(ijk)) failures++;
+                }
+            }
+        }
+        EXPECT_EQ(failures, 0u);
+    }
+}
@@ -0,0 +1,130 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <nanovdb/util/IO.h>
+#include <filesystem>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kFrameCount = 8;
+
+        /** Writes a sequence of spheres with growing radius to NanoVDB files.
+        */
+        std::vector<std::string> createSequence(const std::filesystem::path& dir, std::vector<uint64_t>& voxelCounts, std::string& gridname)
+        {
+            std::vector<std::string> files;
+            for (uint32_t i = 0; i < kFrameCount; i++)
+            {
+                auto pGrid = Grid::createSphere(4.f + i, 1.f);
+                voxelCounts.push_back(pGrid->getVoxelCount());
+                gridname = pGrid->getGridHandle().grid<float>()->gridName();
+
+                std::string filename = (dir / ("frame" + std::to_string(i) + ".nvdb")).string();
+                nanovdb::io::writeGrid(filename, pGrid->getGridHandle());
+                files.push_back(filename);
+            }
+            return files;
+        }
+    }
+
+    GPU_TEST(GridStreamerSequence)
+    {
+        std::filesystem::path dir = std::filesystem::path(getTempFilename()).replace_extension("");
+        std::filesystem::create_directories(dir);
+
+        std::vector<uint64_t> voxelCounts;
+        std::string gridname;
+        auto files = createSequence(dir, voxelCounts, gridname);
+
+        {
+            GridStreamer::Desc desc;
+            desc.prefetchCount = 2;
+            desc.keepBehindCount = 1;
+            auto pStreamer = GridStreamer::create(files, gridname, desc);
+            EXPECT(pStreamer != nullptr);
+            if (!pStreamer) return;
+            EXPECT_EQ(pStreamer->getFrameCount(), kFrameCount);
+
+            // The grid object stays the same, only its data is replaced.
+            auto pGrid = pStreamer->getGrid();
+            for (uint32_t pass = 0; pass < 2; pass++)
+            {
+                for (uint32_t frame = 0; frame < kFrameCount; frame++)
+                {
+                    pStreamer->setFrame(frame);
+                    EXPECT(pStreamer->getGrid() == pGrid);
+                    EXPECT_EQ(pGrid->getVoxelCount(), voxelCounts[frame]);
+                    EXPECT_LE(pStreamer->getStats().residentFrames, 1 + desc.prefetchCount + desc.keepBehindCount);
+                }
+            }
+
+            auto stats = pStreamer->getStats();
+            EXPECT_EQ(stats.frameRequests, 2 * kFrameCount - 1);
+            EXPECT_EQ(stats.frameHits + stats.frameMisses, stats.frameRequests);
+        }
+
+        {
+            // With a tiny budget only the current frame stays resident.
+            GridStreamer::Desc desc;
+            desc.memoryBudget = 1;
+            auto pStreamer = GridStreamer::create(files, gridname, desc);
+            EXPECT(pStreamer != nullptr);
+            if (!pStreamer) return;
+
+            for (uint32_t frame = kFrameCount; frame-- > 0;)
+            {
+                pStreamer->setFrame(frame);
+                EXPECT_EQ(pStreamer->getGrid()->getVoxelCount(), voxelCounts[frame]);
+
+                auto stats = pStreamer->getStats();
+                EXPECT_EQ(stats.residentFrames, 1u);
+                EXPECT_EQ(stats.residentBytes, pStreamer->getGrid()->getGridSizeInBytes());
+            }
+        }
+
+        {
+            // Stream a volume from a directory.
+            auto pVolume = Volume::create("volume");
+            EXPECT_EQ(pVolume->streamGridSequence(Volume::GridSlot::Density, dir.string(), gridname), kFrameCount);
+            EXPECT_EQ(pVolume->getGridFrameCount(), kFrameCount);
+            EXPECT_EQ(pVolume->getAllGrids().size(), (size_t)1);
+            EXPECT(pVolume->getGridStreamer(Volume::GridSlot::Density) != nullptr);
+
+            pVolume->setGridFrame(5);
+            EXPECT_EQ(pVolume->getDensityGrid()->getVoxelCount(), voxelCounts[5]);
+
+            // Setting a grid removes the streamer.
+            pVolume->setDensityGrid(Grid::createSphere(1.f, 1.f));
+            EXPECT(pVolume->getGridStreamer(Volume::GridSlot::Density) == nullptr);
+        }
+
+        std::filesystem::remove_all(dir);
+    }
+}
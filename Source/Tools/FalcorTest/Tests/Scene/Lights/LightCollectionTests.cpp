@@ -0,0 +1,134 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Experimental/Scene/Lights/LightCollection.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Create a scene with a textured emissive sphere and a scaled, untextured emissive quad.
+        */
+        Scene::SharedPtr createEmissiveScene(const std::string& textureFilename)
+        {
+            // Smooth gradient so that the average radiance is insensitive to rasterization rules at triangle edges.
+            const uint32_t kSize = 256;
+            std::vector<uint8_t> texels(kSize * kSize * 4);
+            for (uint32_t y = 0; y < kSize; y++)
+            {
+                for (uint32_t x = 0; x < kSize; x++)
+                {
+                    uint8_t* p = &texels[(y * kSize + x) * 4];
+                    p[0] = (uint8_t)x;
+                    p[1] = (uint8_t)y;
+                    p[2] = (uint8_t)((x + y) / 2);
+                    p[3] = 255;
+                }
+            }
+            Bitmap::saveImage(textureFilename, kSize, kSize, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, true, texels.data());
+
+            auto pBuilder = SceneBuilder::create();
+
+            auto pTextured = Material::create("Textured");
+            pTextured->setEmissiveTexture(Texture::createFromFile(textureFilename, false, true));
+            pTextured->setEmissiveFactor(2.f);
+
+            auto pUniform = Material::create("Uniform");
+            pUniform->setEmissiveColor(float3(0.5f, 1.f, 2.f));
+
+            auto sphereID = pBuilder->addTriangleMesh(TriangleMesh::createSphere(1.f, 32, 16), pTextured);
+            auto quadID = pBuilder->addTriangleMesh(TriangleMesh::createQuad(1.f), pUniform);
+
+            SceneBuilder::Node sphereNode = { "Sphere", glm::identity<glm::mat4>(), glm::identity<glm::mat4>() };
+            pBuilder->addMeshInstance(pBuilder->addNode(sphereNode), sphereID);
+            SceneBuilder::Node quadNode = { "Quad", glm::translate(float3(0.f, 3.f, 0.f)) * glm::scale(float3(2.f)), glm::identity<glm::mat4>() };
+            pBuilder->addMeshInstance(pBuilder->addNode(quadNode), quadID);
+
+            return pBuilder->getScene();
+        }
+
+        bool isClose(float a, float b, float relTolerance)
+        {
+            return std::abs(a - b) <= relTolerance * std::max(std::abs(a), std::abs(b)) + 1e-6f;
+        }
+    }
+
+    GPU_TEST(LightCollectionCPUBuild)
+    {
+        const std::string textureFilename = getTempFilename() + ".png";
+        auto pScene = createEmissiveScene(textureFilename);
+        EXPECT(pScene != nullptr);
+        EXPECT(!pScene->getMeshStaticData().empty());
+
+        LightCollection::Options options;
+        options.buildOnCPU = true;
+        auto pCPU = LightCollection::create(ctx.getRenderContext(), pScene, options);
+        options.buildOnCPU = false;
+        auto pGPU = LightCollection::create(ctx.getRenderContext(), pScene, options);
+        EXPECT(pCPU != nullptr);
+        EXPECT(pGPU != nullptr);
+        EXPECT(pCPU->isBuiltOnCPU());
+        EXPECT(!pGPU->isBuiltOnCPU());
+
+        // The CPU build is validated against the GPU integrator.
+        const auto& cpuTriangles = pCPU->getMeshLightTriangles();
+        const auto& gpuTriangles = pGPU->getMeshLightTriangles();
+        EXPECT_EQ(cpuTriangles.size(), gpuTriangles.size());
+        EXPECT_GT(cpuTriangles.size(), (size_t)0);
+
+        uint32_t geometryFailures = 0;
+        uint32_t fluxFailures = 0;
+        for (size_t i = 0; i < std::min(cpuTriangles.size(), gpuTriangles.size()); i++)
+        {
+            const auto& c = cpuTriangles[i];
+            const auto& g = gpuTriangles[i];
+
+            bool geometryMatch = c.lightIdx == g.lightIdx && isClose(c.area, g.area, 1e-4f);
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                geometryMatch = geometryMatch && glm::length(c.vtx[j].pos - g.vtx[j].pos) <= 1e-5f && c.vtx[j].uv == g.vtx[j].uv;
+            }
+            if (c.area > 0.f) geometryMatch = geometryMatch && glm::dot(c.normal, g.normal) > 0.999f;
+            if (!geometryMatch) geometryFailures++;
+
+            // Texel coverage at triangle edges may differ slightly from the hardware rasterizer.
+            bool fluxMatch = isClose(c.flux, g.flux, 0.02f);
+            for (uint32_t j = 0; j < 3; j++) fluxMatch = fluxMatch && isClose(c.averageRadiance[j], g.averageRadiance[j], 0.02f);
+            if (!fluxMatch) fluxFailures++;
+        }
+        EXPECT_EQ(geometryFailures, 0u);
+        EXPECT_EQ(fluxFailures, 0u);
+
+        // Stats are derived from the same data.
+        EXPECT_EQ(pCPU->getStats().trianglesActive, pGPU->getStats().trianglesActive);
+        EXPECT_EQ(pCPU->getStats().trianglesActiveTextured, pGPU->getStats().trianglesActiveTextured);
+        EXPECT_EQ(pCPU->getStats().trianglesActiveUniform, pGPU->getStats().trianglesActiveUniform);
+
+        std::filesystem::remove(textureFilename);
+    }
+}
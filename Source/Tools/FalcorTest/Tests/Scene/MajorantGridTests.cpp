@@ -0,0 +1,95 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+
+namespace Falcor
+{
+    GPU_TEST(MajorantGridConservative)
+    {
+        auto pGrid = Grid::createSphere(12.f, 1.f);
+        auto pMajorantGrid = pGrid->getMajorantGrid();
+        EXPECT(pMajorantGrid != nullptr);
+        EXPECT_GT(pMajorantGrid->getLevelCount(), 1u);
+
+        // Every majorant has to bound the values in the one voxel neighborhood reached by interpolated lookups.
+        const int3 minIndex = pGrid->getMinIndex() - 1;
+        const int3 maxIndex = pGrid->getMaxIndex() + 1;
+        uint32_t failures = 0;
+        for (int z = minIndex.z; z <= maxIndex.z; z++)
+        {
+            for (int y = minIndex.y; y <= maxIndex.y; y++)
+            {
+                for (int x = minIndex.x; x <= maxIndex.x; x++)
+                {
+                    float value = 0.f;
+                    for (int k = -1; k <= 1; k++) for (int j = -1; j <= 1; j++) for (int i = -1; i <= 1; i++)
+                    {
+                        value = std::max(value, pGrid->getValue(int3(x + i, y + j, z + k)));
+                    }
+
+                    for (uint32_t level = 0; level < pMajorantGrid->getLevelCount(); level++)
+                    {
+                        if (pMajorantGrid->getMajorantAtIndex(int3(x, y, z), level) < value) failures++;
+                    }
+                }
+            }
+        }
+        EXPECT_EQ(failures, 0u);
+
+        // The coarsest level is a single cell containing the global maximum.
+        const uint32_t lastLevel = pMajorantGrid->getLevelCount() - 1;
+        EXPECT(pMajorantGrid->getDimensions(lastLevel) == uint3(1));
+        EXPECT_EQ(pMajorantGrid->getMajorant(int3(0), lastLevel), pGrid->getMaxValue());
+    }
+
+    GPU_TEST(MajorantGridCollisions)
+    {
+        auto pGrid = Grid::createSphere(20.f, 1.f);
+
+        auto stats = pGrid->estimateCollisions(1024, 0, 1);
+        EXPECT_EQ(stats.rayCount, 1024u);
+        EXPECT_GT(stats.realCollisions, 0.0);
+        EXPECT_GE(stats.gridNullCollisions, 0.0);
+        EXPECT_LT(stats.gridNullCollisions, stats.globalNullCollisions);
+
+        // The estimate is deterministic.
+        auto stats2 = pGrid->estimateCollisions(1024, 0, 1);
+        EXPECT_EQ(stats.gridNullCollisions, stats2.gridNullCollisions);
+        EXPECT_EQ(stats.globalNullCollisions, stats2.globalNullCollisions);
+
+        // Coarser levels visit fewer cells but bound the density more loosely.
+        auto coarseStats = pGrid->estimateCollisions(1024, 2, 1);
+        EXPECT_LE(coarseStats.cellsVisited, stats.cellsVisited);
+        EXPECT_GE(coarseStats.gridNullCollisions, stats.gridNullCollisions);
+
+        logInfo("MajorantGridCollisions: real " + std::to_string(stats.realCollisions) +
+            ", null (global majorant) " + std::to_string(stats.globalNullCollisions) +
+            ", null (majorant grid) " + std::to_string(stats.gridNullCollisions) +
+            ", cells visited " + std::to_string(stats.cellsVisited));
+    }
+}
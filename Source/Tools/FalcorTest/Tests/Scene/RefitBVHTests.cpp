@@ -0,0 +1,150 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/CPU/RefitBVH.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Create random boxes with extents up to 'size' in a box of size 10.
+        */
+        std::vector<AABB> createRandomBoxes(std::mt19937& rng, uint32_t boxCount, float size)
+        {
+            std::uniform_real_distribution<float> u(0.f, 1.f);
+            std::vector<AABB> boxes;
+            for (uint32_t i = 0; i < boxCount; i++)
+            {
+                float3 p = float3(u(rng), u(rng), u(rng)) * 10.f;
+                float3 e = float3(u(rng), u(rng), u(rng)) * size;
+                boxes.push_back(AABB(p, p + e));
+            }
+            return boxes;
+        }
+
+        /** Check the hierarchy structure and that the node bounds are the unions of the primitive bounds below them.
+            \return The SAH cost recomputed from scratch.
+        */
+        float validate(CPUUnitTestContext& ctx, const RefitBVH& bvh)
+        {
+            const auto& nodes = bvh.getNodes();
+            const uint32_t primitiveCount = bvh.getPrimitiveCount();
+            EXPECT_EQ(nodes.size(), primitiveCount > 0 ? 2 * primitiveCount - 1 : 0);
+            if (nodes.empty()) return 0.f;
+
+            std::vector<uint32_t> primitiveRefs(primitiveCount, 0);
+            std::vector<AABB> bounds(nodes.size());
+            std::vector<float> costs(nodes.size());
+            for (uint32_t i = (uint32_t)nodes.size(); i-- > 0;)
+            {
+                const auto& node = nodes[i];
+                if (node.isLeaf())
+                {
+                    primitiveRefs[node.primitive]++;
+                    bounds[i] = bvh.getPrimitiveBounds(node.primitive);
+                    costs[i] = bounds[i].area();
+                }
+                else
+                {
+                    EXPECT_GT(node.leftChild, i);
+                    EXPECT_EQ(nodes[node.leftChild].parent, i);
+                    EXPECT_EQ(nodes[node.leftChild + 1].parent, i);
+                    bounds[i] = bounds[node.leftChild] | bounds[node.leftChild + 1];
+                    costs[i] = bounds[i].area() + costs[node.leftChild] + costs[node.leftChild + 1];
+                }
+                EXPECT(node.bounds == bounds[i]) << "node " << i;
+            }
+            for (uint32_t i = 0; i < primitiveCount; i++) EXPECT_EQ(primitiveRefs[i], 1) << "primitive " << i;
+
+            return costs[0] / bounds[0].area();
+        }
+    }
+
+    CPU_TEST(RefitBVH_Build)
+    {
+        std::mt19937 rng;
+        for (uint32_t count : { 0u, 1u, 2u, 7u, 1000u })
+        {
+            RefitBVH bvh;
+            bvh.build(createRandomBoxes(rng, count, 0.5f));
+            float cost = validate(ctx, bvh);
+            EXPECT_LE(std::abs(bvh.getSAHCost() - cost), 1e-3f * cost) << "count " << count;
+            EXPECT_EQ(bvh.getSAHRatio(), 1.f) << "count " << count;
+        }
+
+        // Identical boxes can't be split by SAH and should fall back to median splits.
+        RefitBVH bvh;
+        bvh.build(std::vector<AABB>(100, AABB(float3(0.f), float3(1.f))));
+        validate(ctx, bvh);
+    }
+
+    CPU_TEST(RefitBVH_Refit)
+    {
+        std::mt19937 rng;
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+        const uint32_t count = 1000;
+        std::vector<AABB> boxes = createRandomBoxes(rng, count, 0.5f);
+
+        RefitBVH bvh;
+        bvh.build(boxes);
+
+        // Translating all boxes by the same amount preserves the quality.
+        const float3 offset(3.f, -2.f, 1.f);
+        for (uint32_t i = 0; i < count; i++) bvh.setPrimitiveBounds(i, AABB(boxes[i].minPoint + offset, boxes[i].maxPoint + offset));
+        EXPECT(bvh.refit());
+        validate(ctx, bvh);
+        EXPECT_LE(std::abs(bvh.getSAHRatio() - 1.f), 1e-3f);
+
+        // Nothing to refit without modifications.
+        EXPECT(!bvh.refit());
+
+        // Moving a few boxes only refits their paths, and the bounds stay exact.
+        for (uint32_t i = 0; i < count; i += 97)
+        {
+            float3 p = float3(u(rng), u(rng), u(rng)) * 10.f;
+            bvh.setPrimitiveBounds(i, AABB(p, p + 0.5f));
+        }
+        EXPECT(bvh.refit());
+        float cost = validate(ctx, bvh);
+        EXPECT_LE(std::abs(bvh.getSAHCost() - cost), 1e-3f * cost);
+
+        // Scattering all boxes degrades the hierarchy, and rebuilding restores it.
+        std::vector<AABB> scattered = createRandomBoxes(rng, count, 0.5f);
+        for (uint32_t i = 0; i < count; i++) bvh.setPrimitiveBounds(i, scattered[i]);
+        bvh.refit();
+        validate(ctx, bvh);
+        float refitCost = bvh.getSAHCost();
+        EXPECT_GT(bvh.getSAHRatio(), 2.f);
+
+        bvh.rebuild();
+        validate(ctx, bvh);
+        EXPECT_EQ(bvh.getSAHRatio(), 1.f);
+        EXPECT_LT(bvh.getSAHCost(), 0.5f * refitCost);
+    }
+}
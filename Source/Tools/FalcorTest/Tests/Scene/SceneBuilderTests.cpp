@@ -0,0 +1,69 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+
+namespace Falcor
+{
+    GPU_TEST(SceneBuilderAddProcessedMeshes)
+    {
+        SceneBuilder::SharedPtr pBuilder = SceneBuilder::create();
+        auto pMaterial = Material::create("test");
+
+        const std::vector<uint32_t> indices = { 0, 1, 2 };
+        const std::vector<float3> positions = { float3(0.f, 0.f, 0.f), float3(1.f, 0.f, 0.f), float3(0.f, 1.f, 0.f) };
+        const std::vector<float3> normals(3, float3(0.f, 0.f, 1.f));
+        const std::vector<float2> texCrds(3, float2(0.f));
+
+        SceneBuilder::Mesh mesh;
+        mesh.faceCount = 1;
+        mesh.vertexCount = 3;
+        mesh.indexCount = 3;
+        mesh.pIndices = indices.data();
+        mesh.topology = Vao::Topology::TriangleList;
+        mesh.pMaterial = pMaterial;
+        mesh.positions = { positions.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+        mesh.normals = { normals.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+        mesh.texCrds = { texCrds.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+
+        // A single mesh added first, then a batch. IDs must be assigned in order.
+        EXPECT_EQ(pBuilder->addMesh(mesh), 0);
+
+        std::vector<SceneBuilder::ProcessedMesh> meshes;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            mesh.name = "mesh" + std::to_string(i);
+            meshes.push_back(pBuilder->processMesh(mesh));
+            EXPECT_EQ(meshes.back().staticData.size(), 3);
+        }
+
+        auto meshIDs = pBuilder->addProcessedMeshes(std::move(meshes));
+        EXPECT_EQ(meshIDs.size(), 3);
+        for (uint32_t i = 0; i < meshIDs.size(); i++) EXPECT_EQ(meshIDs[i], i + 1);
+        EXPECT(meshes.empty());
+    }
+}
@@ -0,0 +1,189 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <filesystem>
+#include <random>
+
+// The save benchmark is disabled by default as it writes 4K and 8K images in every mode.
+//#define RUN_BENCHMARK_TESTS
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Creates a synthetic RGBA16Float image with smooth gradients and some noise.
+        */
+        std::vector<uint16_t> createHalfImage(uint32_t width, uint32_t height)
+        {
+            std::vector<uint16_t> data((size_t)width * height * 4);
+            std::mt19937 rng;
+            std::uniform_real_distribution<float> noise(0.f, 0.05f);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    size_t i = ((size_t)y * width + x) * 4;
+                    data[i + 0] = glm::detail::toFloat16(4.f * x / width + noise(rng));
+                    data[i + 1] = glm::detail::toFloat16(float(y) / height);
+                    data[i + 2] = glm::detail::toFloat16(0.5f + noise(rng));
+                    data[i + 3] = glm::detail::toFloat16(1.f);
+                }
+            }
+            return data;
+        }
+
+        /** Creates a synthetic RGBA8 image with smooth gradients.
+        */
+        std::vector<uint8_t> createLdrImage(uint32_t width, uint32_t height)
+        {
+            std::vector<uint8_t> data((size_t)width * height * 4);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    size_t i = ((size_t)y * width + x) * 4;
+                    data[i + 0] = uint8_t(x * 255 / width);
+                    data[i + 1] = uint8_t(y * 255 / height);
+                    data[i + 2] = uint8_t((x ^ y) & 0xff);
+                    data[i + 3] = 0xff;
+                }
+            }
+            return data;
+        }
+    }
+
+    CPU_TEST(BitmapSaveExrHalf)
+    {
+        // Use a size that is not a multiple of the conversion block size and an odd pixel count to exercise the tails.
+        const uint32_t width = 37, height = 45;
+        std::vector<uint16_t> data = createHalfImage(width, height);
+
+        // Include special values in the first pixel.
+        data[0] = 0x0001;   // Smallest denormal.
+        data[1] = 0x8000;   // Negative zero.
+        data[2] = 0x7bff;   // Largest finite half.
+
+        std::string filename = getTempFilename() + ".exr";
+        Bitmap::saveImage(filename, width, height, Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::ExportAlpha | Bitmap::ExportFlags::Uncompressed, ResourceFormat::RGBA16Float, true, data.data());
+
+        auto pBitmap = Bitmap::createFromFile(filename, true);
+        EXPECT(pBitmap != nullptr);
+        if (pBitmap)
+        {
+            EXPECT_EQ(pBitmap->getWidth(), width);
+            EXPECT_EQ(pBitmap->getHeight(), height);
+            EXPECT_EQ(pBitmap->getFormat(), ResourceFormat::RGBA32Float);
+
+            // Values are stored as 32-bit floats and must match the half values exactly.
+            const float* pResult = reinterpret_cast<const float*>(pBitmap->getData());
+            for (size_t i = 0; i < data.size(); i++)
+            {
+                float ref = glm::detail::toFloat32(data[i]);
+                EXPECT_EQ(pResult[i], ref) << "i = " << i;
+            }
+        }
+
+        std::filesystem::remove(filename);
+    }
+
+    CPU_TEST(BitmapSavePngSwizzle)
+    {
+        const uint32_t width = 19, height = 7;
+        std::vector<uint8_t> data = createLdrImage(width, height);
+        const std::vector<uint8_t> original = data;
+
+        std::string filename = getTempFilename() + ".png";
+        Bitmap::saveImage(filename, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::RGBA8Unorm, true, data.data());
+
+        // The source buffer must not be modified.
+        EXPECT(data == original);
+
+        // Loaded PNGs are BGRA.
+        auto pBitmap = Bitmap::createFromFile(filename, true);
+        EXPECT(pBitmap != nullptr);
+        if (pBitmap)
+        {
+            EXPECT_EQ(pBitmap->getFormat(), ResourceFormat::BGRA8Unorm);
+            const uint8_t* pResult = pBitmap->getData();
+            for (size_t i = 0; i < data.size(); i += 4)
+            {
+                EXPECT_EQ(pResult[i + 0], data[i + 2]) << "i = " << i;
+                EXPECT_EQ(pResult[i + 1], data[i + 1]) << "i = " << i;
+                EXPECT_EQ(pResult[i + 2], data[i + 0]) << "i = " << i;
+                EXPECT_EQ(pResult[i + 3], data[i + 3]) << "i = " << i;
+            }
+        }
+
+        std::filesystem::remove(filename);
+    }
+
+#ifdef RUN_BENCHMARK_TESTS
+    CPU_TEST(BitmapSaveBenchmark)
+#else
+    CPU_TEST(BitmapSaveBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        // Writes synthetic 4K and 8K images and logs the time per image.
+        const uint2 kSizes[] = { { 3840, 2160 }, { 7680, 4320 } };
+        const std::pair<Bitmap::ExrCompression, const char*> kExrModes[] =
+        {
+            { Bitmap::ExrCompression::None, "None" },
+            { Bitmap::ExrCompression::Zip, "Zip" },
+            { Bitmap::ExrCompression::Piz, "Piz" },
+            { Bitmap::ExrCompression::B44, "B44" },
+        };
+
+        for (auto size : kSizes)
+        {
+            std::string res = std::to_string(size.x) + "x" + std::to_string(size.y);
+            std::string filename = getTempFilename();
+
+            std::vector<uint16_t> hdr = createHalfImage(size.x, size.y);
+            for (auto mode : kExrModes)
+            {
+                auto start = CpuTimer::getCurrentTimePoint();
+                Bitmap::saveImage(filename, size.x, size.y, Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::RGBA16Float, true, hdr.data(), mode.first);
+                double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+                EXPECT(std::filesystem::exists(filename));
+                logInfo("BitmapSaveBenchmark: EXR " + res + " " + mode.second + ": " + std::to_string(ms) + " ms, " + std::to_string(std::filesystem::file_size(filename) >> 10) + " kB");
+                std::filesystem::remove(filename);
+            }
+
+            std::vector<uint8_t> ldr = createLdrImage(size.x, size.y);
+            for (auto flags : { Bitmap::ExportFlags::Uncompressed, Bitmap::ExportFlags::None })
+            {
+                auto start = CpuTimer::getCurrentTimePoint();
+                Bitmap::saveImage(filename, size.x, size.y, Bitmap::FileFormat::PngFile, flags, ResourceFormat::RGBA8Unorm, true, ldr.data());
+                double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+                EXPECT(std::filesystem::exists(filename));
+                logInfo("BitmapSaveBenchmark: PNG " + res + (flags == Bitmap::ExportFlags::None ? " compressed" : " uncompressed") + ": " + std::to_string(ms) + " ms");
+                std::filesystem::remove(filename);
+            }
+        }
+    }
+}
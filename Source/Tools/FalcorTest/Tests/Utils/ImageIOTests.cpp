@@ -0,0 +1,170 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <filesystem>
+
+// The compression benchmark is disabled by default as it compresses a 2K image in every mode and quality preset.
+//#define RUN_BENCHMARK_TESTS
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Creates an RGBA8 image with smooth gradients and a hard edge.
+        */
+        std::vector<uint8_t> createImage(uint32_t width, uint32_t height)
+        {
+            std::vector<uint8_t> data(size_t(width) * height * 4);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    uint8_t* p = &data[(size_t(y) * width + x) * 4];
+                    p[0] = uint8_t(255 * x / width);
+                    p[1] = uint8_t(255 * y / height);
+                    p[2] = x < width / 2 ? 32 : 224;
+                    p[3] = 255;
+                }
+            }
+            return data;
+        }
+
+        std::filesystem::path createTempDirectory()
+        {
+            std::filesystem::path dir = std::filesystem::path(getTempFilename()).replace_extension("");
+            std::filesystem::create_directories(dir);
+            return dir;
+        }
+    }
+
+    CPU_TEST(ImageIOSaveCompressed)
+    {
+        // The height is not a multiple of the strip size, so the last strip is partial.
+        const uint32_t kWidth = 256, kHeight = 200;
+        auto data = createImage(kWidth, kHeight);
+        auto pBitmap = Bitmap::create(kWidth, kHeight, ResourceFormat::RGBA8Unorm, data.data());
+        std::string filename = getTempFilename() + ".dds";
+
+        const std::pair<ImageIO::CompressionMode, ResourceFormat> kModes[] =
+        {
+            { ImageIO::CompressionMode::BC1, ResourceFormat::BC1Unorm },
+            { ImageIO::CompressionMode::BC3, ResourceFormat::BC3Unorm },
+            { ImageIO::CompressionMode::BC7, ResourceFormat::BC7Unorm },
+        };
+
+        for (auto [mode, format] : kModes)
+        {
+            for (auto quality : { ImageIO::CompressionQuality::Fast, ImageIO::CompressionQuality::Normal, ImageIO::CompressionQuality::High })
+            {
+                ImageIO::saveToDDS(filename, *pBitmap, mode, quality);
+                auto pLoaded = ImageIO::loadBitmapFromDDS(filename);
+                EXPECT(pLoaded != nullptr);
+                EXPECT_EQ(pLoaded->getFormat(), format);
+                EXPECT_EQ(pLoaded->getWidth(), kWidth);
+                EXPECT_EQ(pLoaded->getHeight(), kHeight);
+            }
+        }
+
+        std::filesystem::remove(filename);
+    }
+
+    CPU_TEST(ImageIOConvertDirectory)
+    {
+        auto dir = createTempDirectory();
+        auto srcDir = dir / "src";
+        auto dstDir = dir / "dst";
+        std::filesystem::create_directories(srcDir / "sub");
+
+        auto data = createImage(64, 64);
+        Bitmap::saveImage((srcDir / "color.png").string(), 64, 64, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::RGBA8Unorm, true, data.data());
+        Bitmap::saveImage((srcDir / "sub" / "color.tga").string(), 64, 64, Bitmap::FileFormat::TgaFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, true, data.data());
+        Bitmap::saveImage((srcDir / "ignored.txt").string(), 64, 64, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, true, data.data());
+
+        ImageIO::BatchDesc desc;
+        desc.srcDirectory = srcDir.string();
+        desc.dstDirectory = dstDir.string();
+        desc.quality = ImageIO::CompressionQuality::Fast;
+
+        auto report = ImageIO::convertDirectoryToDDS(desc);
+        EXPECT_EQ(report.filesConverted, 2);
+        EXPECT_EQ(report.filesFailed, 0);
+        EXPECT(std::filesystem::exists(dstDir / "color.dds"));
+        EXPECT(std::filesystem::exists(dstDir / "sub" / "color.dds"));
+
+        auto pLoaded = ImageIO::loadBitmapFromDDS((dstDir / "color.dds").string());
+        EXPECT(pLoaded != nullptr);
+        EXPECT_EQ(pLoaded->getFormat(), ResourceFormat::BC7Unorm);
+
+        // Converting again skips the up-to-date files.
+        report = ImageIO::convertDirectoryToDDS(desc);
+        EXPECT_EQ(report.filesConverted, 0);
+        EXPECT_EQ(report.filesSkipped, 2);
+
+        std::filesystem::remove_all(dir);
+    }
+
+#ifdef RUN_BENCHMARK_TESTS
+    CPU_TEST(ImageIOCompressBenchmark)
+#else
+    CPU_TEST(ImageIOCompressBenchmark, "Disabled for performance reasons")
+#endif
+    {
+        // Compresses a 2K image with mips and logs the time per mode and quality preset.
+        const uint32_t kSize = 2048;
+        auto data = createImage(kSize, kSize);
+        auto pBitmap = Bitmap::create(kSize, kSize, ResourceFormat::RGBA8Unorm, data.data());
+        auto chain = MipGenerator::generate(*pBitmap);
+        std::string filename = getTempFilename() + ".dds";
+
+        const std::pair<ImageIO::CompressionMode, const char*> kModes[] =
+        {
+            { ImageIO::CompressionMode::BC1, "BC1" },
+            { ImageIO::CompressionMode::BC3, "BC3" },
+            { ImageIO::CompressionMode::BC7, "BC7" },
+        };
+        const std::pair<ImageIO::CompressionQuality, const char*> kQualities[] =
+        {
+            { ImageIO::CompressionQuality::Fast, "Fast" },
+            { ImageIO::CompressionQuality::Normal, "Normal" },
+        };
+
+        for (auto mode : kModes)
+        {
+            for (auto quality : kQualities)
+            {
+                auto start = CpuTimer::getCurrentTimePoint();
+                ImageIO::saveToDDS(filename, chain, mode.first, quality.first);
+                double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+                EXPECT(std::filesystem::exists(filename));
+                logInfo(std::string("ImageIOCompressBenchmark: ") + mode.second + " " + quality.second + " 2048x2048 with mips: " + std::to_string(ms) + " ms");
+            }
+        }
+
+        std::filesystem::remove(filename);
+    }
+}
@@ -0,0 +1,173 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <filesystem>
+
+namespace Falcor
+{
+    namespace
+    {
+        std::vector<float> getFloatLevel(const MipGenerator::MipChain& chain, uint32_t mip, uint32_t channelCount)
+        {
+            const float* pData = reinterpret_cast<const float*>(chain.getMipData(mip));
+            return std::vector<float>(pData, pData + size_t(chain.getMipWidth(mip)) * chain.getMipHeight(mip) * channelCount);
+        }
+
+        std::vector<uint8_t> createCheckerboard(uint32_t width, uint32_t height)
+        {
+            std::vector<uint8_t> data(size_t(width) * height * 4);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    uint8_t v = ((x ^ y) & 1) ? 255 : 0;
+                    uint8_t* p = &data[(size_t(y) * width + x) * 4];
+                    p[0] = p[1] = p[2] = p[3] = v;
+                }
+            }
+            return data;
+        }
+    }
+
+    CPU_TEST(MipGeneratorBox)
+    {
+        const float kData[16] =
+        {
+            0.f, 1.f, 2.f, 3.f,
+            4.f, 5.f, 6.f, 7.f,
+            8.f, 9.f, 10.f, 11.f,
+            12.f, 13.f, 14.f, 15.f,
+        };
+        auto pBitmap = Bitmap::create(4, 4, ResourceFormat::R32Float, reinterpret_cast<const uint8_t*>(kData));
+        auto chain = MipGenerator::generate(*pBitmap, MipGenerator::Filter::Box);
+
+        EXPECT_EQ(chain.getMipCount(), 3);
+        EXPECT(getFloatLevel(chain, 0, 1) == std::vector<float>(kData, kData + 16));
+
+        const std::vector<float> kMip1 = { 2.5f, 4.5f, 10.5f, 12.5f };
+        auto mip1 = getFloatLevel(chain, 1, 1);
+        for (size_t i = 0; i < kMip1.size(); i++) EXPECT_EQ(mip1[i], kMip1[i]) << "i = " << i;
+        EXPECT_EQ(getFloatLevel(chain, 2, 1)[0], 7.5f);
+    }
+
+    CPU_TEST(MipGeneratorOddSize)
+    {
+        // A constant image must stay constant for all filters and sizes, including at the borders.
+        const uint32_t kWidth = 13, kHeight = 5;
+        std::vector<float> data(kWidth * kHeight * 4, 0.75f);
+        auto pBitmap = Bitmap::create(kWidth, kHeight, ResourceFormat::RGBA32Float, reinterpret_cast<const uint8_t*>(data.data()));
+
+        for (auto filter : { MipGenerator::Filter::Box, MipGenerator::Filter::Kaiser })
+        {
+            auto chain = MipGenerator::generate(*pBitmap, filter);
+            EXPECT_EQ(chain.getMipCount(), 4);
+            EXPECT_EQ(chain.getMipWidth(1), 6);
+            EXPECT_EQ(chain.getMipHeight(1), 2);
+            EXPECT_EQ(chain.getMipWidth(3), 1);
+            EXPECT_EQ(chain.getMipHeight(3), 1);
+
+            for (uint32_t mip = 1; mip < chain.getMipCount(); mip++)
+            {
+                for (float v : getFloatLevel(chain, mip, 4)) EXPECT_LE(std::abs(v - 0.75f), 1e-5f) << "mip = " << mip;
+            }
+        }
+
+        // The box filter must weight all source pixels equally, also for odd sizes.
+        std::vector<float> ramp(kWidth);
+        for (uint32_t x = 0; x < kWidth; x++) ramp[x] = float(x);
+        auto pRamp = Bitmap::create(kWidth, 1, ResourceFormat::R32Float, reinterpret_cast<const uint8_t*>(ramp.data()));
+        auto chain = MipGenerator::generate(*pRamp, MipGenerator::Filter::Box);
+        EXPECT_LE(std::abs(getFloatLevel(chain, chain.getMipCount() - 1, 1)[0] - 6.f), 1e-5f);
+    }
+
+    CPU_TEST(MipGeneratorSrgb)
+    {
+        // Averaging black and white gives 0.5 in linear space, which is 188 in sRGB. Alpha is always filtered linearly.
+        auto data = createCheckerboard(2, 2);
+        auto pBitmap = Bitmap::create(2, 2, ResourceFormat::RGBA8Unorm, data.data());
+
+        auto linear = MipGenerator::generate(*pBitmap, MipGenerator::Filter::Box, false);
+        const uint8_t* pLinear = linear.getMipData(1);
+        EXPECT_EQ((uint32_t)pLinear[0], 128u);
+        EXPECT_EQ((uint32_t)pLinear[3], 128u);
+
+        auto srgb = MipGenerator::generate(*pBitmap, MipGenerator::Filter::Box, true);
+        const uint8_t* pSrgb = srgb.getMipData(1);
+        EXPECT_EQ((uint32_t)pSrgb[0], 188u);
+        EXPECT_EQ((uint32_t)pSrgb[1], 188u);
+        EXPECT_EQ((uint32_t)pSrgb[2], 188u);
+        EXPECT_EQ((uint32_t)pSrgb[3], 128u);
+
+        // Formats without an sRGB variant are always filtered linearly.
+        std::vector<uint8_t> gray = { 0, 255, 255, 0 };
+        auto pGray = Bitmap::create(2, 2, ResourceFormat::R8Unorm, gray.data());
+        EXPECT_EQ((uint32_t)MipGenerator::generate(*pGray, MipGenerator::Filter::Box, true).getMipData(1)[0], 128u);
+    }
+
+    GPU_TEST(MipGeneratorCache)
+    {
+        const uint32_t kSize = 64;
+        std::string filename = getTempFilename() + ".png";
+        auto data = createCheckerboard(kSize, kSize);
+        Bitmap::saveImage(filename, kSize, kSize, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::RGBA8Unorm, true, data.data());
+
+        std::string cacheFilename = MipGenerator::getCacheFilename(filename, true, MipGenerator::Filter::Box);
+        std::filesystem::remove(cacheFilename);
+
+        // The first load generates the mips and writes the cache, the second load reads the cache.
+        // The cache file is dated into the future after the first load, so a rewrite on the second load is detected.
+        std::filesystem::file_time_type cacheTime;
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            auto pTex = MipGenerator::createTextureFromFile(filename, true, true, MipGenerator::Filter::Box);
+            EXPECT(pTex != nullptr);
+            if (!pTex) break;
+            EXPECT(std::filesystem::exists(cacheFilename));
+            EXPECT_EQ(pTex->getMipCount(), 7);
+            EXPECT_EQ(pTex->getFormat(), ResourceFormat::BGRA8UnormSrgb);
+
+            // The 1x1 level of a checkerboard is 50% gray in linear space.
+            auto lastMip = ctx.getRenderContext()->readTextureSubresource(pTex.get(), pTex->getSubresourceIndex(0, 6));
+            EXPECT_EQ(lastMip.size(), 4);
+            EXPECT_LE(std::abs((int)lastMip[0] - 188), 1);
+
+            if (i == 0)
+            {
+                cacheTime = std::filesystem::last_write_time(filename) + std::chrono::hours(1);
+                std::filesystem::last_write_time(cacheFilename, cacheTime);
+            }
+            else
+            {
+                EXPECT(std::filesystem::last_write_time(cacheFilename) == cacheTime) << "The cache was not hit";
+            }
+        }
+
+        std::filesystem::remove(cacheFilename);
+        std::filesystem::remove(filename);
+    }
+}